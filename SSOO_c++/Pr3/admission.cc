@@ -0,0 +1,113 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: admission.cc
+ * Referencias:
+ *     Enunciado de la práctica
+ *     man 2 listen
+ */
+
+#include "admission.h"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+
+#include "metrics.h"
+
+namespace {
+
+double bucket_size(const admission_limits& limits) {
+  return static_cast<double>(limits.burst != 0 ? limits.burst : limits.rate);
+}
+
+}  // namespace
+
+AdmissionControl::AdmissionControl(const admission_limits& limits)
+    : limits_(limits), tokens_(bucket_size(limits)), refilled_at_(now_ns()) {}
+
+bool AdmissionControl::admit_connection(const sockaddr_in& peer) {
+  if (limits_.max_connections != 0 && open_ >= limits_.max_connections) {
+    metrics_count(metric_counter::connections_shed);
+    return false;
+  }
+  if (limits_.max_per_ip != 0 && peer.sin_family == AF_INET) {
+    size_t& count = per_ip_[peer.sin_addr.s_addr];
+    if (count >= limits_.max_per_ip) {
+      metrics_count(metric_counter::connections_shed);
+      return false;
+    }
+    ++count;
+  }
+  ++open_;
+  return true;
+}
+
+void AdmissionControl::connection_closed(const sockaddr_in& peer) {
+  --open_;
+  if (limits_.max_per_ip == 0 || peer.sin_family != AF_INET) {
+    return;
+  }
+  auto it = per_ip_.find(peer.sin_addr.s_addr);
+  if (it != per_ip_.end() && --it->second == 0) {
+    per_ip_.erase(it);
+  }
+}
+
+void AdmissionControl::refill(uint64_t now) {
+  double elapsed = static_cast<double>(now - refilled_at_) / 1e9;
+  refilled_at_ = now;
+  tokens_ = std::min(bucket_size(limits_),
+                     tokens_ + elapsed * static_cast<double>(limits_.rate));
+}
+
+bool AdmissionControl::overloaded() const {
+  if (limits_.rate != 0 && tokens_ < bucket_size(limits_) / 2) {
+    return true;
+  }
+  return limits_.max_connections != 0 &&
+         open_ * 4 > limits_.max_connections * 3;
+}
+
+bool AdmissionControl::admit_request(request_priority priority) {
+  if (priority == request_priority::exempt) {
+    return true;
+  }
+  if (limits_.rate != 0) {
+    refill(now_ns());
+  }
+  bool admitted = priority == request_priority::high || !overloaded();
+  if (admitted && limits_.rate != 0) {
+    if (tokens_ < 1) {
+      admitted = false;
+    } else {
+      tokens_ -= 1;
+    }
+  }
+  if (!admitted) {
+    metrics_count(metric_counter::requests_shed);
+  }
+  return admitted;
+}
+
+void AdmissionControl::shed(int socket_fd) {
+  static constexpr std::string_view kResponse =
+      "503 Service Unavailable\r\nRetry-After: 1\r\n\r\n";
+  metrics_status(503);
+  send(socket_fd, kResponse.data(), kResponse.size(),
+       MSG_NOSIGNAL | MSG_DONTWAIT);
+  // Cerrar con la petición sin leer manda un RST que puede adelantarse al
+  // 503: se cierra la escritura y se descarta lo que ya haya llegado
+  shutdown(socket_fd, SHUT_WR);
+  std::array<char, 1024> discard;
+  while (recv(socket_fd, discard.data(), discard.size(), MSG_DONTWAIT) > 0) {
+  }
+}
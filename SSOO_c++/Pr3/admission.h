@@ -0,0 +1,102 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: admission.h
+ * Referencias:
+ *     Enunciado de la práctica
+ *     man 2 listen
+ */
+
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include <netinet/in.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * @brief Límites de admisión del servidor (0 = sin límite).
+ */
+struct admission_limits {
+  int backlog = 128;           // Cola de conexiones de listen()
+  size_t max_connections = 0;  // Conexiones abiertas a la vez
+  size_t max_per_ip = 0;       // Conexiones abiertas a la vez por cliente
+  uint64_t rate = 0;           // Peticiones por segundo en régimen
+  uint64_t burst = 0;          // Ráfaga admitida (0 = rate)
+};
+
+/**
+ * @brief Prioridad de una petición cuando hay sobrecarga.
+ */
+enum class request_priority {
+  exempt,  // Métricas y traza: siempre se atienden
+  high,    // Archivos estáticos
+  low,     // Programas de /bin, los más caros
+};
+
+/**
+ * @brief Respuesta 503 ya construida (sin el "\r\n" final que añade
+ * Connection::respond()) para rechazar sin trabajo.
+ */
+constexpr std::string_view kOverloadHeader =
+    "503 Service Unavailable\r\nRetry-After: 1\r\n";
+
+/**
+ * @brief Control de admisión de conexiones y peticiones.
+ *
+ * Al aceptar se rechaza la conexión si ya hay max_connections abiertas o
+ * max_per_ip del mismo cliente. Cada petición gasta una ficha de un cubo
+ * que se rellena a rate por segundo hasta burst. Se considera sobrecarga
+ * que el cubo esté por debajo de la mitad o que haya abiertas más de tres
+ * cuartos de max_connections: entonces las de prioridad baja se rechazan
+ * ya, y así las fichas que quedan son para las de prioridad alta.
+ */
+class AdmissionControl {
+ public:
+  explicit AdmissionControl(const admission_limits& limits);
+
+  /**
+   * @brief Decide si se atiende una conexión recién aceptada; si se atiende
+   * cuenta como abierta hasta connection_closed(). Las que llegan por un
+   * socket Unix (sin_family == AF_UNIX) no tienen límite por cliente: suelen
+   * ser de un proxy local que reparte a muchos.
+   */
+  bool admit_connection(const sockaddr_in& peer);
+  void connection_closed(const sockaddr_in& peer);
+
+  /**
+   * @brief Decide si se atiende una petición, y gasta su ficha si es así.
+   */
+  bool admit_request(request_priority priority);
+
+  /**
+   * @brief Rechaza una conexión sin llegar a crearla: envía el 503
+   * construido de antemano y cierra.
+   */
+  static void shed(int socket_fd);
+
+  [[nodiscard]] const admission_limits& limits() const noexcept {
+    return limits_;
+  }
+
+ private:
+  void refill(uint64_t now);
+  [[nodiscard]] bool overloaded() const;
+
+  admission_limits limits_;
+  size_t open_ = 0;
+  std::unordered_map<in_addr_t, size_t> per_ip_;
+  double tokens_;
+  uint64_t refilled_at_;
+};
+
+#endif  // ADMISSION_H
@@ -0,0 +1,132 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: batch.cc
+ * Referencias:
+ *     man 2 writev, man 2 readahead
+ */
+
+#include "batch.h"
+
+#include <cerrno>
+#include <format>
+#include <fstream>
+#include <utility>
+
+#include "docserver.h"
+
+namespace {
+
+constexpr std::string_view kInlinePrefix = "/_batch?";
+constexpr std::string_view kManifestPrefix = "/_batch/";
+
+/**
+ * @brief true si path es de un archivo estático: ni un programa de /bin ni
+ * una página del servidor (otro lote, por ejemplo).
+ */
+bool is_static_path(std::string_view path) {
+  return !path.empty() && path.front() == '/' && path.back() != '/' &&
+         path.find_first_of(" \t\r\n,") == std::string_view::npos &&
+         !path.starts_with("/bin/") && !path.starts_with("/_") &&
+         path != "/metrics";
+}
+
+/**
+ * @brief Añade path a paths si es válida y cabe.
+ * @return 0, EINVAL o E2BIG.
+ */
+int add_path(std::vector<std::string>& paths, std::string_view path) {
+  if (!is_static_path(path)) {
+    return EINVAL;
+  }
+  if (paths.size() >= kMaxBatchFiles) {
+    return E2BIG;
+  }
+  paths.emplace_back(path);
+  return 0;
+}
+
+}  // namespace
+
+bool is_batch_path(std::string_view path) {
+  return path.starts_with(kInlinePrefix) || path.starts_with(kManifestPrefix);
+}
+
+std::expected<std::vector<std::string>, int> batch_paths(std::string_view path) {
+  std::vector<std::string> paths;
+  if (path.starts_with(kInlinePrefix)) {
+    std::string_view list = path.substr(kInlinePrefix.size());
+    while (!list.empty()) {
+      size_t comma = list.find(',');
+      if (int error = add_path(paths, list.substr(0, comma))) {
+        return std::unexpected(error);
+      }
+      list.remove_prefix(comma == std::string_view::npos ? list.size()
+                                                         : comma + 1);
+    }
+  } else {
+    std::string_view manifest = path.substr(kManifestPrefix.size() - 1);
+    if (!is_static_path(manifest)) {
+      return std::unexpected(EINVAL);
+    }
+    std::ifstream in(base_dir + std::string(manifest));
+    if (!in) {
+      return std::unexpected(errno != 0 ? errno : ENOENT);
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+      std::string_view text = line;
+      if (text.ends_with('\r')) {
+        text.remove_suffix(1);
+      }
+      if (text.empty() || text.front() == '#') {
+        continue;
+      }
+      if (int error = add_path(paths, text)) {
+        return std::unexpected(error);
+      }
+    }
+  }
+  if (paths.empty()) {
+    return std::unexpected(EINVAL);
+  }
+  return paths;
+}
+
+batch_response make_batch_response(const std::vector<batch_entry>& entries) {
+  // Las líneas de todos los archivos van en una sola cadena compartida por
+  // sus trozos, que se crea entera antes de apuntar a ella
+  std::string frames;
+  std::vector<std::pair<size_t, size_t>> lines;  // Posición y longitud
+  lines.reserve(entries.size());
+  size_t total = 0;
+  for (const auto& entry : entries) {
+    size_t length = entry.file ? entry.file->get().size() : 0;
+    size_t start = frames.size();
+    frames += std::format("{} {} {}\n", entry.status, length, entry.path);
+    lines.emplace_back(start, frames.size() - start);
+    total += frames.size() - start + length;
+  }
+  auto owner = std::make_shared<const std::string>(std::move(frames));
+  std::string_view text = *owner;
+
+  batch_response response;
+  response.header = std::format(
+      "Content-Length: {}\r\nContent-Type: application/x-docserver-batch\r\n",
+      total);
+  response.body.reserve(entries.size() * 2);
+  for (size_t i = 0; i < entries.size(); ++i) {
+    response.body.push_back(
+        {owner, text.substr(lines[i].first, lines[i].second)});
+    if (entries[i].file) {
+      response.body.push_back({entries[i].file, entries[i].file->get()});
+    }
+  }
+  return response;
+}
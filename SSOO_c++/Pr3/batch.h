@@ -0,0 +1,71 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: batch.h
+ * Referencias:
+ *     man 2 writev, man 2 readahead
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <expected>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "connection.h"
+#include "safe_map.h"
+
+// Archivos que se admiten en un lote
+constexpr size_t kMaxBatchFiles = 1024;
+
+/**
+ * @brief true si path pide un lote de archivos ("/_batch?..." o
+ * "/_batch/...").
+ */
+bool is_batch_path(std::string_view path);
+
+/**
+ * @brief Rutas de un lote, en el orden pedido. Van en la propia petición,
+ * separadas por comas ("/_batch?/a.html,/img/b.png"), o en un manifiesto de
+ * base_dir con una por línea ("/_batch/lista.txt"; se ignoran las líneas en
+ * blanco y las que empiezan por '#').
+ * @return Las rutas, EINVAL si alguna no es de un archivo estático, E2BIG
+ * si pasan de kMaxBatchFiles o el errno de no poder leer el manifiesto.
+ */
+std::expected<std::vector<std::string>, int> batch_paths(std::string_view path);
+
+/**
+ * @brief Un archivo del lote ya resuelto: status 200 con su contenido o el
+ * código de error sin él.
+ */
+struct batch_entry {
+  std::string path;
+  int status = 200;
+  std::shared_ptr<const SafeMap> file;
+};
+
+/**
+ * @brief Respuesta de un lote: las cabeceras y el cuerpo en trozos que se
+ * envían sin copiar los archivos.
+ *
+ * Cada archivo va precedido de una línea "<código> <longitud> <ruta>\n" y
+ * seguido de sus bytes (ninguno si no se pudo leer).
+ */
+struct batch_response {
+  std::string header;
+  std::vector<body_segment> body;
+};
+
+batch_response make_batch_response(const std::vector<batch_entry>& entries);
+
+#endif  // BATCH_H
@@ -0,0 +1,545 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: bench_read.cc
+ * Referencias:
+ *     man 2 sendfile, man 2 splice, man 2 posix_fadvise
+ */
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "metrics.h"
+#include "tools_common.h"
+
+/**
+ * Microbenchmark de las formas de llevar un archivo del disco al socket.
+ *
+ * Cada operación es lo que hace el servidor por petición: abrir el archivo,
+ * cargarlo con la estrategia elegida, escribirlo entero en un socket TCP por
+ * loopback (un hilo lo vacía en el otro extremo) y cerrarlo.
+ *
+ * Estrategias:
+ *   ifstream       std::ifstream + rdbuf() (Practica_bien/hola: read_file)
+ *   read           read() a buffers reutilizados de un pool + send()
+ *   pread          pread() por desplazamiento a buffers del pool + send()
+ *   mmap           mmap() + send() (Pr3: read_all)
+ *   mmap_populate  mmap(MAP_POPULATE) + send()
+ *   sendfile       sendfile() del archivo al socket
+ *   splice         splice() archivo -> pipe -> socket
+ *
+ * En frío se descarta la caché de páginas del archivo con
+ * posix_fadvise(POSIX_FADV_DONTNEED) antes de cada operación. En tmpfs no
+ * hay nada que descartar, así que --dir debe estar en un disco real.
+ * (Practica_2 no carga archivos, por eso no tiene estrategia propia.)
+ */
+
+/**
+ * @brief Opciones del benchmark.
+ */
+struct bench_options {
+  bool flag_h = false;
+  std::string dir = "/tmp/docserver-bench";
+  std::vector<uint64_t> sizes = {100,       4ull << 10,   64ull << 10,
+                                 1ull << 20, 16ull << 20, 256ull << 20,
+                                 1ull << 30};
+  uint64_t max_size = UINT64_MAX;
+  std::vector<std::string> strategies;
+  bool cold = true;
+  bool warm = true;
+  double min_time = 0.3;  // Segundos por combinación
+  bool csv = false;
+};
+
+/**
+ * @brief Pool de buffers de tamaño fijo que se reutilizan entre lecturas.
+ */
+class BufferPool {
+ public:
+  static constexpr size_t kBufferSize = 256 * 1024;
+
+  std::unique_ptr<char[]> acquire() {
+    if (free_.empty()) {
+      return std::make_unique<char[]>(kBufferSize);
+    }
+    auto buffer = std::move(free_.back());
+    free_.pop_back();
+    return buffer;
+  }
+
+  void release(std::unique_ptr<char[]> buffer) {
+    free_.push_back(std::move(buffer));
+  }
+
+ private:
+  std::vector<std::unique_ptr<char[]>> free_;
+};
+
+/**
+ * @brief Extremo de escritura de una conexión TCP por loopback cuyo otro
+ * extremo vacía un hilo.
+ */
+class LoopbackSink {
+ public:
+  LoopbackSink() {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    bind(listener, reinterpret_cast<sockaddr*>(&address), length);
+    listen(listener, 1);
+    getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    connect(fd_, reinterpret_cast<sockaddr*>(&address), length);
+    int reader = accept(listener, nullptr, nullptr);
+    close(listener);
+    drain_ = std::thread([this, reader] {
+      std::vector<char> buffer(1 << 20);
+      ssize_t got;
+      while ((got = recv(reader, buffer.data(), buffer.size(), 0)) > 0) {
+        drained_.fetch_add(static_cast<uint64_t>(got),
+                           std::memory_order_relaxed);
+      }
+      close(reader);
+    });
+  }
+
+  ~LoopbackSink() {
+    shutdown(fd_, SHUT_WR);
+    drain_.join();
+    close(fd_);
+  }
+
+  LoopbackSink(const LoopbackSink&) = delete;
+  LoopbackSink& operator=(const LoopbackSink&) = delete;
+
+  int fd() const { return fd_; }
+
+ private:
+  int fd_ = -1;
+  std::thread drain_;
+  std::atomic<uint64_t> drained_{0};
+};
+
+/**
+ * @brief Envía un bloque de memoria completo al socket.
+ */
+bool send_all(int socket_fd, const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t sent = send(socket_fd, data, size, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data += sent;
+    size -= static_cast<size_t>(sent);
+  }
+  return true;
+}
+
+using strategy_fn =
+    std::function<bool(const std::string& path, uint64_t size, int sink)>;
+
+/**
+ * @brief Estrategia con nombre.
+ */
+struct strategy {
+  const char* name;
+  strategy_fn run;
+};
+
+std::vector<strategy> make_strategies(BufferPool& pool) {
+  std::vector<strategy> all;
+
+  all.push_back({"ifstream", [](const std::string& path, uint64_t, int sink) {
+                   std::ifstream file(path, std::ios::binary);
+                   if (!file) return false;
+                   std::ostringstream buffer;
+                   buffer << file.rdbuf();
+                   std::string content = buffer.str();
+                   return send_all(sink, content.data(), content.size());
+                 }});
+
+  all.push_back({"read", [&pool](const std::string& path, uint64_t,
+                                 int sink) {
+                   int fd = open(path.c_str(), O_RDONLY);
+                   if (fd < 0) return false;
+                   auto buffer = pool.acquire();
+                   bool ok = true;
+                   ssize_t got;
+                   while ((got = read(fd, buffer.get(), BufferPool::kBufferSize)) >
+                          0) {
+                     if (!send_all(sink, buffer.get(),
+                                   static_cast<size_t>(got))) {
+                       ok = false;
+                       break;
+                     }
+                   }
+                   pool.release(std::move(buffer));
+                   close(fd);
+                   return ok && got == 0;
+                 }});
+
+  all.push_back({"pread", [&pool](const std::string& path, uint64_t size,
+                                  int sink) {
+                   int fd = open(path.c_str(), O_RDONLY);
+                   if (fd < 0) return false;
+                   auto buffer = pool.acquire();
+                   bool ok = true;
+                   for (uint64_t offset = 0; offset < size && ok;) {
+                     ssize_t got = pread(fd, buffer.get(),
+                                         BufferPool::kBufferSize,
+                                         static_cast<off_t>(offset));
+                     if (got <= 0) {
+                       ok = false;
+                       break;
+                     }
+                     ok = send_all(sink, buffer.get(), static_cast<size_t>(got));
+                     offset += static_cast<uint64_t>(got);
+                   }
+                   pool.release(std::move(buffer));
+                   close(fd);
+                   return ok;
+                 }});
+
+  auto mmap_strategy = [](int extra_flags) {
+    return [extra_flags](const std::string& path, uint64_t size, int sink) {
+      int fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0) return false;
+      void* mem = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | extra_flags, fd,
+                       0);
+      close(fd);
+      if (mem == MAP_FAILED) return false;
+      bool ok = send_all(sink, static_cast<const char*>(mem), size);
+      munmap(mem, size);
+      return ok;
+    };
+  };
+  all.push_back({"mmap", mmap_strategy(0)});
+  all.push_back({"mmap_populate", mmap_strategy(MAP_POPULATE)});
+
+  all.push_back({"sendfile", [](const std::string& path, uint64_t size,
+                                int sink) {
+                   int fd = open(path.c_str(), O_RDONLY);
+                   if (fd < 0) return false;
+                   off_t offset = 0;
+                   bool ok = true;
+                   while (static_cast<uint64_t>(offset) < size) {
+                     ssize_t sent = sendfile(
+                         sink, fd, &offset,
+                         size - static_cast<uint64_t>(offset));
+                     if (sent <= 0) {
+                       ok = false;
+                       break;
+                     }
+                   }
+                   close(fd);
+                   return ok;
+                 }});
+
+  all.push_back({"splice", [](const std::string& path, uint64_t size,
+                              int sink) {
+                   int fd = open(path.c_str(), O_RDONLY);
+                   if (fd < 0) return false;
+                   int pipe_fd[2];
+                   if (pipe(pipe_fd) < 0) {
+                     close(fd);
+                     return false;
+                   }
+                   fcntl(pipe_fd[1], F_SETPIPE_SZ, 1 << 20);
+                   bool ok = true;
+                   loff_t offset = 0;
+                   while (static_cast<uint64_t>(offset) < size && ok) {
+                     ssize_t in = splice(fd, &offset, pipe_fd[1], nullptr,
+                                         1 << 20, SPLICE_F_MOVE | SPLICE_F_MORE);
+                     if (in <= 0) {
+                       ok = false;
+                       break;
+                     }
+                     while (in > 0) {
+                       ssize_t out =
+                           splice(pipe_fd[0], nullptr, sink, nullptr,
+                                  static_cast<size_t>(in),
+                                  SPLICE_F_MOVE | SPLICE_F_MORE);
+                       if (out <= 0) {
+                         ok = false;
+                         break;
+                       }
+                       in -= out;
+                     }
+                   }
+                   close(pipe_fd[0]);
+                   close(pipe_fd[1]);
+                   close(fd);
+                   return ok;
+                 }});
+  return all;
+}
+
+void Usage(char* argv[]) {
+  std::cout << "Usage: " << argv[0]
+            << " [--dir <dir>] [--sizes <s1,s2,...>] [--max-size <size>]"
+            << " [--strategies <a,b,...>] [--cold-only | --warm-only]"
+            << " [--min-time <seconds>] [--csv]\n";
+  std::cout << "Options:\n";
+  std::cout << "  --dir         Where the test files are created"
+               " (default /tmp/docserver-bench)\n";
+  std::cout << "  --sizes       File sizes (default 100,4k,64k,1m,16m,256m,1g)\n";
+  std::cout << "  --max-size    Skip sizes above this one\n";
+  std::cout << "  --strategies  Subset of: ifstream, read, pread, mmap,"
+               " mmap_populate, sendfile, splice\n";
+  std::cout << "  --cold-only   Only measure with the page cache dropped\n";
+  std::cout << "  --warm-only   Only measure with the file already cached\n";
+  std::cout << "  --min-time    Measuring time per combination (default 0.3)\n";
+  std::cout << "  --csv         Print CSV instead of a table\n";
+}
+
+std::vector<std::string> split(std::string_view text, char separator) {
+  std::vector<std::string> parts;
+  while (!text.empty()) {
+    size_t pos = text.find(separator);
+    parts.emplace_back(text.substr(0, pos));
+    if (pos == std::string_view::npos) break;
+    text.remove_prefix(pos + 1);
+  }
+  return parts;
+}
+
+std::expected<bench_options, std::string> parse_args(int argc, char* argv[]) {
+  std::vector<std::string_view> args(argv + 1, argv + argc);
+  bench_options options;
+  for (auto it = args.begin(), end = args.end(); it != end; ++it) {
+    std::string_view option = *it;
+    auto needs_value = [&]() { return ++it != end; };
+    if (option == "-h" || option == "--help") {
+      options.flag_h = true;
+    } else if (option == "--csv") {
+      options.csv = true;
+    } else if (option == "--cold-only") {
+      options.warm = false;
+    } else if (option == "--warm-only") {
+      options.cold = false;
+    } else if (option == "--dir") {
+      if (!needs_value()) return std::unexpected("missing directory");
+      options.dir = *it;
+    } else if (option == "--sizes") {
+      if (!needs_value()) return std::unexpected("missing sizes");
+      options.sizes.clear();
+      for (const auto& part : split(*it, ',')) {
+        auto size = parse_size(part);
+        if (!size || *size == 0) {
+          return std::unexpected(std::format("invalid size {}", part));
+        }
+        options.sizes.push_back(*size);
+      }
+    } else if (option == "--max-size") {
+      if (!needs_value()) return std::unexpected("missing size");
+      auto size = parse_size(*it);
+      if (!size) return std::unexpected(std::format("invalid size {}", *it));
+      options.max_size = *size;
+    } else if (option == "--strategies") {
+      if (!needs_value()) return std::unexpected("missing strategies");
+      options.strategies = split(*it, ',');
+    } else if (option == "--min-time") {
+      if (!needs_value()) return std::unexpected("missing time");
+      try {
+        options.min_time = std::stod(std::string(*it));
+      } catch (const std::exception&) {
+        return std::unexpected("invalid time");
+      }
+    } else {
+      return std::unexpected(std::format("unknown option {}", option));
+    }
+  }
+  return options;
+}
+
+/**
+ * @brief Crea (o reutiliza si ya tiene el tamaño) el archivo de prueba.
+ */
+std::expected<std::string, std::string> prepare_file(const std::string& dir,
+                                                     uint64_t size) {
+  std::string path = std::format("{}/file-{}", dir, size);
+  struct stat st;
+  if (stat(path.c_str(), &st) == 0 && static_cast<uint64_t>(st.st_size) == size) {
+    return path;
+  }
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return std::unexpected(std::format("cannot create {}: {}", path,
+                                       std::strerror(errno)));
+  }
+  // Contenido pseudoaleatorio para que ninguna capa pueda comprimirlo
+  std::vector<char> block(1 << 20);
+  uint64_t state = size * 0x9E3779B97F4A7C15ull + 1;
+  for (auto& c : block) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    c = static_cast<char>(state);
+  }
+  for (uint64_t written = 0; written < size;) {
+    size_t chunk = static_cast<size_t>(
+        std::min<uint64_t>(block.size(), size - written));
+    ssize_t n = write(fd, block.data(), chunk);
+    if (n <= 0) {
+      close(fd);
+      return std::unexpected(std::format("cannot write {}", path));
+    }
+    written += static_cast<uint64_t>(n);
+  }
+  fsync(fd);
+  close(fd);
+  return path;
+}
+
+void drop_page_cache(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+void warm_page_cache(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    std::vector<char> buffer(1 << 20);
+    while (read(fd, buffer.data(), buffer.size()) > 0) {
+    }
+    close(fd);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  auto parsed = parse_args(argc, argv);
+  if (!parsed) {
+    std::cerr << "Error: " << parsed.error() << "\n";
+    return EXIT_FAILURE;
+  }
+  const bench_options& options = *parsed;
+  if (options.flag_h) {
+    Usage(argv);
+    return EXIT_SUCCESS;
+  }
+  std::error_code error;
+  std::filesystem::create_directories(options.dir, error);
+
+  BufferPool pool;
+  std::vector<strategy> strategies = make_strategies(pool);
+  if (!options.strategies.empty()) {
+    std::erase_if(strategies, [&](const strategy& s) {
+      return std::find(options.strategies.begin(), options.strategies.end(),
+                       s.name) == options.strategies.end();
+    });
+    if (strategies.empty()) {
+      std::cerr << "Error: no known strategy selected\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  LoopbackSink sink;
+  if (options.csv) {
+    std::cout << "size,cache,strategy,ops,p50_us,p99_us,mean_us,mib_s\n";
+  } else {
+    std::cout << std::format("{:<6} {:<5} {:<14} {:>7} {:>12} {:>12} {:>12} "
+                             "{:>10}\n",
+                             "size", "cache", "strategy", "ops", "p50_us",
+                             "p99_us", "mean_us", "MiB/s");
+  }
+
+  for (uint64_t size : options.sizes) {
+    if (size > options.max_size) {
+      continue;
+    }
+    auto path = prepare_file(options.dir, size);
+    if (!path) {
+      std::cerr << "Error: " << path.error() << "\n";
+      return EXIT_FAILURE;
+    }
+    for (bool cold : {true, false}) {
+      if ((cold && !options.cold) || (!cold && !options.warm)) {
+        continue;
+      }
+      for (const auto& s : strategies) {
+        LogLinearHistogram histogram;
+        uint64_t ops = 0;
+        uint64_t busy_ns = 0;
+        uint64_t started = now_ns();
+        if (!cold) {
+          warm_page_cache(*path);
+        }
+        // Al menos 3 repeticiones y hasta agotar el tiempo por combinación
+        while (ops < 3 ||
+               static_cast<double>(now_ns() - started) / 1e9 < options.min_time) {
+          if (cold) {
+            drop_page_cache(*path);
+          }
+          uint64_t begin = now_ns();
+          if (!s.run(*path, size, sink.fd())) {
+            std::cerr << std::format("Error: {} failed on {}: {}\n", s.name,
+                                     *path, std::strerror(errno));
+            return EXIT_FAILURE;
+          }
+          uint64_t elapsed = now_ns() - begin;
+          histogram.record(elapsed);
+          busy_ns += elapsed;
+          ++ops;
+          if (ops >= 100000) break;
+        }
+        histogram_snapshot snapshot;
+        histogram.add_to(snapshot);
+        double mean_us = static_cast<double>(busy_ns) /
+                         static_cast<double>(ops) / 1000.0;
+        double mib_s = static_cast<double>(size * ops) /
+                       (static_cast<double>(busy_ns) / 1e9) / (1024.0 * 1024.0);
+        double p50 = static_cast<double>(snapshot.percentile(0.50)) / 1000.0;
+        double p99 = static_cast<double>(snapshot.percentile(0.99)) / 1000.0;
+        if (options.csv) {
+          std::cout << std::format("{},{},{},{},{:.2f},{:.2f},{:.2f},{:.1f}\n",
+                                   size, cold ? "cold" : "warm", s.name, ops,
+                                   p50, p99, mean_us, mib_s);
+        } else {
+          std::cout << std::format(
+              "{:<6} {:<5} {:<14} {:>7} {:>12.2f} {:>12.2f} {:>12.2f} "
+              "{:>10.1f}\n",
+              format_size(size), cold ? "cold" : "warm", s.name, ops, p50, p99,
+              mean_us, mib_s);
+        }
+        std::cout.flush();
+      }
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,356 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: bench_sockopts.cc
+ * Referencias:
+ *     man 7 tcp, man 7 socket
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * Efecto de cada opción de socket de docserver en la latencia de archivos
+ * pequeños.
+ *
+ * Para cada variante se arranca el servidor con esas opciones sobre un
+ * corpus de gen_corpus y se mide con loadgen (lazo cerrado, archivos de
+ * sizes/ con -z). Se escribe una tabla con el rendimiento y los percentiles
+ * de latencia de cada una, junto a los de la variante sin opciones.
+ */
+
+/**
+ * @brief Variante: nombre y argumentos que se añaden al servidor.
+ */
+struct variant {
+  const char* name;
+  std::vector<std::string> server_args;
+};
+
+const std::vector<variant>& variants() {
+  static const std::vector<variant> all = {
+      {"baseline", {}},
+      {"nodelay", {"--tcp-nodelay"}},
+      {"cork", {"--tcp-cork"}},
+      {"defer-accept", {"--tcp-defer-accept", "1"}},
+      {"fastopen", {"--tcp-fastopen", "256"}},
+      {"sndbuf-16k", {"--sndbuf", "16384"}},
+      {"notsent-lowat", {"--tcp-notsent-lowat", "16384"}},
+      {"busy-poll", {"--busy-poll", "50"}},
+  };
+  return all;
+}
+
+/**
+ * @brief Opciones del benchmark.
+ */
+struct bench_options {
+  bool flag_h = false;
+  std::string server = "./docserver";
+  std::string loadgen = "./loadgen";
+  std::string corpus;
+  std::string sizes = "100:1";
+  std::vector<std::string> only;
+  uint16_t port = 18081;
+  double duration = 5.0;
+  int connections = 32;
+  bool csv = false;
+};
+
+void Usage(char* argv[]) {
+  std::cout << "Usage: " << argv[0]
+            << " -C <corpus> [--server <path>] [--loadgen <path>] [-p <port>]"
+            << " [-d <seconds>] [-c <connections>] [-z <size:weight,...>]"
+            << " [--only <a,b,...>] [--csv]\n";
+  std::cout << "Options:\n";
+  std::cout << "  -C, --corpus       Directory made by gen_corpus\n";
+  std::cout << "  -d, --duration     Seconds per variant (default 5)\n";
+  std::cout << "  -c, --connections  loadgen connections (default 32)\n";
+  std::cout << "  -z, --sizes        loadgen size mix (default 100:1)\n";
+  std::cout << "  --only             Run only these variants\n";
+  std::cout << "  --csv              Print CSV instead of a table\n";
+  std::cout << "Variants:\n";
+  for (const auto& v : variants()) {
+    std::string args;
+    for (const auto& arg : v.server_args) args += " " + arg;
+    std::cout << std::format("  {:<14}{}\n", v.name, args);
+  }
+}
+
+std::expected<bench_options, std::string> parse_args(int argc, char* argv[]) {
+  std::vector<std::string_view> args(argv + 1, argv + argc);
+  bench_options options;
+  for (auto it = args.begin(), end = args.end(); it != end; ++it) {
+    std::string_view option = *it;
+    if (option == "-h" || option == "--help") {
+      options.flag_h = true;
+      continue;
+    }
+    if (option == "--csv") {
+      options.csv = true;
+      continue;
+    }
+    if (++it == end) {
+      return std::unexpected(std::format("missing value for {}", option));
+    }
+    std::string value(*it);
+    try {
+      if (option == "-C" || option == "--corpus") {
+        options.corpus = value;
+      } else if (option == "--server") {
+        options.server = value;
+      } else if (option == "--loadgen") {
+        options.loadgen = value;
+      } else if (option == "-p" || option == "--port") {
+        options.port = static_cast<uint16_t>(std::stoul(value));
+      } else if (option == "-d" || option == "--duration") {
+        options.duration = std::stod(value);
+      } else if (option == "-c" || option == "--connections") {
+        options.connections = std::stoi(value);
+      } else if (option == "-z" || option == "--sizes") {
+        options.sizes = value;
+      } else if (option == "--only") {
+        std::string_view list = value;
+        while (!list.empty()) {
+          size_t comma = list.find(',');
+          options.only.emplace_back(list.substr(0, comma));
+          list = comma == std::string_view::npos ? "" : list.substr(comma + 1);
+        }
+      } else {
+        return std::unexpected(std::format("unknown option {}", option));
+      }
+    } catch (const std::exception&) {
+      return std::unexpected(std::format("invalid value for {}", option));
+    }
+  }
+  if (!options.flag_h && options.corpus.empty()) {
+    return std::unexpected("the corpus (-C) is required");
+  }
+  return options;
+}
+
+/**
+ * @brief Espera a que el servidor responda en el puerto (con /metrics).
+ */
+bool wait_for_port(uint16_t port, pid_t server, double timeout_s) {
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::duration<double>(timeout_s);
+  while (std::chrono::steady_clock::now() < deadline) {
+    int status;
+    if (waitpid(server, &status, WNOHANG) == server) {
+      return false;
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bool ok = connect(fd, reinterpret_cast<sockaddr*>(&address),
+                      sizeof(address)) == 0;
+    if (ok) {
+      constexpr std::string_view kProbe = "GET /metrics\n";
+      char buffer[4096];
+      ok = send(fd, kProbe.data(), kProbe.size(), MSG_NOSIGNAL) ==
+           static_cast<ssize_t>(kProbe.size());
+      while (ok && read(fd, buffer, sizeof(buffer)) > 0) {
+      }
+    }
+    close(fd);
+    if (ok) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  return false;
+}
+
+/**
+ * @brief Lanza un programa con la salida de errores descartada.
+ * @param capture Si no es nulo, recibe lo que escribe en stdout.
+ */
+pid_t launch(const std::vector<std::string>& argv, int* capture) {
+  int pipe_fd[2] = {-1, -1};
+  if (capture != nullptr && pipe(pipe_fd) < 0) {
+    return -1;
+  }
+  // Lo pendiente de la tabla no debe salir también por el hijo
+  std::cout.flush();
+  fflush(nullptr);
+  pid_t pid = fork();
+  if (pid == 0) {
+    if (capture != nullptr) {
+      dup2(pipe_fd[1], STDOUT_FILENO);
+      close(pipe_fd[0]);
+      close(pipe_fd[1]);
+    } else {
+      freopen("/dev/null", "w", stdout);
+    }
+    freopen("/dev/null", "w", stderr);
+    std::vector<char*> args;
+    for (const auto& arg : argv) args.push_back(const_cast<char*>(arg.c_str()));
+    args.push_back(nullptr);
+    execv(args[0], args.data());
+    _exit(127);
+  }
+  if (capture != nullptr) {
+    close(pipe_fd[1]);
+    *capture = pipe_fd[0];
+  }
+  return pid;
+}
+
+/**
+ * @brief Valor numérico de "key": en el JSON de loadgen, buscado a partir
+ * de from (para distinguir "latency_us" de "service_us").
+ */
+std::optional<double> json_number(std::string_view json, std::string_view from,
+                                  std::string_view key) {
+  size_t start = json.find(from);
+  if (start == std::string_view::npos) {
+    return std::nullopt;
+  }
+  size_t pos = json.find(std::format("\"{}\":", key), start);
+  if (pos == std::string_view::npos) {
+    return std::nullopt;
+  }
+  try {
+    return std::stod(std::string(json.substr(pos + key.size() + 3)));
+  } catch (const std::exception&) {
+    return std::nullopt;
+  }
+}
+
+/**
+ * @brief Resultado de una variante.
+ */
+struct result {
+  double rps = 0;
+  double p50 = 0;
+  double p99 = 0;
+  double p999 = 0;
+  double errors = 0;
+};
+
+std::expected<result, std::string> run_variant(const bench_options& options,
+                                               const variant& v) {
+  std::vector<std::string> server_argv = {
+      options.server, "-p", std::to_string(options.port), "-b",
+      options.corpus};
+  server_argv.insert(server_argv.end(), v.server_args.begin(),
+                     v.server_args.end());
+  pid_t server = launch(server_argv, nullptr);
+  if (server < 0 || !wait_for_port(options.port, server, 5.0)) {
+    if (server > 0) {
+      kill(server, SIGKILL);
+      waitpid(server, nullptr, 0);
+    }
+    return std::unexpected("the server did not start");
+  }
+
+  std::vector<std::string> loadgen_argv = {
+      options.loadgen, "-p", std::to_string(options.port),
+      "-d", std::format("{}", options.duration),
+      "-c", std::to_string(options.connections),
+      "-z", options.sizes, "--json"};
+  int output_fd = -1;
+  pid_t loadgen = launch(loadgen_argv, &output_fd);
+  std::string output;
+  if (loadgen > 0) {
+    char buffer[4096];
+    ssize_t got;
+    while ((got = read(output_fd, buffer, sizeof(buffer))) > 0) {
+      output.append(buffer, static_cast<size_t>(got));
+    }
+    close(output_fd);
+    waitpid(loadgen, nullptr, 0);
+  }
+  kill(server, SIGTERM);
+  waitpid(server, nullptr, 0);
+
+  auto rps = json_number(output, "{", "throughput_rps");
+  auto p50 = json_number(output, "\"latency_us\"", "p50");
+  auto p99 = json_number(output, "\"latency_us\"", "p99");
+  auto p999 = json_number(output, "\"latency_us\"", "p999");
+  auto errors = json_number(output, "{", "errors");
+  if (!rps || !p50 || !p99 || !p999 || !errors) {
+    return std::unexpected("loadgen failed");
+  }
+  return result{*rps, *p50, *p99, *p999, *errors};
+}
+
+int main(int argc, char* argv[]) {
+  auto parsed = parse_args(argc, argv);
+  if (!parsed) {
+    std::cerr << "Error: " << parsed.error() << "\n";
+    return EXIT_FAILURE;
+  }
+  const bench_options& options = *parsed;
+  if (options.flag_h) {
+    Usage(argv);
+    return EXIT_SUCCESS;
+  }
+
+  if (options.csv) {
+    std::cout << "variant,rps,p50_us,p99_us,p999_us,errors\n";
+  } else {
+    std::cout << std::format("{:<14} {:>10} {:>10} {:>10} {:>10} {:>8}\n",
+                             "variant", "req/s", "p50 us", "p99 us",
+                             "p99.9 us", "vs p50");
+  }
+  std::optional<double> baseline_p50;
+  for (const auto& v : variants()) {
+    if (!options.only.empty() &&
+        std::find(options.only.begin(), options.only.end(), v.name) ==
+            options.only.end() &&
+        std::string_view(v.name) != "baseline") {
+      continue;
+    }
+    auto r = run_variant(options, v);
+    if (!r) {
+      std::cerr << std::format("Error: {}: {}\n", v.name, r.error());
+      continue;
+    }
+    if (r->errors > 0) {
+      std::cerr << std::format("Warning: {}: {} failed requests\n", v.name,
+                               r->errors);
+    }
+    if (!baseline_p50) {
+      baseline_p50 = r->p50;
+    }
+    if (options.csv) {
+      std::cout << std::format("{},{:.1f},{:.1f},{:.1f},{:.1f},{}\n", v.name,
+                               r->rps, r->p50, r->p99, r->p999, r->errors);
+    } else {
+      std::cout << std::format(
+          "{:<14} {:>10.0f} {:>10.1f} {:>10.1f} {:>10.1f} {:>+7.1f}%\n",
+          v.name, r->rps, r->p50, r->p99, r->p999,
+          (r->p50 / *baseline_p50 - 1.0) * 100.0);
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,227 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: bench_spawn.cc
+ * Referencias:
+ *     man 3 posix_spawn, man 2 fork, man 2 clone
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <format>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "metrics.h"
+#include "safe_fd.h"
+#include "spawn.h"
+#include "tools_common.h"
+
+/**
+ * Microbenchmark del coste de lanzar un programa de /bin según cuánta
+ * memoria tenga mapeada el proceso que lo lanza.
+ *
+ * Para cada tamaño se mapea esa cantidad de memoria anónima con
+ * MAP_POPULATE (así existen todas sus tablas de páginas, como en un servidor
+ * con caché) y se lanza el programa una y otra vez con cada método:
+ *   posix_spawn  clone(CLONE_VM | CLONE_VFORK) dentro de glibc (spawn.cc)
+ *   fork_exec    fork() + execve(), lo que hacía la versión anterior
+ *
+ * Se mide "spawn" (hasta que el padre puede seguir) y "total" (hasta que el
+ * hijo termina). Las páginas de un archivo mapeado sin modificar no se
+ * copian en el fork, por eso se usa memoria anónima.
+ */
+
+/**
+ * @brief Opciones del benchmark.
+ */
+struct bench_options {
+  bool flag_h = false;
+  std::vector<uint64_t> sizes = {0, 64ull << 20, 256ull << 20, 1ull << 30};
+  std::vector<std::string> methods;
+  std::string program = "/bin/true";
+  double min_time = 0.3;  // Segundos por combinación
+  bool csv = false;
+};
+
+void Usage(char* argv[]) {
+  std::cout << "Usage: " << argv[0]
+            << " [--sizes <s1,s2,...>] [--methods <a,b>] [--program <path>]"
+            << " [--min-time <seconds>] [--csv]\n";
+  std::cout << "Options:\n";
+  std::cout << "  --sizes     Mapped memory before spawning"
+               " (default 0,64m,256m,1g)\n";
+  std::cout << "  --methods   Subset of: posix_spawn, fork_exec\n";
+  std::cout << "  --program   Program to launch (default /bin/true)\n";
+  std::cout << "  --min-time  Measuring time per combination (default 0.3)\n";
+  std::cout << "  --csv       Print CSV instead of a table\n";
+}
+
+std::vector<std::string> split(std::string_view text, char separator) {
+  std::vector<std::string> parts;
+  while (!text.empty()) {
+    size_t pos = text.find(separator);
+    parts.emplace_back(text.substr(0, pos));
+    if (pos == std::string_view::npos) break;
+    text.remove_prefix(pos + 1);
+  }
+  return parts;
+}
+
+std::expected<bench_options, std::string> parse_args(int argc, char* argv[]) {
+  std::vector<std::string_view> args(argv + 1, argv + argc);
+  bench_options options;
+  for (auto it = args.begin(), end = args.end(); it != end; ++it) {
+    std::string_view option = *it;
+    auto needs_value = [&]() { return ++it != end; };
+    if (option == "-h" || option == "--help") {
+      options.flag_h = true;
+    } else if (option == "--csv") {
+      options.csv = true;
+    } else if (option == "--sizes") {
+      if (!needs_value()) return std::unexpected("missing sizes");
+      options.sizes.clear();
+      for (const auto& part : split(*it, ',')) {
+        auto size = parse_size(part);
+        if (!size) {
+          return std::unexpected(std::format("invalid size {}", part));
+        }
+        options.sizes.push_back(*size);
+      }
+    } else if (option == "--methods") {
+      if (!needs_value()) return std::unexpected("missing methods");
+      options.methods = split(*it, ',');
+    } else if (option == "--program") {
+      if (!needs_value()) return std::unexpected("missing program");
+      options.program = *it;
+    } else if (option == "--min-time") {
+      if (!needs_value()) return std::unexpected("missing time");
+      try {
+        options.min_time = std::stod(std::string(*it));
+      } catch (const std::exception&) {
+        return std::unexpected("invalid time");
+      }
+    } else {
+      return std::unexpected(std::format("unknown option {}", option));
+    }
+  }
+  return options;
+}
+
+int main(int argc, char* argv[]) {
+  auto parsed = parse_args(argc, argv);
+  if (!parsed) {
+    std::cerr << "Error: " << parsed.error() << "\n";
+    return EXIT_FAILURE;
+  }
+  const bench_options& options = *parsed;
+  if (options.flag_h) {
+    Usage(argv);
+    return EXIT_SUCCESS;
+  }
+
+  std::vector<std::pair<std::string, spawn_method>> methods = {
+      {"posix_spawn", spawn_method::posix_spawn},
+      {"fork_exec", spawn_method::fork_exec}};
+  if (!options.methods.empty()) {
+    std::erase_if(methods, [&](const auto& m) {
+      return std::find(options.methods.begin(), options.methods.end(),
+                       m.first) == options.methods.end();
+    });
+    if (methods.empty()) {
+      std::cerr << "Error: no known method selected\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  SafeFD dev_null(open("/dev/null", O_WRONLY | O_CLOEXEC));
+  exec_environment environment = inherited_environment({});
+
+  if (options.csv) {
+    std::cout << "mapped,method,ops,spawn_p50_us,spawn_p99_us,total_p50_us,"
+                 "total_p99_us\n";
+  } else {
+    std::cout << std::format("{:<7} {:<12} {:>7} {:>14} {:>14} {:>14} {:>14}\n",
+                             "mapped", "method", "ops", "spawn_p50_us",
+                             "spawn_p99_us", "total_p50_us", "total_p99_us");
+  }
+
+  for (uint64_t size : options.sizes) {
+    void* memory = nullptr;
+    if (size != 0) {
+      memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+      if (memory == MAP_FAILED) {
+        std::cerr << std::format("Error: cannot map {}: {}\n",
+                                 format_size(size), std::strerror(errno));
+        return EXIT_FAILURE;
+      }
+    }
+
+    for (const auto& [name, method] : methods) {
+      LogLinearHistogram spawn_histogram, total_histogram;
+      uint64_t ops = 0;
+      uint64_t started = now_ns();
+      // Al menos 3 repeticiones y hasta agotar el tiempo por combinación
+      while (ops < 3 ||
+             static_cast<double>(now_ns() - started) / 1e9 < options.min_time) {
+        uint64_t begin = now_ns();
+        auto pid = spawn_program(options.program, environment,
+                                 {-1, dev_null.get()}, method);
+        uint64_t spawned = now_ns();
+        if (!pid) {
+          std::cerr << std::format("Error: cannot launch {}: {}\n",
+                                   options.program, std::strerror(pid.error()));
+          return EXIT_FAILURE;
+        }
+        waitpid(*pid, nullptr, 0);
+        uint64_t finished = now_ns();
+        spawn_histogram.record(spawned - begin);
+        total_histogram.record(finished - begin);
+        ++ops;
+        if (ops >= 100000) break;
+      }
+      histogram_snapshot spawn_snapshot, total_snapshot;
+      spawn_histogram.add_to(spawn_snapshot);
+      total_histogram.add_to(total_snapshot);
+      auto us = [](const histogram_snapshot& snapshot, double q) {
+        return static_cast<double>(snapshot.percentile(q)) / 1000.0;
+      };
+      if (options.csv) {
+        std::cout << std::format("{},{},{},{:.2f},{:.2f},{:.2f},{:.2f}\n", size,
+                                 name, ops, us(spawn_snapshot, 0.50),
+                                 us(spawn_snapshot, 0.99),
+                                 us(total_snapshot, 0.50),
+                                 us(total_snapshot, 0.99));
+      } else {
+        std::cout << std::format(
+            "{:<7} {:<12} {:>7} {:>14.2f} {:>14.2f} {:>14.2f} {:>14.2f}\n",
+            format_size(size), name, ops, us(spawn_snapshot, 0.50),
+            us(spawn_snapshot, 0.99), us(total_snapshot, 0.50),
+            us(total_snapshot, 0.99));
+      }
+      std::cout.flush();
+    }
+
+    if (memory != nullptr) {
+      munmap(memory, size);
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,423 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: bin_cache.cc
+ * Referencias:
+ *     RFC 5861 (stale-while-revalidate)
+ *     RFC 9111, sección 5.1 (cabecera Age)
+ */
+
+#include "bin_cache.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <format>
+#include <iostream>
+
+#include "docserver.h"
+#include "metrics.h"
+
+namespace {
+
+constexpr uint64_t kNsPerSecond = 1'000'000'000;
+
+/**
+ * @brief Lee un archivo pequeño entero.
+ */
+std::expected<std::string, int> read_small_file(const std::string& path) {
+  SafeFD fd(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (!fd.is_valid()) {
+    return std::unexpected(errno);
+  }
+  std::string text;
+  char buffer[4096];
+  while (text.size() < 65536) {
+    ssize_t bytes_read = read(fd.get(), buffer, sizeof(buffer));
+    if (bytes_read < 0 && errno == EINTR) continue;
+    if (bytes_read < 0) return std::unexpected(errno);
+    if (bytes_read == 0) break;
+    text.append(buffer, static_cast<size_t>(bytes_read));
+  }
+  return text;
+}
+
+std::string_view trim(std::string_view text) {
+  while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+    text.remove_prefix(1);
+  }
+  while (!text.empty() && (text.back() == ' ' || text.back() == '\t' ||
+                           text.back() == '\r')) {
+    text.remove_suffix(1);
+  }
+  return text;
+}
+
+}  // namespace
+
+std::expected<bin_cache_policy, int> parse_bin_cache_policy(
+    std::string_view text) {
+  bin_cache_policy policy;
+  while (!text.empty()) {
+    size_t end = text.find('\n');
+    std::string_view line = trim(text.substr(0, end));
+    text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+    if (line.empty() || line.front() == '#') {
+      continue;
+    }
+    size_t equals = line.find('=');
+    if (equals == std::string_view::npos) {
+      return std::unexpected(EINVAL);
+    }
+    std::string_view key = trim(line.substr(0, equals));
+    std::string_view value = trim(line.substr(equals + 1));
+    uint64_t seconds = 0;
+    auto [ptr, error] =
+        std::from_chars(value.data(), value.data() + value.size(), seconds);
+    if (error != std::errc() || ptr != value.data() + value.size() ||
+        seconds > UINT64_MAX / kNsPerSecond) {
+      return std::unexpected(EINVAL);
+    }
+    if (key == "ttl") {
+      policy.ttl_ns = seconds * kNsPerSecond;
+    } else if (key == "stale") {
+      policy.stale_ns = seconds * kNsPerSecond;
+    } else {
+      return std::unexpected(EINVAL);
+    }
+  }
+  return policy;
+}
+
+/**
+ * @brief Conexión que espera la salida de un relleno de la caché.
+ */
+class BinOutputCache::Waiter : public ResponseSource {
+ public:
+  /**
+   * @param delay_ns Lo que le queda de plazo a la petición.
+   */
+  Waiter(BinOutputCache* cache, std::string key, Connection& connection,
+         uint64_t delay_ns)
+      : cache_(cache), key_(std::move(key)), connection_(connection) {
+    timer_ = connection_.loop().add_timer(delay_ns, [this] { expire(); });
+  }
+
+  ~Waiter() override { detach(); }
+
+  void abort() override {
+    if (cache_ != nullptr) {
+      BinOutputCache* cache = cache_;
+      detach();
+      cache->remove_waiter(key_, this);
+    }
+  }
+
+  /**
+   * @brief Deja de esperar (ya se le responde o la caché desaparece).
+   */
+  void detach() {
+    cache_ = nullptr;
+    if (timer_ != 0) {
+      connection_.loop().cancel_timer(timer_);
+      timer_ = 0;
+    }
+  }
+
+  Connection& connection() { return connection_; }
+
+ private:
+  /**
+   * @brief Se acabó el plazo de esta petición; la ejecución sigue para las
+   * demás y para la caché.
+   */
+  void expire() {
+    timer_ = 0;
+    if (cache_ == nullptr) {
+      return;
+    }
+    abort();
+    std::cerr << "Error: " << key_ << ": 504 Gateway Timeout\n";
+    connection_.respond(status_line(504));
+  }
+
+  BinOutputCache* cache_;
+  std::string key_;
+  Connection& connection_;
+  uint64_t timer_ = 0;
+};
+
+BinOutputCache::BinOutputCache(EventLoop& loop, BinScheduler& scheduler,
+                               size_t max_bytes)
+    : loop_(loop),
+      scheduler_(scheduler),
+      max_bytes_(max_bytes),
+      metrics_id_(metrics_register_cache("bin_output")) {}
+
+BinOutputCache::~BinOutputCache() {
+  for (auto& [key, e] : entries_) {
+    if (e.fill) {
+      for (Waiter* waiter : e.fill->waiters) {
+        waiter->detach();
+      }
+      if (e.fill->deadline_timer != 0) {
+        loop_.cancel_timer(e.fill->deadline_timer);
+      }
+      if (e.fill->capture) {
+        e.fill->capture->abort();
+      }
+    }
+  }
+}
+
+std::optional<bin_cache_policy> BinOutputCache::policy_for(
+    const std::string& program) {
+  std::string path = base_dir + "/bin/" + program + ".cache";
+  struct stat info {};
+  if (stat(path.c_str(), &info) < 0) {
+    policies_.erase(program);
+    return std::nullopt;
+  }
+  // Se vuelve a leer solo si el archivo ha cambiado
+  auto it = policies_.find(program);
+  if (it != policies_.end() &&
+      it->second.mtime.tv_sec == info.st_mtim.tv_sec &&
+      it->second.mtime.tv_nsec == info.st_mtim.tv_nsec) {
+    return it->second.policy;
+  }
+  policy_file& file = policies_[program];
+  file.mtime = info.st_mtim;
+  file.policy.reset();
+  auto text = read_small_file(path);
+  if (!text) {
+    std::cerr << "Error: " << path << ": " << std::strerror(text.error())
+              << "\n";
+    return std::nullopt;
+  }
+  auto policy = parse_bin_cache_policy(*text);
+  if (!policy) {
+    std::cerr << "Error: " << path << ": invalid cache policy\n";
+    return std::nullopt;
+  }
+  if (policy->ttl_ns != 0) {
+    file.policy = *policy;
+  }
+  print_verbose("Cache: \"" + program + "\" con ttl " +
+                std::to_string(policy->ttl_ns / kNsPerSecond) + " s y stale " +
+                std::to_string(policy->stale_ns / kNsPerSecond) + " s");
+  return file.policy;
+}
+
+bool BinOutputCache::serve(Connection& connection, const bin_request& request) {
+  auto policy = policy_for(request.program);
+  if (!policy) {
+    return false;
+  }
+  std::string key = request.program + "?" + request.query;
+  entry& e = entries_[key];
+  e.policy = *policy;
+
+  uint64_t now = now_ns();
+  if (e.has_body) {
+    uint64_t age = now - e.stored_ns;
+    if (age < e.policy.ttl_ns + e.policy.stale_ns) {
+      metrics_cache_lookup(metrics_id_, true);
+      bool stale = age >= e.policy.ttl_ns;
+      // Mientras dure "stale" se sirve la salida vieja y se regenera aparte
+      // (a la vez que se responde; la respuesta no la espera)
+      connection.respond(std::format("Content-Length: {}\r\nAge: {}\r\n",
+                                     e.body.size(), age / kNsPerSecond),
+                         e.body);
+      if (stale) {
+        metrics_count(metric_counter::bin_cache_stale);
+        if (!e.fill) {
+          start_fill(key, e, request);
+        }
+      }
+      return true;
+    }
+  }
+
+  metrics_cache_lookup(metrics_id_, false);
+  bool in_flight = e.fill != nullptr;
+  if (in_flight) {
+    metrics_count(metric_counter::bin_cache_coalesced);
+  } else {
+    e.fill = std::make_unique<pending_fill>();
+  }
+  uint64_t deadline =
+      connection.accepted_at() + bin_timeout_ns(request.program);
+  auto waiter = std::make_unique<Waiter>(this, key, connection,
+                                         deadline > now ? deadline - now : 0);
+  e.fill->waiters.push_back(waiter.get());
+  connection.set_source(std::move(waiter));
+  if (!in_flight) {
+    start_fill(key, e, request);  // Puede terminar y borrar la entrada
+  }
+  return true;
+}
+
+std::vector<std::string> BinOutputCache::keys() const {
+  std::vector<std::string> result;
+  for (const auto& [key, e] : entries_) {
+    if (e.has_body) {
+      result.push_back(key);
+    }
+  }
+  return result;
+}
+
+void BinOutputCache::prewarm(const std::string& key) {
+  auto request = parse_bin_request("/bin/" + key);
+  if (!request) {
+    return;
+  }
+  auto policy = policy_for(request->program);
+  if (!policy) {
+    return;
+  }
+  entry& e = entries_[key];
+  if (e.has_body || e.fill) {
+    return;
+  }
+  e.policy = *policy;
+  start_fill(key, e, *request);
+}
+
+void BinOutputCache::start_fill(const std::string& key, entry& e,
+                                const bin_request& request) {
+  if (!e.fill) {
+    e.fill = std::make_unique<pending_fill>();
+  }
+  // El turno puede llegar (o negarse) antes de que submit() vuelva
+  scheduler_.submit(
+      request.program,
+      [this, key, request](uint64_t ticket) { run_fill(key, ticket, request); },
+      [this, key, program = request.program] {
+        std::cerr << "Error: " << program << ": 503 Service Unavailable\n";
+        complete_fill(key, std::unexpected(execute_program_error{0, EAGAIN}));
+      });
+}
+
+void BinOutputCache::run_fill(const std::string& key, uint64_t ticket,
+                              const bin_request& request) {
+  pending_fill& fill = *entries_.at(key).fill;
+  fill.ticket = ticket;
+  fill.capture = std::make_unique<BinCapture>(
+      loop_, base_dir + "/bin/" + request.program, kMaxEntrySize,
+      [this, key](std::expected<std::string, execute_program_error> result) {
+        complete_fill(key, std::move(result));
+      });
+  auto started = fill.capture->start(bin_request_environment(request));
+  if (!started) {
+    complete_fill(key, std::unexpected(started.error()));
+    return;
+  }
+  // La ejecución tiene su propio plazo, desde que empieza
+  fill.deadline_timer =
+      loop_.add_timer(bin_timeout_ns(request.program), [this, key] {
+        pending_fill& expired = *entries_.at(key).fill;
+        expired.deadline_timer = 0;
+        expired.capture->expire();  // Llega a complete_fill() con ETIMEDOUT
+      });
+}
+
+void BinOutputCache::complete_fill(
+    const std::string& key,
+    std::expected<std::string, execute_program_error> result) {
+  auto it = entries_.find(key);
+  if (it == entries_.end() || !it->second.fill) {
+    return;
+  }
+  entry& e = it->second;
+  std::unique_ptr<pending_fill> fill = std::move(e.fill);
+  if (fill->deadline_timer != 0) {
+    loop_.cancel_timer(fill->deadline_timer);
+  }
+  std::vector<Waiter*> waiters = std::move(fill->waiters);
+  for (Waiter* waiter : waiters) {
+    waiter->detach();
+  }
+
+  std::string header;
+  if (result) {
+    bytes_ -= e.body.size();
+    e.body = std::move(*result);
+    bytes_ += e.body.size();
+    e.has_body = true;
+    e.stored_ns = now_ns();
+    header = std::format("Content-Length: {}\r\nAge: 0\r\n", e.body.size());
+  } else {
+    int status = execute_error_status(result.error());
+    header = status_line(status);
+    if (result.error().codigo_error == EFBIG) {
+      std::cerr << "Error: " << key << ": output too large to cache\n";
+    } else if (result.error().codigo_error != EAGAIN) {
+      std::cerr << "Error: " << key << ": " << header << "\n";
+    }
+  }
+  // Copia: scheduler_.done() puede dar turno a otro relleno que termine
+  // enseguida y, al hacer sitio, borre esta entrada
+  std::string body = result ? e.body : std::string();
+  if (!e.has_body) {
+    entries_.erase(it);
+  }
+  if (fill->ticket != 0) {
+    scheduler_.done(fill->ticket);
+  }
+  for (Waiter* waiter : waiters) {
+    waiter->connection().respond(header, body);
+  }
+  evict(now_ns());
+  // fill (y su BinCapture, que puede estar llamándonos) se destruye aquí,
+  // después de su última llamada
+}
+
+void BinOutputCache::remove_waiter(const std::string& key, Waiter* waiter) {
+  auto it = entries_.find(key);
+  if (it == entries_.end() || !it->second.fill) {
+    return;
+  }
+  // El relleno sigue aunque ya no espere nadie: la salida se guarda igual
+  std::erase(it->second.fill->waiters, waiter);
+}
+
+void BinOutputCache::evict(uint64_t now) {
+  // Fuera lo que ya no se puede servir ni como salida vieja
+  std::erase_if(entries_, [&](const auto& item) {
+    const entry& e = item.second;
+    bool expired = e.has_body && now - e.stored_ns >=
+                                     e.policy.ttl_ns + e.policy.stale_ns;
+    if (e.fill || !expired) {
+      return false;
+    }
+    bytes_ -= e.body.size();
+    return true;
+  });
+  // Si aún no cabe, fuera las más antiguas (recorrido lineal: hay pocas)
+  while (bytes_ > max_bytes_) {
+    auto oldest = entries_.end();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (!it->second.fill && it->second.has_body &&
+          (oldest == entries_.end() ||
+           it->second.stored_ns < oldest->second.stored_ns)) {
+        oldest = it;
+      }
+    }
+    if (oldest == entries_.end()) {
+      break;
+    }
+    bytes_ -= oldest->second.body.size();
+    entries_.erase(oldest);
+  }
+}
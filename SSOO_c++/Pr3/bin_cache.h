@@ -0,0 +1,141 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: bin_cache.h
+ * Referencias:
+ *     RFC 5861 (stale-while-revalidate)
+ */
+
+#ifndef BIN_CACHE_H
+#define BIN_CACHE_H
+
+#include <sys/stat.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "bin_scheduler.h"
+#include "connection.h"
+#include "dynamic_content.h"
+#include "event_loop.h"
+
+/**
+ * Caché de la salida de los programas de /bin que la piden. Cada programa
+ * se configura con un archivo "<programa>.cache" junto a él en base_dir/bin:
+ *   ttl=<segundos>    Tiempo que la salida se sirve tal cual
+ *   stale=<segundos>  Tiempo de después en el que se sigue sirviendo la
+ *                     salida vieja mientras se regenera en segundo plano
+ * Las líneas vacías y las que empiezan por '#' se ignoran. Sin archivo (o
+ * con ttl=0) el programa se ejecuta en cada petición, como siempre.
+ */
+
+/**
+ * @brief Política de caché de un programa.
+ */
+struct bin_cache_policy {
+  uint64_t ttl_ns = 0;
+  uint64_t stale_ns = 0;
+};
+
+/**
+ * @brief Lee el contenido de un archivo "<programa>.cache".
+ * @return La política, o EINVAL si alguna línea no se entiende.
+ */
+std::expected<bin_cache_policy, int> parse_bin_cache_policy(
+    std::string_view text);
+
+/**
+ * @brief Caché de salidas de /bin, con clave programa + consulta.
+ *
+ * Solo se guardan salidas de ejecuciones correctas. Los fallos a la vez de
+ * una misma clave esperan a una sola ejecución (que pasa por el
+ * planificador como cualquier otra) y reciben todos su salida.
+ */
+class BinOutputCache {
+ public:
+  // Salida más grande que se guarda; una mayor se responde con un 500
+  static constexpr size_t kMaxEntrySize = 8u << 20;
+
+  BinOutputCache(EventLoop& loop, BinScheduler& scheduler,
+                 size_t max_bytes = 64u << 20);
+  ~BinOutputCache();
+
+  BinOutputCache(const BinOutputCache&) = delete;
+  BinOutputCache& operator=(const BinOutputCache&) = delete;
+
+  /**
+   * @brief Atiende la petición desde la caché si el programa la tiene.
+   * @return false si el programa no tiene caché: la petición sigue su
+   *         camino normal.
+   */
+  bool serve(Connection& connection, const bin_request& request);
+
+  /**
+   * @brief Claves ("<programa>?<consulta>") de las salidas guardadas, para
+   * que otro proceso las rellene con prewarm().
+   */
+  [[nodiscard]] std::vector<std::string> keys() const;
+
+  /**
+   * @brief Ejecuta el programa de una clave sin que nadie espere, para que
+   * las primeras peticiones ya encuentren su salida. No hace nada si la
+   * clave no es válida, su programa no tiene caché o ya hay salida.
+   */
+  void prewarm(const std::string& key);
+
+ private:
+  class Waiter;
+
+  struct pending_fill {
+    uint64_t ticket = 0;
+    uint64_t deadline_timer = 0;
+    std::unique_ptr<BinCapture> capture;
+    std::vector<Waiter*> waiters;  // Conexiones a la espera de la salida
+  };
+
+  struct entry {
+    std::string body;
+    bool has_body = false;
+    uint64_t stored_ns = 0;
+    bin_cache_policy policy;
+    std::unique_ptr<pending_fill> fill;
+  };
+
+  struct policy_file {
+    timespec mtime{};
+    std::optional<bin_cache_policy> policy;
+  };
+
+  std::optional<bin_cache_policy> policy_for(const std::string& program);
+  void start_fill(const std::string& key, entry& e, const bin_request& request);
+  void run_fill(const std::string& key, uint64_t ticket,
+                const bin_request& request);
+  void complete_fill(
+      const std::string& key,
+      std::expected<std::string, execute_program_error> result);
+  void remove_waiter(const std::string& key, Waiter* waiter);
+  void evict(uint64_t now);
+
+  EventLoop& loop_;
+  BinScheduler& scheduler_;
+  size_t max_bytes_;
+  size_t bytes_ = 0;
+  size_t metrics_id_;
+  std::unordered_map<std::string, entry> entries_;
+  std::unordered_map<std::string, policy_file> policies_;
+};
+
+#endif  // BIN_CACHE_H
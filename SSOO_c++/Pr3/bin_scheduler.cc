@@ -0,0 +1,155 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: bin_scheduler.cc
+ * Referencias:
+ *     Enunciado de la práctica
+ */
+
+#include "bin_scheduler.h"
+
+#include <algorithm>
+
+#include "metrics.h"
+
+BinScheduler::BinScheduler(EventLoop& loop, bin_scheduler_limits limits)
+    : loop_(loop), limits_(limits) {}
+
+bool BinScheduler::can_start(const job& j) {
+  size_t limit = j.program_limit != 0 ? j.program_limit : limits_.max_per_program;
+  if (programs_[j.program].running >= limit) {
+    return false;
+  }
+  return !j.counts_as_child || children_ < limits_.max_children;
+}
+
+uint64_t BinScheduler::estimated_wait_ns(const job& j) {
+  // Cada "ronda" de huecos libres dura lo que tarda de media el programa
+  const program_stats& stats = programs_[j.program];
+  size_t limit = j.program_limit != 0 ? j.program_limit : limits_.max_per_program;
+  uint64_t program_rounds = stats.queued / limit + 1;
+  uint64_t global_rounds =
+      j.counts_as_child ? queue_.size() / limits_.max_children + 1 : 0;
+  return std::max(program_rounds, global_rounds) * stats.mean_runtime_ns;
+}
+
+void BinScheduler::start(uint64_t ticket, job& j) {
+  j.running = true;
+  j.started_ns = now_ns();
+  metrics_observe(metric_histogram::bin_queue_wait,
+                  j.started_ns - j.submitted_ns);
+  ++programs_[j.program].running;
+  if (j.counts_as_child) {
+    ++children_;
+  }
+  metrics_gauge_add(metric_gauge::bin_running, 1);
+  // start() puede terminar enseguida y llamar a done(ticket)
+  start_callback run = std::move(j.start);
+  run(ticket);
+}
+
+uint64_t BinScheduler::submit(const std::string& program,
+                              start_callback start, callback reject,
+                              size_t program_limit, bool counts_as_child) {
+  uint64_t ticket = next_ticket_++;
+  job& j = jobs_[ticket];
+  j.program = program;
+  j.start = std::move(start);
+  j.reject = std::move(reject);
+  j.program_limit = program_limit;
+  j.counts_as_child = counts_as_child;
+  j.submitted_ns = now_ns();
+
+  // En la cola solo quedan peticiones que no pueden empezar, así que si
+  // esta puede no se adelanta a nadie
+  if (can_start(j)) {
+    this->start(ticket, j);
+    return ticket;
+  }
+  if (estimated_wait_ns(j) > limits_.queue_budget_ns) {
+    metrics_count(metric_counter::bin_rejected);
+    callback reject_callback = std::move(j.reject);
+    jobs_.erase(ticket);
+    reject_callback();
+    return ticket;
+  }
+  j.position = queue_.insert(queue_.end(), ticket);
+  ++programs_[program].queued;
+  metrics_gauge_add(metric_gauge::bin_queued, 1);
+  j.timer = loop_.add_timer(limits_.queue_budget_ns,
+                            [this, ticket] { expire(ticket); });
+  return ticket;
+}
+
+void BinScheduler::expire(uint64_t ticket) {
+  auto it = jobs_.find(ticket);
+  if (it == jobs_.end() || it->second.running) {
+    return;
+  }
+  job& j = it->second;
+  queue_.erase(j.position);
+  --programs_[j.program].queued;
+  metrics_gauge_add(metric_gauge::bin_queued, -1);
+  metrics_count(metric_counter::bin_rejected);
+  callback reject_callback = std::move(j.reject);
+  jobs_.erase(it);
+  reject_callback();
+}
+
+void BinScheduler::done(uint64_t ticket) {
+  auto it = jobs_.find(ticket);
+  if (it == jobs_.end()) {
+    return;
+  }
+  job& j = it->second;
+  program_stats& stats = programs_[j.program];
+  if (j.running) {
+    --stats.running;
+    if (j.counts_as_child) {
+      --children_;
+    }
+    metrics_gauge_add(metric_gauge::bin_running, -1);
+    uint64_t runtime = now_ns() - j.started_ns;
+    stats.mean_runtime_ns = stats.mean_runtime_ns == 0
+                                ? runtime
+                                : (stats.mean_runtime_ns * 7 + runtime) / 8;
+  } else {
+    queue_.erase(j.position);
+    --stats.queued;
+    metrics_gauge_add(metric_gauge::bin_queued, -1);
+    loop_.cancel_timer(j.timer);
+  }
+  jobs_.erase(it);
+  pump();
+}
+
+void BinScheduler::pump() {
+  if (pumping_) {
+    return;  // Un start() que terminó enseguida: sigue el bucle de fuera
+  }
+  pumping_ = true;
+  // Se vuelve a recorrer desde el principio tras cada start(), que puede
+  // haber cambiado la cola
+  while (true) {
+    auto it = std::find_if(queue_.begin(), queue_.end(), [this](uint64_t t) {
+      return can_start(jobs_[t]);
+    });
+    if (it == queue_.end()) {
+      break;
+    }
+    uint64_t ticket = *it;
+    job& j = jobs_[ticket];
+    queue_.erase(it);
+    --programs_[j.program].queued;
+    metrics_gauge_add(metric_gauge::bin_queued, -1);
+    loop_.cancel_timer(j.timer);
+    start(ticket, j);
+  }
+  pumping_ = false;
+}
@@ -0,0 +1,118 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: bin_scheduler.h
+ * Referencias:
+ *     Enunciado de la práctica
+ */
+
+#ifndef BIN_SCHEDULER_H
+#define BIN_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "event_loop.h"
+
+/**
+ * @brief Límites del planificador de /bin.
+ */
+struct bin_scheduler_limits {
+  size_t max_children = 32;              // Procesos a la vez en total
+  size_t max_per_program = 8;            // Procesos a la vez por programa
+  uint64_t queue_budget_ns = 2'000'000'000;  // Espera máxima en la cola
+};
+
+/**
+ * @brief Control de admisión de las peticiones de /bin.
+ *
+ * Cada petición pide turno. Si hay hueco (en total y para su programa)
+ * empieza enseguida; si no, espera en una cola FIFO en la que se salta a
+ * las que no pueden empezar porque su programa está al límite. Se rechaza
+ * (503) al llegar si la espera estimada con el tiempo medio de ejecución
+ * del programa ya supera el presupuesto, o al vencer ese plazo en la cola.
+ */
+class BinScheduler {
+ public:
+  using callback = std::function<void()>;
+  using start_callback = std::function<void(uint64_t ticket)>;
+
+  BinScheduler(EventLoop& loop, bin_scheduler_limits limits);
+
+  /**
+   * @brief Pide turno para un programa.
+   * @param start Se llama con el turno cuando le toca (puede ser dentro de
+   *        submit(), antes de que este devuelva el turno).
+   * @param reject Se llama si se rechaza (también puede ser dentro).
+   * @param program_limit Límite para este programa (0 = max_per_program);
+   *        con workers es el tamaño del pool.
+   * @param counts_as_child Si ocupa un hueco del límite total de procesos
+   *        (las peticiones a workers no lanzan procesos).
+   * @return Turno para done() o cancel().
+   */
+  uint64_t submit(const std::string& program, start_callback start,
+                  callback reject, size_t program_limit = 0,
+                  bool counts_as_child = true);
+
+  /**
+   * @brief La petición terminó y deja su hueco a la siguiente.
+   */
+  void done(uint64_t ticket);
+
+  /**
+   * @brief Retira una petición que ya no hace falta (el cliente se fue),
+   * esté en la cola o en ejecución.
+   */
+  void cancel(uint64_t ticket) { done(ticket); }
+
+  [[nodiscard]] const bin_scheduler_limits& limits() const noexcept {
+    return limits_;
+  }
+
+ private:
+  struct job {
+    std::string program;
+    start_callback start;
+    callback reject;
+    size_t program_limit;
+    bool counts_as_child;
+    bool running = false;
+    uint64_t submitted_ns = 0;
+    uint64_t started_ns = 0;
+    uint64_t timer = 0;
+    std::list<uint64_t>::iterator position;
+  };
+
+  struct program_stats {
+    size_t running = 0;
+    size_t queued = 0;
+    uint64_t mean_runtime_ns = 0;  // Media móvil exponencial
+  };
+
+  bool can_start(const job& j);
+  void start(uint64_t ticket, job& j);
+  void pump();
+  void expire(uint64_t ticket);
+  uint64_t estimated_wait_ns(const job& j);
+
+  EventLoop& loop_;
+  bin_scheduler_limits limits_;
+  uint64_t next_ticket_ = 1;
+  size_t children_ = 0;
+  std::unordered_map<uint64_t, job> jobs_;
+  std::list<uint64_t> queue_;
+  std::unordered_map<std::string, program_stats> programs_;
+  bool pumping_ = false;
+};
+
+#endif  // BIN_SCHEDULER_H
@@ -0,0 +1,554 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: bin_workers.cc
+ * Referencias:
+ *     Enunciado de la práctica
+ *     FastCGI Specification (workers persistentes)
+ */
+
+#include "bin_workers.h"
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+#include "bin_cache.h"
+#include "docserver.h"
+#include "metrics.h"
+#include "tracing.h"
+
+namespace {
+
+constexpr uint64_t kNsPerMs = 1'000'000;
+// Para escribir la trama de petición; la respuesta tiene el plazo de la
+// petición (bin_timeout_ns())
+constexpr uint64_t kRequestTimeoutNs = 5000 * kNsPerMs;
+// Para escribir el ping y recibir su respuesta
+constexpr uint64_t kPingTimeoutNs = 1000 * kNsPerMs;
+// Un worker que lleva este tiempo sin usarse se comprueba antes de reusarlo
+constexpr uint64_t kHealthCheckIdleNs = 5000 * kNsPerMs;
+constexpr uint64_t kMaxBackoffNs = 5000 * kNsPerMs;
+constexpr uint32_t kMaxFrame = 64u << 20;
+
+size_t workers_per_program = 0;
+std::unordered_map<std::string, std::unique_ptr<BinWorkerPool>> pools;
+
+/**
+ * @brief Trama del protocolo: longitud en 4 bytes big-endian + payload.
+ */
+std::string make_frame(std::string_view payload) {
+  auto length = static_cast<uint32_t>(payload.size());
+  std::string frame{
+      static_cast<char>(length >> 24), static_cast<char>(length >> 16),
+      static_cast<char>(length >> 8), static_cast<char>(length)};
+  frame += payload;
+  return frame;
+}
+
+}  // namespace
+
+BinWorkerPool::BinWorkerPool(std::string program_path, size_t max_workers)
+    : program_path_(std::move(program_path)), max_workers_(max_workers) {}
+
+BinWorkerPool::~BinWorkerPool() {
+  while (!idle_.empty()) {
+    retire(idle_.front());
+    idle_.pop_front();
+  }
+}
+
+std::expected<BinWorkerPool::worker, int> BinWorkerPool::spawn() {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+    return std::unexpected(errno);
+  }
+  SafeFD parent_end(fds[0]);
+  SafeFD child_end(fds[1]);
+
+  exec_environment environment = inherited_environment(
+      {"DOCSERVER_WORKER=1", "SERVER_BASEDIR=" + base_dir}, base_dir + "/bin");
+  auto pid = spawn_program(program_path_, environment,
+                           {child_end.get(), child_end.get()});
+  if (!pid) {
+    return std::unexpected(pid.error());
+  }
+
+  metrics_count(metric_counter::bin_worker_spawns);
+  ++live_;
+  worker w;
+  w.pid = *pid;
+  w.fd = std::move(parent_end);
+  w.last_used_ns = now_ns();
+  print_verbose("Worker: \"" + program_path_ + "\" lanzado (pid " +
+                std::to_string(*pid) + ")");
+  return w;
+}
+
+void BinWorkerPool::retire(worker& w, rusage* usage) {
+  if (w.pid <= 0) {
+    return;
+  }
+  w.fd = SafeFD();
+  kill(w.pid, SIGKILL);
+  wait4(w.pid, nullptr, 0, usage);
+  print_verbose("Worker: pid " + std::to_string(w.pid) + " terminado");
+  w.pid = -1;
+  --live_;
+}
+
+void BinWorkerPool::note_failure() {
+  metrics_count(metric_counter::bin_worker_failures);
+  // Un fallo suelto se relanza enseguida; si se repiten, espera exponencial
+  // para no relanzar en bucle un programa que se cae al arrancar
+  failures_ = std::min(failures_ + 1, 16u);
+  if (failures_ > 1) {
+    uint64_t backoff = std::min<uint64_t>((50 * kNsPerMs) << failures_,
+                                          kMaxBackoffNs);
+    retry_after_ns_ = now_ns() + backoff;
+  }
+}
+
+bool BinWorkerPool::healthy(const worker& w) {
+  // Un worker libre no debe tener nada que leer: si lo hay, murió (EOF) o
+  // escribió algo fuera de turno. poll() sin espera: no bloquea
+  pollfd pfd{w.fd.get(), POLLIN, 0};
+  return poll(&pfd, 1, 0) == 0;
+}
+
+std::expected<BinWorkerPool::worker, int> BinWorkerPool::acquire() {
+  while (!idle_.empty()) {
+    worker w = std::move(idle_.front());
+    idle_.pop_front();
+    if (healthy(w)) {
+      w.needs_ping = now_ns() - w.last_used_ns >= kHealthCheckIdleNs;
+      return w;
+    }
+    retire(w);
+    note_failure();
+  }
+  if (live_ >= max_workers_) {
+    return std::unexpected(EAGAIN);
+  }
+  if (now_ns() < retry_after_ns_) {
+    return std::unexpected(EAGAIN);
+  }
+  auto w = spawn();
+  if (w) {
+    w->needs_ping = true;  // El primero dice si habla el protocolo
+  }
+  return w;
+}
+
+void BinWorkerPool::release(worker w) {
+  failures_ = 0;
+  w.answered = true;
+  w.last_used_ns = now_ns();
+  idle_.push_back(std::move(w));
+}
+
+void BinWorkerPool::discard(worker& w, rusage* usage) {
+  retire(w, usage);
+  note_failure();
+}
+
+void BinWorkerPool::ping_failed(worker& w, int error) {
+  if (w.answered || error == ETIMEDOUT) {
+    // Puede ser un arranque lento: cuenta como fallo, con su espera
+    discard(w);
+    return;
+  }
+  print_verbose("Worker: \"" + program_path_ +
+                "\" no contesta al ping, se ejecutará en cada petición");
+  retire(w);
+  speaks_protocol_ = false;
+}
+
+namespace {
+
+/**
+ * @brief Una petición de /bin en curso: espera turno y después habla con un
+ * worker o lanza el programa.
+ */
+class BinRequest : public ResponseSource {
+ public:
+  BinRequest(Connection& connection, bin_request request,
+             std::string program_path, BinWorkerPool* pool)
+      : connection_(connection),
+        request_(std::move(request)),
+        program_path_(std::move(program_path)),
+        pool_(pool) {}
+
+  ~BinRequest() override { abort(); }
+
+  void submit();
+  void abort() override;
+
+ private:
+  void on_deadline();
+  void run();
+  void run_process();
+  void send_request();
+  void exchange(std::string_view payload, uint64_t timeout_ns);
+  void on_worker_event(uint32_t events);
+  void on_worker_timeout();
+  void on_worker_reply();
+  void worker_failed(int error);
+  void respond_error(const execute_program_error& error);
+  void stop_worker_io();
+  void done();
+
+  Connection& connection_;
+  bin_request request_;
+  std::string program_path_;
+  BinWorkerPool* pool_;
+  uint64_t ticket_ = 0;
+  bool finished_ = false;
+
+  std::unique_ptr<BinProcess> process_;
+
+  std::optional<BinWorkerPool::worker> worker_;
+  bool pinging_ = false;  // La trama en curso es un ping
+  std::string out_;       // Trama por escribir al worker
+  size_t sent_ = 0;
+  std::string reply_;
+  uint64_t worker_watch_ = 0;
+  uint64_t worker_timer_ = 0;  // Plazo del ping o de escribir la petición
+  uint64_t worker_start_ = 0;
+  uint64_t deadline_timer_ = 0;
+};
+
+std::unique_ptr<BinScheduler> scheduler;
+std::unique_ptr<BinOutputCache> output_cache;
+
+void BinRequest::submit() {
+  // El plazo cuenta desde el accept(), así que incluye la espera en la cola
+  uint64_t deadline =
+      connection_.accepted_at() + bin_timeout_ns(request_.program);
+  uint64_t now = now_ns();
+  deadline_timer_ = connection_.loop().add_timer(
+      deadline > now ? deadline - now : 0, [this] { on_deadline(); });
+
+  bool workers = pool_ != nullptr && pool_->speaks_protocol();
+  ticket_ = scheduler->submit(
+      request_.program,
+      [this](uint64_t ticket) {
+        ticket_ = ticket;
+        run();
+      },
+      [this] {
+        std::cerr << "Error: " << request_.program
+                  << ": 503 Service Unavailable\n";
+        done();
+        connection_.respond(status_line(503));
+      },
+      workers ? pool_->max_workers() : 0, !workers);
+}
+
+void BinRequest::respond_error(const execute_program_error& error) {
+  int status = execute_error_status(error);
+  std::cerr << "Error: " << request_.program << ": " << status_line(status)
+            << "\n";
+  connection_.respond(status_line(status));
+}
+
+void BinRequest::run() {
+  TraceRequestScope scope(connection_.trace_id());
+  if (pool_ == nullptr || !pool_->speaks_protocol()) {
+    run_process();
+    return;
+  }
+  if (access(program_path_.c_str(), X_OK) < 0) {
+    execute_program_error error{0, errno};
+    done();
+    respond_error(error);
+    return;
+  }
+
+  uint64_t acquire_start = now_ns();
+  auto w = pool_->acquire();
+  trace_record("bin_acquire", acquire_start, now_ns());
+  if (!w) {
+    done();
+    respond_error(execute_program_error{0, w.error()});
+    return;
+  }
+  worker_ = std::move(*w);
+  worker_start_ = now_ns();
+  if (worker_->needs_ping) {
+    // Recién lanzado o mucho tiempo parado: antes, un ping
+    pinging_ = true;
+    exchange({}, kPingTimeoutNs);
+    return;
+  }
+  send_request();
+}
+
+void BinRequest::send_request() {
+  std::string payload;
+  for (const auto& variable : bin_request_variables(request_)) {
+    payload += variable;
+    payload += '\n';
+  }
+  pinging_ = false;
+  exchange(payload, kRequestTimeoutNs);
+}
+
+void BinRequest::exchange(std::string_view payload, uint64_t timeout_ns) {
+  // Tanto la trama como la respuesta van por el bucle: un worker que tarda
+  // en arrancar o en leer no lo para
+  out_ = make_frame(payload);
+  sent_ = 0;
+  reply_.clear();
+  if (worker_watch_ == 0) {
+    worker_watch_ = connection_.loop().watch(
+        worker_->fd.get(), EPOLLIN | EPOLLOUT,
+        [this](uint32_t events) { on_worker_event(events); });
+    if (worker_watch_ == 0) {
+      worker_failed(errno);
+      return;
+    }
+  } else {
+    connection_.loop().modify(worker_watch_, EPOLLIN | EPOLLOUT);
+  }
+  worker_timer_ = connection_.loop().add_timer(
+      timeout_ns, [this] { on_worker_timeout(); });
+}
+
+void BinRequest::on_worker_event(uint32_t events) {
+  TraceRequestScope scope(connection_.trace_id());
+  if ((events & EPOLLOUT) != 0 && sent_ < out_.size()) {
+    while (sent_ < out_.size()) {
+      ssize_t sent = send(worker_->fd.get(), out_.data() + sent_,
+                          out_.size() - sent_, MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (sent < 0 && errno == EINTR) continue;
+      if (sent < 0 && errno == EAGAIN) return;
+      if (sent < 0) {
+        worker_failed(errno);
+        return;
+      }
+      sent_ += static_cast<size_t>(sent);
+    }
+    connection_.loop().modify(worker_watch_, EPOLLIN);
+    if (!pinging_) {
+      // La respuesta tiene el plazo de la petición
+      connection_.loop().cancel_timer(worker_timer_);
+      worker_timer_ = 0;
+    }
+  }
+  if ((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0) {
+    on_worker_reply();
+  }
+}
+
+void BinRequest::on_worker_timeout() {
+  worker_timer_ = 0;
+  TraceRequestScope scope(connection_.trace_id());
+  worker_failed(ETIMEDOUT);
+}
+
+void BinRequest::on_worker_reply() {
+  TraceRequestScope scope(connection_.trace_id());
+  while (true) {
+    char buffer[65536];
+    ssize_t got = recv(worker_->fd.get(), buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (got < 0 && errno == EINTR) continue;
+    if (got < 0 && errno == EAGAIN) break;
+    if (got <= 0) {
+      worker_failed(got == 0 ? EPIPE : errno);
+      return;
+    }
+    reply_.append(buffer, static_cast<size_t>(got));
+  }
+  if (reply_.size() < 4) {
+    return;
+  }
+  auto byte = [this](size_t i) {
+    return uint32_t{static_cast<unsigned char>(reply_[i])};
+  };
+  uint32_t length = byte(0) << 24 | byte(1) << 16 | byte(2) << 8 | byte(3);
+  if (length > kMaxFrame || reply_.size() > 4 + size_t{length}) {
+    worker_failed(EPROTO);
+    return;
+  }
+  if (reply_.size() < 4 + size_t{length}) {
+    return;  // Falta parte de la trama
+  }
+  stop_worker_io();
+  if (pinging_) {
+    if (length != 0) {
+      worker_failed(EPROTO);
+      return;
+    }
+    trace_record("bin_ping", worker_start_, now_ns());
+    worker_start_ = now_ns();
+    send_request();
+    return;
+  }
+  trace_record("bin_worker", worker_start_, now_ns());
+  pool_->release(std::move(*worker_));
+  worker_.reset();
+  std::string body = reply_.substr(4);
+  done();
+  connection_.respond(std::format("Content-Length: {}\r\n", body.size()), body);
+}
+
+void BinRequest::worker_failed(int error) {
+  print_verbose("Worker: pid " + std::to_string(worker_->pid) +
+                " falló (errno: " + std::to_string(error) + ")");
+  stop_worker_io();
+  if (pinging_) {
+    // Aún no tiene la petición: se atiende de otra forma
+    bool fresh = !worker_->answered;
+    pool_->ping_failed(*worker_, error);
+    worker_.reset();
+    pinging_ = false;
+    if (fresh) {
+      run_process();
+    } else {
+      run();  // Otro libre o uno nuevo
+    }
+    return;
+  }
+  pool_->discard(*worker_);
+  worker_.reset();
+  done();
+  respond_error(execute_program_error{1, 0});
+}
+
+void BinRequest::stop_worker_io() {
+  if (worker_watch_ != 0) {
+    connection_.loop().unwatch(worker_watch_);
+    worker_watch_ = 0;
+  }
+  if (worker_timer_ != 0) {
+    connection_.loop().cancel_timer(worker_timer_);
+    worker_timer_ = 0;
+  }
+}
+
+void BinRequest::on_deadline() {
+  deadline_timer_ = 0;
+  if (finished_) {
+    return;
+  }
+  TraceRequestScope scope(connection_.trace_id());
+  if (process_) {
+    process_->expire();  // Responde (504) y acaba llamando a done()
+    return;
+  }
+  if (worker_) {
+    // El worker sigue con la petición: no vale para otra
+    stop_worker_io();
+    rusage usage{};
+    pool_->discard(*worker_, &usage);
+    record_expired_child(usage, true);
+    worker_.reset();
+  }
+  done();  // También si aún esperaba turno en la cola
+  std::cerr << "Error: " << request_.program << ": 504 Gateway Timeout\n";
+  connection_.respond(status_line(504));
+}
+
+void BinRequest::run_process() {
+  process_ = std::make_unique<BinProcess>(connection_, program_path_,
+                                          [this] { done(); });
+  auto started = process_->start(bin_request_environment(request_));
+  if (!started) {
+    done();
+    respond_error(started.error());
+  }
+}
+
+void BinRequest::done() {
+  if (deadline_timer_ != 0) {
+    connection_.loop().cancel_timer(deadline_timer_);
+    deadline_timer_ = 0;
+  }
+  if (!finished_) {
+    finished_ = true;
+    scheduler->done(ticket_);
+  }
+}
+
+void BinRequest::abort() {
+  if (deadline_timer_ != 0) {
+    connection_.loop().cancel_timer(deadline_timer_);
+    deadline_timer_ = 0;
+  }
+  if (worker_) {
+    // A mitad de una petición: su respuesta llegaría después, mejor otro
+    stop_worker_io();
+    pool_->discard(*worker_);
+    worker_.reset();
+  }
+  if (process_) {
+    process_->abort();
+  }
+  if (!finished_) {
+    finished_ = true;
+    scheduler->cancel(ticket_);
+  }
+}
+
+}  // namespace
+
+void bin_workers_configure(size_t workers) { workers_per_program = workers; }
+
+size_t bin_workers_per_program() { return workers_per_program; }
+
+void bin_workers_start(EventLoop& loop, const bin_scheduler_limits& limits) {
+  scheduler = std::make_unique<BinScheduler>(loop, limits);
+  output_cache = std::make_unique<BinOutputCache>(loop, *scheduler);
+}
+
+void bin_workers_serve(Connection& connection, const bin_request& request) {
+  if (output_cache->serve(connection, request)) {
+    return;
+  }
+  std::string program_path = base_dir + "/bin/" + request.program;
+  BinWorkerPool* pool = nullptr;
+  if (workers_per_program != 0) {
+    auto& slot = pools[request.program];
+    if (!slot) {
+      slot = std::make_unique<BinWorkerPool>(program_path, workers_per_program);
+    }
+    pool = slot.get();
+  }
+  auto pending = std::make_unique<BinRequest>(connection, request,
+                                              std::move(program_path), pool);
+  BinRequest* raw = pending.get();
+  connection.set_source(std::move(pending));
+  raw->submit();
+}
+
+std::vector<std::string> bin_workers_cache_keys() {
+  return output_cache->keys();
+}
+
+void bin_workers_prewarm(const std::vector<std::string>& keys) {
+  for (const auto& key : keys) {
+    output_cache->prewarm(key);
+  }
+}
+
+void bin_workers_shutdown() {
+  output_cache.reset();
+  pools.clear();
+}
@@ -0,0 +1,147 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: bin_workers.h
+ * Referencias:
+ *     Enunciado de la práctica
+ *     FastCGI Specification (workers persistentes)
+ */
+
+#ifndef BIN_WORKERS_H
+#define BIN_WORKERS_H
+
+#include <sys/resource.h>
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <string>
+#include <vector>
+
+#include "bin_scheduler.h"
+#include "connection.h"
+#include "dynamic_content.h"
+#include "event_loop.h"
+#include "safe_fd.h"
+
+/**
+ * Protocolo con los workers (por un socketpair conectado a su stdin/stdout):
+ *   - Cada mensaje es una trama: longitud en 4 bytes big-endian + contenido.
+ *   - Petición: líneas "CLAVE=valor\n" (ver bin_request_variables()).
+ *   - Respuesta: el cuerpo que se envía al cliente.
+ *   - Una trama vacía es un ping y el worker contesta con otra vacía.
+ * El worker se lanza con DOCSERVER_WORKER=1 en el entorno. Si al arrancar
+ * contesta al ping otra cosa (o sale), el programa se trata como uno normal
+ * (un proceso por petición); si tarda más del plazo, es un fallo más.
+ */
+
+/**
+ * @brief Pool de workers de un programa de /bin.
+ */
+class BinWorkerPool {
+ public:
+  struct worker {
+    pid_t pid = -1;
+    SafeFD fd;
+    uint64_t last_used_ns = 0;
+    bool answered = false;    // Ya ha atendido alguna petición
+    bool needs_ping = false;  // Comprobarlo antes de darle la petición
+  };
+
+  BinWorkerPool(std::string program_path, size_t max_workers);
+  ~BinWorkerPool();
+
+  BinWorkerPool(const BinWorkerPool&) = delete;
+  BinWorkerPool& operator=(const BinWorkerPool&) = delete;
+
+  /**
+   * @brief Un worker libre (comprobado) o uno nuevo si caben más.
+   * @return El worker, EAGAIN si no hay ni se puede lanzar otro o el errno
+   * de lanzarlo.
+   *
+   * No espera a nada: uno recién lanzado o que llevaba rato parado vuelve
+   * con needs_ping, y quien lo usa le hace el ping por el bucle de eventos.
+   */
+  std::expected<worker, int> acquire();
+
+  /**
+   * @brief Devuelve al pool un worker que respondió bien.
+   */
+  void release(worker w);
+
+  /**
+   * @brief Termina un worker que falló.
+   * @param usage Si no es nulo, recibe lo que consumió el worker.
+   */
+  void discard(worker& w, rusage* usage = nullptr);
+
+  /**
+   * @brief Termina un worker cuyo ping falló con error. Si era nuevo y
+   * contestó otra cosa o salió, el programa no habla el protocolo; si solo
+   * tardó (ETIMEDOUT), puede ser un arranque lento y cuenta como un fallo,
+   * con su espera antes de lanzar otro.
+   */
+  void ping_failed(worker& w, int error);
+
+  [[nodiscard]] bool speaks_protocol() const noexcept {
+    return speaks_protocol_;
+  }
+  [[nodiscard]] size_t max_workers() const noexcept { return max_workers_; }
+
+ private:
+  std::expected<worker, int> spawn();
+  static bool healthy(const worker& w);
+  void retire(worker& w, rusage* usage = nullptr);
+  void note_failure();
+
+  std::string program_path_;
+  size_t max_workers_;
+  size_t live_ = 0;              // Workers lanzados y sin retirar
+  std::deque<worker> idle_;      // Libres, el más antiguo delante
+  bool speaks_protocol_ = true;  // false: un proceso por petición
+  unsigned failures_ = 0;        // Fallos seguidos, para la espera
+  uint64_t retry_after_ns_ = 0;
+};
+
+/**
+ * @brief Activa los workers persistentes (0 = un proceso por petición).
+ */
+void bin_workers_configure(size_t workers_per_program);
+
+size_t bin_workers_per_program();
+
+/**
+ * @brief Prepara la atención de /bin en el bucle de eventos, con los
+ * límites de procesos y de cola indicados.
+ */
+void bin_workers_start(EventLoop& loop, const bin_scheduler_limits& limits);
+
+/**
+ * @brief Atiende una petición de /bin: pide turno al planificador y la
+ * resuelve con el pool de su programa, o lanzando el programa si los
+ * workers están desactivados o no habla el protocolo. La respuesta (o el
+ * error) se envía por la conexión.
+ */
+void bin_workers_serve(Connection& connection, const bin_request& request);
+
+/**
+ * @brief Claves de la caché de salidas de /bin, y su relleno en otro
+ * proceso (ver BinOutputCache::keys() y prewarm()).
+ */
+std::vector<std::string> bin_workers_cache_keys();
+void bin_workers_prewarm(const std::vector<std::string>& keys);
+
+/**
+ * @brief Termina todos los workers.
+ */
+void bin_workers_shutdown();
+
+#endif  // BIN_WORKERS_H
@@ -0,0 +1,206 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: block_sums_cache.cc
+ * Referencias:
+ *     A. Tridgell, P. Mackerras, "The rsync algorithm" (1996),
+ *     man 2 eventfd
+ */
+
+#include "block_sums_cache.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <string_view>
+
+#include "metrics.h"
+
+namespace {
+
+// Hasta este tamaño se suman en el acto: cuesta menos que ir y volver del
+// hilo
+constexpr size_t kInlineSumsBytes = 256 * 1024;
+// Cálculos encargados a la vez como mucho
+constexpr size_t kMaxPendingJobs = 64;
+
+}  // namespace
+
+BlockSumsCache::BlockSumsCache(EventLoop& loop, size_t max_entries)
+    : max_entries_(max_entries),
+      metrics_id_(metrics_register_cache("block_sums")),
+      loop_(loop),
+      event_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+  if (!event_fd_.is_valid()) {
+    return;  // Sin aviso del hilo, todo se suma en el acto
+  }
+  watch_id_ = loop_.watch(event_fd_.get(), EPOLLIN,
+                          [this](uint32_t) { on_done(); });
+  if (watch_id_ != 0) {
+    worker_ = std::thread([this] { run_worker(); });
+  }
+}
+
+BlockSumsCache::~BlockSumsCache() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_one();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+  if (watch_id_ != 0) {
+    loop_.unwatch(watch_id_);
+  }
+}
+
+BlockSumsCache::identity BlockSumsCache::identity_of(const struct stat& info) {
+  return {info.st_dev, info.st_ino, info.st_size, info.st_mtim};
+}
+
+bool BlockSumsCache::same_file(const identity& id, const struct stat& info) {
+  return same_file(id, identity_of(info));
+}
+
+bool BlockSumsCache::same_file(const identity& a, const identity& b) {
+  return a.device == b.device && a.inode == b.inode && a.size == b.size &&
+         a.mtime.tv_sec == b.mtime.tv_sec &&
+         a.mtime.tv_nsec == b.mtime.tv_nsec;
+}
+
+uint64_t BlockSumsCache::get(const std::string& path, const struct stat& info,
+                             const std::shared_ptr<const SafeMap>& content,
+                             sums_callback ready) {
+  auto it = entries_.find(path);
+  if (it != entries_.end()) {
+    if (same_file(it->second.id, info)) {
+      metrics_cache_lookup(metrics_id_, true);
+      lru_.splice(lru_.begin(), lru_, it->second.lru);
+      ready(content, it->second.sums);
+      return 0;
+    }
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+  }
+  metrics_cache_lookup(metrics_id_, false);
+  std::string_view data = content->get();
+  bool matches = static_cast<off_t>(data.size()) == info.st_size;
+  if (data.size() <= kInlineSumsBytes || !worker_.joinable()) {
+    job now{0, path, identity_of(info), matches, content,
+            std::make_shared<const file_sums>(compute_sums(data))};
+    if (now.store) {
+      store(now);
+    }
+    ready(content, now.sums);
+    return 0;
+  }
+
+  uint64_t number = 0;
+  auto found = pending_.find(path);
+  if (matches && found != pending_.end() &&
+      same_file(found->second.id, info)) {
+    number = found->second.number;  // Ya se están calculando
+  } else if (job_waiters_.size() >= kMaxPendingJobs) {
+    ready(content, nullptr);
+    return 0;
+  } else {
+    number = next_ticket_++;
+    if (matches) {
+      pending_[path] = {number, identity_of(info)};
+    }
+    {
+      std::lock_guard lock(mutex_);
+      jobs_.push_back({number, path, identity_of(info), matches, content,
+                       nullptr});
+    }
+    wake_.notify_one();
+  }
+  uint64_t ticket = next_ticket_++;
+  waiters_.emplace(ticket, std::move(ready));
+  job_waiters_[number].push_back(ticket);
+  return ticket;
+}
+
+void BlockSumsCache::run_worker() {
+  std::unique_lock lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+    if (stopping_) {
+      return;
+    }
+    job current = std::move(jobs_.front());
+    jobs_.pop_front();
+    lock.unlock();
+
+    current.sums = std::make_shared<const file_sums>(
+        compute_sums(current.content->get()));
+
+    lock.lock();
+    done_.push_back(std::move(current));
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t written =
+        write(event_fd_.get(), &one, sizeof(one));
+  }
+}
+
+void BlockSumsCache::on_done() {
+  uint64_t count = 0;
+  [[maybe_unused]] ssize_t bytes = read(event_fd_.get(), &count, sizeof(count));
+  std::vector<job> finished;
+  {
+    std::lock_guard lock(mutex_);
+    finished.swap(done_);
+  }
+  for (const auto& done : finished) {
+    auto found = pending_.find(done.path);
+    if (found != pending_.end() && found->second.number == done.number) {
+      pending_.erase(found);
+    }
+    if (done.store) {
+      store(done);
+    }
+    auto node = job_waiters_.extract(done.number);
+    if (node.empty()) {
+      continue;
+    }
+    for (uint64_t ticket : node.mapped()) {
+      // Se saca antes de llamarlo: al responder la conexión puede cerrarse
+      // y cancelar su ticket
+      auto waiter = waiters_.find(ticket);
+      if (waiter == waiters_.end()) {
+        continue;
+      }
+      sums_callback ready = std::move(waiter->second);
+      waiters_.erase(waiter);
+      ready(done.content, done.sums);
+    }
+  }
+}
+
+void BlockSumsCache::store(const job& done) {
+  if (max_entries_ == 0) {
+    return;
+  }
+  auto it = entries_.find(done.path);
+  if (it != entries_.end()) {
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+  }
+  lru_.push_front(done.path);
+  entry& e = entries_[done.path];
+  e.sums = done.sums;
+  e.id = done.id;
+  e.lru = lru_.begin();
+  while (entries_.size() > max_entries_) {
+    entries_.erase(lru_.back());
+    lru_.pop_back();
+  }
+}
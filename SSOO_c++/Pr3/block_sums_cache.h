@@ -0,0 +1,144 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: block_sums_cache.h
+ * Referencias:
+ *     A. Tridgell, P. Mackerras, "The rsync algorithm" (1996),
+ *     man 2 eventfd
+ */
+
+#ifndef BLOCK_SUMS_CACHE_H
+#define BLOCK_SUMS_CACHE_H
+
+#include <sys/stat.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "delta.h"
+#include "event_loop.h"
+#include "safe_fd.h"
+#include "safe_map.h"
+
+/**
+ * @brief Sumas de los bloques de los archivos, calculadas en segundo plano.
+ *
+ * Sumar un archivo de gigas recorre el mapeo entero, demasiado para el
+ * bucle de eventos, así que lo hace un hilo aparte, como en DigestCache: al
+ * acabar avisa por un eventfd y el bucle entrega las sumas a quienes las
+ * esperaban. Los archivos pequeños se suman en el acto. Una entrada vale
+ * mientras el archivo tenga el mismo dispositivo, inodo, tamaño y mtime, y
+ * se expulsan con LRU.
+ */
+class BlockSumsCache {
+ public:
+  /**
+   * @brief Recibe las sumas y el contenido del que son (el de la petición
+   * que encargó el cálculo, que puede no ser el mismo mapeo). sums es nulo
+   * si hay demasiados cálculos encargados.
+   */
+  using sums_callback =
+      std::function<void(const std::shared_ptr<const SafeMap>& content,
+                         const std::shared_ptr<const file_sums>& sums)>;
+
+  BlockSumsCache(EventLoop& loop, size_t max_entries);
+  ~BlockSumsCache();
+
+  BlockSumsCache(const BlockSumsCache&) = delete;
+  BlockSumsCache& operator=(const BlockSumsCache&) = delete;
+
+  /**
+   * @brief Sumas de content, el contenido de base_dir + path. Si ya están
+   * (o el archivo es pequeño) se llama a ready antes de volver; si no, se
+   * encargan al hilo y ready se llama desde el bucle cuando acabe.
+   * @param info stat() del archivo hecho antes de obtener content: si lo
+   * reemplazan entre medias, las sumas quedan con la identidad del viejo y
+   * nunca se vuelven a encontrar.
+   * @return El ticket para cancel() mientras se espera, o 0 si ready ya se
+   * ha llamado.
+   */
+  uint64_t get(const std::string& path, const struct stat& info,
+               const std::shared_ptr<const SafeMap>& content,
+               sums_callback ready);
+
+  /**
+   * @brief Deja de esperar (quien esperaba se ha ido). El cálculo sigue y
+   * sus sumas quedan para las peticiones siguientes.
+   */
+  void cancel(uint64_t ticket) { waiters_.erase(ticket); }
+
+ private:
+  struct identity {
+    dev_t device = 0;
+    ino_t inode = 0;
+    off_t size = 0;
+    timespec mtime{};
+  };
+  struct entry {
+    std::shared_ptr<const file_sums> sums;
+    identity id;
+    std::list<std::string>::iterator lru;
+  };
+  struct job {
+    uint64_t number = 0;
+    std::string path;
+    identity id;
+    bool store = false;  // Solo si content es de esa identidad
+    std::shared_ptr<const SafeMap> content;
+    std::shared_ptr<const file_sums> sums;  // Lo rellena el hilo
+  };
+  struct pending_job {
+    uint64_t number = 0;
+    identity id;
+  };
+
+  static identity identity_of(const struct stat& info);
+  static bool same_file(const identity& id, const struct stat& info);
+  static bool same_file(const identity& a, const identity& b);
+
+  void run_worker();
+  void on_done();
+  void store(const job& done);
+
+  size_t max_entries_;
+  size_t metrics_id_;
+  EventLoop& loop_;
+  SafeFD event_fd_;
+  uint64_t watch_id_ = 0;
+
+  // Solo del bucle de eventos
+  std::unordered_map<std::string, entry> entries_;
+  std::list<std::string> lru_;  // Delante, la usada más recientemente
+  std::unordered_map<std::string, pending_job> pending_;  // Por ruta
+  std::unordered_map<uint64_t, std::vector<uint64_t>> job_waiters_;
+  std::unordered_map<uint64_t, sums_callback> waiters_;  // Por ticket
+  uint64_t next_ticket_ = 1;  // También numera los cálculos
+
+  // Compartido con el hilo, bajo mutex_
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<job> jobs_;
+  std::vector<job> done_;
+  bool stopping_ = false;
+
+  std::thread worker_;
+};
+
+#endif  // BLOCK_SUMS_CACHE_H
@@ -0,0 +1,626 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: connection.cc
+ * Referencias:
+ *     Enunciado de la práctica
+ *     man 7 epoll, man 2 splice
+ */
+
+#include "connection.h"
+
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+
+#include "docserver.h"
+#include "metrics.h"
+#include "tracing.h"
+
+namespace {
+
+constexpr size_t kMaxRequestSize = 1024;
+// Trozos por sendmsg() (IOV_MAX es 1024; con más no se gana nada)
+constexpr size_t kMaxIovecs = 64;
+// Cuerpo más grande que cuenta en el histograma small_response
+constexpr uint64_t kSmallResponseBytes = 64u << 10;
+
+uint64_t header_timeout_ns = 10'000'000'000;
+uint64_t send_timeout_ns = 30'000'000'000;
+bool cork_enabled = false;
+SendScheduler* send_scheduler = nullptr;
+
+}  // namespace
+
+void connection_set_header_timeout(uint64_t header_ns) {
+  header_timeout_ns = header_ns;
+}
+
+void connection_set_send_timeout(uint64_t send_idle_ns) {
+  send_timeout_ns = send_idle_ns;
+}
+
+void connection_set_cork(bool cork) { cork_enabled = cork; }
+
+void connection_set_send_scheduler(SendScheduler* scheduler) {
+  send_scheduler = scheduler;
+}
+
+int response_status(std::string_view header) {
+  auto is_digit = [](char c) { return c >= '0' && c <= '9'; };
+  if (header.size() >= 3 && is_digit(header[0]) && is_digit(header[1]) &&
+      is_digit(header[2])) {
+    return (header[0] - '0') * 100 + (header[1] - '0') * 10 + (header[2] - '0');
+  }
+  return 200;
+}
+
+std::string_view status_line(int status) {
+  switch (status) {
+    case 400:
+      return "400 Bad Request";
+    case 403:
+      return "403 Forbidden";
+    case 404:
+      return "404 Not Found";
+    case 405:
+      return "405 Method Not Allowed";
+    case 413:
+      return "413 Content Too Large";
+    case 503:
+      return "503 Service Unavailable";
+    case 504:
+      return "504 Gateway Timeout";
+    case 507:
+      return "507 Insufficient Storage";
+    default:
+      return "500 Internal Server Error";
+  }
+}
+
+Connection::Connection(EventLoop& loop, SafeFD socket, const sockaddr_in& peer,
+                       uint64_t accepted_at)
+    : loop_(loop),
+      socket_(std::move(socket)),
+      peer_(peer),
+      accepted_at_(accepted_at),
+      trace_id_(trace_begin_request()) {
+  metrics_count(metric_counter::connections_accepted);
+  metrics_gauge_add(metric_gauge::open_connections, 1);
+}
+
+Connection::~Connection() {
+  on_close_ = nullptr;  // Quien la destruye ya sabe que se cierra
+  close();
+}
+
+bool Connection::start(request_handler on_request, close_handler on_close) {
+  on_request_ = std::move(on_request);
+  on_close_ = std::move(on_close);
+  interest_ = EPOLLIN;
+  watch_id_ = loop_.watch(socket_.get(), interest_,
+                          [this](uint32_t events) { on_event(events); });
+  if (watch_id_ == 0) {
+    return false;
+  }
+  // Un cliente que abre la conexión y envía la petición byte a byte (o
+  // nada) no puede retenerla más que el plazo
+  uint64_t waited = now_ns() - accepted_at_;
+  uint64_t delay = waited < header_timeout_ns ? header_timeout_ns - waited : 0;
+  header_timer_ = loop_.add_timer(delay, [this] { on_header_timeout(); });
+  return true;
+}
+
+void Connection::set_cork(bool on) {
+  int value = on ? 1 : 0;
+  setsockopt(socket_.get(), IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+  corked_ = on;
+}
+
+void Connection::on_header_timeout() {
+  header_timer_ = 0;
+  if ((request_done_ && !on_body_) || closed()) {
+    return;
+  }
+  if (on_body_) {
+    // Con el cuerpo, como al enviar: cuenta desde el último avance
+    uint64_t idle = now_ns() - last_body_ns_;
+    if (idle < header_timeout_ns) {
+      header_timer_ = loop_.add_timer(header_timeout_ns - idle,
+                                      [this] { on_header_timeout(); });
+      return;
+    }
+  }
+  TraceRequestScope scope(trace_id_);
+  metrics_count(metric_counter::header_timeouts);
+  print_verbose("Plazo de la petición vencido");
+  close();
+}
+
+void Connection::on_send_timeout() {
+  send_timer_ = 0;
+  if (closed() || drained()) {
+    return;
+  }
+  // El temporizador no se rearma en cada envío: al vencer se mira cuánto
+  // hace del último avance y, si hubo, se vuelve a armar por lo que falta
+  uint64_t idle = now_ns() - last_send_ns_;
+  if (idle < send_timeout_ns) {
+    send_timer_ = loop_.add_timer(send_timeout_ns - idle,
+                                  [this] { on_send_timeout(); });
+    return;
+  }
+  TraceRequestScope scope(trace_id_);
+  metrics_count(metric_counter::send_timeouts);
+  print_verbose("El cliente no lee la respuesta");
+  close();
+}
+
+void Connection::set_interest(uint32_t events) {
+  if (events != interest_) {
+    interest_ = events;
+    loop_.modify(watch_id_, events);
+  }
+}
+
+void Connection::on_event(uint32_t events) {
+  TraceRequestScope scope(trace_id_);
+  if (!request_done_ && (events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+    read_request();
+    return;
+  }
+  if (on_data_ && (events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+    read_stream();
+    if (closed()) {
+      return;
+    }
+  }
+  if (receiving_ && (events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+    on_readable_();
+    if (closed()) {
+      return;
+    }
+  }
+  // Un cliente que cierra se nota al escribirle (RST): EPOLLERR/EPOLLHUP.
+  // EPOLLRDHUP no basta, puede haber cerrado solo su mitad de escritura
+  if (events & (EPOLLERR | EPOLLHUP)) {
+    close();
+    return;
+  }
+  if (events & EPOLLOUT) {
+    if (send_scheduler != nullptr) {
+      // Se espera turno sin seguir vigilando el socket, que seguiría libre
+      set_interest(idle_interest());
+      wait_turn();
+    } else {
+      flush();
+    }
+  }
+}
+
+void Connection::read_request() {
+  uint64_t recv_start = now_ns();
+  bool eof = false;
+  while (request_.size() < kMaxRequestSize) {
+    std::array<char, kMaxRequestSize> buffer;
+    size_t want = kMaxRequestSize - request_.size();
+    ssize_t received = recv(socket_.get(), buffer.data(), want, 0);
+    if (received < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) break;
+      print_verbose("Error al recibir la petición");
+      close();
+      return;
+    }
+    if (received == 0) {
+      eof = true;
+      break;
+    }
+    request_.append(buffer.data(), static_cast<size_t>(received));
+  }
+  trace_record("recv", recv_start, now_ns());
+
+  // La petición es la primera línea: la espera sigue hasta tenerla entera
+  if (!eof && request_.size() < kMaxRequestSize &&
+      request_.find('\n') == std::string::npos) {
+    return;
+  }
+  request_done_ = true;
+  loop_.cancel_timer(header_timer_);
+  header_timer_ = 0;
+  set_interest(0);
+  if (request_.empty()) {
+    close();  // Conectó y se fue sin pedir nada
+    return;
+  }
+  print_verbose("Recv: Peticion recibida");
+  metrics_count(metric_counter::requests);
+  on_request_(*this, request_);
+}
+
+void Connection::respond(std::string_view header, std::string_view body) {
+  begin_response(response_status(header));
+  out_.append(header);
+  out_.append("\r\n");
+  out_.append(body);
+  count_body_bytes(body.size());
+  finish();
+}
+
+void Connection::respond(std::string_view header,
+                         std::shared_ptr<const SafeMap> body) {
+  begin_response(response_status(header));
+  out_.append(header);
+  out_.append("\r\n");
+  std::string_view data = body->get();
+  std::vector<body_segment> segments;
+  segments.push_back({std::move(body), data});
+  count_body_bytes(data.size());
+  segments_ = std::move(segments);
+  segment_ = 0;
+  segment_offset_ = 0;
+  finish();
+}
+
+void Connection::respond(std::string_view header,
+                         std::vector<body_segment> body) {
+  begin_response(response_status(header));
+  out_.append(header);
+  out_.append("\r\n");
+  for (const auto& segment : body) {
+    count_body_bytes(segment.data.size());
+  }
+  segments_ = std::move(body);
+  segment_ = 0;
+  segment_offset_ = 0;
+  finish();
+}
+
+void Connection::begin_response(int status) {
+  metrics_status(status);
+  response_start_ = now_ns();
+}
+
+void Connection::count_body_bytes(uint64_t bytes) {
+  response_bytes_ += bytes;
+  metrics_count(metric_counter::bytes_served, bytes);
+}
+
+void Connection::write(std::string_view data) {
+  out_.append(data);
+  flush();
+}
+
+void Connection::splice_from(int pipe_fd, size_t length,
+                             std::string_view prefix) {
+  out_.append(prefix);
+  splice_fd_ = pipe_fd;
+  splice_left_ = length;
+  flush();
+}
+
+bool Connection::drained() const noexcept {
+  return out_offset_ == out_.size() && segment_ == segments_.size() &&
+         splice_left_ == 0;
+}
+
+uint64_t Connection::pending_bytes() const noexcept {
+  uint64_t pending = out_.size() - out_offset_ + splice_left_;
+  for (size_t i = segment_; i < segments_.size(); ++i) {
+    pending += segments_[i].data.size();
+  }
+  return pending - (segment_ < segments_.size() ? segment_offset_ : 0);
+}
+
+void Connection::set_drained_callback(std::function<void()> callback) {
+  on_drained_ = std::move(callback);
+}
+
+void Connection::finish() {
+  finishing_ = true;
+  flush();
+}
+
+void Connection::flush() {
+  if (closed()) {
+    return;
+  }
+  if (waiting_turn_) {
+    wait_turn();  // Ya espera; solo cambia lo que le queda
+    return;
+  }
+  send(send_scheduler != nullptr ? send_scheduler->quantum() : SIZE_MAX);
+}
+
+void Connection::wait_turn() {
+  waiting_turn_ = true;
+  send_scheduler->wait_turn(watch_id_, pending_bytes(), send_weight_,
+                            [this](size_t quantum) {
+                              waiting_turn_ = false;
+                              TraceRequestScope scope(trace_id_);
+                              send(quantum);
+                            });
+}
+
+void Connection::send(size_t limit) {
+  if (closed()) {
+    return;
+  }
+  bool progress = false;
+  bool blocked = false;  // El socket no admite más (EAGAIN)
+  // Las cabeceras y lo que sale por splice() son dos llamadas: con el tapón
+  // se juntan en segmentos llenos y se quita al acabar esta vuelta
+  if (cork_enabled && !corked_ && peer_.sin_family == AF_INET &&
+      out_offset_ < out_.size() && splice_left_ > 0) {
+    set_cork(true);
+  }
+  // Cabeceras y cuerpo mapeado en una sola llamada, sin copiar el archivo
+  while ((out_offset_ < out_.size() || segment_ < segments_.size()) &&
+         limit > 0) {
+    std::array<iovec, kMaxIovecs> parts;
+    size_t count = 0;
+    if (out_offset_ < out_.size()) {
+      parts[count++] = {out_.data() + out_offset_, out_.size() - out_offset_};
+    }
+    for (size_t i = segment_; i < segments_.size() && count < parts.size();
+         ++i) {
+      std::string_view data = segments_[i].data;
+      if (i == segment_) {
+        data.remove_prefix(segment_offset_);
+      }
+      if (!data.empty()) {
+        parts[count++] = {const_cast<char*>(data.data()), data.size()};
+      }
+    }
+    if (count == 0) {
+      segment_ = segments_.size();  // Solo quedaban trozos vacíos
+      break;
+    }
+    // No más del cuanto: se recorta el vector
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+      if (parts[i].iov_len >= limit - total) {
+        parts[i].iov_len = limit - total;
+        count = i + 1;
+        break;
+      }
+      total += parts[i].iov_len;
+    }
+    msghdr message{};
+    message.msg_iov = parts.data();
+    message.msg_iovlen = count;
+    ssize_t sent = sendmsg(socket_.get(), &message, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) {
+        blocked = true;
+        break;
+      }
+      print_verbose("Error al enviar la respuesta");
+      close();
+      return;
+    }
+    progress = true;
+    auto written = static_cast<size_t>(sent);
+    limit -= written;
+    size_t from_out = std::min(written, out_.size() - out_offset_);
+    out_offset_ += from_out;
+    written -= from_out;
+    while (segment_ < segments_.size()) {
+      size_t left = segments_[segment_].data.size() - segment_offset_;
+      if (written < left) {
+        segment_offset_ += written;
+        break;
+      }
+      written -= left;
+      ++segment_;
+      segment_offset_ = 0;
+    }
+  }
+  if (out_offset_ == out_.size()) {
+    out_.clear();
+    out_offset_ = 0;
+  }
+  while (out_.empty() && splice_left_ > 0 && limit > 0) {
+    ssize_t moved = splice(splice_fd_, nullptr, socket_.get(), nullptr,
+                           std::min(splice_left_, limit),
+                           SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (moved < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) {
+        blocked = true;  // O la tubería está vacía: se sigue con EPOLLOUT
+        break;
+      }
+      print_verbose("Error al enviar la respuesta");
+      close();
+      return;
+    }
+    if (moved == 0) {
+      close();  // El programa cerró la tubería antes de lo anunciado
+      return;
+    }
+    progress = true;
+    splice_left_ -= static_cast<size_t>(moved);
+    limit -= static_cast<size_t>(moved);
+  }
+  if (corked_) {
+    set_cork(false);
+  }
+
+  uint64_t now = now_ns();
+  if (progress && !first_byte_sent_ && response_start_ != 0) {
+    first_byte_sent_ = true;
+    metrics_observe(metric_histogram::accept_to_first_byte,
+                    now - accepted_at_);
+  }
+
+  if (!drained()) {
+    if (progress || send_timer_ == 0) {
+      last_send_ns_ = now;
+    }
+    if (send_timer_ == 0) {
+      send_timer_ = loop_.add_timer(send_timeout_ns,
+                                    [this] { on_send_timeout(); });
+    }
+    if (blocked || limit > 0 || send_scheduler == nullptr) {
+      set_interest(idle_interest() | EPOLLOUT);
+    } else {
+      // Gastó su cuanto y el socket admite más: espera turno
+      set_interest(idle_interest());
+      wait_turn();
+    }
+    return;
+  }
+  loop_.cancel_timer(send_timer_);
+  send_timer_ = 0;
+  set_interest(idle_interest());
+  if (finishing_) {
+    if (response_start_ != 0) {
+      metrics_observe(metric_histogram::send, now - response_start_);
+      if (response_bytes_ <= kSmallResponseBytes) {
+        metrics_observe(metric_histogram::small_response, now - accepted_at_);
+      }
+      trace_record("send", response_start_, now);
+    }
+    close();
+    return;
+  }
+  if (on_drained_) {
+    on_drained_();
+  }
+}
+
+void Connection::set_source(std::unique_ptr<ResponseSource> source) {
+  source_ = std::move(source);
+}
+
+void Connection::take_over(data_handler on_data) {
+  on_data_ = std::move(on_data);
+  std::string received = std::move(request_);
+  request_.clear();
+  set_interest(interest_ | EPOLLIN);
+  if (!received.empty()) {
+    on_data_(*this, received);
+  }
+}
+
+std::string Connection::receive_body(std::function<void()> on_readable) {
+  on_readable_ = std::move(on_readable);
+  receiving_ = true;
+  set_interest(interest_ | EPOLLIN);
+  size_t line_end = request_.find('\n');
+  return line_end == std::string::npos ? std::string()
+                                       : request_.substr(line_end + 1);
+}
+
+void Connection::stop_receiving() {
+  // on_readable_ se queda: puede ser quien llama
+  receiving_ = false;
+  if (!closed()) {
+    set_interest(idle_interest() | (interest_ & EPOLLOUT));
+  }
+}
+
+void Connection::read_body(size_t length, body_handler on_body) {
+  on_body_ = std::move(on_body);
+  body_length_ = length;
+  body_ = receive_body([this] { read_body_data(); });
+  // Sin reservar length: lo dice el cliente y crece según llega
+  body_.resize(std::min(body_.size(), length));
+  last_body_ns_ = now_ns();
+  header_timer_ =
+      loop_.add_timer(header_timeout_ns, [this] { on_header_timeout(); });
+  read_body_data();
+}
+
+void Connection::read_body_data() {
+  std::array<char, 65536> buffer;
+  while (body_.size() < body_length_) {
+    size_t want = std::min(buffer.size(), body_length_ - body_.size());
+    ssize_t received = recv(socket_.get(), buffer.data(), want, 0);
+    if (received < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) return;
+      print_verbose("Error al recibir el cuerpo");
+      close();
+      return;
+    }
+    if (received == 0) {
+      close();  // El cliente se fue sin enviarlo entero
+      return;
+    }
+    body_.append(buffer.data(), static_cast<size_t>(received));
+    last_body_ns_ = now_ns();
+  }
+  stop_receiving();
+  loop_.cancel_timer(header_timer_);
+  header_timer_ = 0;
+  auto on_body = std::move(on_body_);
+  on_body_ = nullptr;
+  on_body(*this, std::move(body_));
+}
+
+uint32_t Connection::idle_interest() const noexcept {
+  return on_data_ || receiving_ ? EPOLLIN : 0u;
+}
+
+void Connection::read_stream() {
+  std::array<char, 16384> buffer;
+  while (!closed()) {
+    ssize_t received = recv(socket_.get(), buffer.data(), buffer.size(), 0);
+    if (received < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) return;
+      print_verbose("Error al recibir");
+      close();
+      return;
+    }
+    if (received == 0) {
+      close();  // El cliente ha cerrado
+      return;
+    }
+    on_data_(*this,
+             std::string_view(buffer.data(), static_cast<size_t>(received)));
+  }
+}
+
+void Connection::close() {
+  if (closed()) {
+    return;
+  }
+  if (send_scheduler != nullptr) {
+    send_scheduler->forget(watch_id_);
+    waiting_turn_ = false;
+  }
+  loop_.unwatch(watch_id_);
+  loop_.cancel_timer(header_timer_);
+  loop_.cancel_timer(send_timer_);
+  header_timer_ = send_timer_ = 0;
+  socket_ = SafeFD();
+  if (source_) {
+    source_->abort();
+  }
+  metrics_gauge_add(metric_gauge::open_connections, -1);
+  {
+    TraceRequestScope scope(trace_id_);
+    trace_record("request", accepted_at_, now_ns());
+  }
+  print_verbose("Conexión cerrada");
+  if (on_close_) {
+    auto on_close = std::move(on_close_);
+    on_close_ = nullptr;
+    on_close(*this);
+  }
+}
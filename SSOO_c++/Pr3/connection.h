@@ -0,0 +1,257 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: connection.h
+ * Referencias:
+ *     Enunciado de la práctica
+ *     man 7 epoll, man 2 splice
+ */
+
+#ifndef CONNECTION_H
+#define CONNECTION_H
+
+#include <netinet/in.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "event_loop.h"
+#include "safe_fd.h"
+#include "safe_map.h"
+#include "send_scheduler.h"
+
+/**
+ * @brief Lo que está generando la respuesta de una conexión (un programa de
+ * /bin, por ejemplo). La conexión lo mantiene vivo hasta destruirse y le
+ * avisa con abort() si se cierra antes de tiempo.
+ */
+class ResponseSource {
+ public:
+  virtual ~ResponseSource() = default;
+  virtual void abort() {}
+};
+
+/**
+ * @brief Trozo del cuerpo de una respuesta que se envía sin copiarlo: data
+ * apunta a memoria que owner mantiene viva (un archivo mapeado, un texto).
+ */
+struct body_segment {
+  std::shared_ptr<const void> owner;
+  std::string_view data;
+};
+
+/**
+ * @brief Código de estado de una respuesta: las de error empiezan por él
+ * ("404 Not Found") y las correctas solo llevan cabeceras.
+ */
+int response_status(std::string_view header);
+
+/**
+ * @brief Línea de estado de una respuesta de error ("404 Not Found").
+ */
+std::string_view status_line(int status);
+
+/**
+ * @brief Plazos de las conexiones. header_ns: para recibir la petición
+ * entera, contado desde que se aceptó (por defecto 10 s). send_idle_ns:
+ * tiempo sin poder enviar nada porque el cliente no lee (por defecto 30 s).
+ * Al vencer se cierra la conexión.
+ */
+void connection_set_header_timeout(uint64_t header_ns);
+void connection_set_send_timeout(uint64_t send_idle_ns);
+
+/**
+ * @brief Con cork, mientras se envían juntas las cabeceras y un cuerpo que
+ * sale aparte (splice() o trozos) se pone TCP_CORK, para que las cabeceras
+ * no viajen solas en un segmento pequeño.
+ */
+void connection_set_cork(bool cork);
+
+/**
+ * @brief Con scheduler, cada conexión envía como mucho un cuanto seguido y,
+ * si le queda, espera turno en él (ver SendScheduler); con nullptr, envía
+ * hasta llenar el socket.
+ */
+void connection_set_send_scheduler(SendScheduler* scheduler);
+
+/**
+ * @brief Conexión con un cliente dentro del bucle de eventos.
+ *
+ * Lee una petición (hasta el primer salto de línea, 1024 bytes o el cierre
+ * del cliente), se la pasa al manejador y envía la respuesta sin bloquearse.
+ * Como antes, se cierra tras una respuesta (salvo con take_over()).
+ *
+ * La salida pendiente se envía en este orden: lo escrito con write(), el
+ * cuerpo mapeado (o sus trozos) de respond() y los bytes de splice_from(). Quien genera la
+ * respuesta por partes espera a drained() antes de añadir más.
+ */
+class Connection {
+ public:
+  using request_handler = std::function<void(Connection&, std::string_view)>;
+  using close_handler = std::function<void(Connection&)>;
+  using data_handler = std::function<void(Connection&, std::string_view)>;
+  using body_handler = std::function<void(Connection&, std::string body)>;
+
+  /**
+   * @param peer Dirección del cliente; con sin_family == AF_UNIX (y sin
+   * dirección) si llegó por un socket Unix.
+   */
+  Connection(EventLoop& loop, SafeFD socket, const sockaddr_in& peer,
+             uint64_t accepted_at);
+  ~Connection();
+
+  Connection(const Connection&) = delete;
+  Connection& operator=(const Connection&) = delete;
+
+  /**
+   * @brief Empieza a esperar la petición.
+   * @param on_close Se llama una vez al cerrarse; la conexión no debe
+   * destruirse dentro del propio evento, sino después.
+   */
+  bool start(request_handler on_request, close_handler on_close);
+
+  /**
+   * @brief Respuesta completa: cabecera + "\r\n" + cuerpo. Se cierra la
+   * conexión cuando termina de enviarse.
+   */
+  void respond(std::string_view header, std::string_view body = {});
+  /**
+   * @brief Igual, con el cuerpo de un archivo mapeado, que se envía sin
+   * copiarlo; puede estar compartido con otras respuestas (FileCache).
+   */
+  void respond(std::string_view header, std::shared_ptr<const SafeMap> body);
+  /**
+   * @brief Igual, con el cuerpo hecho de varios trozos seguidos: cada
+   * sendmsg() lleva las cabeceras y todos los trozos que quepan en su vector.
+   */
+  void respond(std::string_view header, std::vector<body_segment> body);
+
+  /**
+   * @brief Anota el código de la respuesta que se va a enviar por partes.
+   */
+  void begin_response(int status);
+  void write(std::string_view data);
+  /**
+   * @brief Envía length bytes de la tubería, precedidos de prefix (la
+   * cabecera de un trozo, por ejemplo) en la misma vuelta.
+   */
+  void splice_from(int pipe_fd, size_t length, std::string_view prefix = {});
+  void count_body_bytes(uint64_t bytes);
+  [[nodiscard]] bool drained() const noexcept;
+  /**
+   * @brief Peso de la conexión con la política weighted_fair (por defecto
+   * 1): con el doble de peso, el doble de bytes por turno.
+   */
+  void set_send_weight(uint32_t weight) { send_weight_ = weight; }
+  void set_drained_callback(std::function<void()> callback);
+  /**
+   * @brief Cierra la conexión cuando se haya enviado todo lo pendiente.
+   */
+  void finish();
+  void close();
+
+  void set_source(std::unique_ptr<ResponseSource> source);
+
+  /**
+   * @brief Deja de ser una petición y una respuesta para pasar a ser un
+   * flujo en los dos sentidos (HTTP/2): lo recibido hasta ahora, petición
+   * incluida, y lo que vaya llegando se entrega a on_data, y lo escrito con
+   * write() se envía según se pueda. Se cierra cuando cierra el cliente,
+   * con finish() o con close().
+   */
+  void take_over(data_handler on_data);
+
+  /**
+   * @brief Para recibir un cuerpo detrás de la petición leyéndolo
+   * directamente del socket (con splice(), por ejemplo): on_readable se
+   * llama cada vez que hay algo que leer o el cliente ha cerrado su mitad,
+   * hasta stop_receiving() o close().
+   * @return Lo que ya se había recibido detrás de la primera línea.
+   */
+  std::string receive_body(std::function<void()> on_readable);
+  void stop_receiving();
+  /**
+   * @brief Recibe length bytes de cuerpo detrás de la petición y se los
+   * pasa a on_body. El plazo de la petición cuenta desde lo último que
+   * llegó; si el cliente cierra antes o vence el plazo, se cierra la
+   * conexión.
+   */
+  void read_body(size_t length, body_handler on_body);
+  [[nodiscard]] int socket_fd() const noexcept { return socket_.get(); }
+
+  EventLoop& loop() noexcept { return loop_; }
+  [[nodiscard]] const sockaddr_in& peer() const noexcept { return peer_; }
+  [[nodiscard]] uint64_t accepted_at() const noexcept { return accepted_at_; }
+  [[nodiscard]] uint64_t trace_id() const noexcept { return trace_id_; }
+  [[nodiscard]] bool closed() const noexcept { return !socket_.is_valid(); }
+
+ private:
+  void on_event(uint32_t events);
+  void read_request();
+  void read_stream();
+  void read_body_data();
+  [[nodiscard]] uint32_t idle_interest() const noexcept;
+  void flush();
+  void send(size_t limit);
+  void wait_turn();
+  [[nodiscard]] uint64_t pending_bytes() const noexcept;
+  void set_interest(uint32_t events);
+  void set_cork(bool on);
+  void on_header_timeout();
+  void on_send_timeout();
+
+  EventLoop& loop_;
+  SafeFD socket_;
+  sockaddr_in peer_;
+  uint64_t accepted_at_;
+  uint64_t trace_id_;
+  uint64_t watch_id_ = 0;
+  uint32_t interest_ = 0;
+
+  request_handler on_request_;
+  close_handler on_close_;
+  data_handler on_data_;  // Solo tras take_over()
+  std::function<void()> on_readable_;  // Solo tras receive_body()
+  bool receiving_ = false;
+  body_handler on_body_;  // Solo mientras read_body() no ha acabado
+  std::string body_;
+  size_t body_length_ = 0;
+  uint64_t last_body_ns_ = 0;  // Último avance del cuerpo
+  std::function<void()> on_drained_;
+  std::unique_ptr<ResponseSource> source_;
+
+  std::string request_;
+  bool request_done_ = false;
+
+  std::string out_;  // Pendiente de enviar (cabeceras, trozos...)
+  size_t out_offset_ = 0;
+  std::vector<body_segment> segments_;  // Cuerpo sin copiar, tras out_
+  size_t segment_ = 0;                  // Primer trozo sin enviar entero
+  size_t segment_offset_ = 0;           // Lo ya enviado de ese trozo
+  int splice_fd_ = -1;  // Tubería de la que quedan splice_left_ bytes
+  size_t splice_left_ = 0;
+  bool corked_ = false;
+  uint32_t send_weight_ = 1;
+  bool waiting_turn_ = false;  // En la cola del SendScheduler
+
+  uint64_t header_timer_ = 0;
+  uint64_t send_timer_ = 0;  // Armado solo mientras se espera a EPOLLOUT
+  uint64_t last_send_ns_ = 0;  // Último avance (o inicio de la espera)
+
+  bool finishing_ = false;
+  uint64_t response_start_ = 0;  // Primer byte encolado, para el histograma
+  bool first_byte_sent_ = false;
+  uint64_t response_bytes_ = 0;  // Cuerpo de la respuesta, para el histograma
+};
+
+#endif  // CONNECTION_H
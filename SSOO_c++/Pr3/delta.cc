@@ -0,0 +1,194 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: delta.cc
+ * Referencias:
+ *     A. Tridgell, P. Mackerras, "The rsync algorithm" (1996)
+ */
+
+#include "delta.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <format>
+
+#include "hash.h"
+
+namespace {
+
+constexpr uint32_t kMinBlock = 2048;
+constexpr uint32_t kMaxBlock = 128 * 1024;
+
+void append_le(std::string& out, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    out.push_back(static_cast<char>(value >> (8 * i)));
+  }
+}
+
+uint64_t read_le(std::string_view data, size_t bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < bytes; ++i) {
+    value |= uint64_t{static_cast<unsigned char>(data[i])} << (8 * i);
+  }
+  return value;
+}
+
+/**
+ * @brief Lee un número al principio de text y lo quita (con el separador).
+ */
+bool take_number(std::string_view& text, uint64_t& value, char separator) {
+  auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc() || end == text.data() + text.size() ||
+      *end != separator) {
+    return false;
+  }
+  text.remove_prefix(static_cast<size_t>(end - text.data()) + 1);
+  return true;
+}
+
+}  // namespace
+
+RollingChecksum::RollingChecksum(std::string_view window)
+    : length_(window.size()) {
+  for (size_t i = 0; i < window.size(); ++i) {
+    auto byte = static_cast<unsigned char>(window[i]);
+    a_ += byte;
+    b_ += static_cast<uint32_t>(window.size() - i) * byte;
+  }
+}
+
+uint64_t strong_checksum(std::string_view data) {
+  return xxh3_64(data);
+}
+
+uint32_t delta_block_size(uint64_t file_size) {
+  auto root = static_cast<uint64_t>(std::sqrt(static_cast<double>(file_size)));
+  return static_cast<uint32_t>(
+      std::clamp<uint64_t>(std::bit_ceil(root), kMinBlock, kMaxBlock));
+}
+
+file_sums compute_sums(std::string_view content) {
+  file_sums sums;
+  sums.size = content.size();
+  sums.block = delta_block_size(content.size());
+  sums.blocks.reserve(content.size() / sums.block + 1);
+  for (size_t offset = 0; offset < content.size(); offset += sums.block) {
+    std::string_view block = content.substr(offset, sums.block);
+    sums.blocks.push_back(
+        {RollingChecksum(block).value(), strong_checksum(block)});
+  }
+  return sums;
+}
+
+void append_block_sum(std::string& out, const block_sum& sum) {
+  append_le(out, sum.weak, 4);
+  append_le(out, sum.strong, 8);
+}
+
+block_sum read_block_sum(std::string_view data) {
+  return {static_cast<uint32_t>(read_le(data, 4)), read_le(data.substr(4), 8)};
+}
+
+std::string encode_sums(const file_sums& sums) {
+  std::string out = std::format("docserver-sums {} {} {}\n", sums.size,
+                                sums.block, sums.blocks.size());
+  out.reserve(out.size() + sums.blocks.size() * kBlockSumBytes);
+  for (const auto& sum : sums.blocks) {
+    append_block_sum(out, sum);
+  }
+  return out;
+}
+
+std::expected<file_sums, int> decode_sums(std::string_view text) {
+  constexpr std::string_view kMagic = "docserver-sums ";
+  if (!text.starts_with(kMagic)) {
+    return std::unexpected(EINVAL);
+  }
+  text.remove_prefix(kMagic.size());
+  file_sums sums;
+  uint64_t block = 0;
+  uint64_t count = 0;
+  if (!take_number(text, sums.size, ' ') || !take_number(text, block, ' ') ||
+      !take_number(text, count, '\n') || block == 0 || block > kMaxBlock ||
+      count != (sums.size + block - 1) / block ||
+      text.size() != count * kBlockSumBytes) {
+    return std::unexpected(EINVAL);
+  }
+  sums.block = static_cast<uint32_t>(block);
+  sums.blocks.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    sums.blocks.push_back(read_block_sum(text.substr(i * kBlockSumBytes)));
+  }
+  return sums;
+}
+
+std::pair<std::vector<body_segment>, size_t> make_delta(
+    const std::shared_ptr<const SafeMap>& content, const file_sums& sums,
+    const std::vector<block_sum>& have) {
+  std::unordered_map<uint64_t, uint32_t> known;  // Fuerte -> débil
+  known.reserve(have.size());
+  for (const auto& sum : have) {
+    known.emplace(sum.strong, sum.weak);
+  }
+  auto client_has = [&known](const block_sum& sum) {
+    auto it = known.find(sum.strong);
+    return it != known.end() && it->second == sum.weak;
+  };
+
+  // Primero todos los registros en una cadena y las posiciones de los
+  // literales; los trozos se crean después, cuando ya no se mueve
+  std::string records = std::format("docserver-delta {} {} {}\n", sums.size,
+                                    sums.block, sums.blocks.size());
+  struct literal {
+    size_t record_end;  // Hasta dónde llegan los registros antes de él
+    size_t first;       // Primer bloque
+    size_t count;
+  };
+  std::vector<literal> literals;
+  size_t count = sums.blocks.size();
+  for (size_t i = 0; i < count;) {
+    if (client_has(sums.blocks[i])) {
+      records.push_back('C');
+      append_block_sum(records, sums.blocks[i]);
+      ++i;
+      continue;
+    }
+    size_t first = i;
+    while (i < count && !client_has(sums.blocks[i])) {
+      ++i;
+    }
+    records.push_back('L');
+    append_le(records, i - first, 4);
+    literals.push_back({records.size(), first, i - first});
+  }
+
+  auto owner = std::make_shared<const std::string>(std::move(records));
+  std::string_view text = *owner;
+  std::string_view data = content->get();
+  std::vector<body_segment> body;
+  body.reserve(literals.size() * 2 + 1);
+  size_t total = text.size();
+  size_t from = 0;
+  for (const auto& run : literals) {
+    body.push_back({owner, text.substr(from, run.record_end - from)});
+    from = run.record_end;
+    std::string_view blocks =
+        data.substr(run.first * sums.block, run.count * sums.block);
+    body.push_back({content, blocks});
+    total += blocks.size();
+  }
+  if (from < text.size()) {
+    body.push_back({owner, text.substr(from)});
+  }
+  return {std::move(body), total};
+}
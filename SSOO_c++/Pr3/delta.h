@@ -0,0 +1,129 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: delta.h
+ * Referencias:
+ *     A. Tridgell, P. Mackerras, "The rsync algorithm" (1996)
+ */
+
+#ifndef DELTA_H
+#define DELTA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "connection.h"
+#include "safe_map.h"
+
+/**
+ * Transferencia por diferencias de archivos grandes, al estilo de rsync.
+ *
+ * El servidor publica las sumas de los bloques del archivo ("GET
+ * /_sums/<ruta>"). El cliente busca esos bloques en su versión vieja con la
+ * suma rodante, que se actualiza en O(1) al avanzar un byte, y confirma cada
+ * candidato con la suma fuerte. Luego envía las sumas de los que ya tiene
+ * ("DELTA <ruta> <número>" y detrás las sumas) y recibe el archivo como
+ * una secuencia de "copia este bloque tuyo" y de bloques literales, que
+ * salen tal cual del mapeo del archivo.
+ *
+ * Formatos (enteros en little endian):
+ *   sumas: "docserver-sums <tamaño> <bloque> <número>\n" y número sumas de
+ *          kBlockSumBytes (débil de 4 bytes, fuerte de 8).
+ *   delta: "docserver-delta <tamaño> <bloque> <número>\n" y, por orden de
+ *          bloques, 'C' + una suma (el cliente ya lo tiene) o 'L' + un
+ *          número de bloques de 4 bytes + sus bytes.
+ */
+
+constexpr size_t kBlockSumBytes = 12;
+// Sumas que se aceptan en una petición DELTA
+constexpr size_t kMaxDeltaSums = size_t{1} << 20;
+
+/**
+ * @brief Suma de un bloque: la rodante para buscarlo y la fuerte para
+ * confirmarlo.
+ */
+struct block_sum {
+  uint32_t weak = 0;
+  uint64_t strong = 0;
+};
+
+/**
+ * @brief Sumas de todos los bloques de un archivo (el último puede ser más
+ * corto).
+ */
+struct file_sums {
+  uint64_t size = 0;
+  uint32_t block = 0;
+  std::vector<block_sum> blocks;
+};
+
+/**
+ * @brief Suma rodante de rsync sobre una ventana de tamaño fijo.
+ */
+class RollingChecksum {
+ public:
+  explicit RollingChecksum(std::string_view window);
+
+  /**
+   * @brief Desplaza la ventana un byte: sale out por delante y entra in.
+   */
+  void roll(unsigned char out, unsigned char in) noexcept {
+    a_ = a_ - uint32_t{out} + uint32_t{in};
+    b_ = b_ - static_cast<uint32_t>(length_) * uint32_t{out} + a_;
+  }
+
+  [[nodiscard]] uint32_t value() const noexcept {
+    return (a_ & 0xffff) | (b_ << 16);
+  }
+
+ private:
+  uint32_t a_ = 0;
+  uint32_t b_ = 0;
+  size_t length_;
+};
+
+/**
+ * @brief Suma fuerte de un bloque: XXH3 de 64 bits.
+ */
+uint64_t strong_checksum(std::string_view data);
+
+/**
+ * @brief Tamaño de bloque para un archivo: la potencia de dos más cercana
+ * por encima a su raíz cuadrada, entre 2 KiB y 128 KiB, como hace rsync
+ * para equilibrar lo que ocupan las sumas con lo que se reenvía de más.
+ */
+uint32_t delta_block_size(uint64_t file_size);
+
+file_sums compute_sums(std::string_view content);
+
+/**
+ * @brief Cuerpo de la respuesta a "GET /_sums/<ruta>".
+ */
+std::string encode_sums(const file_sums& sums);
+std::expected<file_sums, int> decode_sums(std::string_view text);
+
+void append_block_sum(std::string& out, const block_sum& sum);
+block_sum read_block_sum(std::string_view data);
+
+/**
+ * @brief Delta del archivo content para un cliente que ya tiene los
+ * bloques de have: los bloques literales son trozos del propio mapeo.
+ * @return El cuerpo y su longitud total.
+ */
+std::pair<std::vector<body_segment>, size_t> make_delta(
+    const std::shared_ptr<const SafeMap>& content, const file_sums& sums,
+    const std::vector<block_sum>& have);
+
+#endif  // DELTA_H
@@ -0,0 +1,205 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: digest_cache.cc
+ * Referencias:
+ *     man 2 eventfd, RFC 9110 (ETag), RFC 9530 (Repr-Digest),
+ *     RFC 3230 (Digest)
+ */
+
+#include "digest_cache.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <format>
+#include <string_view>
+
+#include "metrics.h"
+
+namespace {
+
+// Resúmenes encargados a la vez como mucho; el resto espera a otra petición
+constexpr size_t kMaxPendingJobs = 64;
+
+std::string sha256_base64(const file_digest& digest) {
+  return base64(std::string_view(
+      reinterpret_cast<const char*>(digest.sha256.data()),
+      digest.sha256.size()));
+}
+
+}  // namespace
+
+std::string digest_header_lines(const file_digest& digest) {
+  std::string lines = std::format("ETag: \"{}\"\r\n", to_hex(digest.xxh128));
+  if (digest.has_sha256) {
+    std::string encoded = sha256_base64(digest);
+    lines += std::format("Repr-Digest: sha-256=:{}:\r\nDigest: sha-256={}\r\n",
+                         encoded, encoded);
+  }
+  return lines;
+}
+
+void append_digest_headers(std::vector<header_field>& headers,
+                           const file_digest& digest) {
+  headers.push_back({"etag", "\"" + to_hex(digest.xxh128) + "\""});
+  if (digest.has_sha256) {
+    std::string encoded = sha256_base64(digest);
+    headers.push_back({"repr-digest", "sha-256=:" + encoded + ":"});
+    headers.push_back({"digest", "sha-256=" + encoded});
+  }
+}
+
+DigestCache::DigestCache(EventLoop& loop, size_t max_entries,
+                         bool with_sha256)
+    : max_entries_(max_entries),
+      with_sha256_(with_sha256),
+      metrics_id_(metrics_register_cache("digests")),
+      loop_(loop),
+      event_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+  if (max_entries_ == 0 || !event_fd_.is_valid()) {
+    max_entries_ = 0;  // Sin aviso del hilo no hay resúmenes
+    return;
+  }
+  watch_id_ = loop_.watch(event_fd_.get(), EPOLLIN,
+                          [this](uint32_t) { on_done(); });
+  worker_ = std::thread([this] { run_worker(); });
+}
+
+DigestCache::~DigestCache() {
+  {
+    std::lock_guard lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_one();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+  if (watch_id_ != 0) {
+    loop_.unwatch(watch_id_);
+  }
+}
+
+DigestCache::identity DigestCache::identity_of(const struct stat& info) {
+  return {info.st_dev, info.st_ino, info.st_size, info.st_mtim};
+}
+
+bool DigestCache::same_file(const identity& id, const struct stat& info) {
+  return id.device == info.st_dev && id.inode == info.st_ino &&
+         id.size == info.st_size && id.mtime.tv_sec == info.st_mtim.tv_sec &&
+         id.mtime.tv_nsec == info.st_mtim.tv_nsec;
+}
+
+std::shared_ptr<const file_digest> DigestCache::get(
+    const std::string& path, const struct stat& info,
+    const std::shared_ptr<const SafeMap>& content) {
+  if (max_entries_ == 0) {
+    return nullptr;
+  }
+  auto it = entries_.find(path);
+  if (it != entries_.end()) {
+    if (same_file(it->second.id, info)) {
+      metrics_cache_lookup(metrics_id_, true);
+      lru_.splice(lru_.begin(), lru_, it->second.lru);
+      if (on_digest_) {
+        on_digest_(path, content, *it->second.digest);
+      }
+      return it->second.digest;
+    }
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+  }
+  metrics_cache_lookup(metrics_id_, false);
+  // Si lo reemplazaron entre el stat() y el mapeo, el resumen no sería
+  // de la identidad que se guardaría
+  if (static_cast<off_t>(content->get().size()) != info.st_size ||
+      pending_.size() >= kMaxPendingJobs || pending_.contains(path)) {
+    return nullptr;
+  }
+  pending_.insert(path);
+  {
+    std::lock_guard lock(mutex_);
+    jobs_.push_back({path, identity_of(info), content, nullptr});
+  }
+  wake_.notify_one();
+  return nullptr;
+}
+
+void DigestCache::forget(const std::string& path) {
+  auto it = entries_.find(path);
+  if (it != entries_.end()) {
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+  }
+}
+
+void DigestCache::run_worker() {
+  std::unique_lock lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+    if (stopping_) {
+      return;
+    }
+    job current = std::move(jobs_.front());
+    jobs_.pop_front();
+    lock.unlock();
+
+    auto digest = std::make_shared<file_digest>();
+    std::string_view data = current.content->get();
+    digest->xxh128 = xxh3_128(data);
+    if (with_sha256_) {
+      digest->sha256 = sha256(data);
+      digest->has_sha256 = true;
+    }
+    current.digest = std::move(digest);
+
+    lock.lock();
+    done_.push_back(std::move(current));
+    uint64_t one = 1;
+    [[maybe_unused]] ssize_t written =
+        write(event_fd_.get(), &one, sizeof(one));
+  }
+}
+
+void DigestCache::on_done() {
+  uint64_t count = 0;
+  [[maybe_unused]] ssize_t bytes = read(event_fd_.get(), &count, sizeof(count));
+  std::vector<job> finished;
+  {
+    std::lock_guard lock(mutex_);
+    finished.swap(done_);
+  }
+  for (auto& done : finished) {
+    store(done);
+  }
+}
+
+void DigestCache::store(job& done) {
+  pending_.erase(done.path);
+  metrics_count(metric_counter::digest_bytes,
+                static_cast<uint64_t>(done.id.size));
+  if (on_digest_) {
+    on_digest_(done.path, done.content, *done.digest);
+  }
+  auto it = entries_.find(done.path);
+  if (it != entries_.end()) {
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+  }
+  lru_.push_front(done.path);
+  entry& e = entries_[done.path];
+  e.digest = std::move(done.digest);
+  e.id = done.id;
+  e.lru = lru_.begin();
+  while (entries_.size() > max_entries_) {
+    entries_.erase(lru_.back());
+    lru_.pop_back();
+  }
+}
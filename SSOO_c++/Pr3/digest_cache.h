@@ -0,0 +1,165 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: digest_cache.h
+ * Referencias:
+ *     man 2 eventfd, RFC 9110 (ETag), RFC 9530 (Repr-Digest),
+ *     RFC 3230 (Digest)
+ */
+
+#ifndef DIGEST_CACHE_H
+#define DIGEST_CACHE_H
+
+#include <sys/stat.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "event_loop.h"
+#include "hash.h"
+#include "hpack.h"
+#include "safe_fd.h"
+#include "safe_map.h"
+
+/**
+ * @brief Resumen del contenido de un archivo.
+ */
+struct file_digest {
+  hash128 xxh128;
+  bool has_sha256 = false;
+  sha256_digest sha256{};
+};
+
+/**
+ * @brief Cabeceras de HTTP/1 de un resumen, cada una con su "\r\n":
+ * "ETag" con el XXH3 de 128 bits y, si lo hay, el SHA-256 en "Repr-Digest"
+ * y en "Digest" (para los clientes que solo conocen la antigua).
+ */
+std::string digest_header_lines(const file_digest& digest);
+
+/**
+ * @brief Las mismas cabeceras para una respuesta de HTTP/2.
+ */
+void append_digest_headers(std::vector<header_field>& headers,
+                           const file_digest& digest);
+
+/**
+ * @brief Resúmenes de los archivos servidos, calculados en segundo plano.
+ *
+ * Un resumen se calcula recorriendo el mapeo entero, demasiado para el
+ * bucle de eventos con un archivo grande, así que lo hace un hilo aparte
+ * sobre el mismo SafeMap que se está enviando (la respuesta y el hilo lo
+ * comparten, no se copia). Cuando acaba, avisa por un eventfd y el bucle
+ * guarda el resultado. Hasta entonces el archivo se sirve sin esas
+ * cabeceras. Una entrada vale mientras el archivo tenga el mismo
+ * dispositivo, inodo, tamaño y mtime, y se expulsan con LRU.
+ */
+class DigestCache {
+ public:
+  using digest_callback =
+      std::function<void(const std::string& path,
+                         const std::shared_ptr<const SafeMap>& content,
+                         const file_digest& digest)>;
+
+  /**
+   * @param with_sha256 Calcular también SHA-256 (unas diez veces más
+   * lento que XXH3).
+   */
+  DigestCache(EventLoop& loop, size_t max_entries, bool with_sha256);
+  ~DigestCache();
+
+  DigestCache(const DigestCache&) = delete;
+  DigestCache& operator=(const DigestCache&) = delete;
+
+  /**
+   * @brief Resumen de content, el contenido de base_dir + path.
+   * @param info stat() hecho antes de obtener content (ver
+   * BlockSumsCache::get()).
+   * @return El resumen, o nullptr si aún no está: entonces se encarga al
+   * hilo y estará para las peticiones siguientes.
+   */
+  std::shared_ptr<const file_digest> get(
+      const std::string& path, const struct stat& info,
+      const std::shared_ptr<const SafeMap>& content);
+
+  /**
+   * @brief Suelta la entrada de path (porque se acaba de reemplazar).
+   */
+  void forget(const std::string& path);
+
+  /**
+   * @brief Llama a callback, desde el bucle, con cada resumen que se
+   * termina o que get() encuentra, y el contenido del que es.
+   */
+  void set_on_digest(digest_callback callback) {
+    on_digest_ = std::move(callback);
+  }
+
+ private:
+  struct identity {
+    dev_t device = 0;
+    ino_t inode = 0;
+    off_t size = 0;
+    timespec mtime{};
+  };
+  struct entry {
+    std::shared_ptr<const file_digest> digest;
+    identity id;
+    std::list<std::string>::iterator lru;
+  };
+  struct job {
+    std::string path;
+    identity id;
+    std::shared_ptr<const SafeMap> content;
+    std::shared_ptr<const file_digest> digest;  // Lo rellena el hilo
+  };
+
+  static identity identity_of(const struct stat& info);
+  static bool same_file(const identity& id, const struct stat& info);
+
+  void run_worker();
+  void on_done();
+  void store(job& done);
+
+  size_t max_entries_;
+  bool with_sha256_;
+  size_t metrics_id_;
+  EventLoop& loop_;
+  SafeFD event_fd_;
+  uint64_t watch_id_ = 0;
+  digest_callback on_digest_;
+
+  // Solo del bucle de eventos
+  std::unordered_map<std::string, entry> entries_;
+  std::list<std::string> lru_;  // Delante, la usada más recientemente
+  std::unordered_set<std::string> pending_;  // Encargados y sin terminar
+
+  // Compartido con el hilo, bajo mutex_
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<job> jobs_;
+  std::vector<job> done_;
+  bool stopping_ = false;
+
+  std::thread worker_;
+};
+
+#endif  // DIGEST_CACHE_H
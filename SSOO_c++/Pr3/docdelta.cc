@@ -0,0 +1,403 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: docdelta.cc
+ * Referencias:
+ *     A. Tridgell, P. Mackerras, "The rsync algorithm" (1996)
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <expected>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "delta.h"
+#include "safe_fd.h"
+
+/**
+ * Actualiza una copia local de un archivo de docserver descargando solo lo
+ * que ha cambiado (ver delta.h).
+ *
+ * Pide las sumas de los bloques del archivo, busca cada bloque en la copia
+ * local (en cualquier posición, no solo alineado), envía las sumas de los
+ * que encontró y rehace el archivo con el delta: los bloques que ya tenía
+ * salen de la copia local y el resto llega del servidor. El resultado se
+ * escribe aparte y se renombra sobre la copia. Sin copia local, descarga
+ * el archivo entero.
+ */
+
+/**
+ * @brief Opciones del cliente.
+ */
+struct client_options {
+  bool flag_h = false;
+  std::string host = "127.0.0.1";
+  uint16_t port = 8080;
+  std::string remote;  // Ruta en el servidor ("/docs/a.iso")
+  std::string local;   // Copia local que se actualiza
+};
+
+/**
+ * @brief Un bloque del servidor que ya está en la copia local.
+ */
+struct local_block {
+  uint32_t weak = 0;
+  size_t offset = 0;
+};
+
+void Usage(char* argv[]) {
+  std::cout << "Usage: " << argv[0]
+            << " [-H <host>] [-p <port>] <remote path> <local file>\n";
+  std::cout << "Options:\n";
+  std::cout << "  -H, --host   Server address (default 127.0.0.1)\n";
+  std::cout << "  -p, --port   Server port (default 8080)\n";
+}
+
+std::expected<client_options, std::string> parse_args(int argc,
+                                                      char* argv[]) {
+  std::vector<std::string_view> args(argv + 1, argv + argc);
+  client_options options;
+  std::vector<std::string_view> positional;
+  for (auto it = args.begin(), end = args.end(); it != end; ++it) {
+    std::string_view option = *it;
+    if (option == "-h" || option == "--help") {
+      options.flag_h = true;
+    } else if (option == "-H" || option == "--host" || option == "-p" ||
+               option == "--port") {
+      if (++it == end) {
+        return std::unexpected(std::format("missing value for {}", option));
+      }
+      if (option == "-H" || option == "--host") {
+        options.host = *it;
+        continue;
+      }
+      try {
+        unsigned long value = std::stoul(std::string(*it));
+        if (value == 0 || value > 65535) {
+          throw std::out_of_range("port");
+        }
+        options.port = static_cast<uint16_t>(value);
+      } catch (const std::exception&) {
+        return std::unexpected(std::format("invalid value for {}", option));
+      }
+    } else if (option.starts_with("-")) {
+      return std::unexpected(std::format("unknown option {}", option));
+    } else {
+      positional.push_back(option);
+    }
+  }
+  if (options.flag_h) {
+    return options;
+  }
+  if (positional.size() != 2) {
+    return std::unexpected("a remote path and a local file are required");
+  }
+  options.remote = positional[0];
+  options.local = positional[1];
+  if (!options.remote.starts_with("/")) {
+    return std::unexpected("the remote path must start with '/'");
+  }
+  return options;
+}
+
+/**
+ * @brief Envía request al servidor y devuelve el cuerpo de la respuesta.
+ */
+std::expected<std::string, std::string> fetch(
+    const client_options& options, std::string_view request) {
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(options.port);
+  if (inet_pton(AF_INET, options.host.c_str(), &address.sin_addr) != 1) {
+    return std::unexpected("invalid host address");
+  }
+  SafeFD fd(socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0));
+  if (!fd.is_valid() ||
+      connect(fd.get(), reinterpret_cast<const sockaddr*>(&address),
+              sizeof(address)) < 0) {
+    return std::unexpected(std::format("cannot connect: {}", strerror(errno)));
+  }
+  while (!request.empty()) {
+    ssize_t sent = send(fd.get(), request.data(), request.size(), MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) continue;
+    if (sent < 0) {
+      return std::unexpected(std::format("cannot send: {}", strerror(errno)));
+    }
+    request.remove_prefix(static_cast<size_t>(sent));
+  }
+  std::string response;
+  std::vector<char> buffer(1 << 16);
+  while (true) {
+    ssize_t received = recv(fd.get(), buffer.data(), buffer.size(), 0);
+    if (received < 0 && errno == EINTR) continue;
+    if (received < 0) {
+      return std::unexpected(
+          std::format("cannot receive: {}", strerror(errno)));
+    }
+    if (received == 0) {
+      break;
+    }
+    response.append(buffer.data(), static_cast<size_t>(received));
+  }
+
+  // Las respuestas correctas empiezan por sus cabeceras y las de error por
+  // su línea de estado
+  if (!response.starts_with("Content-Length: ")) {
+    std::string_view status = response;
+    return std::unexpected(std::format(
+        "server answered {}", status.substr(0, status.find('\r'))));
+  }
+  size_t end = response.find("\r\n\r\n");
+  if (end == std::string::npos) {
+    return std::unexpected("truncated response");
+  }
+  uint64_t length = std::stoull(response.substr(16));
+  std::string body = response.substr(end + 4);
+  if (body.size() != length) {
+    return std::unexpected("truncated response");
+  }
+  return body;
+}
+
+/**
+ * @brief Busca en local los bloques de sums: la suma rodante se desplaza
+ * byte a byte y solo las coincidencias se confirman con la fuerte.
+ * @return Los encontrados, por su suma fuerte.
+ */
+std::unordered_map<uint64_t, local_block> find_blocks(std::string_view local,
+                                                      const file_sums& sums) {
+  std::unordered_map<uint64_t, local_block> found;
+  size_t block = sums.block;
+  std::unordered_multimap<uint32_t, size_t> by_weak;
+  for (size_t i = 0; i < sums.blocks.size(); ++i) {
+    if ((i + 1) * block <= sums.size) {
+      by_weak.emplace(sums.blocks[i].weak, i);
+    }
+  }
+
+  auto try_match = [&](size_t offset, size_t length, uint32_t weak) {
+    auto [first, last] = by_weak.equal_range(weak);
+    if (first == last) {
+      return false;
+    }
+    uint64_t strong = strong_checksum(local.substr(offset, length));
+    for (auto it = first; it != last; ++it) {
+      if (sums.blocks[it->second].strong == strong) {
+        found.try_emplace(strong, local_block{weak, offset});
+        return true;
+      }
+    }
+    return false;
+  };
+
+  size_t offset = 0;
+  if (local.size() >= block) {
+    RollingChecksum rolling(local.substr(0, block));
+    while (true) {
+      if (try_match(offset, block, rolling.value())) {
+        offset += block;
+        if (offset + block > local.size()) {
+          break;
+        }
+        rolling = RollingChecksum(local.substr(offset, block));
+        continue;
+      }
+      if (offset + block >= local.size()) {
+        break;
+      }
+      rolling.roll(static_cast<unsigned char>(local[offset]),
+                   static_cast<unsigned char>(local[offset + block]));
+      ++offset;
+    }
+  }
+
+  // El último bloque, si es más corto, solo se busca al final de la copia
+  size_t tail = sums.size % block;
+  if (tail != 0 && local.size() >= tail) {
+    std::string_view candidate = local.substr(local.size() - tail);
+    const block_sum& last = sums.blocks.back();
+    if (RollingChecksum(candidate).value() == last.weak &&
+        strong_checksum(candidate) == last.strong) {
+      found.try_emplace(last.strong,
+                        local_block{last.weak, local.size() - tail});
+    }
+  }
+  return found;
+}
+
+/**
+ * @brief Rehace el archivo a partir de la copia local y el delta.
+ * @param literal_bytes Bytes que llegaron del servidor.
+ */
+std::expected<std::string, std::string> apply_delta(
+    std::string_view local,
+    const std::unordered_map<uint64_t, local_block>& found,
+    std::string_view delta, uint64_t& literal_bytes) {
+  constexpr std::string_view kMagic = "docserver-delta ";
+  size_t line_end = delta.find('\n');
+  if (!delta.starts_with(kMagic) || line_end == std::string_view::npos) {
+    return std::unexpected("invalid delta");
+  }
+  uint64_t size = 0, block = 0, count = 0;
+  if (std::sscanf(std::string(delta.substr(0, line_end)).c_str(),
+                  "docserver-delta %lu %lu %lu", &size, &block, &count) != 3 ||
+      block == 0) {
+    return std::unexpected("invalid delta");
+  }
+  delta.remove_prefix(line_end + 1);
+
+  std::string result;
+  result.reserve(size);
+  for (uint64_t index = 0; index < count;) {
+    if (delta.empty()) {
+      return std::unexpected("truncated delta");
+    }
+    char kind = delta.front();
+    delta.remove_prefix(1);
+    uint64_t left = size - index * block;
+    if (kind == 'C' && delta.size() >= kBlockSumBytes) {
+      block_sum sum = read_block_sum(delta);
+      delta.remove_prefix(kBlockSumBytes);
+      auto it = found.find(sum.strong);
+      if (it == found.end() || it->second.weak != sum.weak) {
+        return std::unexpected("the delta copies an unknown block");
+      }
+      result.append(local.substr(it->second.offset, std::min(block, left)));
+      ++index;
+    } else if (kind == 'L' && delta.size() >= 4) {
+      uint64_t blocks = 0;
+      for (size_t i = 0; i < 4; ++i) {
+        blocks |= uint64_t{static_cast<unsigned char>(delta[i])} << (8 * i);
+      }
+      delta.remove_prefix(4);
+      uint64_t length = std::min(blocks * block, left);
+      if (blocks == 0 || delta.size() < length) {
+        return std::unexpected("truncated delta");
+      }
+      result.append(delta.substr(0, length));
+      delta.remove_prefix(length);
+      literal_bytes += length;
+      index += blocks;
+    } else {
+      return std::unexpected("invalid delta");
+    }
+  }
+  if (result.size() != size || !delta.empty()) {
+    return std::unexpected("the delta does not add up to the file");
+  }
+  return result;
+}
+
+int main(int argc, char* argv[]) {
+  auto parsed = parse_args(argc, argv);
+  if (!parsed) {
+    std::cerr << "Error: " << parsed.error() << "\n";
+    return EXIT_FAILURE;
+  }
+  const client_options& options = *parsed;
+  if (options.flag_h) {
+    Usage(argv);
+    return EXIT_SUCCESS;
+  }
+
+  auto sums_body = fetch(options, "GET /_sums" + options.remote + "\r\n");
+  if (!sums_body) {
+    std::cerr << "Error: " << sums_body.error() << "\n";
+    return EXIT_FAILURE;
+  }
+  auto sums = decode_sums(*sums_body);
+  if (!sums) {
+    std::cerr << "Error: invalid block sums from the server\n";
+    return EXIT_FAILURE;
+  }
+
+  // Sin copia local todo llega como literal
+  std::string local;
+  if (std::ifstream in{options.local, std::ios::binary | std::ios::ate}) {
+    local.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    in.read(local.data(), static_cast<std::streamsize>(local.size()));
+    if (!in) {
+      std::cerr << "Error: cannot read " << options.local << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+  auto found = find_blocks(local, *sums);
+
+  std::string request =
+      std::format("DELTA {} {}\n", options.remote, found.size());
+  for (const auto& [strong, where] : found) {
+    append_block_sum(request, block_sum{where.weak, strong});
+  }
+  auto delta = fetch(options, request);
+  if (!delta) {
+    std::cerr << "Error: " << delta.error() << "\n";
+    return EXIT_FAILURE;
+  }
+  uint64_t literal_bytes = 0;
+  auto result = apply_delta(local, found, *delta, literal_bytes);
+  if (!result) {
+    std::cerr << "Error: " << result.error() << "\n";
+    return EXIT_FAILURE;
+  }
+  // Si no ha cambiado desde que se pidieron las sumas, se comprueba entero
+  if (result->size() == sums->size) {
+    auto check = compute_sums(*result);
+    if (check.block == sums->block &&
+        !std::equal(check.blocks.begin(), check.blocks.end(),
+                    sums->blocks.begin(), sums->blocks.end(),
+                    [](const block_sum& a, const block_sum& b) {
+                      return a.weak == b.weak && a.strong == b.strong;
+                    })) {
+      std::cerr << "Error: the rebuilt file does not match its block sums\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Se escribe aparte y se renombra: la copia vieja vale hasta el final
+  std::string temporary = options.local + ".docdelta";
+  {
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    out.write(result->data(), static_cast<std::streamsize>(result->size()));
+    if (!out) {
+      std::cerr << "Error: cannot write " << temporary << "\n";
+      std::remove(temporary.c_str());
+      return EXIT_FAILURE;
+    }
+  }
+  if (std::rename(temporary.c_str(), options.local.c_str()) != 0) {
+    std::cerr << "Error: cannot replace " << options.local << "\n";
+    std::remove(temporary.c_str());
+    return EXIT_FAILURE;
+  }
+
+  uint64_t reused = result->size() - literal_bytes;
+  std::cout << std::format(
+      "{}: {} bytes, {} reused ({:.1f}%), {} bytes of delta received\n",
+      options.local, result->size(), reused,
+      result->empty() ? 0.0
+                      : 100.0 * static_cast<double>(reused) /
+                            static_cast<double>(result->size()),
+      sums_body->size() + delta->size());
+  return EXIT_SUCCESS;
+}
@@ -12,15 +12,18 @@
  *     Enunciado de la práctica
  */
 
+#include <arpa/inet.h>
 #include <fcntl.h>
 #include <netinet/ip.h>
-#include <sys/mman.h>
+#include <signal.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cinttypes>
+#include <climits>
 #include <cmath>
 #include <cstdint>
 #include <cstdio>
@@ -29,31 +32,61 @@
 #include <filesystem>
 #include <format>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
 #include <string>
 #include <string_view>
 #include <system_error>
+#include <unordered_map>
 #include <vector>
 
+#include "admission.h"
+#include "batch.h"
+#include "block_sums_cache.h"
+#include "bin_scheduler.h"
+#include "bin_workers.h"
+#include "connection.h"
+#include "delta.h"
+#include "digest_cache.h"
+#include "docserver.h"
+#include "dynamic_content.h"
+#include "event_loop.h"
+#include "file_cache.h"
+#include "http2.h"
+#include "hot_restart.h"
+#include "listener.h"
+#include "metrics.h"
+#include "safe_fd.h"
+#include "send_scheduler.h"
+#include "shared_cache.h"
+#include "tracing.h"
+#include "upload.h"
+
 /**
  * En la terminal: socat STDIO TCP:127.0.0.1:8080
  */
 
 /**
- * Compilar con:
- * g++ -std=c++23 -Wall -Wextra -Werror -Wpedantic \
-    -Wshadow -Wnon-virtual-dtor -Wold-style-cast \
-    -Wcast-align -Wunused -Woverloaded-virtual \
-    -Wconversion -Wsign-conversion -Wnull-dereference \
-    -Wdouble-promotion -Wformat=2 -Wmisleading-indentation \
-    -Wduplicated-cond -Wduplicated-branches -Wlogical-op \
-    -Wuseless-cast -fsanitize=address,undefined,leak -o docserver docserver.cc
+ * Compilar con: make
+ * (mismas opciones de siempre, ver el Makefile de este directorio)
  */
 
 // Variables globales
 bool flag_v = false;
 uint16_t port = 8080;
+
+// Tras un reinicio en caliente, plazo para que acaben las conexiones viejas
+constexpr uint64_t kDrainTimeoutNs = 60'000'000'000;
+// Cada cuánto se guarda el historial de archivos más pedidos
+constexpr uint64_t kHistoryPeriodNs = 60'000'000'000;
+// Archivos de los que se guardan las sumas de bloques (ver delta.h)
+constexpr size_t kBlockSumsEntries = 256;
+// Archivos de los que se guarda el resumen (ETag, Repr-Digest)
+constexpr size_t kDigestEntries = 4096;
 bool flag_base_dir = false;
 std::string base_dir;
 
@@ -75,6 +108,18 @@ enum class parse_args_errors {
   opcion_desconocida,
   no_indica_puerto,
   puerto_no_usable,
+  muestreo_no_valido,
+  workers_no_valido,
+  limite_no_valido,
+  plazo_no_valido,
+  plazo_conexion_no_valido,
+  direccion_no_valida,
+  opcion_socket_no_valida,
+  config_no_valida,
+  admision_no_valida,
+  cache_no_valida,
+  subida_no_valida,
+  envio_no_valido,
   // ...
 };
 
@@ -87,98 +132,64 @@ struct program_options {
   int port = 0;
   std::vector<std::string> additional_args;
   std::string base_directory;
+  bin_scheduler_limits bin_limits;
+  admission_limits admission;
+  std::vector<listen_address> listen;  // Vacío: TCP en el puerto de -p
+  socket_tuning tuning;
+  std::string restart_socket;  // Vacío: sin reinicio en caliente
+  size_t file_cache_bytes = 64u << 20;
+  std::string cache_history;  // Vacío: ni se guarda ni se precarga
+  size_t prewarm_count = 256;
+  uint64_t prewarm_budget_ns = 2'000'000'000;
+  upload_limits uploads;
+  bool digest_sha256 = false;  // Repr-Digest y Digest además del ETag
+  std::string shared_cache;  // Vacío: sin caché compartida entre procesos
+  size_t shared_cache_bytes = 64u << 20;
+  send_policy scheduling = send_policy::srpt;
+  size_t send_quantum = 64u << 10;
 };
 
 /**
- * @brief Estructura que representa un error al ejecutar un programa.
- */
-struct execute_program_error {
-  int codigo_salida;
-  int codigo_error;
-};
-
-struct exec_environment {
-  std::string cwd;
-  std::vector<std::string> env;
-};
-
-/**
- * @brief Clase que mapea un archivo en memoria de forma segura.
+ * @brief Sustituye cada "--config <archivo>" por las opciones que contiene:
+ * una por línea, "<opción>" o "<opción>=<valor>", con el nombre largo sin
+ * los guiones ("tcp-nodelay", "sndbuf=65536"). Las líneas vacías y las que
+ * empiezan por '#' se ignoran.
  */
-class SafeMap {
- public:
-  // Constructor por defecto
-  SafeMap() = default;
-  // Constructor que recibe un std::string_view
-  SafeMap(std::string_view sv) : sv_(sv) {}
-  // Destructor llama a munmap con la dirrecion y el tamaño
-  ~SafeMap() {
-    if (sv_.data() != nullptr) {
-      munmap(const_cast<char*>(sv_.data()), sv_.size());
+std::expected<std::vector<std::string>, parse_args_errors> expand_config(
+    int argc, char* argv[]) {
+  std::vector<std::string> args;
+  for (int i = 1; i < argc; ++i) {
+    if (std::string_view(argv[i]) != "--config") {
+      args.emplace_back(argv[i]);
+      continue;
     }
-  }
-
-  // Método para obtener el std::string_view
-  std::string_view get() const { return sv_; }
-
-  // Prohibir la copia
-  SafeMap(const SafeMap&) = delete;
-  SafeMap& operator=(const SafeMap&) = delete;
-
-  // Permitir el movimiento
-  SafeMap(SafeMap&& other) : sv_(other.sv_) { other.sv_ = std::string_view(); }
-
-  SafeMap& operator=(SafeMap&& other) {
-    if (this != &other) {
-      if (sv_.data() != nullptr) {
-        munmap(const_cast<char*>(sv_.data()), sv_.size());
-      }
-      sv_ = other.sv_;
-      other.sv_ = std::string_view();
+    if (++i == argc) {
+      return std::unexpected(parse_args_errors::argumento_faltante);
     }
-    return *this;
-  }
-
- private:
-  std::string_view sv_;  // std::string_view que almacena el archivo mapeado
-};
-
-class SafeFD {
- public:
-  // Constructor
-  explicit SafeFD(int fd) noexcept : fd_(fd) {}
-  explicit SafeFD() noexcept : fd_(-1) {}
-
-  SafeFD(const SafeFD&) = delete;
-  SafeFD& operator=(const SafeFD&) = delete;
-
-  SafeFD(SafeFD&& other) noexcept : fd_(other.fd_) { other.fd_ = -1; }
-
-  SafeFD& operator=(SafeFD&& other) noexcept {
-    if (this != &other && fd_ != other.fd_) {
-      // Cerrar el descriptor de archivo actual
-      close(fd_);
-
-      // Mover el descriptor de archivo de 'other' a este objeto
-      fd_ = other.fd_;
-      other.fd_ = -1;
+    std::ifstream file(argv[i]);
+    if (!file) {
+      return std::unexpected(parse_args_errors::config_no_valida);
     }
-    return *this;
-  }
-
-  ~SafeFD() noexcept {
-    if (fd_ >= 0) {
-      close(fd_);
+    std::string line;
+    while (std::getline(file, line)) {
+      auto first = line.find_first_not_of(" \t");
+      if (first == std::string::npos || line[first] == '#') {
+        continue;
+      }
+      line.erase(0, first);
+      line.erase(line.find_last_not_of(" \t\r") + 1);
+      if (line.starts_with("-") || line.starts_with("config")) {
+        return std::unexpected(parse_args_errors::config_no_valida);
+      }
+      size_t equals = line.find('=');
+      args.push_back("--" + line.substr(0, equals));
+      if (equals != std::string::npos) {
+        args.push_back(line.substr(equals + 1));
+      }
     }
   }
-
-  [[nodiscard]] bool is_valid() const noexcept { return fd_ >= 0; }
-
-  [[nodiscard]] int get() const noexcept { return fd_; }
-
- private:
-  int fd_;
-};
+  return args;
+}
 
 /**
  * @brief Parsea los argumentos de la línea de comandos.
@@ -187,7 +198,11 @@ class SafeFD {
  */
 std::expected<program_options, parse_args_errors> parse_args(int argc,
                                                              char* argv[]) {
-  std::vector<std::string_view> args(argv + 1, argv + argc);
+  auto expanded = expand_config(argc, argv);
+  if (!expanded) {
+    return std::unexpected(expanded.error());
+  }
+  std::vector<std::string_view> args(expanded->begin(), expanded->end());
   program_options options;
 
   for (auto it = args.begin(), end = args.end(); it != end; ++it) {
@@ -216,6 +231,270 @@ std::expected<program_options, parse_args_errors> parse_args(int argc,
       } else {
         return std::unexpected(parse_args_errors::argumento_faltante);
       }
+    } else if (*it == "-t" || *it == "--trace") {
+      if (++it != end && !it->starts_with("-")) {
+        try {
+          unsigned long every = std::stoul(std::string(*it));
+          if (every > UINT32_MAX) {
+            return std::unexpected(parse_args_errors::muestreo_no_valido);
+          }
+          trace_sample_every = static_cast<uint32_t>(every);
+        } catch (const std::exception&) {
+          return std::unexpected(parse_args_errors::muestreo_no_valido);
+        }
+      } else {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+    } else if (*it == "-w" || *it == "--bin-workers") {
+      if (++it != end && !it->starts_with("-")) {
+        try {
+          unsigned long workers = std::stoul(std::string(*it));
+          if (workers > 64) {
+            return std::unexpected(parse_args_errors::workers_no_valido);
+          }
+          bin_workers_configure(workers);
+        } catch (const std::exception&) {
+          return std::unexpected(parse_args_errors::workers_no_valido);
+        }
+      } else {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+    } else if (*it == "--bin-max-children" || *it == "--bin-max-per-program" ||
+               *it == "--bin-queue-ms") {
+      std::string_view option = *it;
+      if (++it == end || it->starts_with("-")) {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+      unsigned long value = 0;
+      try {
+        value = std::stoul(std::string(*it));
+      } catch (const std::exception&) {
+        return std::unexpected(parse_args_errors::limite_no_valido);
+      }
+      if (value == 0 || value > 1'000'000) {
+        return std::unexpected(parse_args_errors::limite_no_valido);
+      }
+      if (option == "--bin-max-children") {
+        options.bin_limits.max_children = value;
+      } else if (option == "--bin-max-per-program") {
+        options.bin_limits.max_per_program = value;
+      } else {
+        options.bin_limits.queue_budget_ns = value * 1'000'000;
+      }
+    } else if (*it == "--bin-timeout") {
+      // "<ms>" para todos los programas o "<programa>=<ms>" para uno
+      if (++it == end || it->starts_with("-")) {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+      std::string_view value = *it;
+      std::string program;
+      if (size_t equals = value.find('='); equals != std::string_view::npos) {
+        program = value.substr(0, equals);
+        value.remove_prefix(equals + 1);
+        if (program.empty() || program.find('/') != std::string::npos) {
+          return std::unexpected(parse_args_errors::plazo_no_valido);
+        }
+      }
+      uint64_t milliseconds = 0;
+      try {
+        milliseconds = std::stoull(std::string(value));
+      } catch (const std::exception&) {
+        return std::unexpected(parse_args_errors::plazo_no_valido);
+      }
+      if (milliseconds == 0 || milliseconds > 86'400'000) {
+        return std::unexpected(parse_args_errors::plazo_no_valido);
+      }
+      if (program.empty()) {
+        bin_set_timeout(milliseconds * 1'000'000);
+      } else {
+        bin_set_program_timeout(program, milliseconds * 1'000'000);
+      }
+    } else if (*it == "-l" || *it == "--listen") {
+      if (++it == end || it->starts_with("-")) {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+      auto address = parse_listen_address(*it);
+      if (!address) {
+        return std::unexpected(parse_args_errors::direccion_no_valida);
+      }
+      options.listen.push_back(std::move(address.value()));
+    } else if (*it == "--backlog" || *it == "--max-connections" ||
+               *it == "--max-per-ip" || *it == "--rate" || *it == "--burst") {
+      std::string_view option = *it;
+      if (++it == end || it->starts_with("-")) {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+      unsigned long value = 0;
+      try {
+        value = std::stoul(std::string(*it));
+      } catch (const std::exception&) {
+        return std::unexpected(parse_args_errors::admision_no_valida);
+      }
+      if (value == 0 || value > 1'000'000) {
+        return std::unexpected(parse_args_errors::admision_no_valida);
+      }
+      if (option == "--backlog") {
+        options.admission.backlog = static_cast<int>(value);
+      } else if (option == "--max-connections") {
+        options.admission.max_connections = value;
+      } else if (option == "--max-per-ip") {
+        options.admission.max_per_ip = value;
+      } else if (option == "--rate") {
+        options.admission.rate = value;
+      } else {
+        options.admission.burst = value;
+      }
+    } else if (*it == "--restart-socket") {
+      if (++it == end || it->starts_with("-")) {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+      options.restart_socket = *it;
+    } else if (*it == "--cache-history") {
+      if (++it == end || it->starts_with("-")) {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+      options.cache_history = *it;
+    } else if (*it == "--shared-cache") {
+      if (++it == end || it->starts_with("-")) {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+      // Un nombre de shm_open(): "/nombre", sin más barras
+      if (it->size() < 2 || it->front() != '/' ||
+          it->find('/', 1) != std::string_view::npos) {
+        return std::unexpected(parse_args_errors::cache_no_valida);
+      }
+      options.shared_cache = *it;
+    } else if (*it == "--file-cache" || *it == "--prewarm-count" ||
+               *it == "--prewarm-budget" || *it == "--shared-cache-size") {
+      std::string_view option = *it;
+      if (++it == end || it->starts_with("-")) {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+      uint64_t value = 0;
+      try {
+        value = std::stoull(std::string(*it));
+      } catch (const std::exception&) {
+        return std::unexpected(parse_args_errors::cache_no_valida);
+      }
+      if (option == "--file-cache") {
+        if (value > (uint64_t{1} << 40)) {
+          return std::unexpected(parse_args_errors::cache_no_valida);
+        }
+        options.file_cache_bytes = value;
+      } else if (option == "--shared-cache-size") {
+        if (value < (uint64_t{1} << 20) || value > (uint64_t{1} << 40)) {
+          return std::unexpected(parse_args_errors::cache_no_valida);
+        }
+        options.shared_cache_bytes = value;
+      } else if (option == "--prewarm-count") {
+        if (value == 0 || value > 1'000'000) {
+          return std::unexpected(parse_args_errors::cache_no_valida);
+        }
+        options.prewarm_count = value;
+      } else {
+        if (value > 600'000) {
+          return std::unexpected(parse_args_errors::cache_no_valida);
+        }
+        options.prewarm_budget_ns = value * 1'000'000;
+      }
+    } else if (*it == "--digest-sha256") {
+      options.digest_sha256 = true;
+    } else if (*it == "--allow-put") {
+      options.uploads.enabled = true;
+    } else if (*it == "--put-durability") {
+      if (++it == end || it->starts_with("-")) {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+      if (*it == "none") {
+        options.uploads.durability = upload_durability::none;
+      } else if (*it == "data") {
+        options.uploads.durability = upload_durability::data;
+      } else if (*it == "full") {
+        options.uploads.durability = upload_durability::full;
+      } else {
+        return std::unexpected(parse_args_errors::subida_no_valida);
+      }
+    } else if (*it == "--put-max-size") {
+      if (++it == end || it->starts_with("-")) {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+      try {
+        options.uploads.max_bytes = std::stoull(std::string(*it));
+      } catch (const std::exception&) {
+        return std::unexpected(parse_args_errors::subida_no_valida);
+      }
+    } else if (*it == "--tcp-nodelay") {
+      options.tuning.nodelay = true;
+    } else if (*it == "--tcp-cork") {
+      options.tuning.cork = true;
+    } else if (*it == "--tcp-defer-accept" || *it == "--tcp-fastopen" ||
+               *it == "--sndbuf" || *it == "--tcp-notsent-lowat" ||
+               *it == "--busy-poll") {
+      std::string_view option = *it;
+      if (++it == end || it->starts_with("-")) {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+      unsigned long value = 0;
+      try {
+        value = std::stoul(std::string(*it));
+      } catch (const std::exception&) {
+        return std::unexpected(parse_args_errors::opcion_socket_no_valida);
+      }
+      if (value == 0 || value > INT_MAX) {
+        return std::unexpected(parse_args_errors::opcion_socket_no_valida);
+      }
+      int number = static_cast<int>(value);
+      if (option == "--tcp-defer-accept") {
+        options.tuning.defer_accept_s = number;
+      } else if (option == "--tcp-fastopen") {
+        options.tuning.fastopen_queue = number;
+      } else if (option == "--sndbuf") {
+        options.tuning.sndbuf = number;
+      } else if (option == "--tcp-notsent-lowat") {
+        options.tuning.notsent_lowat = number;
+      } else {
+        options.tuning.busy_poll_us = number;
+      }
+    } else if (*it == "--header-timeout" || *it == "--send-timeout") {
+      std::string_view option = *it;
+      if (++it == end || it->starts_with("-")) {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+      uint64_t milliseconds = 0;
+      try {
+        milliseconds = std::stoull(std::string(*it));
+      } catch (const std::exception&) {
+        return std::unexpected(parse_args_errors::plazo_conexion_no_valido);
+      }
+      if (milliseconds == 0 || milliseconds > 86'400'000) {
+        return std::unexpected(parse_args_errors::plazo_conexion_no_valido);
+      }
+      if (option == "--header-timeout") {
+        connection_set_header_timeout(milliseconds * 1'000'000);
+      } else {
+        connection_set_send_timeout(milliseconds * 1'000'000);
+      }
+    } else if (*it == "--send-policy") {
+      if (++it == end || it->starts_with("-")) {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+      auto policy = parse_send_policy(*it);
+      if (!policy) {
+        return std::unexpected(parse_args_errors::envio_no_valido);
+      }
+      options.scheduling = policy.value();
+    } else if (*it == "--send-quantum") {
+      if (++it == end || it->starts_with("-")) {
+        return std::unexpected(parse_args_errors::argumento_faltante);
+      }
+      try {
+        options.send_quantum = std::stoul(std::string(*it));
+      } catch (const std::exception&) {
+        return std::unexpected(parse_args_errors::envio_no_valido);
+      }
+      if (options.send_quantum < 4096 || options.send_quantum > (16u << 20)) {
+        return std::unexpected(parse_args_errors::envio_no_valido);
+      }
     } else if (std::filesystem::exists(*it)) {
       options.output_filename = *it;
     } else if (it->starts_with("-") || it->starts_with("--")) {
@@ -230,158 +509,630 @@ std::expected<program_options, parse_args_errors> parse_args(int argc,
 
 void Usage(char* argv[]) {
   std::cout << "Usage: " << argv[0] << " [-v | --verbose] [-h | --help]"
-            << "[-p <puerto> | --port <puerto>] [-b <ruta> | --base <ruta>]\n";
+            << "[-p <puerto> | --port <puerto>] [-b <ruta> | --base <ruta>]"
+            << "[-l <address> | --listen <address>]..."
+            << "[-t <N> | --trace <N>] [-w <N> | --bin-workers <N>]"
+            << "[--bin-max-children <N>] [--bin-max-per-program <N>]"
+            << "[--bin-queue-ms <ms>] [--bin-timeout [<program>=]<ms>]"
+            << "[--header-timeout <ms>] [--send-timeout <ms>]"
+            << "[--send-policy off|rr|srpt|wfq] [--send-quantum <bytes>]"
+            << "[--backlog <N>] [--max-connections <N>] [--max-per-ip <N>]"
+            << "[--rate <N>] [--burst <N>] [--tcp-nodelay] [--tcp-cork]"
+            << "[--tcp-defer-accept <s>] [--tcp-fastopen <N>] [--sndbuf <size>]"
+            << "[--tcp-notsent-lowat <size>] [--busy-poll <us>]"
+            << "[--config <file>] [--restart-socket <path>]"
+            << "[--file-cache <bytes>] [--cache-history <file>]"
+            << "[--prewarm-count <N>] [--prewarm-budget <ms>]"
+            << "[--allow-put] [--put-durability none|data|full]"
+            << "[--put-max-size <bytes>] [--digest-sha256]"
+            << "[--shared-cache </name>] [--shared-cache-size <bytes>]\n";
   std::cout << "Options:\n";
   std::cout << "  -h, --help    Show this help mensaje\n";
   std::cout << "  -v, --verbose Enable verbose mode\n";
   std::cout << "  -p, --port    Set port number\n";
   std::cout << "  -b, --base    Set base directory\n";
+  std::cout << "  -l, --listen  Listen on <port>, <ipv4>:<port>, unix:<path> "
+               "or unix:@<abstract name>;\n"
+               "                repeatable (default: the port of -p)\n";
+  std::cout << "  -t, --trace   Trace 1 of every N requests (0 = off); "
+               "SIGUSR1 dumps the trace to trace-<pid>-<n>.json\n";
+  std::cout << "  -w, --bin-workers  Keep N persistent workers per /bin "
+               "program (0 = one process per request, max 64)\n";
+  std::cout << "  --bin-max-children     /bin processes running at once "
+               "(default 32)\n";
+  std::cout << "  --bin-max-per-program  Processes of one /bin program at "
+               "once (default 8)\n";
+  std::cout << "  --bin-queue-ms         Longest wait for a /bin slot before "
+               "503 (default 2000)\n";
+  std::cout << "  --bin-timeout          Deadline of /bin requests, 504 when "
+               "exceeded (default 30000);\n"
+               "                         <program>=<ms> sets it for one "
+               "program (repeatable)\n";
+  std::cout << "  --header-timeout       Time to receive the request line "
+               "before closing (default 10000)\n";
+  std::cout << "  --send-timeout         Time a client may stop reading the "
+               "response before closing (default 30000)\n";
+  std::cout << "  --send-policy          Which connection sends next when "
+               "several can: rr (in turn),\n"
+               "                         srpt (least bytes left first, "
+               "default), wfq (static files\n"
+               "                         weigh more than /bin) or off (each "
+               "one fills its socket)\n";
+  std::cout << "  --send-quantum         Bytes a connection sends per turn "
+               "(default 65536)\n";
+  std::cout << "  --backlog              Pending connections queue of listen() "
+               "(default 128)\n";
+  std::cout << "  --max-connections      Open connections at once; more get a "
+               "503 (default unlimited)\n";
+  std::cout << "  --max-per-ip           Open connections at once per client "
+               "(default unlimited)\n";
+  std::cout << "  --rate                 Requests per second admitted, 503 "
+               "beyond it; /bin requests are\n"
+               "                         shed first (default unlimited)\n";
+  std::cout << "  --burst                Requests admitted in a burst above "
+               "--rate (default = rate)\n";
+  std::cout << "  --tcp-nodelay          Disable Nagle (TCP_NODELAY)\n";
+  std::cout << "  --tcp-cork             Cork headers and a spliced or chunked "
+               "body together (TCP_CORK)\n";
+  std::cout << "  --tcp-defer-accept     Wake up on a connection only when its "
+               "request arrives, waiting\n"
+               "                         up to <s> seconds "
+               "(TCP_DEFER_ACCEPT)\n";
+  std::cout << "  --tcp-fastopen         Accept data in the SYN, with a queue of "
+               "<N> (TCP_FASTOPEN)\n";
+  std::cout << "  --sndbuf               Socket send buffer in bytes "
+               "(SO_SNDBUF)\n";
+  std::cout << "  --tcp-notsent-lowat    Unsent bytes kept in the kernel before "
+               "the socket is writable\n"
+               "                         again (TCP_NOTSENT_LOWAT)\n";
+  std::cout << "  --busy-poll            Busy poll the device for <us> "
+               "microseconds on reads (SO_BUSY_POLL)\n";
+  std::cout << "  --config               Read options from a file, one "
+               "\"<option>[=<value>]\" per line\n"
+               "                         without the leading dashes\n";
+  std::cout << "  --restart-socket       Hot restart control socket (a path, "
+               "or @<name> for an abstract\n"
+               "                         one). A new server given the same "
+               "path takes over the listening\n"
+               "                         sockets of the running one, which "
+               "finishes its connections and exits\n";
+  std::cout << "  --file-cache           Bytes of static files kept mapped "
+               "(default 64 MiB, 0 = none)\n";
+  std::cout << "  --cache-history        Save the most requested files here "
+               "every minute, and load\n"
+               "                         them into the cache on startup\n";
+  std::cout << "  --prewarm-count        Files saved in the history (default "
+               "256)\n";
+  std::cout << "  --prewarm-budget       Longest time loading them before "
+               "accepting connections\n"
+               "                         (default 2000)\n";
+  std::cout << "  --allow-put            Accept \"PUT <path> [<length>]\" "
+               "followed by the file, which\n"
+               "                         replaces <path> atomically (without "
+               "a length, the body ends\n"
+               "                         when the client shuts down its side)\n";
+  std::cout << "  --put-durability       Sync uploads before answering: none, "
+               "data (default) or full\n"
+               "                         (also the directory entry)\n";
+  std::cout << "  --put-max-size         Largest upload in bytes (default "
+               "1 GiB)\n";
+  std::cout << "  --digest-sha256        Also hash served files with SHA-256 "
+               "and send it in\n"
+               "                         Repr-Digest and Digest (the ETag "
+               "uses XXH3-128)\n";
+  std::cout << "  --shared-cache         Keep small files (up to 256 KiB) and "
+               "their headers in the\n"
+               "                         shared memory segment </name> "
+               "(shm_open), shared with every\n"
+               "                         server that opens it, such as the "
+               "new one of a hot restart\n";
+  std::cout << "  --shared-cache-size    Bytes of files in a new segment "
+               "(default 64 MiB, at least 1 MiB)\n";
+}
+
+/**
+ *
+ */
+std::string getenv(const std::string& name) {
+  char* value = getenv(name.c_str());
+  if (value) {
+    return std::string(value);
+  } else {
+    return std::string();
+  }
 }
 
 /**
- * @brief Crear un socket y asignarle el puerto indicado
+ * @brief Aceptar una conexión
  */
-std::expected<SafeFD, int> make_socket(uint16_t socket_port) {
-  int fd = socket(AF_INET, SOCK_STREAM, 0);
-  if (fd < 0) {
-    print_verbose("Error al crear el socket");
+std::expected<SafeFD, int> accept_connection(const SafeFD& socket,
+                                             sockaddr_in& client_addr) {
+  sockaddr_storage address{};
+  socklen_t client_addr_len = sizeof(address);
+  int client_fd =
+      accept4(socket.get(), reinterpret_cast<sockaddr*>(&address),
+              &client_addr_len, SOCK_CLOEXEC | SOCK_NONBLOCK);
+  if (client_fd < 0) {
     return std::unexpected(errno);
   }
-  print_verbose("Make_socket: Socket creado");
+  if (address.ss_family == AF_INET) {
+    std::memcpy(&client_addr, &address, sizeof(client_addr));
+  } else {
+    // Por un socket Unix el cliente no tiene dirección IP
+    client_addr = {};
+    client_addr.sin_family = AF_UNIX;
+  }
+  print_verbose("Accept: Conexion aceptada");
+  return SafeFD(client_fd);
+}
 
-  int opt = 1;
-  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-  print_verbose("Setsockopt: Socket configurado");
+/**
+ * @brief Responde con un error y lo anota en la salida de errores; solo se
+ * cierra esa conexión.
+ */
+void respond_error(Connection& connection, int status,
+                   std::string_view message) {
+  connection.respond(status_line(status));
+  std::cerr << "Error: " << message << "\n";
+}
 
-  sockaddr_in local_address{};
-  local_address.sin_family = AF_INET;
-  local_address.sin_addr.s_addr = htonl(INADDR_ANY);
-  local_address.sin_port = htons(socket_port);
+/**
+ * @brief Página del propio servidor (/metrics o /_trace).
+ */
+struct builtin_page {
+  int status = 200;
+  std::string content_type;
+  std::string body;
+};
 
-  int result = bind(fd, reinterpret_cast<sockaddr*>(&local_address),
-                    sizeof(local_address));
-  if (result < 0) {
-    print_verbose("Error al enlazar el socket");
-    close(fd);
-    return std::unexpected(errno);
+/**
+ * @return La página de path, o nullopt si no es de ninguna.
+ */
+std::optional<builtin_page> make_builtin_page(const std::string& path) {
+  // Métricas del propio servidor en formato Prometheus
+  if (path == "/metrics") {
+    return builtin_page{200, "text/plain; version=0.0.4", metrics_render()};
   }
-  print_verbose("Bind: Socket enlazado");
-
-  return SafeFD(fd);
+  if (path != "/_trace" && !path.starts_with("/_trace?")) {
+    return std::nullopt;
+  }
+  // Con "?sample=N" se cambia el muestreo; sin nada, se vuelca la traza
+  auto query = path.find("?sample=");
+  if (query == std::string::npos) {
+    return builtin_page{200, "application/json", trace_dump_json()};
+  }
+  try {
+    unsigned long every = std::stoul(path.substr(query + 8));
+    trace_sample_every =
+        static_cast<uint32_t>(std::min<unsigned long>(every, UINT32_MAX));
+  } catch (const std::exception&) {
+    return builtin_page{400, "", ""};
+  }
+  return builtin_page{200, "application/json",
+                      std::format("sample_every={}\n",
+                                  trace_sample_every.load())};
 }
 
 /**
- *
+ * @brief Con sobrecarga se rechaza primero lo más caro.
  */
-std::string getenv(const std::string& name) {
-  char* value = getenv(name.c_str());
-  if (value) {
-    return std::string(value);
-  } else {
-    return std::string();
+request_priority priority_for(const std::string& path) {
+  if (path == "/metrics" || path == "/_trace" || path.starts_with("/_trace?")) {
+    return request_priority::exempt;
+  }
+  if (path.starts_with("/bin/") || path.starts_with("/_sums/")) {
+    return request_priority::low;
   }
+  return request_priority::high;
 }
 
 /**
- * @brief Escuchar conexiones en el puerto indicado
+ * @brief Peso de una respuesta con --send-policy wfq: lo barato y lo que
+ * consulta el operador avanza antes que /bin.
  */
-int listen_connection(const SafeFD& socket) {
-  int result = listen(socket.get(), 10);
-  if (result < 0) {
-    print_verbose("Error al escuchar conexiones");
-    return errno;
-  }
-  print_verbose("Listen: Escuchando conexiones");
-  return 0;
+uint32_t send_weight_for(request_priority priority) {
+  switch (priority) {
+    case request_priority::exempt:
+      return 4;
+    case request_priority::high:
+      return 2;
+    default:
+      return 1;
+  }
 }
 
-std::expected<std::string, int> receive_request(const SafeFD& socket,
-                                                size_t max_size) {
-  std::string buffer(max_size, '\0');
-  ssize_t result = recv(socket.get(), buffer.data(), buffer.size(), 0);
-  if (result < 0) {
-    print_verbose("Error al recibir la petición");
-    return std::unexpected(errno);
+/**
+ * @brief Código de respuesta de no poder leer un archivo.
+ */
+int file_error_status(int error) {
+  switch (error) {
+    case EACCES:
+      return 403;
+    case ENOENT:
+      return 404;
+    default:
+      return 500;
   }
-  print_verbose("Recv: Peticion recibida");
-  return buffer;
 }
 
 /**
- * @brief Aceptar una conexión
+ * @brief Responde a un lote de archivos (ver batch.h) en una sola respuesta.
+ * Primero se piden a la vez las lecturas de todos los que no están en la
+ * caché; luego se mapean y salen seguidos, sin copiarlos.
  */
-std::expected<SafeFD, int> accept_connection(const SafeFD& socket,
-                                             sockaddr_in& client_addr) {
-  socklen_t client_addr_len = sizeof(client_addr);
-  int client_fd =
-      accept(socket.get(), reinterpret_cast<sockaddr*>(&client_addr),
-             &client_addr_len);
-  if (client_fd < 0) {
-    print_verbose("Error al aceptar la conexión");
-    return std::unexpected(errno);
+void respond_batch(Connection& connection, const std::string& path,
+                   FileCache& files) {
+  auto paths = batch_paths(path);
+  if (!paths) {
+    int status = paths.error() == ENOENT || paths.error() == EACCES
+                     ? file_error_status(paths.error())
+                     : 400;
+    respond_error(connection, status,
+                  paths.error() == E2BIG ? "too many files in batch"
+                                         : status_line(status));
+    return;
   }
-  print_verbose("Accept: Conexion aceptada");
-  return SafeFD(client_fd);
+  files.prefetch(paths.value());
+  std::vector<batch_entry> entries;
+  entries.reserve(paths->size());
+  for (auto& file_path : paths.value()) {
+    auto file = files.get(file_path);
+    batch_entry entry{std::move(file_path), 200, nullptr};
+    if (file) {
+      entry.file = std::move(file.value());
+    } else {
+      entry.status = file_error_status(file.error());
+    }
+    entries.push_back(std::move(entry));
+  }
+  auto response = make_batch_response(entries);
+  connection.respond(response.header, std::move(response.body));
 }
 
 /**
- * @brief Lee el contenido de un archivo.
- * @param path Ruta del archivo.
- * @return Contenido del archivo.
+ * @brief Pasa a ready el contenido y las sumas de los bloques de un archivo
+ * estático, ahora o cuando acabe de calcularlas el hilo (ver
+ * BlockSumsCache::get()).
+ * @return El ticket de la espera (0 si ready ya se ha llamado), o el código
+ * de respuesta de no poder leerlo.
  */
-std::expected<SafeMap, int> read_all(const std::string& path) {
-  int fd = open(path.c_str(), O_RDONLY);
-  if (fd < 0) {
-    // Error al abrir el archivo...
-    print_verbose("Error al abrir el archivo");
-    return std::unexpected(errno);
+std::expected<uint64_t, int> file_with_sums(
+    const std::string& path, FileCache& files, BlockSumsCache& sums,
+    BlockSumsCache::sums_callback ready) {
+  if (path.empty() || path.front() != '/' || path.back() == '/' ||
+      path.starts_with("/bin/") || path.starts_with("/_")) {
+    return std::unexpected(400);
   }
-  print_verbose("Open: Archivo \"" + path + "\" abierto correctamente");
+  // Hecho antes de obtener el contenido: ver BlockSumsCache::get()
+  struct stat info {};
+  auto file = files.get(path, &info);
+  if (!file) {
+    return std::unexpected(file_error_status(file.error()));
+  }
+  return sums.get(path, info, file.value(), std::move(ready));
+}
 
-  off_t length = lseek(fd, 0, SEEK_END);
-  if (length < 0) {
-    // Error al obtener el tamaño del archivo...
-    print_verbose("Error al obtener el tamaño del archivo");
-    close(fd);
-    return std::unexpected(errno);
+/**
+ * @brief Una conexión que espera las sumas de un archivo grande: si se
+ * cierra antes, deja de esperarlas.
+ */
+class SumsWait : public ResponseSource {
+ public:
+  SumsWait(BlockSumsCache& sums, uint64_t ticket)
+      : sums_(sums), ticket_(ticket) {}
+
+  void abort() override { sums_.cancel(ticket_); }
+
+ private:
+  BlockSumsCache& sums_;
+  uint64_t ticket_;
+};
+
+using sums_response =
+    std::function<void(Connection&, const std::shared_ptr<const SafeMap>&,
+                       const file_sums&)>;
+
+/**
+ * @brief Responde con respond cuando estén las sumas de los bloques de path
+ * (o con el error de no poder tenerlas), sin parar el bucle a calcularlas.
+ */
+void respond_with_sums(Connection& connection, const std::string& path,
+                       FileCache& files, BlockSumsCache& sums,
+                       sums_response respond) {
+  auto ticket = file_with_sums(
+      path, files, sums,
+      [&connection, respond = std::move(respond)](
+          const std::shared_ptr<const SafeMap>& content,
+          const std::shared_ptr<const file_sums>& file_sums) {
+        if (!file_sums) {
+          connection.respond(kOverloadHeader);
+          return;
+        }
+        respond(connection, content, *file_sums);
+      });
+  if (!ticket) {
+    respond_error(connection, ticket.error(), status_line(ticket.error()));
+    return;
   }
+  if (*ticket != 0) {
+    connection.set_source(std::make_unique<SumsWait>(sums, *ticket));
+  }
+}
 
-  void* mem =
-      mmap(NULL, static_cast<size_t>(length), PROT_READ, MAP_PRIVATE, fd, 0);
-  close(fd);
-  print_verbose("Close: Archivo \"" + path + "\" cerrado correctamente");
-  if (mem == MAP_FAILED) {
-    // Error al mapear el archivo...
-    print_verbose("Mmap: error al mapear el archivo \"" + path +
-                  "\" (errno: " + std::to_string(errno) + ")");
-    return std::unexpected(errno);
+/**
+ * @brief Atiende "DELTA <ruta> <número>" seguido de las sumas de los
+ * bloques que ya tiene el cliente: responde con el delta (ver delta.h).
+ */
+void handle_delta(Connection& connection, std::istringstream& iss,
+                  const std::string& path, AdmissionControl& admission,
+                  FileCache& files, BlockSumsCache& sums) {
+  uint64_t count = 0;
+  if (!(iss >> count) || count > kMaxDeltaSums) {
+    respond_error(connection, 400, "bad request");
+    return;
+  }
+  if (!admission.admit_request(request_priority::low)) {
+    connection.respond(kOverloadHeader);
+    return;
   }
-  print_verbose("Mmap: archivo \"" + path + "\" mapeado correctamente");
+  connection.read_body(
+      count * kBlockSumBytes,
+      [path, &files, &sums](Connection& client, std::string body) {
+        std::vector<block_sum> have;
+        have.reserve(body.size() / kBlockSumBytes);
+        for (size_t i = 0; i < body.size(); i += kBlockSumBytes) {
+          have.push_back(read_block_sum(std::string_view(body).substr(i)));
+        }
+        respond_with_sums(
+            client, path, files, sums,
+            [have = std::move(have)](
+                Connection& ready,
+                const std::shared_ptr<const SafeMap>& content,
+                const file_sums& file_sums) {
+              auto [delta, length] = make_delta(content, file_sums, have);
+              ready.respond(
+                  std::format("Content-Length: {}\r\nContent-Type: "
+                              "application/x-docserver-delta\r\n",
+                              length),
+                  std::move(delta));
+            });
+      });
+}
 
-  return SafeMap(
-      std::string_view(static_cast<char*>(mem), static_cast<size_t>(length)));
+/**
+ * @brief Atiende una petición de una sesión HTTP/2. Los programas de /bin
+ * y los lotes responden desde la conexión, así que esos streams se
+ * rechazan para que el cliente los pida por una conexión aparte.
+ */
+h2_response handle_h2_request(std::string_view target,
+                              AdmissionControl& admission, FileCache& files,
+                              BlockSumsCache& sums, DigestCache& digests) {
+  std::string path(target);
+  h2_response response;
+  if (path.empty() || path.front() != '/' || path.back() == '/') {
+    response.status = 400;
+    return response;
+  }
+  if (path.starts_with("/bin/") || is_batch_path(path)) {
+    response.needs_http1 = true;
+    return response;
+  }
+  if (!admission.admit_request(priority_for(path))) {
+    response.status = 503;
+    response.headers.push_back({"retry-after", "1"});
+    return response;
+  }
+  if (auto page = make_builtin_page(path)) {
+    response.status = page->status;
+    if (!page->content_type.empty()) {
+      response.headers.push_back({"content-type", page->content_type});
+    }
+    response.body = std::move(page->body);
+    return response;
+  }
+  if (path.starts_with("/_sums/")) {
+    std::shared_ptr<const file_sums> found;
+    auto ticket = file_with_sums(
+        path.substr(6), files, sums,
+        [&found](const std::shared_ptr<const SafeMap>&,
+                 const std::shared_ptr<const file_sums>& file_sums) {
+          found = file_sums;
+        });
+    if (!ticket) {
+      response.status = ticket.error();
+      return response;
+    }
+    if (*ticket != 0 || !found) {
+      // El stream no puede esperar: el hilo sigue y estarán al reintentar
+      sums.cancel(*ticket);
+      response.status = 503;
+      response.headers.push_back({"retry-after", "1"});
+      return response;
+    }
+    response.headers.push_back(
+        {"content-type", "application/x-docserver-sums"});
+    response.body = encode_sums(*found);
+    return response;
+  }
+  struct stat info {};
+  auto file = files.get(path, &info);
+  if (!file) {
+    response.status = file_error_status(file.error());
+    std::cerr << "Error: " << status_line(response.status) << "\n";
+    return response;
+  }
+  if (auto digest = digests.get(path, info, file.value())) {
+    append_digest_headers(response.headers, *digest);
+  }
+  response.file = std::move(file.value());
+  return response;
 }
 
 /**
- * @brief Envia la respuesta al cliente.
- * @param header Cabecera de la respuesta.
- * @param body Cuerpo de la respuesta.
+ * @brief Atiende un PUT: "PUT <ruta> [<longitud>]" y detrás el contenido.
  */
-void send_response(std::string_view header, std::string_view body = {}) {
-  std::cout << header << "\n";
-  std::cout << body << "\n\n";
+void handle_put(Connection& connection, std::istringstream& iss,
+                const std::string& path, AdmissionControl& admission,
+                FileCache& files, DigestCache& digests,
+                const upload_limits& uploads) {
+  if (!uploads.enabled) {
+    respond_error(connection, 405, "method not allowed");
+    return;
+  }
+  if (!is_upload_path(path)) {
+    respond_error(connection, 400, "bad request");
+    return;
+  }
+  std::optional<uint64_t> length;
+  std::string length_text;
+  if (iss >> length_text) {
+    try {
+      size_t parsed = 0;
+      length = std::stoull(length_text, &parsed);
+      if (parsed != length_text.size()) {
+        throw std::invalid_argument(length_text);
+      }
+    } catch (const std::exception&) {
+      respond_error(connection, 400, "bad request");
+      return;
+    }
+  }
+  if (!admission.admit_request(request_priority::low)) {
+    connection.respond(kOverloadHeader);
+    return;
+  }
+  Upload::start(connection, path, length, uploads,
+                [&files, &digests](const std::string& stored) {
+                  files.forget(stored);
+                  digests.forget(stored);
+                });
 }
 
-int send_response(const SafeFD& socket, std::string_view header,
-                  std::string_view body) {
-  std::string response = std::string(header) + "\r\n" + std::string(body);
-  ssize_t result = send(socket.get(), response.data(), response.size(), 0);
-  if (result < 0) {
-    print_verbose("Error al enviar la respuesta");
-    return errno;
+/**
+ * @brief Atiende la petición de una conexión.
+ * @param request Primera línea de la petición.
+ */
+void handle_request(Connection& connection, std::string_view request,
+                    AdmissionControl& admission, FileCache& files,
+                    BlockSumsCache& sums, DigestCache& digests,
+                    SharedFileCache* shared, const upload_limits& uploads) {
+  print_verbose("Petición recibida: " + std::string(request));
+
+  // HTTP/2 con conocimiento previo: la conexión pasa a la sesión
+  if (http2_is_preface(request)) {
+    Http2Session::start(
+        connection,
+        [&admission, &files, &sums, &digests](std::string_view path) {
+          return handle_h2_request(path, admission, files, sums, digests);
+        });
+    return;
+  }
+
+  // Solo la primera línea: lo que viene detrás es el cuerpo (PUT, DELTA)
+  std::istringstream iss{std::string(request.substr(0, request.find('\n')))};
+  std::string get, output_filename;
+  iss >> get >> output_filename;
+
+  if (get == "PUT") {
+    handle_put(connection, iss, output_filename, admission, files, digests,
+               uploads);
+    return;
+  }
+  if (get == "DELTA") {
+    handle_delta(connection, iss, output_filename, admission, files, sums);
+    return;
+  }
+
+  // Errores
+  if (get != "GET") {
+    respond_error(connection, 400, "method not allowed");
+    return;
+  }
+
+  if (output_filename.empty() || output_filename.front() != '/' ||
+      output_filename.back() == '/') {
+    respond_error(connection, 400, "bad request");
+    return;
+  }
+
+  request_priority priority = priority_for(output_filename);
+  connection.set_send_weight(send_weight_for(priority));
+  if (!admission.admit_request(priority)) {
+    connection.respond(kOverloadHeader);
+    return;
+  }
+
+  if (auto page = make_builtin_page(output_filename)) {
+    if (page->status != 200) {
+      respond_error(connection, page->status, "bad request");
+      return;
+    }
+    std::string header =
+        std::format("Content-Length: {}\r\nContent-Type: {}\r\n",
+                    page->body.size(), page->content_type);
+    connection.respond(header, page->body);
+  } else if (output_filename.starts_with("/_sums/")) {
+    respond_with_sums(
+        connection, output_filename.substr(6), files, sums,
+        [](Connection& ready, const std::shared_ptr<const SafeMap>&,
+           const file_sums& file_sums) {
+          std::string body = encode_sums(file_sums);
+          ready.respond(
+              std::format("Content-Length: {}\r\nContent-Type: "
+                          "application/x-docserver-sums\r\n",
+                          body.size()),
+              body);
+        });
+  } else if (is_batch_path(output_filename)) {
+    respond_batch(connection, output_filename, files);
+  } else if (output_filename.starts_with("/bin/")) {
+    auto bin = parse_bin_request(output_filename);
+    if (!bin) {
+      respond_error(connection, 400, "bad request");
+      return;
+    }
+    bin->remote_ip = connection.peer().sin_family == AF_UNIX
+                         ? "unix:"
+                         : inet_ntoa(connection.peer().sin_addr);
+    bin->remote_port = ntohs(connection.peer().sin_port);
+    // Responde más tarde, desde el bucle de eventos
+    bin_workers_serve(connection, bin.value());
+  } else {
+    struct stat info {};
+    // Otro proceso puede haberlo dejado ya, con sus cabeceras
+    if (shared != nullptr &&
+        stat((base_dir + output_filename).c_str(), &info) == 0) {
+      if (auto hit = shared->get(output_filename, info)) {
+        files.note_use(output_filename, hit->content.size());
+        connection.respond(hit->header,
+                           std::vector<body_segment>{
+                               {std::move(hit->pin), hit->content}});
+        return;
+      }
+    }
+    auto file_content = files.get(output_filename, &info);
+
+    if (!file_content) {
+      int status = file_error_status(file_content.error());
+      respond_error(connection, status,
+                    status == 500 ? "unknown error" : status_line(status));
+      return;
+    }
+
+    size_t size = file_content.value()->get().size();
+    std::string header = std::format("Content-Length: {}\r\n", size);
+    // El primero que lo pide lo encarga y se queda sin estas cabeceras
+    if (auto digest =
+            digests.get(output_filename, info, file_content.value())) {
+      header += digest_header_lines(*digest);
+      // Con el resumen ya está completo para los demás procesos
+      if (shared != nullptr) {
+        shared->put(output_filename, info, header,
+                    file_content.value()->get());
+      }
+    }
+    connection.respond(header, std::move(file_content.value()));
   }
-  print_verbose("Send: Respuesta enviada");
-  return 0;
 }
 
 /**
@@ -405,6 +1156,42 @@ int main(int argc, char* argv[]) {
       case parse_args_errors::puerto_no_usable:
         std::cerr << "Error: port out of bounds\n";
         break;
+      case parse_args_errors::muestreo_no_valido:
+        std::cerr << "Error: invalid trace sampling rate\n";
+        break;
+      case parse_args_errors::workers_no_valido:
+        std::cerr << "Error: invalid number of bin workers\n";
+        break;
+      case parse_args_errors::limite_no_valido:
+        std::cerr << "Error: invalid bin scheduler limit\n";
+        break;
+      case parse_args_errors::plazo_no_valido:
+        std::cerr << "Error: invalid bin timeout\n";
+        break;
+      case parse_args_errors::plazo_conexion_no_valido:
+        std::cerr << "Error: invalid connection timeout\n";
+        break;
+      case parse_args_errors::direccion_no_valida:
+        std::cerr << "Error: invalid listen address\n";
+        break;
+      case parse_args_errors::opcion_socket_no_valida:
+        std::cerr << "Error: invalid socket option value\n";
+        break;
+      case parse_args_errors::config_no_valida:
+        std::cerr << "Error: cannot read the config file\n";
+        break;
+      case parse_args_errors::admision_no_valida:
+        std::cerr << "Error: invalid admission limit\n";
+        break;
+      case parse_args_errors::cache_no_valida:
+        std::cerr << "Error: invalid file cache option\n";
+        break;
+      case parse_args_errors::subida_no_valida:
+        std::cerr << "Error: invalid upload option\n";
+        break;
+      case parse_args_errors::envio_no_valido:
+        std::cerr << "Error: invalid send scheduling option\n";
+        break;
       default:
         std::cerr << "Error: unknown error\n";
         break;
@@ -447,130 +1234,313 @@ int main(int argc, char* argv[]) {
     return EXIT_SUCCESS;
   }
 
-  auto socket = make_socket(port);
-  if (!socket) {
-    switch (socket.error()) {
-      case ECONNRESET:
-        std::cerr << "Error: connection reset by peer\n";
-        break;
-      default:
-        std::cerr << "Error: unknown error\n";
-        break;
+  std::vector<listen_address> addresses = options.listen;
+  if (addresses.empty()) {
+    listen_address address;
+    address.port = port;
+    addresses.push_back(address);
+  }
+  connection_set_cork(options.tuning.cork);
+
+  // Archivos estáticos: los más pedidos la última vez se cargan antes de
+  // empezar a aceptar conexiones y antes de pedir los sockets a un servidor
+  // anterior, que mientras tanto sigue aceptando
+  FileCache files(options.file_cache_bytes);
+  if (!options.cache_history.empty()) {
+    auto history = FileCache::load_history(options.cache_history);
+    if (history && !history.value().empty()) {
+      auto report = files.prewarm(history.value(), options.prewarm_budget_ns);
+      std::cerr << "Prewarm: loaded " << report.files << " files ("
+                << report.bytes << " bytes) in "
+                << report.elapsed_ns / 1'000'000 << " ms"
+                << (report.out_of_time ? ", out of time" : "") << "\n";
+    } else if (!history && history.error() != ENOENT) {
+      std::cerr << "Error: cannot read the cache history "
+                << options.cache_history << ": "
+                << std::strerror(history.error()) << "\n";
     }
-    return EXIT_FAILURE;
   }
 
-  if (listen_connection(socket.value()) != 0) {
-    switch (listen_connection(socket.value())) {
-      case ECONNRESET:
-        std::cerr << "Error: connection reset by peer\n";
-        break;
-      default:
-        std::cerr << "Error: unknown error\n";
-        break;
+  // Reinicio en caliente: si hay un servidor en marcha se usan sus sockets
+  restart_handoff inherited;
+  if (!options.restart_socket.empty()) {
+    auto handoff = request_handoff(options.restart_socket);
+    if (handoff) {
+      inherited = std::move(handoff.value());
+      std::cerr << "Hot restart: received " << inherited.listeners.size()
+                << " listening sockets and " << inherited.cache_keys.size()
+                << " cache keys\n";
+    } else if (handoff.error() != ENOENT && handoff.error() != ECONNREFUSED) {
+      std::cerr << "Error: hot restart failed: "
+                << std::strerror(handoff.error()) << "\n";
+      return EXIT_FAILURE;
     }
-    return EXIT_FAILURE;
   }
 
-  while (true) {
-    sockaddr_in client_addr;
-    auto client = accept_connection(socket.value(), client_addr);
-    if (!client) {
-      switch (client.error()) {
-        case ECONNRESET:
-          std::cerr << "Error: connection reset by peer\n";
-          break;
-        default:
-          std::cerr << "Error: unknown error\n";
-          break;
+  std::vector<SafeFD> listeners;  // Uno por cada dirección de addresses
+  for (const auto& address : addresses) {
+    auto same = std::find_if(
+        inherited.listeners.begin(), inherited.listeners.end(),
+        [&](const auto& item) {
+          return item.first == address.to_string() && item.second.is_valid();
+        });
+    if (same != inherited.listeners.end()) {
+      int error = adopt_listener(same->second, address,
+                                 options.admission.backlog, options.tuning);
+      if (error != 0) {
+        std::cerr << "Error: cannot listen on " << address.to_string() << ": "
+                  << std::strerror(error) << "\n";
+        return EXIT_FAILURE;
       }
+      listeners.push_back(std::move(same->second));
+      continue;
+    }
+    auto socket =
+        open_listener(address, options.admission.backlog, options.tuning);
+    if (!socket) {
+      std::cerr << "Error: cannot listen on " << address.to_string() << ": "
+                << std::strerror(socket.error()) << "\n";
       return EXIT_FAILURE;
     }
+    listeners.push_back(std::move(socket.value()));
+  }
+  // Los sockets recibidos que esta ejecución no usa se cierran aquí
+  inherited.listeners.clear();
 
-    print_verbose("Recibiendo petición");
-    auto request = receive_request(client.value(), 1024);
+  trace_install_signal_handler();
+  // Un cliente que cierra a mitad de respuesta da EPIPE en vez de matarnos
+  signal(SIGPIPE, SIG_IGN);
 
-    if (!request) {
-      switch (request.error()) {
-        case ECONNRESET:
-          send_response(client.value(), "400 Bad Request", "");
-          std::cerr << "Error: connection reset by peer\n";
-          break;
-        default:
-          std::cerr << "Error: unknown error\n";
-          break;
-      }
-      return EXIT_FAILURE;
+  EventLoop loop;
+  if (!loop.is_valid()) {
+    std::cerr << "Error: cannot create the event loop\n";
+    return EXIT_FAILURE;
+  }
+  // Quién envía primero cuando pueden varias; vive más que las conexiones
+  std::unique_ptr<SendScheduler> scheduler;
+  if (options.scheduling != send_policy::off) {
+    scheduler = std::make_unique<SendScheduler>(loop, options.scheduling,
+                                                options.send_quantum);
+  }
+  connection_set_send_scheduler(scheduler.get());
+  bin_workers_start(loop, options.bin_limits);
+  bin_workers_prewarm(inherited.cache_keys);
+
+  BlockSumsCache sums(loop, kBlockSumsEntries);
+  DigestCache digests(loop, kDigestEntries, options.digest_sha256);
+  // Las rutas con el mismo contenido comparten el mapeo
+  digests.set_on_digest([&files](const std::string& path,
+                                 const std::shared_ptr<const SafeMap>& content,
+                                 const file_digest& digest) {
+    files.deduplicate(path, content, digest.xxh128);
+  });
+  std::unique_ptr<SharedFileCache> shared;
+  if (!options.shared_cache.empty()) {
+    auto attached = SharedFileCache::attach(options.shared_cache,
+                                            options.shared_cache_bytes);
+    if (attached) {
+      shared = std::move(attached.value());
     } else {
-      print_verbose("Petición recibida: " + request.value());
-
-      std::istringstream iss(request.value());
-      std::string get, output_filename;
-      iss >> get >> output_filename;
-
-      // Errores
-      if (get != "GET") {
-        send_response(client.value(), "400 Bad Request", "");
-        std::cerr << "Error: method not allowed\n";
-        return EXIT_FAILURE;
+      // Sin ella se sirve igual, desde la caché de este proceso
+      std::cerr << "Error: cannot open the shared cache "
+                << options.shared_cache << ": "
+                << std::strerror(attached.error()) << "\n";
+    }
+  }
+  std::function<void()> save_history;
+  std::function<void()> on_history_timer;
+  if (!options.cache_history.empty()) {
+    save_history = [&] {
+      int error = files.save_history(options.cache_history,
+                                     options.prewarm_count);
+      if (error != 0) {
+        std::cerr << "Error: cannot save the cache history "
+                  << options.cache_history << ": " << std::strerror(error)
+                  << "\n";
       }
+    };
+    on_history_timer = [&] {
+      save_history();
+      files.age_usage();
+      loop.add_timer(kHistoryPeriodNs, on_history_timer);
+    };
+    loop.add_timer(kHistoryPeriodNs, on_history_timer);
+  }
 
-      if (output_filename.empty()) {
-        send_response(client.value(), "400 Bad Request", "");
-        std::cerr << "Error: bad request\n";
-        return EXIT_FAILURE;
+  // Conexiones abiertas; las cerradas esperan en closed hasta acabar la
+  // vuelta del bucle, porque se cierran desde sus propios eventos
+  std::unordered_map<Connection*, std::unique_ptr<Connection>> connections;
+  std::vector<std::unique_ptr<Connection>> closed;
+  AdmissionControl admission(options.admission);
+
+  auto on_request = [&](Connection& connection, std::string_view request) {
+    handle_request(connection, request, admission, files, sums, digests,
+                   shared.get(), options.uploads);
+  };
+  auto on_close = [&](Connection& connection) {
+    admission.connection_closed(connection.peer());
+    auto it = connections.find(&connection);
+    if (it != connections.end()) {
+      closed.push_back(std::move(it->second));
+      connections.erase(it);
+    }
+    print_verbose("Conexión cerrada");
+  };
+
+  auto on_accept = [&](const SafeFD& listener) {
+    // Se aceptan todas las que esperan: el socket no bloquea
+    while (true) {
+      sockaddr_in client_addr{};
+      uint64_t accept_start = now_ns();
+      auto client = accept_connection(listener, client_addr);
+      if (!client) {
+        if (client.error() != EAGAIN && client.error() != EINTR) {
+          std::cerr << "Error: accept failed: "
+                    << std::strerror(client.error()) << "\n";
+        }
+        return;
       }
-
-      if (output_filename.front() != '/' || output_filename.back() == '/') {
-        send_response(client.value(), "400 Bad Request", "");
-        std::cerr << "Error: bad request\n";
-        return EXIT_FAILURE;
+      if (!admission.admit_connection(client_addr)) {
+        AdmissionControl::shed(client.value().get());
+        continue;
       }
+      uint64_t accepted_at = now_ns();
+      print_verbose("Accept: Conexion aceptada");
+      auto connection = std::make_unique<Connection>(
+          loop, std::move(client.value()), client_addr, accepted_at);
+      trace_record("accept", accept_start, accepted_at);
+      Connection* raw = connection.get();
+      connections.emplace(raw, std::move(connection));
+      if (!raw->start(on_request, on_close)) {
+        raw->close();
+      }
+      trace_end_request();
+    }
+  };
+  std::vector<uint64_t> listener_watches;
+  for (const auto& listener : listeners) {
+    uint64_t id =
+        loop.watch(listener.get(), EPOLLIN, [&](uint32_t) { on_accept(listener); });
+    if (id == 0) {
+      std::cerr << "Error: cannot watch the listening socket\n";
+      return EXIT_FAILURE;
+    }
+    listener_watches.push_back(id);
+  }
+  // Ya se acepta en los sockets recibidos: el viejo puede dejar de hacerlo
+  if (inherited.control.is_valid()) {
+    if (int error = confirm_handoff(inherited.control); error != 0) {
+      std::cerr << "Error: cannot confirm the hot restart: "
+                << std::strerror(error) << "\n";
+    }
+    inherited.control = SafeFD();
+  }
 
-      // Si get empieza por "/bin"
-      if (output_filename.starts_with("/bin")) {
-        std::cout << "Por hacer...\n";
-      } else {
-        auto file_content = read_all(base_dir + output_filename);
-
-        if (!file_content) {
-          switch (file_content.error()) {
-            case EACCES:
-              std::cerr << "403 Forbidden\n";
-              break;
-            case ENOENT:
-              std::cerr << "404 Not Found\n";
-              break;
-            default:
-              std::cerr << "Error: unknown error\n";
-              break;
-          }
-          return EXIT_FAILURE;
-        }
-
-        SafeMap safe_map = std::move(file_content.value());
-        size_t size = safe_map.get().size();
-        std::string header = std::format("Content-Length: {}\r\n", size);
-        std::string_view body = safe_map.get();
-
-        if (send_response(client.value(), header, body) != 0) {
-          switch (send_response(client.value(), header, body)) {
-            case ECONNRESET:
-              std::cerr << "Error: connection reset by peer\n";
-              break;
-            default:
-              std::cerr << "Error: unknown error\n";
-              break;
-          }
-          return EXIT_FAILURE;
-        }
+  // Lado del proceso viejo en un reinicio en caliente: entrega los sockets,
+  // sigue aceptando hasta que el nuevo confirma y sale cuando no le quedan
+  // conexiones
+  SafeFD restart_socket;
+  uint64_t restart_watch = 0;
+  SafeFD handoff_peer;  // El nuevo, hasta que confirma
+  uint64_t handoff_watch = 0;
+  bool draining = false;
+  std::function<bool()> listen_for_restart;
+  auto on_handoff_reply = [&](uint32_t) {
+    int error = receive_ready(handoff_peer);
+    if (error == EAGAIN) {
+      return;
+    }
+    loop.unwatch(handoff_watch);
+    handoff_watch = 0;
+    handoff_peer = SafeFD();
+    if (error != 0) {
+      std::cerr << "Error: the new server did not take over ("
+                << std::strerror(error) << "), still serving\n";
+      listen_for_restart();
+      return;
+    }
+    for (uint64_t id : listener_watches) {
+      loop.unwatch(id);
+    }
+    listener_watches.clear();
+    listeners.clear();
+    draining = true;
+    std::cerr << "Hot restart: taken over, draining " << connections.size()
+              << " connections\n";
+    loop.add_timer(kDrainTimeoutNs, [&] {
+      std::vector<Connection*> remaining;
+      for (auto& item : connections) {
+        remaining.push_back(item.first);
+      }
+      for (Connection* connection : remaining) {
+        connection->close();
       }
+    });
+  };
+  auto on_restart = [&](uint32_t) {
+    SafeFD peer(accept4(restart_socket.get(), nullptr, nullptr, SOCK_CLOEXEC));
+    if (!peer.is_valid()) {
+      return;
+    }
+    // Se cierra antes de entregar para que el nuevo pueda crear el suyo
+    loop.unwatch(restart_watch);
+    restart_socket = SafeFD();
+    std::vector<std::pair<std::string, int>> handed;
+    for (size_t i = 0; i < listeners.size(); ++i) {
+      handed.emplace_back(addresses[i].to_string(), listeners[i].get());
+    }
+    int error = send_handoff(peer, handed, bin_workers_cache_keys());
+    if (error == 0) {
+      handoff_peer = std::move(peer);
+      handoff_watch =
+          loop.watch(handoff_peer.get(), EPOLLIN, on_handoff_reply);
+      error = handoff_watch != 0 ? 0 : EIO;
+    }
+    if (error != 0) {
+      std::cerr << "Error: hot restart handoff failed: "
+                << std::strerror(error) << "\n";
+      handoff_peer = SafeFD();
+      listen_for_restart();
+      return;
     }
+    std::cerr << "Hot restart: handed off, waiting for the new server\n";
+  };
+  listen_for_restart = [&] {
+    auto socket = open_restart_socket(options.restart_socket);
+    if (!socket) {
+      std::cerr << "Error: cannot open the restart socket "
+                << options.restart_socket << ": "
+                << std::strerror(socket.error()) << "\n";
+      return false;
+    }
+    restart_socket = std::move(socket.value());
+    restart_watch = loop.watch(restart_socket.get(), EPOLLIN, on_restart);
+    return restart_watch != 0;
+  };
+  if (!options.restart_socket.empty() && !listen_for_restart()) {
+    return EXIT_FAILURE;
+  }
 
-    // Cerrar la conexión
-    close(client.value().get());
-    print_verbose("Conexión cerrada");
+  while (!draining || !connections.empty()) {
+    int error = loop.run_once();
+    closed.clear();
+    if (error == EINTR) {
+      // Interrumpido por una señal (SIGUSR1 pide volcar la traza)
+      std::string dump = trace_dump_if_requested();
+      if (!dump.empty()) {
+        std::cerr << "Trace written to " << dump << "\n";
+      }
+    } else if (error != 0) {
+      std::cerr << "Error: event loop failed: " << std::strerror(error)
+                << "\n";
+      return EXIT_FAILURE;
+    }
   }
 
+  closed.clear();
+  if (save_history) {
+    save_history();
+  }
+  bin_workers_shutdown();
   return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
@@ -0,0 +1,29 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: docserver.h
+ * Referencias:
+ *     Enunciado de la práctica
+ */
+
+#ifndef DOCSERVER_H
+#define DOCSERVER_H
+
+#include <cstdint>
+#include <string>
+
+// Variables globales (definidas en docserver.cc)
+extern bool flag_v;
+extern uint16_t port;
+extern bool flag_base_dir;
+extern std::string base_dir;
+
+void print_verbose(std::string mensaje);
+
+#endif  // DOCSERVER_H
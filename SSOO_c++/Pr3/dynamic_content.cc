@@ -0,0 +1,605 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: dynamic_content.cc
+ * Referencias:
+ *     Enunciado de la práctica
+ */
+
+#include "dynamic_content.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+// La cabecera de glibc 2.36 no trae __BEGIN_DECLS
+extern "C" {
+#include <sys/pidfd.h>
+}
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+
+#include "docserver.h"
+#include "metrics.h"
+#include "tracing.h"
+
+std::expected<bin_request, int> parse_bin_request(const std::string& path) {
+  constexpr std::string_view kPrefix = "/bin/";
+  if (!path.starts_with(kPrefix)) {
+    return std::unexpected(EINVAL);
+  }
+  bin_request request;
+  request.request_path = path;
+  size_t query = path.find('?');
+  request.program = path.substr(kPrefix.size(), query - kPrefix.size());
+  if (query != std::string::npos) {
+    request.query = path.substr(query + 1);
+  }
+  // El programa tiene que estar directamente en base_dir/bin
+  if (request.program.empty() ||
+      request.program.find('/') != std::string::npos ||
+      request.program == "." || request.program == "..") {
+    return std::unexpected(EINVAL);
+  }
+  return request;
+}
+
+std::vector<std::string> bin_request_variables(const bin_request& request) {
+  return {
+      "REQUEST_PATH=" + request.request_path,
+      "QUERY_STRING=" + request.query,
+      "SERVER_BASEDIR=" + base_dir,
+      "REMOTE_IP=" + request.remote_ip,
+      std::format("REMOTE_PORT={}", request.remote_port),
+  };
+}
+
+exec_environment bin_request_environment(const bin_request& request) {
+  return inherited_environment(bin_request_variables(request),
+                               base_dir + "/bin");
+}
+
+namespace {
+
+uint64_t default_timeout_ns = 30'000'000'000;
+std::unordered_map<std::string, uint64_t> program_timeouts;
+
+}  // namespace
+
+void bin_set_timeout(uint64_t timeout_ns) { default_timeout_ns = timeout_ns; }
+
+void bin_set_program_timeout(const std::string& program, uint64_t timeout_ns) {
+  program_timeouts[program] = timeout_ns;
+}
+
+uint64_t bin_timeout_ns(const std::string& program) {
+  auto it = program_timeouts.find(program);
+  return it != program_timeouts.end() ? it->second : default_timeout_ns;
+}
+
+void record_expired_child(const rusage& usage, bool needed_sigkill) {
+  auto microseconds = [](const timeval& time) {
+    return static_cast<uint64_t>(time.tv_sec) * 1'000'000 +
+           static_cast<uint64_t>(time.tv_usec);
+  };
+  metrics_count(metric_counter::bin_deadline_kills);
+  if (needed_sigkill) {
+    metrics_count(metric_counter::bin_deadline_sigkills);
+  }
+  metrics_count(metric_counter::bin_killed_user_cpu_us,
+                microseconds(usage.ru_utime));
+  metrics_count(metric_counter::bin_killed_system_cpu_us,
+                microseconds(usage.ru_stime));
+}
+
+int execute_error_status(const execute_program_error& error) {
+  switch (error.codigo_error) {
+    case 0:
+      return 500;  // Se ejecutó pero terminó mal
+    case ENOENT:
+      return 404;
+    case EACCES:
+      return 403;
+    case EAGAIN:
+      return 503;  // Sin workers libres o esperando para relanzarlos
+    case ETIMEDOUT:
+      return 504;  // Se pasó de plazo
+    default:
+      return 500;
+  }
+}
+
+namespace {
+
+// Lo que se lee antes de decidir entre Content-Length y chunked
+constexpr size_t kFirstBufferSize = 64 * 1024;
+// Margen para que un programa rápido termine y su respuesta lleve
+// Content-Length; es lo más que se retrasa el primer byte de uno lento
+constexpr uint64_t kFirstBufferWaitNs = 5'000'000;
+
+/**
+ * @brief Hijos que ya no atiende nadie (el cliente se fue o se pasaron de
+ * plazo) y quedan por recoger. Se recogen cuando su pidfd avisa, sin
+ * bloquear el bucle con waitpid().
+ */
+struct orphan {
+  SafeFD pidfd;
+  uint64_t kill_timer = 0;  // SIGKILL pendiente tras el SIGTERM
+  bool killed = false;      // Hizo falta el SIGKILL
+  bool expired = false;     // Se pasó de plazo: su consumo va a las métricas
+};
+std::unordered_map<uint64_t, orphan> orphans;
+
+/**
+ * @brief Recoge al hijo de un pidfd y su consumo de recursos. El waitid()
+ * de glibc no devuelve el rusage, la llamada al sistema sí.
+ */
+void wait_pidfd(int pidfd, rusage& usage) {
+  siginfo_t info{};
+  syscall(SYS_waitid, P_PIDFD, pidfd, &info, WEXITED, &usage);
+}
+
+/**
+ * @brief Las señales van a todo el grupo del hijo (pid), para no dejar vivo
+ * lo que haya lanzado. Mientras no se recoja, el hijo sigue como zombi y su
+ * pid no puede reutilizarse como grupo de otros.
+ * @param grace_ns 0 para matarlo ya con SIGKILL (el cliente se fue); si no,
+ *        se le pide terminar con SIGTERM y se le mata si sigue vivo pasado
+ *        ese tiempo.
+ */
+void reap_later(EventLoop& loop, SafeFD pidfd, pid_t pid,
+                uint64_t grace_ns = 0) {
+  int fd = pidfd.get();
+  auto id = std::make_shared<uint64_t>(0);
+  *id = loop.watch(fd, EPOLLIN, [&loop, fd, pid, id](uint32_t) {
+    // Los que quedan del grupo (ignoraron el SIGTERM) se van con él
+    kill(-pid, SIGKILL);
+    rusage usage{};
+    wait_pidfd(fd, usage);
+    loop.unwatch(*id);
+    auto it = orphans.find(*id);
+    if (it == orphans.end()) {
+      return;
+    }
+    if (it->second.kill_timer != 0) {
+      loop.cancel_timer(it->second.kill_timer);
+    }
+    if (it->second.expired) {
+      record_expired_child(usage, it->second.killed);
+    }
+    orphans.erase(it);
+  });
+  if (*id == 0) {
+    // Sin poder vigilarlo se recoge aquí, esperando lo que haga falta
+    kill(-pid, SIGKILL);
+    rusage usage{};
+    wait_pidfd(fd, usage);
+    if (grace_ns != 0) {
+      record_expired_child(usage, true);
+    }
+    return;
+  }
+  orphan& o = orphans[*id];
+  o.pidfd = std::move(pidfd);
+  if (grace_ns == 0) {
+    kill(-pid, SIGKILL);
+    return;
+  }
+  o.expired = true;
+  kill(-pid, SIGTERM);
+  o.kill_timer = loop.add_timer(grace_ns, [pid, id] {
+    auto it = orphans.find(*id);
+    if (it != orphans.end()) {
+      it->second.kill_timer = 0;
+      it->second.killed = true;
+      kill(-pid, SIGKILL);
+    }
+  });
+}
+
+struct launched_program {
+  SafeFD output;  // Extremo de lectura, no bloqueante
+  SafeFD pidfd;
+  pid_t pid;
+};
+
+/**
+ * @brief Abre la tubería de salida y lanza el programa con su extremo de
+ * escritura como stdout.
+ */
+std::expected<launched_program, execute_program_error> launch(
+    const std::string& program_path, const exec_environment& environment) {
+  int pipe_fd[2];
+  if (pipe2(pipe_fd, O_CLOEXEC) == -1) {
+    return std::unexpected(execute_program_error{0, errno});
+  }
+  SafeFD read_fd(pipe_fd[0]);
+  SafeFD write_fd(pipe_fd[1]);
+  // Solo el extremo del servidor: el programa escribe de forma bloqueante
+  fcntl(read_fd.get(), F_SETFL, O_NONBLOCK);
+
+  // posix_spawn en vez de fork: no copia las tablas de páginas del servidor
+  auto pid = spawn_program(program_path, environment, {-1, write_fd.get()});
+  if (!pid) {
+    return std::unexpected(execute_program_error{0, pid.error()});
+  }
+  SafeFD pidfd(pidfd_open(*pid, 0));
+  if (!pidfd.is_valid()) {
+    int error = errno;
+    kill(-*pid, SIGKILL);
+    waitpid(*pid, nullptr, 0);
+    return std::unexpected(execute_program_error{0, error});
+  }
+  // El extremo de escritura se cierra al salir: EOF cuando el hijo termine
+  return launched_program{std::move(read_fd), std::move(pidfd), *pid};
+}
+
+/**
+ * @brief Recoge al hijo de un pidfd si ya terminó.
+ * @return false si sigue vivo; si no, error queda con su estado de salida
+ *         (codigo_salida 0 si terminó bien).
+ */
+bool reap(const SafeFD& pidfd, execute_program_error& error) {
+  siginfo_t info{};
+  if (waitid(P_PIDFD, static_cast<id_t>(pidfd.get()), &info,
+             WEXITED | WNOHANG) < 0 ||
+      info.si_pid == 0) {
+    return false;
+  }
+  if (info.si_code != CLD_EXITED || info.si_status != 0) {
+    int exit_code =
+        info.si_code == CLD_EXITED ? info.si_status : 128 + info.si_status;
+    error = execute_program_error{exit_code, 0};
+  }
+  return true;
+}
+
+}  // namespace
+
+BinProcess::BinProcess(Connection& connection, std::string program_path,
+                       std::function<void()> on_done)
+    : connection_(connection),
+      program_path_(std::move(program_path)),
+      on_done_(std::move(on_done)) {}
+
+BinProcess::~BinProcess() { abort(); }
+
+std::expected<void, execute_program_error> BinProcess::start(
+    const exec_environment& environment) {
+  auto launched = launch(program_path_, environment);
+  if (!launched) {
+    return std::unexpected(launched.error());
+  }
+  output_fd_ = std::move(launched->output);
+  pidfd_ = std::move(launched->pidfd);
+  pid_ = launched->pid;
+
+  EventLoop& loop = connection_.loop();
+  output_watch_ = loop.watch(output_fd_.get(), EPOLLIN,
+                             [this](uint32_t) { on_output(); });
+  exit_watch_ =
+      loop.watch(pidfd_.get(), EPOLLIN, [this](uint32_t) { on_exit(); });
+  return {};
+}
+
+void BinProcess::on_output() {
+  TraceRequestScope scope(connection_.trace_id());
+  if (phase_ == phase::first_buffer) {
+    // Primer trozo: se recoge lo que haya; tras los primeros datos se da
+    // kFirstBufferWaitNs para terminar antes de pasar a chunked
+    bool had_data = !first_.empty();
+    while (first_.size() < kFirstBufferSize) {
+      char buffer[16384];
+      size_t want = std::min(sizeof(buffer), kFirstBufferSize - first_.size());
+      ssize_t bytes_read = read(output_fd_.get(), buffer, want);
+      if (bytes_read < 0 && errno == EINTR) continue;
+      if (bytes_read < 0) break;  // EAGAIN: no hay más por ahora
+      if (bytes_read == 0) {
+        eof_ = true;
+        break;
+      }
+      first_.append(buffer, static_cast<size_t>(bytes_read));
+    }
+    if (eof_) {
+      connection_.loop().unwatch(output_watch_);
+      output_watch_ = 0;
+      print_verbose("Read: Salida de \"" + program_path_ + "\" leída");
+      maybe_finish();
+    } else if (first_.size() >= kFirstBufferSize) {
+      start_chunked();
+    } else if (!had_data && !first_.empty()) {
+      first_timer_ = connection_.loop().add_timer(kFirstBufferWaitNs, [this] {
+        first_timer_ = 0;
+        TraceRequestScope timer_scope(connection_.trace_id());
+        start_chunked();
+      });
+    }
+    return;
+  }
+
+  if (phase_ != phase::chunked) {
+    return;
+  }
+  if (!connection_.drained()) {
+    connection_.loop().modify(output_watch_, 0);
+    return;
+  }
+  int available = 0;
+  if (ioctl(output_fd_.get(), FIONREAD, &available) < 0 || available == 0) {
+    // EPOLLHUP sin datos: el programa cerró su salida
+    eof_ = true;
+    connection_.loop().unwatch(output_watch_);
+    output_watch_ = 0;
+    maybe_finish();
+    return;
+  }
+  auto length = static_cast<size_t>(available);
+  connection_.count_body_bytes(length);
+  connection_.splice_from(output_fd_.get(), length,
+                          std::format("\r\n{:x}\r\n", length));
+  // Mientras el cliente no se lleve este trozo no se lee más de la tubería;
+  // on_drained() vuelve a vigilarla
+  if (!connection_.closed() && !connection_.drained()) {
+    connection_.loop().modify(output_watch_, 0);
+  }
+}
+
+void BinProcess::start_chunked() {
+  if (phase_ != phase::first_buffer || eof_) {
+    return;
+  }
+  if (first_timer_ != 0) {
+    connection_.loop().cancel_timer(first_timer_);
+    first_timer_ = 0;
+  }
+  phase_ = phase::chunked;
+  print_verbose("Send: Salida de \"" + program_path_ + "\" en chunks");
+  connection_.loop().modify(output_watch_, 0);
+  connection_.set_drained_callback([this] { on_drained(); });
+  connection_.begin_response(200);
+  connection_.count_body_bytes(first_.size());
+  connection_.write(
+      std::format("Transfer-Encoding: chunked\r\n\r\n{:x}\r\n", first_.size()) +
+      first_);
+  first_.clear();
+}
+
+void BinProcess::on_drained() {
+  if (phase_ != phase::chunked) {
+    return;
+  }
+  if (output_watch_ != 0) {
+    connection_.loop().modify(output_watch_, EPOLLIN);
+  }
+  maybe_finish();
+}
+
+void BinProcess::on_exit() {
+  TraceRequestScope scope(connection_.trace_id());
+  if (!reap(pidfd_, exit_error_)) {
+    return;
+  }
+  connection_.loop().unwatch(exit_watch_);
+  exit_watch_ = 0;
+  exited_ = true;
+  failed_ = exit_error_.codigo_salida != 0;
+  maybe_finish();
+}
+
+void BinProcess::maybe_finish() {
+  if (!eof_ || !exited_) {
+    return;
+  }
+  if (phase_ == phase::first_buffer) {
+    if (first_timer_ != 0) {
+      connection_.loop().cancel_timer(first_timer_);
+      first_timer_ = 0;
+    }
+    phase_ = phase::done;
+    if (failed_) {
+      int status = execute_error_status(exit_error_);
+      connection_.respond(status_line(status));
+      std::cerr << "Error: " << program_path_ << ": " << status_line(status)
+                << "\n";
+    } else {
+      connection_.respond(std::format("Content-Length: {}\r\n", first_.size()),
+                          first_);
+    }
+    finish();
+    return;
+  }
+  if (phase_ == phase::chunked && connection_.drained()) {
+    phase_ = phase::done;
+    if (failed_) {
+      // Sin el chunk final el cliente sabe que la respuesta está incompleta
+      std::cerr << "Error: " << program_path_ << ": response cut short\n";
+      connection_.close();
+    } else {
+      connection_.write("\r\n0\r\n\r\n");
+      connection_.finish();
+    }
+    finish();
+  }
+}
+
+void BinProcess::finish() {
+  if (on_done_) {
+    auto on_done = std::move(on_done_);
+    on_done_ = nullptr;
+    on_done();
+  }
+}
+
+void BinProcess::abort() {
+  EventLoop& loop = connection_.loop();
+  if (output_watch_ != 0) {
+    loop.unwatch(output_watch_);
+    output_watch_ = 0;
+  }
+  if (exit_watch_ != 0) {
+    loop.unwatch(exit_watch_);
+    exit_watch_ = 0;
+  }
+  if (first_timer_ != 0) {
+    loop.cancel_timer(first_timer_);
+    first_timer_ = 0;
+  }
+  if (pidfd_.is_valid() && !exited_) {
+    reap_later(loop, std::move(pidfd_), pid_);
+    exited_ = true;
+  }
+  phase_ = phase::done;
+  finish();
+}
+
+void BinProcess::expire() {
+  if (phase_ == phase::done) {
+    return;
+  }
+  EventLoop& loop = connection_.loop();
+  for (uint64_t* watch : {&output_watch_, &exit_watch_}) {
+    if (*watch != 0) {
+      loop.unwatch(*watch);
+      *watch = 0;
+    }
+  }
+  if (first_timer_ != 0) {
+    loop.cancel_timer(first_timer_);
+    first_timer_ = 0;
+  }
+  if (pidfd_.is_valid() && !exited_) {
+    reap_later(loop, std::move(pidfd_), pid_, kBinKillGraceNs);
+    exited_ = true;
+  }
+  bool started = phase_ == phase::chunked;
+  phase_ = phase::done;
+  if (started) {
+    // Ya no se puede cambiar el estado: sin el chunk final queda incompleta
+    std::cerr << "Error: " << program_path_ << ": deadline exceeded, "
+              << "response cut short\n";
+    connection_.close();
+  } else {
+    std::cerr << "Error: " << program_path_ << ": 504 Gateway Timeout\n";
+    connection_.respond(status_line(504));
+  }
+  finish();
+}
+
+BinCapture::BinCapture(EventLoop& loop, std::string program_path,
+                       size_t max_output, done_callback on_done)
+    : loop_(loop),
+      program_path_(std::move(program_path)),
+      max_output_(max_output),
+      on_done_(std::move(on_done)) {}
+
+BinCapture::~BinCapture() { abort(); }
+
+std::expected<void, execute_program_error> BinCapture::start(
+    const exec_environment& environment) {
+  auto launched = launch(program_path_, environment);
+  if (!launched) {
+    return std::unexpected(launched.error());
+  }
+  output_fd_ = std::move(launched->output);
+  pidfd_ = std::move(launched->pidfd);
+  pid_ = launched->pid;
+  output_watch_ =
+      loop_.watch(output_fd_.get(), EPOLLIN, [this](uint32_t) { on_output(); });
+  exit_watch_ =
+      loop_.watch(pidfd_.get(), EPOLLIN, [this](uint32_t) { on_exit(); });
+  return {};
+}
+
+void BinCapture::on_output() {
+  while (true) {
+    char buffer[65536];
+    ssize_t bytes_read = read(output_fd_.get(), buffer, sizeof(buffer));
+    if (bytes_read < 0 && errno == EINTR) continue;
+    if (bytes_read < 0) return;  // EAGAIN: no hay más por ahora
+    if (bytes_read == 0) {
+      eof_ = true;
+      loop_.unwatch(output_watch_);
+      output_watch_ = 0;
+      maybe_finish();
+      return;
+    }
+    output_.append(buffer, static_cast<size_t>(bytes_read));
+    if (output_.size() > max_output_) {
+      fail(execute_program_error{0, EFBIG});
+      return;
+    }
+  }
+}
+
+void BinCapture::on_exit() {
+  if (!reap(pidfd_, exit_error_)) {
+    return;
+  }
+  loop_.unwatch(exit_watch_);
+  exit_watch_ = 0;
+  exited_ = true;
+  failed_ = exit_error_.codigo_salida != 0;
+  maybe_finish();
+}
+
+void BinCapture::maybe_finish() {
+  if (!eof_ || !exited_) {
+    return;
+  }
+  auto on_done = std::move(on_done_);
+  on_done_ = nullptr;
+  if (failed_) {
+    on_done(std::unexpected(exit_error_));
+  } else {
+    on_done(std::move(output_));
+  }
+}
+
+void BinCapture::fail(execute_program_error error) {
+  auto on_done = std::move(on_done_);
+  abort();
+  on_done(std::unexpected(error));
+}
+
+void BinCapture::abort() {
+  on_done_ = nullptr;
+  if (output_watch_ != 0) {
+    loop_.unwatch(output_watch_);
+    output_watch_ = 0;
+  }
+  if (exit_watch_ != 0) {
+    loop_.unwatch(exit_watch_);
+    exit_watch_ = 0;
+  }
+  if (pidfd_.is_valid() && !exited_) {
+    reap_later(loop_, std::move(pidfd_), pid_);
+    exited_ = true;
+  }
+}
+
+void BinCapture::expire() {
+  auto on_done = std::move(on_done_);
+  SafeFD pidfd = exited_ ? SafeFD() : std::move(pidfd_);
+  exited_ = true;
+  abort();  // Antes de reap_later(): el pidfd no puede vigilarse dos veces
+  if (pidfd.is_valid()) {
+    reap_later(loop_, std::move(pidfd), pid_, kBinKillGraceNs);
+  }
+  if (on_done) {
+    on_done(std::unexpected(execute_program_error{0, ETIMEDOUT}));
+  }
+}
@@ -0,0 +1,225 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: dynamic_content.h
+ * Referencias:
+ *     Enunciado de la práctica
+ */
+
+#ifndef DYNAMIC_CONTENT_H
+#define DYNAMIC_CONTENT_H
+
+#include <sys/resource.h>
+#include <sys/types.h>
+
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "connection.h"
+#include "safe_fd.h"
+#include "spawn.h"
+
+/**
+ * @brief Estructura que representa un error al ejecutar un programa.
+ * codigo_error es el errno si no se pudo lanzar (0 si se lanzó) y
+ * codigo_salida el estado de salida si terminó mal.
+ */
+struct execute_program_error {
+  int codigo_salida;
+  int codigo_error;
+};
+
+/**
+ * @brief Petición a un programa de /bin: "/bin/<programa>[?<consulta>]".
+ */
+struct bin_request {
+  std::string program;  // Nombre dentro de base_dir/bin
+  std::string query;
+  std::string request_path;
+  std::string remote_ip;
+  uint16_t remote_port = 0;
+};
+
+/**
+ * @brief Separa el nombre del programa y la consulta de una ruta /bin/...
+ * @return La petición, o EINVAL si la ruta no nombra un programa.
+ */
+std::expected<bin_request, int> parse_bin_request(const std::string& path);
+
+/**
+ * @brief Variables "CLAVE=valor" que describen la petición al programa.
+ */
+std::vector<std::string> bin_request_variables(const bin_request& request);
+
+/**
+ * @brief Entorno de un programa lanzado por petición: el del servidor más
+ * bin_request_variables(), con base_dir/bin como directorio de trabajo.
+ */
+exec_environment bin_request_environment(const bin_request& request);
+
+/**
+ * @brief Tiempo que se da a un programa que se pasó de plazo entre el
+ * SIGTERM y el SIGKILL.
+ */
+constexpr uint64_t kBinKillGraceNs = 2'000'000'000;
+
+/**
+ * @brief Plazo de las peticiones de /bin, contado desde que se aceptó la
+ * conexión: uno general y, si se indica, uno propio de un programa.
+ */
+void bin_set_timeout(uint64_t timeout_ns);
+void bin_set_program_timeout(const std::string& program, uint64_t timeout_ns);
+uint64_t bin_timeout_ns(const std::string& program);
+
+/**
+ * @brief Anota en las métricas un hijo terminado por pasarse de plazo y lo
+ * que consumió.
+ */
+void record_expired_child(const rusage& usage, bool needed_sigkill);
+
+/**
+ * @brief Código de estado HTTP para un error de ejecución.
+ */
+int execute_error_status(const execute_program_error& error);
+
+/**
+ * @brief Programa de /bin lanzado para una petición y atendido desde el
+ * bucle de eventos: su salida (tubería) y su final (pidfd) son eventos más.
+ *
+ * Si el programa termina antes de llenar el primer buffer la respuesta
+ * lleva Content-Length; si no, se envía con Transfer-Encoding: chunked,
+ * pasando cada trozo de la tubería al socket con splice(). Mientras el
+ * cliente no lee, no se vacía la tubería y el programa se bloquea al
+ * escribir: la contrapresión llega hasta él.
+ */
+class BinProcess {
+ public:
+  /**
+   * @param on_done Se llama una vez, cuando la respuesta está entregada (o
+   *        abortada) y el hijo recogido.
+   */
+  BinProcess(Connection& connection, std::string program_path,
+             std::function<void()> on_done);
+  ~BinProcess();
+
+  BinProcess(const BinProcess&) = delete;
+  BinProcess& operator=(const BinProcess&) = delete;
+
+  /**
+   * @brief Lanza el programa.
+   * @return El error si no se pudo lanzar (no se ha enviado nada).
+   */
+  std::expected<void, execute_program_error> start(
+      const exec_environment& environment);
+
+  /**
+   * @brief El cliente se fue: se mata al hijo y se recoge sin esperar.
+   */
+  void abort();
+
+  /**
+   * @brief Se acabó el plazo: se termina al hijo (SIGTERM y, pasado
+   * kBinKillGraceNs, SIGKILL) y el cliente recibe un 504, o la respuesta
+   * se corta si ya había empezado.
+   */
+  void expire();
+
+ private:
+  enum class phase { first_buffer, chunked, done };
+
+  void on_output();
+  void on_exit();
+  void start_chunked();
+  void on_drained();
+  void maybe_finish();
+  void finish();
+
+  Connection& connection_;
+  std::string program_path_;
+  std::function<void()> on_done_;
+  phase phase_ = phase::first_buffer;
+
+  SafeFD output_fd_;
+  SafeFD pidfd_;
+  pid_t pid_ = -1;  // También el de su grupo de procesos
+  uint64_t output_watch_ = 0;
+  uint64_t exit_watch_ = 0;
+  uint64_t first_timer_ = 0;
+
+  std::string first_;
+  bool eof_ = false;
+  bool exited_ = false;
+  execute_program_error exit_error_{0, 0};
+  bool failed_ = false;
+};
+
+/**
+ * @brief Programa de /bin lanzado sin conexión: se recoge toda su salida y
+ * se entrega al terminar (para la caché de salidas, por ejemplo).
+ */
+class BinCapture {
+ public:
+  using done_callback =
+      std::function<void(std::expected<std::string, execute_program_error>)>;
+
+  /**
+   * @param max_output Si la salida lo supera se mata al programa y se
+   *        entrega un error (codigo_error EFBIG).
+   * @param on_done Se llama una vez con la salida o el error; puede
+   *        destruir este objeto.
+   */
+  BinCapture(EventLoop& loop, std::string program_path, size_t max_output,
+             done_callback on_done);
+  ~BinCapture();
+
+  BinCapture(const BinCapture&) = delete;
+  BinCapture& operator=(const BinCapture&) = delete;
+
+  std::expected<void, execute_program_error> start(
+      const exec_environment& environment);
+
+  /**
+   * @brief Mata y recoge al programa sin llamar a on_done.
+   */
+  void abort();
+
+  /**
+   * @brief Se acabó el plazo: se termina al programa como en
+   * BinProcess::expire() y on_done recibe ETIMEDOUT.
+   */
+  void expire();
+
+ private:
+  void on_output();
+  void on_exit();
+  void maybe_finish();
+  void fail(execute_program_error error);
+
+  EventLoop& loop_;
+  std::string program_path_;
+  size_t max_output_;
+  done_callback on_done_;
+
+  SafeFD output_fd_;
+  SafeFD pidfd_;
+  pid_t pid_ = -1;  // También el de su grupo de procesos
+  uint64_t output_watch_ = 0;
+  uint64_t exit_watch_ = 0;
+
+  std::string output_;
+  bool eof_ = false;
+  bool exited_ = false;
+  bool failed_ = false;
+  execute_program_error exit_error_{0, 0};
+};
+
+#endif  // DYNAMIC_CONTENT_H
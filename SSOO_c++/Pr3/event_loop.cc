@@ -0,0 +1,93 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: event_loop.cc
+ * Referencias:
+ *     man 7 epoll
+ */
+
+#include "event_loop.h"
+
+#include <array>
+#include <cerrno>
+
+#include "metrics.h"
+
+EventLoop::EventLoop() : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)) {}
+
+uint64_t EventLoop::watch(int fd, uint32_t events, event_callback callback) {
+  uint64_t id = next_id_++;
+  epoll_event event{};
+  event.events = events;
+  event.data.u64 = id;
+  if (epoll_ctl(epoll_fd_.get(), EPOLL_CTL_ADD, fd, &event) < 0) {
+    return 0;
+  }
+  watches_.emplace(
+      id, watch_entry{fd, std::make_shared<event_callback>(std::move(callback))});
+  return id;
+}
+
+void EventLoop::modify(uint64_t id, uint32_t events) {
+  auto it = watches_.find(id);
+  if (it == watches_.end()) {
+    return;
+  }
+  epoll_event event{};
+  event.events = events;
+  event.data.u64 = id;
+  epoll_ctl(epoll_fd_.get(), EPOLL_CTL_MOD, it->second.fd, &event);
+}
+
+void EventLoop::unwatch(uint64_t id) {
+  auto it = watches_.find(id);
+  if (it == watches_.end()) {
+    return;
+  }
+  epoll_ctl(epoll_fd_.get(), EPOLL_CTL_DEL, it->second.fd, nullptr);
+  watches_.erase(it);
+}
+
+uint64_t EventLoop::add_timer(uint64_t delay_ns, timer_callback callback) {
+  return timers_.schedule(delay_ns, std::move(callback));
+}
+
+void EventLoop::cancel_timer(uint64_t id) { timers_.cancel(id); }
+
+void EventLoop::defer(timer_callback callback) {
+  deferred_.push_back(std::move(callback));
+}
+
+int EventLoop::run_once() {
+  std::array<epoll_event, 64> events;
+  int timeout = deferred_.empty() ? timers_.timeout_ms() : 0;
+  int ready = epoll_wait(epoll_fd_.get(), events.data(),
+                         static_cast<int>(events.size()), timeout);
+  if (ready < 0) {
+    return errno;
+  }
+  for (int i = 0; i < ready; ++i) {
+    const epoll_event& event = events[static_cast<size_t>(i)];
+    auto it = watches_.find(event.data.u64);
+    if (it == watches_.end()) {
+      continue;  // Se dejó de vigilar mientras se atendía otro evento
+    }
+    // Copia del puntero: el callback puede quitar su propia vigilancia
+    std::shared_ptr<event_callback> callback = it->second.callback;
+    (*callback)(event.events);
+  }
+  // Lo que se aplace mientras tanto queda para la vuelta siguiente
+  std::vector<timer_callback> deferred;
+  deferred.swap(deferred_);
+  for (auto& callback : deferred) {
+    callback();
+  }
+  timers_.expire();
+  return 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: event_loop.h
+ * Referencias:
+ *     man 7 epoll
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <sys/epoll.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "safe_fd.h"
+#include "timing_wheel.h"
+
+/**
+ * @brief Bucle de eventos de un hilo sobre epoll, con temporizadores (una
+ * TimingWheel, que también decide cuánto espera epoll_wait()).
+ *
+ * Cada descriptor vigilado y cada temporizador se identifican con un número
+ * que no se reutiliza: un evento que llega para un descriptor que ya se dejó
+ * de vigilar (o que se cerró y se volvió a abrir con el mismo número) se
+ * descarta en vez de llegar a quien no toca.
+ */
+class EventLoop {
+ public:
+  using event_callback = std::function<void(uint32_t events)>;
+  using timer_callback = std::function<void()>;
+
+  EventLoop();
+
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  [[nodiscard]] bool is_valid() const noexcept { return epoll_fd_.is_valid(); }
+
+  /**
+   * @brief Vigila un descriptor (EPOLLIN, EPOLLOUT...).
+   * @return Identificador para modify() y unwatch(), o 0 si falló.
+   */
+  uint64_t watch(int fd, uint32_t events, event_callback callback);
+  void modify(uint64_t id, uint32_t events);
+  void unwatch(uint64_t id);
+
+  /**
+   * @brief Llama a callback cuando pasen delay_ns nanosegundos (con 1 ms de
+   * resolución, nunca antes). Armar y cancelar cuestan O(1).
+   * @return Identificador para cancel_timer().
+   */
+  uint64_t add_timer(uint64_t delay_ns, timer_callback callback);
+  void cancel_timer(uint64_t id);
+
+  /**
+   * @brief Llama a callback al acabar de atender los eventos de esta vuelta,
+   * antes de los temporizadores. Mientras quede alguno, la vuelta siguiente
+   * no espera en epoll_wait(): solo recoge lo que ya haya llegado.
+   */
+  void defer(timer_callback callback);
+
+  /**
+   * @brief Espera eventos (como mucho hasta el siguiente temporizador) y
+   * los atiende; después, lo aplazado con defer() y los temporizadores
+   * vencidos.
+   * @return 0, o el errno de epoll_wait (EINTR si llegó una señal).
+   */
+  int run_once();
+
+ private:
+  struct watch_entry {
+    int fd;
+    std::shared_ptr<event_callback> callback;
+  };
+  SafeFD epoll_fd_;
+  uint64_t next_id_ = 1;
+  std::unordered_map<uint64_t, watch_entry> watches_;
+  std::vector<timer_callback> deferred_;
+  TimingWheel timers_;
+};
+
+#endif  // EVENT_LOOP_H
@@ -0,0 +1,449 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: file_cache.cc
+ * Referencias:
+ *     man 2 mmap, man 2 readahead, man 2 stat
+ */
+
+#include "file_cache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+
+#include "docserver.h"
+#include "metrics.h"
+#include "safe_fd.h"
+#include "tracing.h"
+
+namespace {
+
+// Rutas distintas de las que se lleva la cuenta entre dos age_usage()
+constexpr size_t kMaxTracked = 65536;
+
+/**
+ * @brief Lee un número al principio de text y lo quita (con el espacio).
+ */
+bool take_number(std::string_view& text, uint64_t& value) {
+  auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc() || end == text.data() + text.size() ||
+      *end != ' ') {
+    return false;
+  }
+  text.remove_prefix(static_cast<size_t>(end - text.data()) + 1);
+  return true;
+}
+
+}  // namespace
+
+std::expected<SafeMap, int> read_all(const std::string& path, bool populate) {
+  uint64_t resolution_start = now_ns();
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    // Error al abrir el archivo...
+    print_verbose("Error al abrir el archivo");
+    return std::unexpected(errno);
+  }
+  print_verbose("Open: Archivo \"" + path + "\" abierto correctamente");
+
+  off_t length = lseek(fd, 0, SEEK_END);
+  if (length < 0) {
+    // Error al obtener el tamaño del archivo...
+    print_verbose("Error al obtener el tamaño del archivo");
+    close(fd);
+    return std::unexpected(errno);
+  }
+  uint64_t mapping_start = now_ns();
+  metrics_observe(metric_histogram::file_resolution,
+                  mapping_start - resolution_start);
+  trace_record("open", resolution_start, mapping_start);
+
+  void* mem = mmap(NULL, static_cast<size_t>(length), PROT_READ,
+                   MAP_PRIVATE | (populate ? MAP_POPULATE : 0), fd, 0);
+  uint64_t mapping_end = now_ns();
+  metrics_observe(metric_histogram::file_mapping, mapping_end - mapping_start);
+  trace_record("mmap", mapping_start, mapping_end);
+  close(fd);
+  print_verbose("Close: Archivo \"" + path + "\" cerrado correctamente");
+  if (mem == MAP_FAILED) {
+    // Error al mapear el archivo...
+    print_verbose("Mmap: error al mapear el archivo \"" + path +
+                  "\" (errno: " + std::to_string(errno) + ")");
+    return std::unexpected(errno);
+  }
+  print_verbose("Mmap: archivo \"" + path + "\" mapeado correctamente");
+
+  return SafeMap(
+      std::string_view(static_cast<char*>(mem), static_cast<size_t>(length)));
+}
+
+FileCache::FileCache(size_t max_bytes)
+    : max_bytes_(max_bytes),
+      metrics_id_(metrics_register_cache("static_file")) {}
+
+bool FileCache::same_file(const entry& e, const struct stat& info) {
+  return e.device == info.st_dev && e.inode == info.st_ino &&
+         e.size == info.st_size && e.ctime.tv_sec == info.st_ctim.tv_sec &&
+         e.ctime.tv_nsec == info.st_ctim.tv_nsec;
+}
+
+std::expected<std::shared_ptr<const SafeMap>, int> FileCache::get(
+    const std::string& path, struct stat* info_out) {
+  uint64_t resolution_start = now_ns();
+  struct stat info {};
+  if (stat((base_dir + path).c_str(), &info) < 0) {
+    print_verbose("Error al abrir el archivo");
+    return std::unexpected(errno);
+  }
+  if (info_out != nullptr) {
+    *info_out = info;
+  }
+  auto it = entries_.find(path);
+  bool unchanged = it != entries_.end() && same_file(it->second, info);
+  if (unchanged && source_unchanged(path, it->second)) {
+    uint64_t resolution_end = now_ns();
+    metrics_observe(metric_histogram::file_resolution,
+                    resolution_end - resolution_start);
+    trace_record("stat", resolution_start, resolution_end);
+    metrics_cache_lookup(metrics_id_, true);
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    note_use(path, it->second.map->get().size());
+    return it->second.map;
+  }
+  if (it != entries_.end()) {
+    const entry& e = it->second;
+    if (e.shared && (unchanged || contents_.at(e.digest).source == path)) {
+      // Cambió el archivo del mapeo compartido: ninguna de las rutas que lo
+      // usan puede seguir con él
+      drop_content(e.digest);
+    } else {
+      remove(it);  // El archivo ha cambiado
+    }
+  }
+  metrics_cache_lookup(metrics_id_, false);
+  auto map = load(path, info, false);
+  if (map) {
+    note_use(path, (*map)->get().size());
+  }
+  return map;
+}
+
+void FileCache::prefetch(const std::vector<std::string>& paths) {
+  for (const auto& path : paths) {
+    if (entries_.contains(path)) {
+      continue;
+    }
+    SafeFD fd(open((base_dir + path).c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat info {};
+    if (fd.is_valid() && fstat(fd.get(), &info) == 0 &&
+        S_ISREG(info.st_mode) && info.st_size > 0) {
+      readahead(fd.get(), 0, static_cast<size_t>(info.st_size));
+    }
+  }
+}
+
+void FileCache::forget(const std::string& path) {
+  auto it = entries_.find(path);
+  if (it != entries_.end()) {
+    remove(it);
+  }
+}
+
+void FileCache::deduplicate(const std::string& path,
+                            const std::shared_ptr<const SafeMap>& content,
+                            const hash128& digest) {
+  auto it = entries_.find(path);
+  std::string_view data = content->get();
+  if (it == entries_.end() || it->second.map != content ||
+      it->second.shared || data.empty()) {
+    return;  // Ya no es el contenido que se resumió, o ya se comparte
+  }
+  entry& e = it->second;
+  auto found = contents_.find(digest);
+  if (found != contents_.end() && !content_unchanged(found->second)) {
+    drop_content(digest);
+    found = contents_.end();
+  }
+  if (found != contents_.end()) {
+    shared_content& shared = found->second;
+    std::string_view existing = shared.map->get();
+    if (existing.size() != data.size() ||
+        std::memcmp(existing.data(), data.data(), data.size()) != 0) {
+      return;  // Colisión: cada uno sigue con su mapeo
+    }
+    e.map = shared.map;
+    e.shared = true;
+    e.digest = digest;
+    shared.paths.insert(path);
+    bytes_ -= data.size();
+    metrics_gauge_add(metric_gauge::file_cache_bytes,
+                      -static_cast<int64_t>(data.size()));
+    metrics_count(metric_counter::dedup_files);
+    // Sus páginas ya no se leen: el núcleo las puede soltar
+    SafeFD fd(open((base_dir + path).c_str(), O_RDONLY | O_CLOEXEC));
+    if (fd.is_valid()) {
+      posix_fadvise(fd.get(), 0, 0, POSIX_FADV_DONTNEED);
+    }
+    print_verbose("Dedup: \"" + path + "\" comparte el mapeo de \"" +
+                  shared.source + "\"");
+    return;
+  }
+  // El primero con este contenido: su mapeo es el que compartirán los demás
+  shared_content& shared = contents_[digest];
+  shared.map = content;
+  shared.source = path;
+  shared.device = e.device;
+  shared.inode = e.inode;
+  shared.size = e.size;
+  shared.ctime = e.ctime;
+  shared.paths.insert(path);
+  e.shared = true;
+  e.digest = digest;
+}
+
+bool FileCache::content_unchanged(const shared_content& shared) {
+  struct stat info {};
+  return stat((base_dir + shared.source).c_str(), &info) == 0 &&
+         shared.device == info.st_dev && shared.inode == info.st_ino &&
+         shared.size == info.st_size &&
+         shared.ctime.tv_sec == info.st_ctim.tv_sec &&
+         shared.ctime.tv_nsec == info.st_ctim.tv_nsec;
+}
+
+bool FileCache::source_unchanged(const std::string& path,
+                                 const entry& e) const {
+  if (!e.shared) {
+    return true;
+  }
+  const shared_content& shared = contents_.at(e.digest);
+  // Si es el suyo ya lo ha comprobado su propio stat()
+  return shared.source == path || content_unchanged(shared);
+}
+
+void FileCache::drop_content(const hash128& digest) {
+  std::unordered_set<std::string> paths = contents_.at(digest).paths;
+  for (const auto& path : paths) {
+    remove(entries_.find(path));
+  }
+}
+
+std::expected<std::shared_ptr<const SafeMap>, int> FileCache::load(
+    const std::string& path, const struct stat& info, bool populate) {
+  auto content = read_all(base_dir + path, populate);
+  if (!content) {
+    return std::unexpected(content.error());
+  }
+  auto map = std::make_shared<const SafeMap>(std::move(content.value()));
+  size_t size = map->get().size();
+  // Si cambió entre el stat() y el open() no se guarda: no se sabría de cuál
+  // de las dos versiones es el contenido
+  if (!S_ISREG(info.st_mode) || size > max_bytes_ / 4 ||
+      static_cast<off_t>(size) != info.st_size) {
+    return map;
+  }
+  lru_.push_front(path);
+  entry& e = entries_[path];
+  e.map = map;
+  e.device = info.st_dev;
+  e.inode = info.st_ino;
+  e.size = info.st_size;
+  e.ctime = info.st_ctim;
+  e.lru = lru_.begin();
+  bytes_ += size;
+  metrics_gauge_add(metric_gauge::file_cache_bytes,
+                    static_cast<int64_t>(size));
+  metrics_gauge_add(metric_gauge::file_cache_logical_bytes,
+                    static_cast<int64_t>(size));
+  while (bytes_ > max_bytes_) {
+    remove(entries_.find(lru_.back()));
+  }
+  return map;
+}
+
+void FileCache::remove(std::unordered_map<std::string, entry>::iterator it) {
+  auto size = static_cast<int64_t>(it->second.map->get().size());
+  bool last_user = true;
+  if (it->second.shared) {
+    auto content = contents_.find(it->second.digest);
+    content->second.paths.erase(it->first);
+    last_user = content->second.paths.empty();
+    if (last_user) {
+      contents_.erase(content);
+    }
+  }
+  // El mapeo compartido sigue ocupando mientras lo use otra ruta
+  if (last_user) {
+    bytes_ -= static_cast<size_t>(size);
+    metrics_gauge_add(metric_gauge::file_cache_bytes, -size);
+  }
+  metrics_gauge_add(metric_gauge::file_cache_logical_bytes, -size);
+  lru_.erase(it->second.lru);
+  entries_.erase(it);
+}
+
+void FileCache::note_use(const std::string& path, uint64_t bytes) {
+  auto it = usage_.find(path);
+  if (it == usage_.end()) {
+    if (usage_.size() >= kMaxTracked) {
+      return;  // Hasta que age_usage() olvide las poco pedidas
+    }
+    it = usage_.emplace(path, hot_path{path, 0, 0}).first;
+  }
+  ++it->second.requests;
+  it->second.bytes += bytes;
+}
+
+std::vector<hot_path> FileCache::hottest(size_t count) const {
+  std::vector<hot_path> result;
+  result.reserve(usage_.size());
+  for (const auto& [path, use] : usage_) {
+    result.push_back(use);
+  }
+  auto more_used = [](const hot_path& a, const hot_path& b) {
+    if (a.requests != b.requests) {
+      return a.requests > b.requests;
+    }
+    return a.bytes > b.bytes;
+  };
+  count = std::min(count, result.size());
+  std::partial_sort(result.begin(),
+                    result.begin() + static_cast<std::ptrdiff_t>(count),
+                    result.end(), more_used);
+  result.resize(count);
+  return result;
+}
+
+int FileCache::save_history(const std::string& file, size_t count) {
+  std::string text = "# docserver: <requests> <bytes> <path>\n";
+  for (const auto& hot : hottest(count)) {
+    text += std::to_string(hot.requests) + " " + std::to_string(hot.bytes) +
+            " " + hot.path + "\n";
+  }
+
+  // Se escribe aparte y se renombra: quien lo lea nunca lo ve a medias
+  std::string temporary = file + ".tmp";
+  SafeFD fd(open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                 0644));
+  if (!fd.is_valid()) {
+    return errno;
+  }
+  std::string_view pending = text;
+  while (!pending.empty()) {
+    ssize_t written = write(fd.get(), pending.data(), pending.size());
+    if (written < 0 && errno == EINTR) continue;
+    if (written < 0) {
+      int error = errno;
+      unlink(temporary.c_str());
+      return error;
+    }
+    pending.remove_prefix(static_cast<size_t>(written));
+  }
+  fd = SafeFD();
+  if (rename(temporary.c_str(), file.c_str()) < 0) {
+    int error = errno;
+    unlink(temporary.c_str());
+    return error;
+  }
+  return 0;
+}
+
+void FileCache::age_usage() {
+  for (auto it = usage_.begin(); it != usage_.end();) {
+    it->second.requests /= 2;
+    it->second.bytes /= 2;
+    it = it->second.requests == 0 ? usage_.erase(it) : std::next(it);
+  }
+}
+
+std::expected<std::vector<hot_path>, int> FileCache::load_history(
+    const std::string& file) {
+  std::ifstream in(file);
+  if (!in) {
+    return std::unexpected(errno != 0 ? errno : ENOENT);
+  }
+  std::vector<hot_path> paths;
+  std::string line;
+  while (std::getline(in, line)) {
+    std::string_view text = line;
+    hot_path hot;
+    if (text.empty() || text.front() == '#' ||
+        !take_number(text, hot.requests) || !take_number(text, hot.bytes)) {
+      continue;
+    }
+    // Las mismas rutas que se aceptan en una petición de un archivo
+    if (text.empty() || text.front() != '/' || text.back() == '/' ||
+        text.find_first_of(" \t\r") != std::string_view::npos ||
+        text.starts_with("/bin/")) {
+      continue;
+    }
+    hot.path = text;
+    paths.push_back(std::move(hot));
+  }
+  return paths;
+}
+
+prewarm_report FileCache::prewarm(const std::vector<hot_path>& paths,
+                                   uint64_t budget_ns) {
+  prewarm_report report;
+  uint64_t start = now_ns();
+  uint64_t deadline = start + budget_ns;
+
+  // Primero se piden todas las lecturas: readahead() solo las encola
+  std::vector<const hot_path*> wanted;
+  uint64_t planned = 0;
+  for (const auto& hot : paths) {
+    if (now_ns() >= deadline) {
+      report.out_of_time = true;
+      break;
+    }
+    SafeFD fd(open((base_dir + hot.path).c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat info {};
+    if (!fd.is_valid() || fstat(fd.get(), &info) < 0 ||
+        !S_ISREG(info.st_mode) || info.st_size == 0) {
+      continue;
+    }
+    auto size = static_cast<uint64_t>(info.st_size);
+    if (size > max_bytes_ / 4 || planned + size > max_bytes_) {
+      continue;
+    }
+    readahead(fd.get(), 0, size);
+    planned += size;
+    wanted.push_back(&hot);
+  }
+
+  // Luego se mapean en orden de popularidad mientras quede tiempo
+  for (const hot_path* hot : wanted) {
+    if (now_ns() >= deadline) {
+      report.out_of_time = true;
+      break;
+    }
+    struct stat info {};
+    if (entries_.contains(hot->path) ||
+        stat((base_dir + hot->path).c_str(), &info) < 0) {
+      continue;
+    }
+    auto map = load(hot->path, info, true);
+    if (map && entries_.contains(hot->path)) {
+      ++report.files;
+      report.bytes += (*map)->get().size();
+    }
+  }
+  report.elapsed_ns = now_ns() - start;
+  return report;
+}
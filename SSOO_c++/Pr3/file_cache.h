@@ -0,0 +1,215 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: file_cache.h
+ * Referencias:
+ *     man 2 mmap, man 2 readahead, man 2 stat
+ */
+
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include <sys/stat.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "hash.h"
+#include "safe_map.h"
+
+/**
+ * @brief Lee el contenido de un archivo.
+ * @param path Ruta del archivo.
+ * @param populate Con MAP_POPULATE: las páginas se cargan ya al mapearlo.
+ * @return Contenido del archivo.
+ */
+std::expected<SafeMap, int> read_all(const std::string& path,
+                                     bool populate = false);
+
+/**
+ * @brief Ruta pedida con su uso reciente.
+ */
+struct hot_path {
+  std::string path;  // Como en la petición ("/docs/a.html")
+  uint64_t requests = 0;
+  uint64_t bytes = 0;
+};
+
+/**
+ * @brief Resultado de FileCache::prewarm().
+ */
+struct prewarm_report {
+  size_t files = 0;
+  uint64_t bytes = 0;
+  uint64_t elapsed_ns = 0;
+  bool out_of_time = false;  // Se agotó el plazo antes de acabar la lista
+};
+
+/**
+ * @brief Caché de archivos estáticos mapeados, con expulsión LRU.
+ *
+ * Un acierto cuesta un stat() en vez de open() + mmap() + munmap(): la
+ * entrada vale mientras el archivo tenga el mismo dispositivo, inodo,
+ * tamaño y ctime (que cambia al escribirlo y al cambiar sus permisos). Los
+ * mapeos se comparten entre las respuestas que los están enviando, así que
+ * expulsar uno no lo desmapea hasta que acaba la última.
+ *
+ * Las rutas con el mismo contenido (mismo tamaño y mismo resumen, ver
+ * deduplicate()) comparten un solo mapeo: las copias de un recurso bajo
+ * varias rutas versionadas ocupan memoria y caché de páginas una vez.
+ *
+ * También lleva la cuenta de peticiones y bytes de cada ruta. La lista de
+ * las más usadas se guarda en un archivo de historial, y al arrancar se
+ * cargan de antemano con prewarm().
+ */
+class FileCache {
+ public:
+  /**
+   * @param max_bytes Tamaño total de los archivos guardados (0: ninguno,
+   * solo se lleva la cuenta de uso). Un archivo de más de la cuarta parte
+   * se sirve sin guardarlo.
+   */
+  explicit FileCache(size_t max_bytes);
+
+  FileCache(const FileCache&) = delete;
+  FileCache& operator=(const FileCache&) = delete;
+
+  /**
+   * @brief Contenido de base_dir + path, de la caché o recién mapeado.
+   * @param info Si no es nulo, recibe el stat() del archivo, hecho antes
+   * de mapearlo.
+   * @return El mapeo, o el errno de no poder abrirlo o mapearlo.
+   */
+  std::expected<std::shared_ptr<const SafeMap>, int> get(
+      const std::string& path, struct stat* info = nullptr);
+
+  /**
+   * @brief Pide con readahead() la lectura de los archivos de paths que no
+   * están en la caché. El núcleo las hace a la vez, así que los get() que
+   * vengan después ya encuentran en memoria casi todo.
+   */
+  void prefetch(const std::vector<std::string>& paths);
+
+  /**
+   * @brief Suelta la entrada de path (porque se acaba de reemplazar). No
+   * hace falta para acertar, el stat() ya ve el cambio, pero así el mapeo
+   * viejo no ocupa sitio hasta que lo expulse la LRU.
+   */
+  void forget(const std::string& path);
+
+  /**
+   * @brief Avisa de que content, el contenido de base_dir + path, tiene el
+   * resumen digest. Si en la caché ya hay otro archivo con el mismo tamaño
+   * y resumen, y sus bytes coinciden de verdad (XXH3 no resiste colisiones
+   * buscadas, y con PUT cualquiera podría fabricarlas), la entrada de path
+   * pasa a usar su mapeo y el de path se suelta.
+   */
+  void deduplicate(const std::string& path,
+                   const std::shared_ptr<const SafeMap>& content,
+                   const hash128& digest);
+
+  /**
+   * @brief Cuenta una petición de path servida sin pasar por get() (por
+   * ejemplo desde la caché compartida), para que entre en el historial.
+   */
+  void note_use(const std::string& path, uint64_t bytes);
+
+  /**
+   * @brief Las count rutas más pedidas (a igualdad, las de más bytes).
+   */
+  [[nodiscard]] std::vector<hot_path> hottest(size_t count) const;
+
+  /**
+   * @brief Guarda hottest(count) en file (lo escribe aparte y lo renombra).
+   * @return 0 o el errno del fallo.
+   */
+  int save_history(const std::string& file, size_t count);
+
+  /**
+   * @brief Reduce a la mitad las cuentas, para que pese más lo reciente, y
+   * olvida las rutas que se quedan a 0.
+   */
+  void age_usage();
+
+  /**
+   * @brief Lee un historial de save_history(); las líneas que no se
+   * entienden se ignoran.
+   * @return Las rutas en orden de popularidad, o ENOENT si no hay archivo.
+   */
+  static std::expected<std::vector<hot_path>, int> load_history(
+      const std::string& file);
+
+  /**
+   * @brief Carga las rutas en la caché, en orden, hasta llenarla o agotar
+   * budget_ns. Primero pide con readahead() la lectura de todas las que
+   * caben, que el núcleo hace a la vez; luego las mapea con MAP_POPULATE,
+   * que ya encuentra casi todo en memoria.
+   */
+  prewarm_report prewarm(const std::vector<hot_path>& paths,
+                         uint64_t budget_ns);
+
+ private:
+  struct entry {
+    std::shared_ptr<const SafeMap> map;
+    dev_t device = 0;
+    ino_t inode = 0;
+    off_t size = 0;
+    timespec ctime{};
+    std::list<std::string>::iterator lru;  // Posición en lru_
+    bool shared = false;  // Su contenido está en contents_
+    hash128 digest;       // Si shared
+  };
+
+  /**
+   * @brief Mapeo que comparten las rutas de un mismo contenido. Es el de
+   * source: si ese archivo cambia, el mapeo podría cambiar con él (es
+   * MAP_PRIVATE, pero las páginas que no se han copiado son las del
+   * archivo), así que las rutas que lo usan lo comprueban en cada acierto.
+   */
+  struct shared_content {
+    std::shared_ptr<const SafeMap> map;
+    std::string source;
+    dev_t device = 0;
+    ino_t inode = 0;
+    off_t size = 0;
+    timespec ctime{};
+    std::unordered_set<std::string> paths;  // Entradas que lo usan
+  };
+  struct digest_hash {
+    size_t operator()(const hash128& digest) const noexcept {
+      return static_cast<size_t>(digest.low);
+    }
+  };
+
+  static bool same_file(const entry& e, const struct stat& info);
+  static bool content_unchanged(const shared_content& shared);
+  bool source_unchanged(const std::string& path, const entry& e) const;
+  void drop_content(const hash128& digest);
+  std::expected<std::shared_ptr<const SafeMap>, int> load(
+      const std::string& path, const struct stat& info, bool populate);
+  void remove(std::unordered_map<std::string, entry>::iterator it);
+
+  size_t max_bytes_;
+  size_t bytes_ = 0;
+  size_t metrics_id_;
+  std::unordered_map<std::string, entry> entries_;
+  std::list<std::string> lru_;  // Delante, la usada más recientemente
+  // Por resumen; el tamaño también tiene que coincidir
+  std::unordered_map<hash128, shared_content, digest_hash> contents_;
+  std::unordered_map<std::string, hot_path> usage_;
+};
+
+#endif  // FILE_CACHE_H
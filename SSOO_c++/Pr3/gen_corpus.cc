@@ -0,0 +1,433 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: gen_corpus.cc
+ * Referencias:
+ *     xoshiro256** y splitmix64 (Blackman y Vigna)
+ */
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <numbers>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tools_common.h"
+
+/**
+ * Generador de un base_dir de prueba reproducible.
+ *
+ * Con las mismas opciones y semilla produce los mismos archivos: el
+ * generador de números y las distribuciones están implementados aquí porque
+ * las de <random> cambian de una biblioteca estándar a otra.
+ *
+ * Además de los archivos escribe:
+ *   paths.txt      "<ruta> <peso>" con popularidad Zipf, para loadgen -l
+ *   bin_paths.txt  Los programas de /bin, para loadgen -l
+ *   sizes/<bytes>  Un archivo por tamaño de --size-list, para loadgen -z
+ */
+
+/**
+ * @brief Distribución de tamaños de archivo.
+ */
+struct size_distribution {
+  enum class kind { fixed, zipf, lognormal };
+
+  kind type = kind::lognormal;
+  uint64_t fixed = 4096;
+  double zipf_s = 1.2;       // Exponente de la Zipf acotada
+  double lognormal_mu = 8.5;  // Mediana e^8.5 ~ 4.9 KiB
+  double lognormal_sigma = 1.8;
+  uint64_t min = 64;
+  uint64_t max = 64ull << 20;
+};
+
+/**
+ * @brief Opciones del generador.
+ */
+struct corpus_options {
+  bool flag_h = false;
+  std::string out;
+  uint64_t files = 1000;
+  unsigned depth = 3;
+  unsigned fanout = 8;
+  size_distribution sizes;
+  double popularity_skew = 1.0;  // Exponente Zipf de paths.txt
+  std::vector<uint64_t> size_list = {100,         1ull << 10,  4ull << 10,
+                                     16ull << 10, 64ull << 10, 256ull << 10,
+                                     1ull << 20};
+  bool bin = true;
+  uint64_t seed = 1;
+};
+
+/**
+ * @brief xoshiro256**: rápido y con la misma secuencia en todas partes.
+ */
+class DeterministicRng {
+ public:
+  explicit DeterministicRng(uint64_t seed) {
+    for (auto& word : state_) {
+      seed += 0x9E3779B97F4A7C15ull;  // splitmix64
+      uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      word = z ^ (z >> 31);
+    }
+  }
+
+  uint64_t next() {
+    uint64_t result = rotl(state_[1] * 5, 7) * 9;
+    uint64_t t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = rotl(state_[3], 45);
+    return result;
+  }
+
+  // Uniforme en [0, 1) con 53 bits
+  double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+  uint64_t below(uint64_t bound) { return bound == 0 ? 0 : next() % bound; }
+
+  // Normal estándar por Box-Muller
+  double normal() {
+    double u1 = uniform();
+    double u2 = uniform();
+    if (u1 < 1e-300) u1 = 1e-300;
+    return std::sqrt(-2.0 * std::log(u1)) *
+           std::cos(2.0 * std::numbers::pi * u2);
+  }
+
+ private:
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+  uint64_t state_[4];
+};
+
+/**
+ * @brief Saca un tamaño de la distribución, acotado a [min, max].
+ */
+uint64_t sample_size(const size_distribution& dist, DeterministicRng& rng) {
+  double value = 0;
+  switch (dist.type) {
+    case size_distribution::kind::fixed:
+      return dist.fixed;
+    case size_distribution::kind::lognormal:
+      value = std::exp(dist.lognormal_mu + dist.lognormal_sigma * rng.normal());
+      break;
+    case size_distribution::kind::zipf: {
+      // Zipf continua acotada (Pareto acotada) por inversión de la CDF
+      double a = static_cast<double>(dist.min);
+      double b = static_cast<double>(dist.max);
+      double u = rng.uniform();
+      if (std::abs(dist.zipf_s - 1.0) < 1e-9) {
+        value = a * std::pow(b / a, u);
+      } else {
+        double e = 1.0 - dist.zipf_s;
+        value = std::pow(std::pow(a, e) + u * (std::pow(b, e) - std::pow(a, e)),
+                         1.0 / e);
+      }
+      break;
+    }
+  }
+  auto size = static_cast<uint64_t>(value);
+  return std::clamp(size, dist.min, dist.max);
+}
+
+void Usage(char* argv[]) {
+  std::cout << "Usage: " << argv[0]
+            << " -o <dir> [--files <n>] [--depth <d>] [--fanout <f>]"
+            << " [--sizes fixed:<size> | zipf:<s> | lognormal:<mu>,<sigma>]"
+            << " [--min <size>] [--max <size>] [--skew <alpha>]"
+            << " [--size-list <s1,s2,...>] [--no-bin] [--seed <n>]\n";
+  std::cout << "Options:\n";
+  std::cout << "  -o, --out     Directory to create (the server base_dir)\n";
+  std::cout << "  --files       Number of files (default 1000)\n";
+  std::cout << "  --depth       Maximum directory depth (default 3)\n";
+  std::cout << "  --fanout      Subdirectories per directory (default 8)\n";
+  std::cout << "  --sizes       File size distribution (default"
+               " lognormal:8.5,1.8)\n";
+  std::cout << "  --min, --max  Size bounds (default 64 and 64m)\n";
+  std::cout << "  --skew        Zipf exponent of the request popularity written"
+               " to paths.txt (default 1.0)\n";
+  std::cout << "  --size-list   Files written as sizes/<bytes> for loadgen -z\n";
+  std::cout << "  --no-bin      Do not create the /bin scripts\n";
+  std::cout << "  --seed        Random seed (default 1)\n";
+}
+
+std::expected<size_distribution, std::string> parse_distribution(
+    std::string_view spec, size_distribution dist) {
+  size_t colon = spec.find(':');
+  std::string_view name = spec.substr(0, colon);
+  std::string params =
+      colon == std::string_view::npos ? "" : std::string(spec.substr(colon + 1));
+  try {
+    if (name == "fixed") {
+      auto size = parse_size(params);
+      if (!size) return std::unexpected("fixed needs a size");
+      dist.type = size_distribution::kind::fixed;
+      dist.fixed = *size;
+    } else if (name == "zipf") {
+      dist.type = size_distribution::kind::zipf;
+      if (!params.empty()) dist.zipf_s = std::stod(params);
+    } else if (name == "lognormal") {
+      dist.type = size_distribution::kind::lognormal;
+      if (!params.empty()) {
+        size_t comma = params.find(',');
+        dist.lognormal_mu = std::stod(params.substr(0, comma));
+        if (comma != std::string::npos) {
+          dist.lognormal_sigma = std::stod(params.substr(comma + 1));
+        }
+      }
+    } else {
+      return std::unexpected(std::format("unknown distribution {}", name));
+    }
+  } catch (const std::exception&) {
+    return std::unexpected(std::format("invalid parameters in {}", spec));
+  }
+  return dist;
+}
+
+std::expected<corpus_options, std::string> parse_args(int argc, char* argv[]) {
+  std::vector<std::string_view> args(argv + 1, argv + argc);
+  corpus_options options;
+  for (auto it = args.begin(), end = args.end(); it != end; ++it) {
+    std::string_view option = *it;
+    auto next = [&]() -> std::expected<std::string, std::string> {
+      if (++it == end) {
+        return std::unexpected(std::format("missing value for {}", option));
+      }
+      return std::string(*it);
+    };
+    try {
+      if (option == "-h" || option == "--help") {
+        options.flag_h = true;
+      } else if (option == "--no-bin") {
+        options.bin = false;
+      } else if (option == "-o" || option == "--out") {
+        auto v = next();
+        if (!v) return std::unexpected(v.error());
+        options.out = *v;
+      } else if (option == "--files") {
+        auto v = next();
+        if (!v) return std::unexpected(v.error());
+        options.files = std::stoull(*v);
+      } else if (option == "--depth") {
+        auto v = next();
+        if (!v) return std::unexpected(v.error());
+        options.depth = static_cast<unsigned>(std::stoul(*v));
+      } else if (option == "--fanout") {
+        auto v = next();
+        if (!v) return std::unexpected(v.error());
+        options.fanout = static_cast<unsigned>(std::stoul(*v));
+      } else if (option == "--sizes") {
+        auto v = next();
+        if (!v) return std::unexpected(v.error());
+        auto dist = parse_distribution(*v, options.sizes);
+        if (!dist) return std::unexpected(dist.error());
+        options.sizes = *dist;
+      } else if (option == "--min" || option == "--max") {
+        auto v = next();
+        if (!v) return std::unexpected(v.error());
+        auto size = parse_size(*v);
+        if (!size) return std::unexpected(std::format("invalid size {}", *v));
+        (option == "--min" ? options.sizes.min : options.sizes.max) = *size;
+      } else if (option == "--skew") {
+        auto v = next();
+        if (!v) return std::unexpected(v.error());
+        options.popularity_skew = std::stod(*v);
+      } else if (option == "--size-list") {
+        auto v = next();
+        if (!v) return std::unexpected(v.error());
+        options.size_list.clear();
+        std::string_view list = *v;
+        while (!list.empty()) {
+          size_t comma = list.find(',');
+          auto size = parse_size(list.substr(0, comma));
+          if (!size) return std::unexpected("invalid size list");
+          options.size_list.push_back(*size);
+          list = comma == std::string_view::npos ? std::string_view()
+                                                 : list.substr(comma + 1);
+        }
+      } else if (option == "--seed") {
+        auto v = next();
+        if (!v) return std::unexpected(v.error());
+        options.seed = std::stoull(*v);
+      } else {
+        return std::unexpected(std::format("unknown option {}", option));
+      }
+    } catch (const std::exception&) {
+      return std::unexpected(std::format("invalid value for {}", option));
+    }
+  }
+  if (!options.flag_h && options.out.empty()) {
+    return std::unexpected("missing output directory (-o)");
+  }
+  if (options.sizes.min == 0 || options.sizes.min > options.sizes.max) {
+    return std::unexpected("invalid size bounds");
+  }
+  return options;
+}
+
+/**
+ * @brief Escribe size bytes imprimibles y deterministas en path.
+ */
+bool write_file(const std::string& path, uint64_t size, uint64_t seed) {
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  static constexpr std::string_view kAlphabet =
+      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 \n";
+  DeterministicRng rng(seed);
+  std::vector<char> block(std::min<uint64_t>(size, 1 << 16));
+  bool ok = true;
+  for (uint64_t written = 0; written < size && ok;) {
+    size_t chunk =
+        static_cast<size_t>(std::min<uint64_t>(block.size(), size - written));
+    for (size_t i = 0; i < chunk; i += 8) {
+      uint64_t r = rng.next();
+      for (size_t j = 0; j < 8 && i + j < chunk; ++j) {
+        block[i + j] = kAlphabet[(r >> (8 * j)) % kAlphabet.size()];
+      }
+    }
+    ok = write(fd, block.data(), chunk) == static_cast<ssize_t>(chunk);
+    written += chunk;
+  }
+  close(fd);
+  return ok;
+}
+
+/**
+ * @brief Programas de ejemplo para /bin: rápidos, lentos y de salida grande.
+ */
+struct bin_program {
+  const char* name;
+  const char* script;
+};
+
+constexpr bin_program kBinPrograms[] = {
+    {"hello", "#!/bin/sh\necho \"Hello from docserver /bin\"\n"},
+    {"env", "#!/bin/sh\nenv | sort\n"},
+    {"big", "#!/bin/sh\nhead -c 1048576 /dev/zero | tr '\\0' 'x'\n"},
+    {"slow", "#!/bin/sh\nsleep 0.2\necho done\n"},
+};
+
+int main(int argc, char* argv[]) {
+  auto parsed = parse_args(argc, argv);
+  if (!parsed) {
+    std::cerr << "Error: " << parsed.error() << "\n";
+    return EXIT_FAILURE;
+  }
+  const corpus_options& options = *parsed;
+  if (options.flag_h) {
+    Usage(argv);
+    return EXIT_SUCCESS;
+  }
+
+  namespace fs = std::filesystem;
+  std::error_code error;
+  fs::create_directories(options.out, error);
+  if (error) {
+    std::cerr << "Error: " << error.message() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  DeterministicRng rng(options.seed);
+
+  // Árbol de directorios: la raíz y hasta `depth` niveles de `fanout` hijos,
+  // con un tope para que depth y fanout grandes no exploten.
+  constexpr size_t kMaxDirectories = 20000;
+  std::vector<std::string> directories = {""};
+  for (size_t level_begin = 0, level = 0; level < options.depth; ++level) {
+    size_t level_end = directories.size();
+    for (size_t d = level_begin; d < level_end; ++d) {
+      for (unsigned child = 0; child < options.fanout; ++child) {
+        if (directories.size() >= kMaxDirectories) break;
+        directories.push_back(std::format("{}/d{}", directories[d], child));
+      }
+    }
+    level_begin = level_end;
+  }
+  for (const auto& dir : directories) {
+    fs::create_directories(options.out + dir, error);
+  }
+
+  static constexpr const char* kExtensions[] = {".html", ".css", ".js",
+                                                ".txt", ".bin"};
+  std::vector<std::string> paths;
+  uint64_t total_bytes = 0;
+  for (uint64_t i = 0; i < options.files; ++i) {
+    const std::string& dir = directories[rng.below(directories.size())];
+    std::string path = std::format(
+        "{}/f{}{}", dir, i,
+        kExtensions[rng.below(std::size(kExtensions))]);
+    uint64_t size = sample_size(options.sizes, rng);
+    if (!write_file(options.out + path, size, options.seed ^ (i * 0x9E37ull))) {
+      std::cerr << "Error: cannot write " << options.out + path << ": "
+                << std::strerror(errno) << "\n";
+      return EXIT_FAILURE;
+    }
+    total_bytes += size;
+    paths.push_back(path);
+  }
+
+  // Popularidad: el orden de los rangos Zipf se baraja (Fisher-Yates) para
+  // que los archivos más pedidos no sean siempre los primeros generados.
+  std::vector<size_t> ranks(paths.size());
+  for (size_t i = 0; i < ranks.size(); ++i) ranks[i] = i;
+  for (size_t i = ranks.size(); i > 1; --i) {
+    std::swap(ranks[i - 1], ranks[rng.below(i)]);
+  }
+  std::ofstream path_list(options.out + "/paths.txt");
+  for (size_t i = 0; i < paths.size(); ++i) {
+    double weight =
+        1.0 / std::pow(static_cast<double>(ranks[i] + 1), options.popularity_skew);
+    path_list << std::format("{} {:.9f}\n", paths[i], weight);
+  }
+
+  fs::create_directories(options.out + "/sizes", error);
+  for (uint64_t size : options.size_list) {
+    write_file(std::format("{}/sizes/{}", options.out, size), size,
+               options.seed ^ size);
+  }
+
+  if (options.bin) {
+    fs::create_directories(options.out + "/bin", error);
+    std::ofstream bin_list(options.out + "/bin_paths.txt");
+    for (const auto& program : kBinPrograms) {
+      std::string path = std::format("{}/bin/{}", options.out, program.name);
+      std::ofstream(path) << program.script;
+      chmod(path.c_str(), 0755);
+      bin_list << "/bin/" << program.name << " 1\n";
+    }
+  }
+
+  std::cout << std::format(
+      "Corpus in {}: {} files ({}), {} directories, seed {}\n", options.out,
+      paths.size(), format_size(total_bytes), directories.size(),
+      options.seed);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,632 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: hash.cc
+ * Referencias:
+ *     Y. Collet, "xxHash - Extremely fast hash algorithm" (XXH3, v0.8)
+ *     FIPS 180-4, "Secure Hash Standard" (SHA-256)
+ *     RFC 4648, "The Base16, Base32, and Base64 Data Encodings"
+ */
+
+#include "hash.h"
+
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <format>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+__extension__ typedef unsigned __int128 uint128;
+
+constexpr size_t kStripeLen = 64;
+constexpr size_t kSecretConsumeRate = 8;
+constexpr size_t kAccumulators = 8;
+constexpr size_t kMidSizeMax = 240;
+constexpr size_t kMidSizeStartOffset = 3;
+constexpr size_t kMidSizeLastOffset = 17;
+constexpr size_t kSecretSizeMin = 136;
+constexpr size_t kSecretLastAccStart = 7;
+constexpr size_t kSecretMergeAccsStart = 11;
+
+// Secreto por defecto de XXH3
+alignas(64) constexpr unsigned char kSecret[192] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c,
+    0xf7, 0x21, 0xad, 0x1c, 0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb,
+    0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f, 0xcb, 0x79, 0xe6, 0x4e,
+    0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6,
+    0x81, 0x3a, 0x26, 0x4c, 0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb,
+    0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3, 0x71, 0x64, 0x48, 0x97,
+    0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7,
+    0xc7, 0x0b, 0x4f, 0x1d, 0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31,
+    0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64, 0xea, 0xc5, 0xac, 0x83,
+    0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26,
+    0x29, 0xd4, 0x68, 0x9e, 0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc,
+    0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce, 0x45, 0xcb, 0x3a, 0x8f,
+    0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+constexpr size_t kSecretSize = sizeof(kSecret);
+
+constexpr uint32_t kPrime32_1 = 0x9E3779B1U;
+constexpr uint32_t kPrime32_2 = 0x85EBCA77U;
+constexpr uint32_t kPrime32_3 = 0xC2B2AE3DU;
+constexpr uint64_t kPrime64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime64_5 = 0x27D4EB2F165667C5ULL;
+constexpr uint64_t kPrimeMx1 = 0x165667919E3779F9ULL;
+constexpr uint64_t kPrimeMx2 = 0x9FB21C651E98DF25ULL;
+
+uint64_t read64(const unsigned char* data) {
+  uint64_t value;
+  std::memcpy(&value, data, sizeof(value));
+  if constexpr (std::endian::native == std::endian::big) {
+    value = std::byteswap(value);
+  }
+  return value;
+}
+
+uint32_t read32(const unsigned char* data) {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  if constexpr (std::endian::native == std::endian::big) {
+    value = std::byteswap(value);
+  }
+  return value;
+}
+
+hash128 multiply128(uint64_t a, uint64_t b) {
+  uint128 product = uint128{a} * b;
+  return {static_cast<uint64_t>(product), static_cast<uint64_t>(product >> 64)};
+}
+
+/**
+ * @brief Producto de 128 bits plegado a 64: la mitad baja xor la alta.
+ */
+uint64_t fold64(uint64_t a, uint64_t b) {
+  hash128 product = multiply128(a, b);
+  return product.low ^ product.high;
+}
+
+uint64_t xxh64_avalanche(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= kPrime64_2;
+  hash ^= hash >> 29;
+  hash *= kPrime64_3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+uint64_t avalanche(uint64_t hash) {
+  hash ^= hash >> 37;
+  hash *= kPrimeMx1;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+uint64_t rrmxmx(uint64_t hash, uint64_t length) {
+  hash ^= std::rotl(hash, 49) ^ std::rotl(hash, 24);
+  hash *= kPrimeMx2;
+  hash ^= (hash >> 35) + length;
+  hash *= kPrimeMx2;
+  hash ^= hash >> 28;
+  return hash;
+}
+
+uint64_t mix16(const unsigned char* input, const unsigned char* secret) {
+  return fold64(read64(input) ^ read64(secret),
+                read64(input + 8) ^ read64(secret + 8));
+}
+
+// ---------------------------------------------------------------------------
+// Entradas largas: bandas de 64 bytes sobre ocho acumuladores
+// ---------------------------------------------------------------------------
+
+using accumulate_fn = void (*)(uint64_t* acc, const unsigned char* input,
+                               const unsigned char* secret, size_t stripes);
+using scramble_fn = void (*)(uint64_t* acc, const unsigned char* secret);
+
+/**
+ * @brief Implementación del bucle de bandas para el procesador actual.
+ */
+struct long_kernels {
+  accumulate_fn accumulate;
+  scramble_fn scramble;
+};
+
+[[maybe_unused]] void accumulate_scalar(uint64_t* acc,
+                                        const unsigned char* input,
+                                        const unsigned char* secret,
+                                        size_t stripes) {
+  for (size_t n = 0; n < stripes; ++n) {
+    const unsigned char* stripe = input + n * kStripeLen;
+    const unsigned char* key = secret + n * kSecretConsumeRate;
+    for (size_t lane = 0; lane < kAccumulators; ++lane) {
+      uint64_t value = read64(stripe + 8 * lane);
+      uint64_t keyed = value ^ read64(key + 8 * lane);
+      acc[lane ^ 1] += value;  // Los carriles vecinos se cruzan
+      acc[lane] += (keyed & 0xffffffff) * (keyed >> 32);
+    }
+  }
+}
+
+[[maybe_unused]] void scramble_scalar(uint64_t* acc,
+                                      const unsigned char* secret) {
+  for (size_t lane = 0; lane < kAccumulators; ++lane) {
+    uint64_t value = acc[lane];
+    value ^= value >> 47;
+    value ^= read64(secret + 8 * lane);
+    value *= kPrime32_1;
+    acc[lane] = value;
+  }
+}
+
+#if defined(__x86_64__)
+
+// SSE2 es parte de x86-64: dos carriles por registro
+void accumulate_sse2(uint64_t* acc, const unsigned char* input,
+                     const unsigned char* secret, size_t stripes) {
+  auto* lanes = reinterpret_cast<__m128i*>(acc);
+  for (size_t n = 0; n < stripes; ++n) {
+    const unsigned char* stripe = input + n * kStripeLen;
+    const unsigned char* key = secret + n * kSecretConsumeRate;
+    for (size_t i = 0; i < kStripeLen / 16; ++i) {
+      __m128i data =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(stripe + 16 * i));
+      __m128i keyed = _mm_xor_si128(
+          data,
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + 16 * i)));
+      __m128i keyed_high = _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1));
+      __m128i product = _mm_mul_epu32(keyed, keyed_high);
+      __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+      lanes[i] = _mm_add_epi64(product, _mm_add_epi64(lanes[i], swapped));
+    }
+  }
+}
+
+void scramble_sse2(uint64_t* acc, const unsigned char* secret) {
+  auto* lanes = reinterpret_cast<__m128i*>(acc);
+  const __m128i prime = _mm_set1_epi32(static_cast<int>(kPrime32_1));
+  for (size_t i = 0; i < kStripeLen / 16; ++i) {
+    __m128i value = lanes[i];
+    value = _mm_xor_si128(value, _mm_srli_epi64(value, 47));
+    __m128i keyed = _mm_xor_si128(
+        value,
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret + 16 * i)));
+    __m128i keyed_high = _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1));
+    __m128i low = _mm_mul_epu32(keyed, prime);
+    __m128i high = _mm_mul_epu32(keyed_high, prime);
+    lanes[i] = _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+  }
+}
+
+// AVX2: cuatro carriles por registro, solo si el procesador lo tiene
+__attribute__((target("avx2"))) void accumulate_avx2(
+    uint64_t* acc, const unsigned char* input, const unsigned char* secret,
+    size_t stripes) {
+  auto* lanes = reinterpret_cast<__m256i*>(acc);
+  for (size_t n = 0; n < stripes; ++n) {
+    const unsigned char* stripe = input + n * kStripeLen;
+    const unsigned char* key = secret + n * kSecretConsumeRate;
+    for (size_t i = 0; i < kStripeLen / 32; ++i) {
+      __m256i data = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(stripe + 32 * i));
+      __m256i keyed = _mm256_xor_si256(
+          data,
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(key + 32 * i)));
+      __m256i keyed_high =
+          _mm256_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1));
+      __m256i product = _mm256_mul_epu32(keyed, keyed_high);
+      __m256i swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+      lanes[i] =
+          _mm256_add_epi64(product, _mm256_add_epi64(lanes[i], swapped));
+    }
+  }
+}
+
+__attribute__((target("avx2"))) void scramble_avx2(
+    uint64_t* acc, const unsigned char* secret) {
+  auto* lanes = reinterpret_cast<__m256i*>(acc);
+  const __m256i prime = _mm256_set1_epi32(static_cast<int>(kPrime32_1));
+  for (size_t i = 0; i < kStripeLen / 32; ++i) {
+    __m256i value = lanes[i];
+    value = _mm256_xor_si256(value, _mm256_srli_epi64(value, 47));
+    __m256i keyed = _mm256_xor_si256(
+        value,
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(secret + 32 * i)));
+    __m256i keyed_high =
+        _mm256_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1));
+    __m256i low = _mm256_mul_epu32(keyed, prime);
+    __m256i high = _mm256_mul_epu32(keyed_high, prime);
+    lanes[i] = _mm256_add_epi64(low, _mm256_slli_epi64(high, 32));
+  }
+}
+
+#endif
+
+const long_kernels& kernels() {
+  static const long_kernels selected = [] {
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) {
+      return long_kernels{accumulate_avx2, scramble_avx2};
+    }
+    return long_kernels{accumulate_sse2, scramble_sse2};
+#else
+    return long_kernels{accumulate_scalar, scramble_scalar};
+#endif
+  }();
+  return selected;
+}
+
+struct alignas(32) accumulators {
+  uint64_t lanes[kAccumulators] = {kPrime32_3, kPrime64_1, kPrime64_2,
+                                   kPrime64_3, kPrime64_4, kPrime32_2,
+                                   kPrime64_5, kPrime32_1};
+};
+
+/**
+ * @brief Recorre una entrada de más de 240 bytes: bloques de 16 bandas
+ * (cada una con el secreto desplazado 8 bytes más) separados por una
+ * mezcla, y al final la última banda completa.
+ */
+accumulators hash_long(const unsigned char* input, size_t length) {
+  constexpr size_t kStripesPerBlock =
+      (kSecretSize - kStripeLen) / kSecretConsumeRate;
+  constexpr size_t kBlockLen = kStripeLen * kStripesPerBlock;
+  const long_kernels& kernel = kernels();
+  accumulators acc;
+  size_t blocks = (length - 1) / kBlockLen;
+  for (size_t n = 0; n < blocks; ++n) {
+    kernel.accumulate(acc.lanes, input + n * kBlockLen, kSecret,
+                      kStripesPerBlock);
+    kernel.scramble(acc.lanes, kSecret + kSecretSize - kStripeLen);
+  }
+  size_t stripes = ((length - 1) - kBlockLen * blocks) / kStripeLen;
+  kernel.accumulate(acc.lanes, input + blocks * kBlockLen, kSecret, stripes);
+  kernel.accumulate(acc.lanes, input + length - kStripeLen,
+                    kSecret + kSecretSize - kStripeLen - kSecretLastAccStart,
+                    1);
+  return acc;
+}
+
+uint64_t merge(const accumulators& acc, const unsigned char* secret,
+               uint64_t start) {
+  uint64_t result = start;
+  for (size_t i = 0; i < 4; ++i) {
+    result += fold64(acc.lanes[2 * i] ^ read64(secret + 16 * i),
+                     acc.lanes[2 * i + 1] ^ read64(secret + 16 * i + 8));
+  }
+  return avalanche(result);
+}
+
+// ---------------------------------------------------------------------------
+// XXH3 de 64 bits
+// ---------------------------------------------------------------------------
+
+uint64_t len_0to16_64(const unsigned char* input, size_t length) {
+  if (length > 8) {
+    uint64_t low =
+        read64(input) ^ (read64(kSecret + 24) ^ read64(kSecret + 32));
+    uint64_t high = read64(input + length - 8) ^
+                    (read64(kSecret + 40) ^ read64(kSecret + 48));
+    return avalanche(length + std::byteswap(low) + high + fold64(low, high));
+  }
+  if (length >= 4) {
+    uint64_t first = read32(input);
+    uint64_t last = read32(input + length - 4);
+    uint64_t keyed = (last + (first << 32)) ^
+                     (read64(kSecret + 8) ^ read64(kSecret + 16));
+    return rrmxmx(keyed, length);
+  }
+  if (length > 0) {
+    uint32_t combined = (uint32_t{input[0]} << 16) |
+                        (uint32_t{input[length >> 1]} << 24) |
+                        uint32_t{input[length - 1]} |
+                        (static_cast<uint32_t>(length) << 8);
+    uint64_t bitflip = read32(kSecret) ^ read32(kSecret + 4);
+    return xxh64_avalanche(combined ^ bitflip);
+  }
+  return xxh64_avalanche(read64(kSecret + 56) ^ read64(kSecret + 64));
+}
+
+uint64_t len_17to128_64(const unsigned char* input, size_t length) {
+  uint64_t acc = length * kPrime64_1;
+  if (length > 32) {
+    if (length > 64) {
+      if (length > 96) {
+        acc += mix16(input + 48, kSecret + 96);
+        acc += mix16(input + length - 64, kSecret + 112);
+      }
+      acc += mix16(input + 32, kSecret + 64);
+      acc += mix16(input + length - 48, kSecret + 80);
+    }
+    acc += mix16(input + 16, kSecret + 32);
+    acc += mix16(input + length - 32, kSecret + 48);
+  }
+  acc += mix16(input, kSecret);
+  acc += mix16(input + length - 16, kSecret + 16);
+  return avalanche(acc);
+}
+
+uint64_t len_129to240_64(const unsigned char* input, size_t length) {
+  uint64_t acc = length * kPrime64_1;
+  for (size_t i = 0; i < 8; ++i) {
+    acc += mix16(input + 16 * i, kSecret + 16 * i);
+  }
+  uint64_t acc_end = mix16(input + length - 16,
+                           kSecret + kSecretSizeMin - kMidSizeLastOffset);
+  acc = avalanche(acc);
+  for (size_t i = 8; i < length / 16; ++i) {
+    acc_end +=
+        mix16(input + 16 * i, kSecret + 16 * (i - 8) + kMidSizeStartOffset);
+  }
+  return avalanche(acc + acc_end);
+}
+
+// ---------------------------------------------------------------------------
+// XXH3 de 128 bits
+// ---------------------------------------------------------------------------
+
+hash128 len_0to16_128(const unsigned char* input, size_t length) {
+  if (length > 8) {
+    uint64_t bitflip_low = read64(kSecret + 32) ^ read64(kSecret + 40);
+    uint64_t bitflip_high = read64(kSecret + 48) ^ read64(kSecret + 56);
+    uint64_t low = read64(input);
+    uint64_t high = read64(input + length - 8);
+    hash128 m = multiply128(low ^ high ^ bitflip_low, kPrime64_1);
+    m.low += uint64_t{length - 1} << 54;
+    high ^= bitflip_high;
+    m.high += high + uint64_t{static_cast<uint32_t>(high)} * (kPrime32_2 - 1);
+    m.low ^= std::byteswap(m.high);
+    hash128 h = multiply128(m.low, kPrime64_2);
+    h.high += m.high * kPrime64_2;
+    return {avalanche(h.low), avalanche(h.high)};
+  }
+  if (length >= 4) {
+    uint64_t low = read32(input);
+    uint64_t high = read32(input + length - 4);
+    uint64_t keyed = (low + (high << 32)) ^
+                     (read64(kSecret + 16) ^ read64(kSecret + 24));
+    hash128 m = multiply128(keyed, kPrime64_1 + (length << 2));
+    m.high += m.low << 1;
+    m.low ^= m.high >> 3;
+    m.low ^= m.low >> 35;
+    m.low *= kPrimeMx2;
+    m.low ^= m.low >> 28;
+    m.high = avalanche(m.high);
+    return m;
+  }
+  if (length > 0) {
+    uint32_t combined_low = (uint32_t{input[0]} << 16) |
+                            (uint32_t{input[length >> 1]} << 24) |
+                            uint32_t{input[length - 1]} |
+                            (static_cast<uint32_t>(length) << 8);
+    uint32_t combined_high = std::rotl(std::byteswap(combined_low), 13);
+    uint64_t bitflip_low = read32(kSecret) ^ read32(kSecret + 4);
+    uint64_t bitflip_high = read32(kSecret + 8) ^ read32(kSecret + 12);
+    return {xxh64_avalanche(combined_low ^ bitflip_low),
+            xxh64_avalanche(combined_high ^ bitflip_high)};
+  }
+  return {xxh64_avalanche(read64(kSecret + 64) ^ read64(kSecret + 72)),
+          xxh64_avalanche(read64(kSecret + 80) ^ read64(kSecret + 88))};
+}
+
+hash128 mix32(hash128 acc, const unsigned char* first,
+              const unsigned char* second, const unsigned char* secret) {
+  acc.low += mix16(first, secret);
+  acc.low ^= read64(second) + read64(second + 8);
+  acc.high += mix16(second, secret + 16);
+  acc.high ^= read64(first) + read64(first + 8);
+  return acc;
+}
+
+hash128 finish_mid_128(const hash128& acc, size_t length) {
+  uint64_t low = acc.low + acc.high;
+  uint64_t high = acc.low * kPrime64_1 + acc.high * kPrime64_4 +
+                  length * kPrime64_2;
+  return {avalanche(low), 0 - avalanche(high)};
+}
+
+hash128 len_17to128_128(const unsigned char* input, size_t length) {
+  hash128 acc{length * kPrime64_1, 0};
+  if (length > 32) {
+    if (length > 64) {
+      if (length > 96) {
+        acc = mix32(acc, input + 48, input + length - 64, kSecret + 96);
+      }
+      acc = mix32(acc, input + 32, input + length - 48, kSecret + 64);
+    }
+    acc = mix32(acc, input + 16, input + length - 32, kSecret + 32);
+  }
+  acc = mix32(acc, input, input + length - 16, kSecret);
+  return finish_mid_128(acc, length);
+}
+
+hash128 len_129to240_128(const unsigned char* input, size_t length) {
+  hash128 acc{length * kPrime64_1, 0};
+  for (size_t i = 32; i < 160; i += 32) {
+    acc = mix32(acc, input + i - 32, input + i - 16, kSecret + i - 32);
+  }
+  acc = {avalanche(acc.low), avalanche(acc.high)};
+  for (size_t i = 160; i <= length; i += 32) {
+    acc = mix32(acc, input + i - 32, input + i - 16,
+                kSecret + kMidSizeStartOffset + i - 160);
+  }
+  acc = mix32(acc, input + length - 16, input + length - 32,
+              kSecret + kSecretSizeMin - kMidSizeLastOffset - 16);
+  return finish_mid_128(acc, length);
+}
+
+// ---------------------------------------------------------------------------
+// SHA-256
+// ---------------------------------------------------------------------------
+
+constexpr uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+uint32_t read32_be(const unsigned char* data) {
+  return (uint32_t{data[0]} << 24) | (uint32_t{data[1]} << 16) |
+         (uint32_t{data[2]} << 8) | uint32_t{data[3]};
+}
+
+void sha256_block(uint32_t* state, const unsigned char* block) {
+  uint32_t w[64];
+  for (size_t i = 0; i < 16; ++i) {
+    w[i] = read32_be(block + 4 * i);
+  }
+  for (size_t i = 16; i < 64; ++i) {
+    uint32_t s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18) ^
+                  (w[i - 15] >> 3);
+    uint32_t s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19) ^
+                  (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+  uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+  for (size_t i = 0; i < 64; ++i) {
+    uint32_t s1 = std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25);
+    uint32_t choose = (e & f) ^ (~e & g);
+    uint32_t t1 = h + s1 + choose + kRoundConstants[i] + w[i];
+    uint32_t s0 = std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22);
+    uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+    uint32_t t2 = s0 + majority;
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+  state[5] += f;
+  state[6] += g;
+  state[7] += h;
+}
+
+}  // namespace
+
+uint64_t xxh3_64(std::string_view data) {
+  auto input = reinterpret_cast<const unsigned char*>(data.data());
+  size_t length = data.size();
+  if (length <= 16) {
+    return len_0to16_64(input, length);
+  }
+  if (length <= 128) {
+    return len_17to128_64(input, length);
+  }
+  if (length <= kMidSizeMax) {
+    return len_129to240_64(input, length);
+  }
+  return merge(hash_long(input, length), kSecret + kSecretMergeAccsStart,
+               length * kPrime64_1);
+}
+
+hash128 xxh3_128(std::string_view data) {
+  auto input = reinterpret_cast<const unsigned char*>(data.data());
+  size_t length = data.size();
+  if (length <= 16) {
+    return len_0to16_128(input, length);
+  }
+  if (length <= 128) {
+    return len_17to128_128(input, length);
+  }
+  if (length <= kMidSizeMax) {
+    return len_129to240_128(input, length);
+  }
+  accumulators acc = hash_long(input, length);
+  return {merge(acc, kSecret + kSecretMergeAccsStart, length * kPrime64_1),
+          merge(acc,
+                kSecret + kSecretSize - sizeof(acc.lanes) -
+                    kSecretMergeAccsStart,
+                ~(length * kPrime64_2))};
+}
+
+sha256_digest sha256(std::string_view data) {
+  uint32_t state[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                       0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  auto input = reinterpret_cast<const unsigned char*>(data.data());
+  size_t full = data.size() / 64 * 64;
+  for (size_t offset = 0; offset < full; offset += 64) {
+    sha256_block(state, input + offset);
+  }
+
+  // Lo que queda, un 0x80, ceros y la longitud en bits: uno o dos bloques
+  unsigned char tail[128] = {};
+  size_t rest = data.size() - full;
+  if (rest > 0) {
+    std::memcpy(tail, input + full, rest);
+  }
+  tail[rest] = 0x80;
+  size_t tail_size = rest < 56 ? 64 : 128;
+  uint64_t bits = uint64_t{data.size()} * 8;
+  for (size_t i = 0; i < 8; ++i) {
+    tail[tail_size - 1 - i] = static_cast<unsigned char>(bits >> (8 * i));
+  }
+  for (size_t offset = 0; offset < tail_size; offset += 64) {
+    sha256_block(state, tail + offset);
+  }
+
+  sha256_digest digest;
+  for (size_t i = 0; i < 8; ++i) {
+    for (size_t j = 0; j < 4; ++j) {
+      digest[4 * i + j] = static_cast<unsigned char>(state[i] >> (24 - 8 * j));
+    }
+  }
+  return digest;
+}
+
+std::string to_hex(const hash128& hash) {
+  return std::format("{:016x}{:016x}", hash.high, hash.low);
+}
+
+std::string base64(std::string_view data) {
+  constexpr std::string_view kAlphabet =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  out.reserve((data.size() + 2) / 3 * 4);
+  for (size_t i = 0; i < data.size(); i += 3) {
+    uint32_t group = uint32_t{static_cast<unsigned char>(data[i])} << 16;
+    if (i + 1 < data.size()) {
+      group |= uint32_t{static_cast<unsigned char>(data[i + 1])} << 8;
+    }
+    if (i + 2 < data.size()) {
+      group |= static_cast<unsigned char>(data[i + 2]);
+    }
+    out.push_back(kAlphabet[(group >> 18) & 63]);
+    out.push_back(kAlphabet[(group >> 12) & 63]);
+    out.push_back(i + 1 < data.size() ? kAlphabet[(group >> 6) & 63] : '=');
+    out.push_back(i + 2 < data.size() ? kAlphabet[group & 63] : '=');
+  }
+  return out;
+}
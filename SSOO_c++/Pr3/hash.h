@@ -0,0 +1,68 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: hash.h
+ * Referencias:
+ *     Y. Collet, "xxHash - Extremely fast hash algorithm" (XXH3, v0.8)
+ *     FIPS 180-4, "Secure Hash Standard" (SHA-256)
+ *     RFC 4648, "The Base16, Base32, and Base64 Data Encodings"
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Resumen de 128 bits de XXH3.
+ */
+struct hash128 {
+  uint64_t low = 0;
+  uint64_t high = 0;
+
+  bool operator==(const hash128&) const = default;
+};
+
+using sha256_digest = std::array<unsigned char, 32>;
+
+/**
+ * @brief XXH3 de 64 bits con semilla 0 y el secreto por defecto: da lo
+ * mismo que XXH3_64bits() de la biblioteca xxHash.
+ */
+uint64_t xxh3_64(std::string_view data);
+
+/**
+ * @brief XXH3 de 128 bits, como XXH3_128bits().
+ *
+ * Con más de 240 bytes se recorren bandas de 64 bytes con ocho
+ * acumuladores; ese bucle usa AVX2 si el procesador lo tiene, SSE2 si no
+ * (siempre en x86-64), y la versión escalar en otras arquitecturas.
+ */
+hash128 xxh3_128(std::string_view data);
+
+/**
+ * @brief SHA-256 de data.
+ */
+sha256_digest sha256(std::string_view data);
+
+/**
+ * @brief Los 32 dígitos hexadecimales de hash (primero la parte alta, como
+ * el XXH128_canonical_t de xxHash).
+ */
+std::string to_hex(const hash128& hash);
+
+/**
+ * @brief data en base64 con relleno ("=").
+ */
+std::string base64(std::string_view data);
+
+#endif  // HASH_H
@@ -0,0 +1,252 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: hot_restart.cc
+ * Referencias:
+ *     man 7 unix (SCM_RIGHTS, SO_PEERCRED), man 3 cmsg
+ */
+
+#include "hot_restart.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+
+#include "docserver.h"
+#include "listener.h"
+
+namespace {
+
+// Sockets que escuchan que caben en un mensaje (SCM_MAX_FD es 253)
+constexpr size_t kMaxListeners = 64;
+// Tamaño de los mensajes de claves, por debajo del búfer del socket
+constexpr size_t kMaxMessage = 16384;
+// Lo que se espera al otro proceso antes de darlo por perdido
+constexpr timeval kTimeout = {5, 0};
+
+void set_timeouts(int fd) {
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &kTimeout, sizeof(kTimeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &kTimeout, sizeof(kTimeout));
+}
+
+int send_message(int fd, std::string_view text, const std::vector<int>& fds) {
+  iovec part = {const_cast<char*>(text.data()), text.size()};
+  msghdr message{};
+  message.msg_iov = &part;
+  message.msg_iovlen = 1;
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxListeners)];
+  if (!fds.empty()) {
+    size_t length = sizeof(int) * fds.size();
+    message.msg_control = control;
+    message.msg_controllen = CMSG_SPACE(length);
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    if (header == nullptr) {
+      return EINVAL;
+    }
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(length);
+    std::memcpy(CMSG_DATA(header), fds.data(), length);
+  }
+  while (sendmsg(fd, &message, MSG_NOSIGNAL) < 0) {
+    if (errno != EINTR) {
+      return errno;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief Recibe un mensaje y los descriptores que traiga (con CLOEXEC).
+ */
+std::expected<std::string, int> receive_message(int fd,
+                                                std::vector<SafeFD>& fds) {
+  std::string text(kMaxMessage, '\0');
+  iovec part = {text.data(), text.size()};
+  msghdr message{};
+  message.msg_iov = &part;
+  message.msg_iovlen = 1;
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * kMaxListeners)];
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  ssize_t received;
+  while ((received = recvmsg(fd, &message, MSG_CMSG_CLOEXEC)) < 0) {
+    if (errno != EINTR) {
+      return std::unexpected(errno);
+    }
+  }
+  for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr;
+       header = CMSG_NXTHDR(&message, header)) {
+    if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+      size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      for (size_t i = 0; i < count; ++i) {
+        int received_fd;
+        std::memcpy(&received_fd, CMSG_DATA(header) + i * sizeof(int),
+                    sizeof(int));
+        fds.emplace_back(received_fd);
+      }
+    }
+  }
+  if (received == 0 || (message.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) != 0) {
+    return std::unexpected(EPROTO);
+  }
+  text.resize(static_cast<size_t>(received));
+  return text;
+}
+
+std::vector<std::string> split_lines(std::string_view text) {
+  std::vector<std::string> lines;
+  while (!text.empty()) {
+    size_t end = text.find('\n');
+    lines.emplace_back(text.substr(0, end));
+    text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+  }
+  return lines;
+}
+
+}  // namespace
+
+std::expected<restart_handoff, int> request_handoff(const std::string& path) {
+  SafeFD fd(socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0));
+  if (!fd.is_valid()) {
+    return std::unexpected(errno);
+  }
+  sockaddr_un address{};
+  socklen_t length = unix_address(path, address);
+  if (connect(fd.get(), reinterpret_cast<sockaddr*>(&address), length) < 0) {
+    return std::unexpected(errno);
+  }
+  set_timeouts(fd.get());
+
+  restart_handoff result;
+  while (true) {
+    std::vector<SafeFD> fds;
+    auto text = receive_message(fd.get(), fds);
+    if (!text) {
+      return std::unexpected(text.error());
+    }
+    std::vector<std::string> lines = split_lines(*text);
+    if (lines.empty()) {
+      return std::unexpected(EPROTO);
+    }
+    if (lines[0] == "E") {
+      result.control = std::move(fd);
+      return result;
+    }
+    if (lines[0] == "L") {
+      if (fds.size() != lines.size() - 1) {
+        return std::unexpected(EPROTO);
+      }
+      for (size_t i = 0; i < fds.size(); ++i) {
+        result.listeners.emplace_back(lines[i + 1], std::move(fds[i]));
+      }
+    } else if (lines[0] == "K" && fds.empty()) {
+      result.cache_keys.insert(result.cache_keys.end(), lines.begin() + 1,
+                               lines.end());
+    } else {
+      return std::unexpected(EPROTO);
+    }
+  }
+}
+
+std::expected<SafeFD, int> open_restart_socket(const std::string& path) {
+  if (path.empty() || path.size() >= sizeof(sockaddr_un::sun_path)) {
+    return std::unexpected(ENAMETOOLONG);
+  }
+  SafeFD fd(socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0));
+  if (!fd.is_valid()) {
+    return std::unexpected(errno);
+  }
+  remove_stale_socket(path);
+  sockaddr_un address{};
+  socklen_t length = unix_address(path, address);
+  if (bind(fd.get(), reinterpret_cast<sockaddr*>(&address), length) < 0 ||
+      listen(fd.get(), 1) < 0) {
+    return std::unexpected(errno);
+  }
+  print_verbose("Restart: Socket de control en " + path);
+  return fd;
+}
+
+int send_handoff(const SafeFD& peer,
+                 const std::vector<std::pair<std::string, int>>& listeners,
+                 const std::vector<std::string>& cache_keys) {
+  // Quien se lleva los sockets puede hacerse pasar por el servidor: solo
+  // otro proceso del mismo usuario (o root)
+  ucred credentials{};
+  socklen_t length = sizeof(credentials);
+  if (getsockopt(peer.get(), SOL_SOCKET, SO_PEERCRED, &credentials,
+                 &length) < 0) {
+    return errno;
+  }
+  if (credentials.uid != geteuid() && credentials.uid != 0) {
+    return EPERM;
+  }
+  if (listeners.size() > kMaxListeners) {
+    return E2BIG;
+  }
+  set_timeouts(peer.get());
+
+  std::string text = "L\n";
+  std::vector<int> fds;
+  for (const auto& [address, fd] : listeners) {
+    text += address + "\n";
+    fds.push_back(fd);
+  }
+  if (int error = send_message(peer.get(), text, fds); error != 0) {
+    return error;
+  }
+  text = "K\n";
+  for (const auto& key : cache_keys) {
+    if (key.size() + 3 > kMaxMessage) {
+      continue;
+    }
+    if (text.size() + key.size() + 1 > kMaxMessage) {
+      if (int error = send_message(peer.get(), text, {}); error != 0) {
+        return error;
+      }
+      text = "K\n";
+    }
+    text += key + "\n";
+  }
+  if (text.size() > 2) {
+    if (int error = send_message(peer.get(), text, {}); error != 0) {
+      return error;
+    }
+  }
+  return send_message(peer.get(), "E\n", {});
+}
+
+int confirm_handoff(const SafeFD& control) {
+  return send_message(control.get(), "R\n", {});
+}
+
+int receive_ready(const SafeFD& peer) {
+  char text[16];
+  ssize_t received;
+  while ((received = recv(peer.get(), text, sizeof(text), MSG_DONTWAIT)) <
+         0) {
+    if (errno == EAGAIN) {
+      return EAGAIN;
+    }
+    if (errno != EINTR) {
+      return errno;
+    }
+  }
+  if (received == 0) {
+    return EPIPE;
+  }
+  return std::string_view(text, static_cast<size_t>(received)) == "R\n"
+             ? 0
+             : EPROTO;
+}
@@ -0,0 +1,91 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: hot_restart.h
+ * Referencias:
+ *     man 7 unix (SCM_RIGHTS, SO_PEERCRED), man 3 cmsg
+ */
+
+#ifndef HOT_RESTART_H
+#define HOT_RESTART_H
+
+#include <expected>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "safe_fd.h"
+
+/**
+ * Reinicio en caliente. El servidor arrancado con --restart-socket <ruta>
+ * escucha en esa ruta un socket Unix de control. Un servidor nuevo con la
+ * misma opción se conecta a él y recibe:
+ *   - Los sockets que escuchan, con SCM_RIGHTS, cada uno con su dirección.
+ *   - Las claves de la caché de salidas de /bin, para rellenarlas.
+ * El viejo sigue aceptando hasta que el nuevo, ya atendiendo los sockets,
+ * confirma por la misma conexión; entonces deja de aceptar, termina las
+ * conexiones que tiene y sale. Si el nuevo cierra sin confirmar (murió al
+ * arrancar), el viejo sigue como si nada. En ningún momento se quedan los
+ * sockets sin nadie que acepte.
+ *
+ * Mensajes (SOCK_SEQPACKET, así que cada uno llega entero), una línea por
+ * elemento tras la letra del tipo:
+ *   "L\n<dirección>\n..."  Con los sockets en el mismo orden
+ *   "K\n<clave>\n..."      Claves de la caché; puede haber varios
+ *   "E\n"                  Fin
+ *   "R\n"                  Del nuevo al viejo: ya acepta
+ */
+
+/**
+ * @brief Lo que entrega el proceso viejo.
+ */
+struct restart_handoff {
+  std::vector<std::pair<std::string, SafeFD>> listeners;  // Dirección, socket
+  std::vector<std::string> cache_keys;
+  SafeFD control;  // Conexión con el viejo, para confirm_handoff()
+};
+
+/**
+ * @brief Pide los sockets al proceso que atiende en la ruta de control.
+ * @return Lo entregado; ENOENT o ECONNREFUSED si no hay un proceso anterior
+ * (arranque normal) o el errno del fallo.
+ */
+std::expected<restart_handoff, int> request_handoff(const std::string& path);
+
+/**
+ * @brief Crea el socket de control en la ruta ("@nombre" = abstracto).
+ */
+std::expected<SafeFD, int> open_restart_socket(const std::string& path);
+
+/**
+ * @brief Atiende una conexión aceptada en el socket de control: comprueba
+ * que es del mismo usuario y le envía los sockets y las claves.
+ * @param listeners Dirección y descriptor de cada socket que escucha.
+ * @return 0 si se entregó todo, o el errno del fallo.
+ */
+int send_handoff(const SafeFD& peer,
+                 const std::vector<std::pair<std::string, int>>& listeners,
+                 const std::vector<std::string>& cache_keys);
+
+/**
+ * @brief Avisa al proceso viejo de que el nuevo ya acepta en los sockets
+ * recibidos.
+ * @return 0 o el errno del fallo.
+ */
+int confirm_handoff(const SafeFD& control);
+
+/**
+ * @brief Lee sin bloquear la confirmación del nuevo en la conexión de
+ * control.
+ * @return 0 si llegó, EAGAIN si aún no hay nada, EPIPE si el nuevo cerró
+ * sin confirmar o el errno del fallo.
+ */
+int receive_ready(const SafeFD& peer);
+
+#endif  // HOT_RESTART_H
@@ -0,0 +1,422 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: hpack.cc
+ * Referencias:
+ *     RFC 7541 (HPACK: Header Compression for HTTP/2)
+ */
+
+#include "hpack.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+
+namespace {
+
+// Apéndice A: tabla estática (índices 1 a 61)
+const std::array<header_field, 61> kStaticTable = {{
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+}};
+
+struct huffman_code {
+  uint32_t code;
+  int bits;
+};
+
+// Apéndice B: código de cada byte y del fin de cadena (EOS, el 256)
+const std::array<huffman_code, 257> kHuffmanCodes = {{
+    {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28},
+    {0xfffffe4, 28}, {0xfffffe5, 28}, {0xfffffe6, 28}, {0xfffffe7, 28},
+    {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+    {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28},
+    {0xfffffed, 28}, {0xfffffee, 28}, {0xfffffef, 28}, {0xffffff0, 28},
+    {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+    {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28},
+    {0xffffff8, 28}, {0xffffff9, 28}, {0xffffffa, 28}, {0xffffffb, 28},
+    {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12}, {0x1ff9, 13}, {0x15, 6},
+    {0xf8, 8}, {0x7fa, 11}, {0x3fa, 10}, {0x3fb, 10}, {0xf9, 8}, {0x7fb, 11},
+    {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6}, {0x0, 5}, {0x1, 5}, {0x2, 5},
+    {0x19, 6}, {0x1a, 6}, {0x1b, 6}, {0x1c, 6}, {0x1d, 6}, {0x1e, 6}, {0x1f, 6},
+    {0x5c, 7}, {0xfb, 8}, {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10},
+    {0x1ffa, 13}, {0x21, 6}, {0x5d, 7}, {0x5e, 7}, {0x5f, 7}, {0x60, 7},
+    {0x61, 7}, {0x62, 7}, {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7}, {0x67, 7},
+    {0x68, 7}, {0x69, 7}, {0x6a, 7}, {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+    {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7}, {0xfc, 8}, {0x73, 7}, {0xfd, 8},
+    {0x1ffb, 13}, {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+    {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5}, {0x24, 6}, {0x5, 5}, {0x25, 6},
+    {0x26, 6}, {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7}, {0x28, 6}, {0x29, 6},
+    {0x2a, 6}, {0x7, 5}, {0x2b, 6}, {0x76, 7}, {0x2c, 6}, {0x8, 5}, {0x9, 5},
+    {0x2d, 6}, {0x77, 7}, {0x78, 7}, {0x79, 7}, {0x7a, 7}, {0x7b, 7},
+    {0x7ffe, 15}, {0x7fc, 11}, {0x3ffd, 14}, {0x1ffd, 13}, {0xffffffc, 28},
+    {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20}, {0x3fffd3, 22},
+    {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23}, {0x3fffd6, 22},
+    {0x7fffda, 23}, {0x7fffdb, 23}, {0x7fffdc, 23}, {0x7fffdd, 23},
+    {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23}, {0xffffec, 24},
+    {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23}, {0xffffee, 24},
+    {0x7fffe1, 23}, {0x7fffe2, 23}, {0x7fffe3, 23}, {0x7fffe4, 23},
+    {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23}, {0x3fffd9, 22},
+    {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24}, {0x3fffda, 22},
+    {0x1fffdd, 21}, {0xfffe9, 20}, {0x3fffdb, 22}, {0x3fffdc, 22},
+    {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21}, {0x7fffea, 23},
+    {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24}, {0x1fffdf, 21},
+    {0x3fffdf, 22}, {0x7fffeb, 23}, {0x7fffec, 23}, {0x1fffe0, 21},
+    {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21}, {0x7fffed, 23},
+    {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23}, {0xfffea, 20},
+    {0x3fffe2, 22}, {0x3fffe3, 22}, {0x3fffe4, 22}, {0x7ffff0, 23},
+    {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23}, {0x3ffffe0, 26},
+    {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19}, {0x3fffe7, 22},
+    {0x7ffff2, 23}, {0x3fffe8, 22}, {0x1ffffec, 25}, {0x3ffffe2, 26},
+    {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27}, {0x7ffffdf, 27},
+    {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25}, {0x7fff2, 19},
+    {0x1fffe3, 21}, {0x3ffffe6, 26}, {0x7ffffe0, 27}, {0x7ffffe1, 27},
+    {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24}, {0x1fffe4, 21},
+    {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26}, {0xffffffd, 28},
+    {0x7ffffe3, 27}, {0x7ffffe4, 27}, {0x7ffffe5, 27}, {0xfffec, 20},
+    {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21}, {0x3fffe9, 22},
+    {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23}, {0x3fffea, 22},
+    {0x3fffeb, 22}, {0x1ffffee, 25}, {0x1ffffef, 25}, {0xfffff4, 24},
+    {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23}, {0x3ffffeb, 26},
+    {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26}, {0x7ffffe7, 27},
+    {0x7ffffe8, 27}, {0x7ffffe9, 27}, {0x7ffffea, 27}, {0x7ffffeb, 27},
+    {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27}, {0x7ffffee, 27},
+    {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26}, {0x3fffffff, 30},
+}};
+
+constexpr int kMaxHuffmanBits = 30;
+
+/**
+ * @brief Tablas para decodificar el código canónico longitud a longitud:
+ * los códigos de una misma longitud son consecutivos.
+ */
+struct huffman_decoder {
+  std::array<uint32_t, kMaxHuffmanBits + 1> first_code{};
+  std::array<uint32_t, kMaxHuffmanBits + 1> count{};
+  std::array<uint32_t, kMaxHuffmanBits + 1> first_symbol{};  // En symbols
+  std::array<uint16_t, 257> symbols{};  // Por longitud y, dentro, por código
+
+  huffman_decoder() {
+    for (uint16_t symbol = 0; symbol < 257; ++symbol) {
+      symbols[symbol] = symbol;
+    }
+    std::sort(symbols.begin(), symbols.end(), [](uint16_t a, uint16_t b) {
+      const auto& x = kHuffmanCodes[a];
+      const auto& y = kHuffmanCodes[b];
+      return x.bits != y.bits ? x.bits < y.bits : x.code < y.code;
+    });
+    for (uint32_t i = 257; i-- > 0;) {
+      const auto& code = kHuffmanCodes[symbols[i]];
+      auto bits = static_cast<size_t>(code.bits);
+      ++count[bits];
+      first_code[bits] = code.code;
+      first_symbol[bits] = i;
+    }
+  }
+};
+
+const huffman_decoder& decoder_tables() {
+  static const huffman_decoder tables;
+  return tables;
+}
+
+/**
+ * @brief Entero con prefijo de prefix_bits bits (sección 5.1).
+ */
+bool decode_integer(std::string_view& in, int prefix_bits, uint64_t& value) {
+  if (in.empty()) {
+    return false;
+  }
+  uint64_t limit = (uint64_t{1} << prefix_bits) - 1;
+  value = static_cast<uint8_t>(in.front()) & limit;
+  in.remove_prefix(1);
+  if (value < limit) {
+    return true;
+  }
+  for (int shift = 0; shift <= 56; shift += 7) {
+    if (in.empty()) {
+      return false;
+    }
+    auto byte = static_cast<uint8_t>(in.front());
+    in.remove_prefix(1);
+    value += uint64_t{byte & 0x7fu} << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;  // Más de lo que cabe en 64 bits
+}
+
+void encode_integer(std::string& out, uint8_t first, int prefix_bits,
+                    uint64_t value) {
+  uint64_t limit = (uint64_t{1} << prefix_bits) - 1;
+  if (value < limit) {
+    out.push_back(static_cast<char>(first | value));
+    return;
+  }
+  out.push_back(static_cast<char>(first | limit));
+  value -= limit;
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+/**
+ * @brief Cadena literal, en Huffman si el primer bit lo indica (5.2).
+ */
+std::expected<std::string, int> decode_string(std::string_view& in) {
+  if (in.empty()) {
+    return std::unexpected(EINVAL);
+  }
+  bool huffman = (static_cast<uint8_t>(in.front()) & 0x80) != 0;
+  uint64_t length = 0;
+  if (!decode_integer(in, 7, length) || length > in.size()) {
+    return std::unexpected(EINVAL);
+  }
+  std::string_view raw = in.substr(0, length);
+  in.remove_prefix(length);
+  if (huffman) {
+    return huffman_decode(raw);
+  }
+  return std::string(raw);
+}
+
+void encode_string(std::string& out, std::string_view text) {
+  encode_integer(out, 0x00, 7, text.size());
+  out.append(text);
+}
+
+constexpr size_t kEntryOverhead = 32;
+
+size_t entry_size(const header_field& field) {
+  return field.name.size() + field.value.size() + kEntryOverhead;
+}
+
+}  // namespace
+
+std::expected<std::string, int> huffman_decode(std::string_view encoded) {
+  const huffman_decoder& tables = decoder_tables();
+  std::string decoded;
+  uint32_t code = 0;
+  int bits = 0;
+  for (char c : encoded) {
+    auto byte = static_cast<uint8_t>(c);
+    for (int bit = 7; bit >= 0; --bit) {
+      code = (code << 1) | ((uint32_t{byte} >> bit) & 1u);
+      ++bits;
+      auto length = static_cast<size_t>(bits);
+      uint32_t offset = code - tables.first_code[length];
+      if (tables.count[length] != 0 && code >= tables.first_code[length] &&
+          offset < tables.count[length]) {
+        uint16_t symbol = tables.symbols[tables.first_symbol[length] + offset];
+        if (symbol == 256) {
+          return std::unexpected(EINVAL);  // EOS no puede ir en la cadena
+        }
+        decoded.push_back(static_cast<char>(symbol));
+        code = 0;
+        bits = 0;
+      } else if (bits == kMaxHuffmanBits) {
+        return std::unexpected(EINVAL);
+      }
+    }
+  }
+  // El relleno es el principio de EOS (todo unos) y no llega a un byte
+  if (bits > 7 || code != (uint32_t{1} << bits) - 1) {
+    return std::unexpected(EINVAL);
+  }
+  return decoded;
+}
+
+HpackDecoder::HpackDecoder(size_t max_table_size)
+    : max_table_size_(max_table_size), table_size_(max_table_size) {}
+
+const header_field* HpackDecoder::field(uint64_t index) const {
+  if (index == 0) {
+    return nullptr;
+  }
+  if (index <= kStaticTable.size()) {
+    return &kStaticTable[index - 1];
+  }
+  index -= kStaticTable.size() + 1;
+  return index < table_.size() ? &table_[index] : nullptr;
+}
+
+void HpackDecoder::evict_to(size_t size) {
+  while (used_ > size) {
+    used_ -= entry_size(table_.back());
+    table_.pop_back();
+  }
+}
+
+void HpackDecoder::insert(header_field field) {
+  size_t size = entry_size(field);
+  if (size > table_size_) {
+    evict_to(0);  // No cabe: la tabla se queda vacía (sección 4.4)
+    return;
+  }
+  evict_to(table_size_ - size);
+  used_ += size;
+  table_.push_front(std::move(field));
+}
+
+std::expected<std::vector<header_field>, int> HpackDecoder::decode(
+    std::string_view block, size_t max_list_size) {
+  std::vector<header_field> headers;
+  size_t list_size = 0;
+  bool fields_seen = false;
+  while (!block.empty()) {
+    auto first = static_cast<uint8_t>(block.front());
+    uint64_t index = 0;
+    if (first & 0x80) {
+      // Indexada (6.1)
+      if (!decode_integer(block, 7, index)) {
+        return std::unexpected(EINVAL);
+      }
+      const header_field* found = field(index);
+      if (found == nullptr) {
+        return std::unexpected(EINVAL);
+      }
+      headers.push_back(*found);
+    } else if ((first & 0xe0) == 0x20) {
+      // Cambio de tamaño de la tabla (6.3): solo al principio del bloque
+      if (fields_seen || !decode_integer(block, 5, index) ||
+          index > max_table_size_) {
+        return std::unexpected(EINVAL);
+      }
+      table_size_ = index;
+      evict_to(table_size_);
+      continue;
+    } else {
+      // Literal con indexado (6.2.1), sin indexar (6.2.2) o nunca (6.2.3)
+      bool indexed = (first & 0xc0) == 0x40;
+      if (!decode_integer(block, indexed ? 6 : 4, index)) {
+        return std::unexpected(EINVAL);
+      }
+      header_field literal;
+      if (index != 0) {
+        const header_field* found = field(index);
+        if (found == nullptr) {
+          return std::unexpected(EINVAL);
+        }
+        literal.name = found->name;
+      } else {
+        auto name = decode_string(block);
+        if (!name) {
+          return std::unexpected(name.error());
+        }
+        literal.name = std::move(name.value());
+      }
+      auto value = decode_string(block);
+      if (!value) {
+        return std::unexpected(value.error());
+      }
+      literal.value = std::move(value.value());
+      if (indexed) {
+        insert(literal);
+      }
+      headers.push_back(std::move(literal));
+    }
+    fields_seen = true;
+    list_size += entry_size(headers.back());
+    if (list_size > max_list_size) {
+      return std::unexpected(E2BIG);
+    }
+  }
+  return headers;
+}
+
+std::string hpack_encode(const std::vector<header_field>& headers) {
+  std::string out;
+  for (const auto& header : headers) {
+    size_t name_index = 0;
+    size_t full_index = 0;
+    for (size_t i = 0; i < kStaticTable.size() && full_index == 0; ++i) {
+      if (kStaticTable[i].name != header.name) {
+        continue;
+      }
+      if (name_index == 0) {
+        name_index = i + 1;
+      }
+      if (kStaticTable[i].value == header.value) {
+        full_index = i + 1;
+      }
+    }
+    if (full_index != 0) {
+      encode_integer(out, 0x80, 7, full_index);
+      continue;
+    }
+    encode_integer(out, 0x00, 4, name_index);
+    if (name_index == 0) {
+      encode_string(out, header.name);
+    }
+    encode_string(out, header.value);
+  }
+  return out;
+}
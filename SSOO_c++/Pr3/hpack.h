@@ -0,0 +1,86 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: hpack.h
+ * Referencias:
+ *     RFC 7541 (HPACK: Header Compression for HTTP/2)
+ */
+
+#ifndef HPACK_H
+#define HPACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Cabecera de HTTP/2 (nombre en minúsculas).
+ */
+struct header_field {
+  std::string name;
+  std::string value;
+};
+
+/**
+ * @brief Descompresor de bloques de cabeceras, uno por conexión.
+ *
+ * Entiende todas las representaciones (indexada, literales con y sin
+ * indexar, nunca indexada y cambio de tamaño de la tabla), con cadenas
+ * literales o en Huffman. Los errores son de compresión y dejan la tabla
+ * dinámica inservible: hay que cerrar la conexión.
+ */
+class HpackDecoder {
+ public:
+  /**
+   * @param max_table_size SETTINGS_HEADER_TABLE_SIZE anunciado (4096 por
+   * defecto); el codificador no puede pedir una tabla mayor.
+   */
+  explicit HpackDecoder(size_t max_table_size = 4096);
+
+  /**
+   * @brief Descomprime un bloque entero (HEADERS + CONTINUATION).
+   * @param max_list_size Suma de nombre + valor + 32 de todas las cabeceras
+   * que se admite.
+   * @return Las cabeceras, o EINVAL si el bloque no es válido y E2BIG si
+   * pasa de max_list_size.
+   */
+  std::expected<std::vector<header_field>, int> decode(
+      std::string_view block, size_t max_list_size = 65536);
+
+ private:
+  [[nodiscard]] const header_field* field(uint64_t index) const;
+  void insert(header_field field);
+  void evict_to(size_t size);
+
+  size_t max_table_size_;
+  size_t table_size_;  // Tamaño que ha fijado el codificador
+  size_t used_ = 0;
+  std::deque<header_field> table_;  // Delante, la más reciente
+};
+
+/**
+ * @brief Compresor de las cabeceras de respuesta.
+ *
+ * No usa la tabla dinámica (así no depende del tamaño que anuncie el
+ * cliente): cada cabecera va indexada si está entera en la tabla estática
+ * y, si no, literal sin indexar con el nombre de la tabla cuando está.
+ */
+std::string hpack_encode(const std::vector<header_field>& headers);
+
+/**
+ * @brief Decodifica una cadena en el código Huffman de HPACK.
+ * @return La cadena, o EINVAL si el código o el relleno no son válidos.
+ */
+std::expected<std::string, int> huffman_decode(std::string_view encoded);
+
+#endif  // HPACK_H
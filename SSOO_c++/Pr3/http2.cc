@@ -0,0 +1,563 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: http2.cc
+ * Referencias:
+ *     RFC 9113 (HTTP/2), RFC 7541 (HPACK)
+ */
+
+#include "http2.h"
+
+#include <algorithm>
+
+#include "docserver.h"
+#include "metrics.h"
+
+namespace {
+
+constexpr std::string_view kPreface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr size_t kFrameHeaderSize = 9;
+constexpr size_t kMaxFrameSize = 16384;  // El que se anuncia (el mínimo)
+constexpr uint32_t kMaxConcurrentStreams = 100;
+constexpr size_t kMaxHeaderBlock = 65536;
+constexpr int64_t kMaxWindow = 0x7fffffff;
+// DATA que se prepara de una vez, antes de esperar a que salga
+constexpr size_t kBatchBytes = 65536;
+
+// Tipos de trama (sección 6)
+constexpr uint8_t kData = 0x0;
+constexpr uint8_t kHeaders = 0x1;
+constexpr uint8_t kPriority = 0x2;
+constexpr uint8_t kRstStream = 0x3;
+constexpr uint8_t kSettings = 0x4;
+constexpr uint8_t kPushPromise = 0x5;
+constexpr uint8_t kPing = 0x6;
+constexpr uint8_t kGoAway = 0x7;
+constexpr uint8_t kWindowUpdate = 0x8;
+constexpr uint8_t kContinuation = 0x9;
+
+constexpr uint8_t kEndStream = 0x1;
+constexpr uint8_t kAck = 0x1;
+constexpr uint8_t kEndHeaders = 0x4;
+constexpr uint8_t kPadded = 0x8;
+constexpr uint8_t kPriorityFlag = 0x20;
+
+// Códigos de error (sección 7)
+constexpr uint32_t kNoError = 0x0;
+constexpr uint32_t kProtocolError = 0x1;
+constexpr uint32_t kFlowControlError = 0x3;
+constexpr uint32_t kStreamClosed = 0x5;
+constexpr uint32_t kFrameSizeError = 0x6;
+constexpr uint32_t kRefusedStream = 0x7;
+constexpr uint32_t kCompressionError = 0x9;
+constexpr uint32_t kHttp11Required = 0xd;
+
+uint32_t read_u32(std::string_view data) {
+  return static_cast<uint32_t>(static_cast<uint8_t>(data[0])) << 24 |
+         static_cast<uint32_t>(static_cast<uint8_t>(data[1])) << 16 |
+         static_cast<uint32_t>(static_cast<uint8_t>(data[2])) << 8 |
+         static_cast<uint32_t>(static_cast<uint8_t>(data[3]));
+}
+
+void append_u32(std::string& out, uint32_t value) {
+  out.push_back(static_cast<char>(value >> 24));
+  out.push_back(static_cast<char>(value >> 16));
+  out.push_back(static_cast<char>(value >> 8));
+  out.push_back(static_cast<char>(value));
+}
+
+void append_frame(std::string& out, uint8_t type, uint8_t flags,
+                  uint32_t stream_id, std::string_view payload) {
+  auto length = static_cast<uint32_t>(payload.size());
+  out.push_back(static_cast<char>(length >> 16));
+  out.push_back(static_cast<char>(length >> 8));
+  out.push_back(static_cast<char>(length));
+  out.push_back(static_cast<char>(type));
+  out.push_back(static_cast<char>(flags));
+  append_u32(out, stream_id & 0x7fffffff);
+  out.append(payload);
+}
+
+/**
+ * @brief Quita el relleno de una trama con PADDED.
+ */
+bool strip_padding(uint8_t flags, std::string_view& payload) {
+  if ((flags & kPadded) == 0) {
+    return true;
+  }
+  if (payload.empty()) {
+    return false;
+  }
+  auto padding = static_cast<uint8_t>(payload.front());
+  payload.remove_prefix(1);
+  if (padding > payload.size()) {
+    return false;
+  }
+  payload.remove_suffix(padding);
+  return true;
+}
+
+}  // namespace
+
+bool http2_is_preface(std::string_view request) {
+  return request.starts_with(kPreface.substr(0, 16));  // "PRI * HTTP/2.0\r\n"
+}
+
+void Http2Session::start(Connection& connection, h2_handler handler) {
+  auto session = std::unique_ptr<Http2Session>(
+      new Http2Session(connection, std::move(handler)));
+  Http2Session* raw = session.get();
+  connection.set_source(std::move(session));
+  connection.set_drained_callback([raw] { raw->pump(); });
+  connection.take_over(
+      [raw](Connection&, std::string_view data) { raw->on_data(data); });
+}
+
+Http2Session::Http2Session(Connection& connection, h2_handler handler)
+    : connection_(connection), handler_(std::move(handler)) {
+  print_verbose("HTTP/2: nueva sesión");
+  // Nuestros SETTINGS son lo primero que se envía
+  std::string settings;
+  auto setting = [&](uint16_t id, uint32_t value) {
+    settings.push_back(static_cast<char>(id >> 8));
+    settings.push_back(static_cast<char>(id));
+    append_u32(settings, value);
+  };
+  setting(0x3, kMaxConcurrentStreams);   // SETTINGS_MAX_CONCURRENT_STREAMS
+  setting(0x6, kMaxHeaderBlock);         // SETTINGS_MAX_HEADER_LIST_SIZE
+  append_frame(control_, kSettings, 0, 0, settings);
+}
+
+void Http2Session::on_data(std::string_view data) {
+  if (dead_) {
+    return;
+  }
+  in_.append(data);
+  std::string_view pending = in_;
+  if (!preface_done_) {
+    size_t compared = std::min(pending.size(), kPreface.size());
+    if (pending.substr(0, compared) != kPreface.substr(0, compared)) {
+      dead_ = true;
+      connection_.close();
+      return;
+    }
+    if (compared < kPreface.size()) {
+      return;
+    }
+    pending.remove_prefix(kPreface.size());
+    preface_done_ = true;
+  }
+
+  while (!dead_ && pending.size() >= kFrameHeaderSize) {
+    size_t length = read_u32(pending) >> 8;  // 24 bits
+    if (length > kMaxFrameSize) {
+      go_away(kFrameSizeError);
+      break;
+    }
+    if (pending.size() < kFrameHeaderSize + length) {
+      break;
+    }
+    auto type = static_cast<uint8_t>(pending[3]);
+    auto flags = static_cast<uint8_t>(pending[4]);
+    uint32_t stream_id = read_u32(pending.substr(5)) & 0x7fffffff;
+    std::string_view payload = pending.substr(kFrameHeaderSize, length);
+    pending.remove_prefix(kFrameHeaderSize + length);
+    if (!process_frame(type, flags, stream_id, payload)) {
+      break;
+    }
+  }
+  if (dead_) {
+    return;
+  }
+  in_.erase(0, in_.size() - pending.size());
+  pump();
+}
+
+bool Http2Session::process_frame(uint8_t type, uint8_t flags,
+                                 uint32_t stream_id,
+                                 std::string_view payload) {
+  // Un bloque de cabeceras no se puede interrumpir con otras tramas
+  if (continuing_ != 0 &&
+      (type != kContinuation || stream_id != continuing_)) {
+    go_away(kProtocolError);
+    return false;
+  }
+  switch (type) {
+    case kData:
+      return on_data_frame(flags, stream_id, payload);
+    case kHeaders:
+      return on_headers(flags, stream_id, payload);
+    case kContinuation:
+      if (continuing_ == 0) {
+        go_away(kProtocolError);
+        return false;
+      }
+      header_block_.append(payload);
+      if (header_block_.size() > kMaxHeaderBlock) {
+        go_away(kCompressionError);
+        return false;
+      }
+      return (flags & kEndHeaders) == 0 || end_headers(stream_id);
+    case kPriority:
+      if (stream_id == 0 || payload.size() != 5) {
+        go_away(stream_id == 0 ? kProtocolError : kFrameSizeError);
+        return false;
+      }
+      return true;
+    case kRstStream:
+      if (stream_id == 0 || payload.size() != 4) {
+        go_away(stream_id == 0 ? kProtocolError : kFrameSizeError);
+        return false;
+      }
+      streams_.erase(stream_id);  // Se quita de sending_ al llegarle el turno
+      return true;
+    case kSettings:
+      return on_settings(flags, stream_id, payload);
+    case kPushPromise:
+      go_away(kProtocolError);  // Un cliente no puede enviarlas
+      return false;
+    case kPing:
+      if (stream_id != 0 || payload.size() != 8) {
+        go_away(stream_id != 0 ? kProtocolError : kFrameSizeError);
+        return false;
+      }
+      if ((flags & kAck) == 0) {
+        append_frame(control_, kPing, kAck, 0, payload);
+      }
+      return true;
+    case kGoAway:
+      // El cliente no abrirá más streams: se cierra al acabar los que hay
+      peer_going_away_ = true;
+      return true;
+    case kWindowUpdate:
+      return on_window_update(stream_id, payload);
+    default:
+      return true;  // Los tipos desconocidos se ignoran (sección 5.5)
+  }
+}
+
+bool Http2Session::on_headers(uint8_t flags, uint32_t stream_id,
+                              std::string_view payload) {
+  if (stream_id == 0 || stream_id % 2 == 0 || !strip_padding(flags, payload)) {
+    go_away(kProtocolError);
+    return false;
+  }
+  if (flags & kPriorityFlag) {
+    if (payload.size() < 5) {
+      go_away(kFrameSizeError);
+      return false;
+    }
+    payload.remove_prefix(5);
+  }
+  if (stream_id <= last_stream_id_) {
+    // Solo peticiones sin cuerpo: un segundo bloque (trailers) no se admite
+    go_away(streams_.contains(stream_id) ? kProtocolError : kStreamClosed);
+    return false;
+  }
+  last_stream_id_ = stream_id;
+  header_block_.assign(payload);
+  block_end_stream_ = (flags & kEndStream) != 0;
+  if ((flags & kEndHeaders) == 0) {
+    continuing_ = stream_id;
+    return true;
+  }
+  return end_headers(stream_id);
+}
+
+bool Http2Session::end_headers(uint32_t stream_id) {
+  continuing_ = 0;
+  // El bloque se descomprime siempre, aunque el stream se rechace: la tabla
+  // dinámica es de toda la conexión
+  auto headers = decoder_.decode(header_block_, kMaxHeaderBlock);
+  header_block_.clear();
+  if (!headers) {
+    go_away(kCompressionError);
+    return false;
+  }
+  if (peer_going_away_ || streams_.size() >= kMaxConcurrentStreams) {
+    reset_stream(stream_id, kRefusedStream);
+    return true;
+  }
+  stream s;
+  s.window = initial_window_;
+  s.request_done = block_end_stream_;
+  for (const auto& header : headers.value()) {
+    if (header.name == ":method") {
+      s.method = header.value;
+    } else if (header.name == ":path") {
+      s.path = header.value;
+    }
+  }
+  if (s.method.empty() || s.path.empty()) {
+    reset_stream(stream_id, kProtocolError);
+    return true;
+  }
+  metrics_count(metric_counter::requests);
+  print_verbose("HTTP/2: petición " + s.method + " " + s.path + " (stream " +
+                std::to_string(stream_id) + ")");
+  bool ready = s.request_done;
+  streams_.emplace(stream_id, std::move(s));
+  if (ready) {
+    respond(stream_id);
+  }
+  return true;
+}
+
+bool Http2Session::on_data_frame(uint8_t flags, uint32_t stream_id,
+                                 std::string_view payload) {
+  if (stream_id == 0) {
+    go_away(kProtocolError);
+    return false;
+  }
+  // El cuerpo no se usa, pero cuenta para el control de flujo: se devuelve
+  // la ventana en seguida para que el cliente no se quede parado
+  auto consumed = static_cast<uint32_t>(payload.size());
+  if (consumed != 0) {
+    std::string increment;
+    append_u32(increment, consumed);
+    append_frame(control_, kWindowUpdate, 0, 0, increment);
+  }
+  if (!strip_padding(flags, payload)) {
+    go_away(kProtocolError);
+    return false;
+  }
+  auto it = streams_.find(stream_id);
+  if (it == streams_.end() || it->second.request_done) {
+    reset_stream(stream_id, kStreamClosed);
+    return true;
+  }
+  if (consumed != 0) {
+    std::string increment;
+    append_u32(increment, consumed);
+    append_frame(control_, kWindowUpdate, 0, stream_id, increment);
+  }
+  if (flags & kEndStream) {
+    it->second.request_done = true;
+    respond(stream_id);
+  }
+  return true;
+}
+
+bool Http2Session::on_settings(uint8_t flags, uint32_t stream_id,
+                               std::string_view payload) {
+  if (stream_id != 0) {
+    go_away(kProtocolError);
+    return false;
+  }
+  if (flags & kAck) {
+    if (!payload.empty()) {
+      go_away(kFrameSizeError);
+      return false;
+    }
+    return true;
+  }
+  if (payload.size() % 6 != 0) {
+    go_away(kFrameSizeError);
+    return false;
+  }
+  for (; !payload.empty(); payload.remove_prefix(6)) {
+    auto id = static_cast<uint16_t>(static_cast<uint8_t>(payload[0]) << 8 |
+                                    static_cast<uint8_t>(payload[1]));
+    uint32_t value = read_u32(payload.substr(2));
+    switch (id) {
+      case 0x2:  // SETTINGS_ENABLE_PUSH
+        if (value > 1) {
+          go_away(kProtocolError);
+          return false;
+        }
+        break;
+      case 0x4: {  // SETTINGS_INITIAL_WINDOW_SIZE
+        if (value > kMaxWindow) {
+          go_away(kFlowControlError);
+          return false;
+        }
+        // Cambia la ventana de todos los streams en la diferencia
+        int64_t delta = static_cast<int64_t>(value) - initial_window_;
+        initial_window_ = value;
+        for (auto& [other, s] : streams_) {
+          s.window += delta;
+          if (s.window > kMaxWindow) {
+            go_away(kFlowControlError);
+            return false;
+          }
+        }
+        for (auto& [other, s] : streams_) {
+          queue(other, s);
+        }
+        break;
+      }
+      case 0x5:  // SETTINGS_MAX_FRAME_SIZE
+        if (value < 16384 || value > 16777215) {
+          go_away(kProtocolError);
+          return false;
+        }
+        peer_max_frame_ = value;
+        break;
+      default:
+        break;  // SETTINGS_HEADER_TABLE_SIZE no importa: no se usa la tabla
+    }
+  }
+  append_frame(control_, kSettings, kAck, 0, {});
+  return true;
+}
+
+bool Http2Session::on_window_update(uint32_t stream_id,
+                                    std::string_view payload) {
+  if (payload.size() != 4) {
+    go_away(kFrameSizeError);
+    return false;
+  }
+  int64_t increment = read_u32(payload) & 0x7fffffff;
+  if (stream_id == 0) {
+    if (increment == 0 || connection_window_ + increment > kMaxWindow) {
+      go_away(increment == 0 ? kProtocolError : kFlowControlError);
+      return false;
+    }
+    connection_window_ += increment;
+    return true;
+  }
+  auto it = streams_.find(stream_id);
+  if (it == streams_.end()) {
+    return true;  // Ya terminado: puede llegar tarde
+  }
+  if (increment == 0 || it->second.window + increment > kMaxWindow) {
+    reset_stream(stream_id,
+                 increment == 0 ? kProtocolError : kFlowControlError);
+    return true;
+  }
+  it->second.window += increment;
+  queue(stream_id, it->second);
+  return true;
+}
+
+void Http2Session::respond(uint32_t stream_id) {
+  stream& s = streams_.at(stream_id);
+  h2_response response;
+  if (s.method == "GET" || s.method == "HEAD") {
+    response = handler_(s.path);
+  } else {
+    response.status = 405;
+    response.headers.push_back({"allow", "GET, HEAD"});
+  }
+  if (response.needs_http1) {
+    reset_stream(stream_id, kHttp11Required);
+    return;
+  }
+
+  s.file = std::move(response.file);
+  s.body = std::move(response.body);
+  std::string_view body = s.file ? s.file->get() : std::string_view(s.body);
+  connection_.begin_response(response.status);
+  std::vector<header_field> headers = {
+      {":status", std::to_string(response.status)},
+      {"content-length", std::to_string(body.size())}};
+  for (auto& header : response.headers) {
+    headers.push_back(std::move(header));
+  }
+  bool head_only = s.method == "HEAD" || body.empty();
+  append_frame(control_, kHeaders,
+               static_cast<uint8_t>(kEndHeaders | (head_only ? kEndStream : 0)),
+               stream_id, hpack_encode(headers));
+  s.responded = true;
+  if (head_only) {
+    streams_.erase(stream_id);
+    return;
+  }
+  connection_.count_body_bytes(body.size());
+  s.pending = body;
+  queue(stream_id, s);
+}
+
+void Http2Session::queue(uint32_t stream_id, stream& s) {
+  if (!s.queued && s.responded && !s.pending.empty() && s.window > 0) {
+    s.queued = true;
+    sending_.push_back(stream_id);
+  }
+}
+
+void Http2Session::reset_stream(uint32_t stream_id, uint32_t error) {
+  std::string code;
+  append_u32(code, error);
+  append_frame(control_, kRstStream, 0, stream_id, code);
+  streams_.erase(stream_id);
+}
+
+void Http2Session::go_away(uint32_t error) {
+  if (dead_) {
+    return;
+  }
+  std::string payload;
+  append_u32(payload, last_stream_id_);
+  append_u32(payload, error);
+  append_frame(control_, kGoAway, 0, 0, payload);
+  std::string out = std::move(control_);
+  control_.clear();
+  dead_ = true;
+  print_verbose("HTTP/2: GOAWAY con error " + std::to_string(error));
+  connection_.write(out);
+  connection_.finish();
+}
+
+void Http2Session::pump() {
+  // write() puede acabar llamando otra vez a pump() al vaciarse
+  if (pumping_) {
+    pump_again_ = true;
+    return;
+  }
+  pumping_ = true;
+  do {
+    pump_again_ = false;
+    pump_once();
+  } while (pump_again_ && !dead_ && !connection_.closed());
+  pumping_ = false;
+}
+
+void Http2Session::pump_once() {
+  if (dead_ || connection_.closed()) {
+    return;
+  }
+  std::string out = std::move(control_);
+  control_.clear();
+  // Solo se preparan más DATA cuando ha salido lo anterior: lo que espera
+  // en la conexión ya no se puede reordenar
+  if (connection_.drained()) {
+    while (out.size() < kBatchBytes && connection_window_ > 0 &&
+           !sending_.empty()) {
+      uint32_t stream_id = sending_.front();
+      sending_.pop_front();
+      auto it = streams_.find(stream_id);
+      if (it == streams_.end()) {
+        continue;  // Cancelado con RST_STREAM
+      }
+      stream& s = it->second;
+      s.queued = false;
+      auto length = static_cast<size_t>(
+          std::min({static_cast<int64_t>(s.pending.size()),
+                    static_cast<int64_t>(peer_max_frame_), connection_window_,
+                    s.window}));
+      bool last = length == s.pending.size();
+      append_frame(out, kData, last ? kEndStream : 0, stream_id,
+                   s.pending.substr(0, length));
+      s.pending.remove_prefix(length);
+      s.window -= static_cast<int64_t>(length);
+      connection_window_ -= static_cast<int64_t>(length);
+      if (last) {
+        streams_.erase(it);
+      } else {
+        queue(stream_id, s);  // Al final de la cola: turno del siguiente
+      }
+    }
+  }
+  if (!out.empty()) {
+    connection_.write(out);
+  }
+  if (peer_going_away_ && streams_.empty()) {
+    go_away(kNoError);
+  }
+}
@@ -0,0 +1,133 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: http2.h
+ * Referencias:
+ *     RFC 9113 (HTTP/2), RFC 7541 (HPACK)
+ */
+
+#ifndef HTTP2_H
+#define HTTP2_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "connection.h"
+#include "hpack.h"
+#include "safe_map.h"
+
+/**
+ * @brief Respuesta a una petición de HTTP/2.
+ */
+struct h2_response {
+  int status = 200;
+  std::vector<header_field> headers;  // Además de :status y content-length
+  std::string body;                   // Si no hay file
+  std::shared_ptr<const SafeMap> file;  // Cuerpo mapeado, sin copiarlo antes
+  bool needs_http1 = false;  // Se rechaza con HTTP_1_1_REQUIRED
+};
+
+/**
+ * @brief Atiende una petición GET (o HEAD) de path.
+ */
+using h2_handler = std::function<h2_response(std::string_view path)>;
+
+/**
+ * @brief true si la petición es el prefacio de una conexión HTTP/2 con
+ * conocimiento previo ("PRI * HTTP/2.0").
+ */
+bool http2_is_preface(std::string_view request);
+
+/**
+ * @brief Sesión HTTP/2 sin TLS (h2c) sobre una conexión.
+ *
+ * Muchas peticiones comparten la conexión, cada una en su stream. Las
+ * cabeceras van con HPACK; los cuerpos salen en tramas DATA que se
+ * intercalan por turnos entre los streams que tienen algo que enviar, así
+ * que un archivo grande no retiene a los pequeños. Se respeta el control de
+ * flujo del cliente (ventana de la conexión y de cada stream) y solo se
+ * preparan tramas nuevas cuando la conexión ha enviado lo anterior.
+ *
+ * La respuesta de cada stream se genera al recibir su petición entera; no
+ * hay push ni prioridades (las tramas PRIORITY se ignoran).
+ */
+class Http2Session : public ResponseSource {
+ public:
+  /**
+   * @brief Pasa la conexión a HTTP/2. La sesión queda como fuente de la
+   * conexión, que la mantiene viva hasta cerrarse.
+   */
+  static void start(Connection& connection, h2_handler handler);
+
+  void abort() override { dead_ = true; }
+
+ private:
+  struct stream {
+    int64_t window = 0;  // Bytes que se pueden enviar en DATA
+    bool request_done = false;  // Llegó END_STREAM del cliente
+    bool responded = false;
+    bool queued = false;  // Está en sending_
+    std::string method;
+    std::string path;
+    std::shared_ptr<const SafeMap> file;
+    std::string body;
+    std::string_view pending;  // Lo que falta del cuerpo
+  };
+
+  Http2Session(Connection& connection, h2_handler handler);
+
+  void on_data(std::string_view data);
+  bool process_frame(uint8_t type, uint8_t flags, uint32_t stream_id,
+                     std::string_view payload);
+  bool on_headers(uint8_t flags, uint32_t stream_id, std::string_view payload);
+  bool on_data_frame(uint8_t flags, uint32_t stream_id,
+                     std::string_view payload);
+  bool on_settings(uint8_t flags, uint32_t stream_id,
+                   std::string_view payload);
+  bool on_window_update(uint32_t stream_id, std::string_view payload);
+  bool end_headers(uint32_t stream_id);
+  void respond(uint32_t stream_id);
+  void reset_stream(uint32_t stream_id, uint32_t error);
+  void go_away(uint32_t error);
+  void queue(uint32_t stream_id, stream& s);
+  void pump();
+  void pump_once();
+
+  Connection& connection_;
+  h2_handler handler_;
+  HpackDecoder decoder_;
+  std::string in_;  // Recibido sin procesar
+  bool preface_done_ = false;
+  bool dead_ = false;  // Conexión cerrada o GOAWAY enviado
+  bool peer_going_away_ = false;
+
+  std::string control_;  // Tramas que salen antes que los DATA pendientes
+  bool pumping_ = false;
+  bool pump_again_ = false;
+
+  std::unordered_map<uint32_t, stream> streams_;
+  std::deque<uint32_t> sending_;  // Turno de los streams con DATA que enviar
+  uint32_t last_stream_id_ = 0;
+  uint32_t continuing_ = 0;  // Stream cuyas CONTINUATION se esperan
+  std::string header_block_;
+  bool block_end_stream_ = false;
+
+  int64_t connection_window_ = 65535;
+  int64_t initial_window_ = 65535;  // SETTINGS_INITIAL_WINDOW_SIZE del cliente
+  size_t peer_max_frame_ = 16384;
+};
+
+#endif  // HTTP2_H
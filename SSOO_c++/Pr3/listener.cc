@@ -0,0 +1,199 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: listener.cc
+ * Referencias:
+ *     Enunciado de la práctica
+ *     man 7 unix, man 7 ip
+ */
+
+#include "listener.h"
+
+#include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <format>
+#include <iostream>
+
+#include "docserver.h"
+
+namespace {
+
+std::expected<uint16_t, int> parse_port(std::string_view text) {
+  unsigned value = 0;
+  auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc() || end != text.data() + text.size() ||
+      value == 0 || value > 65535) {
+    return std::unexpected(EINVAL);
+  }
+  return static_cast<uint16_t>(value);
+}
+
+void set_option(int fd, int level, int name, const char* label, int value,
+                const listen_address& address) {
+  if (setsockopt(fd, level, name, &value, sizeof(value)) < 0) {
+    std::cerr << "Error: cannot set " << label << " on "
+              << address.to_string() << ": " << std::strerror(errno) << "\n";
+  }
+}
+
+void apply_tuning(int fd, const listen_address& address,
+                  const socket_tuning& tuning) {
+  if (tuning.sndbuf != 0) {
+    set_option(fd, SOL_SOCKET, SO_SNDBUF, "SO_SNDBUF", tuning.sndbuf, address);
+  }
+  if (address.family != AF_INET) {
+    return;  // El resto son de TCP
+  }
+  if (tuning.defer_accept_s != 0) {
+    set_option(fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, "TCP_DEFER_ACCEPT",
+               tuning.defer_accept_s, address);
+  }
+  if (tuning.fastopen_queue != 0) {
+    set_option(fd, IPPROTO_TCP, TCP_FASTOPEN, "TCP_FASTOPEN",
+               tuning.fastopen_queue, address);
+  }
+  if (tuning.nodelay) {
+    set_option(fd, IPPROTO_TCP, TCP_NODELAY, "TCP_NODELAY", 1, address);
+  }
+  if (tuning.notsent_lowat != 0) {
+    set_option(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, "TCP_NOTSENT_LOWAT",
+               tuning.notsent_lowat, address);
+  }
+  if (tuning.busy_poll_us != 0) {
+    set_option(fd, SOL_SOCKET, SO_BUSY_POLL, "SO_BUSY_POLL",
+               tuning.busy_poll_us, address);
+  }
+}
+
+}  // namespace
+
+socklen_t unix_address(const std::string& path, sockaddr_un& address) {
+  address = {};
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.data(), path.size());
+  if (path.front() == '@') {
+    address.sun_path[0] = '\0';
+    return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) +
+                                  path.size());
+  }
+  return sizeof(address);
+}
+
+void remove_stale_socket(const std::string& path) {
+  // Solo se borra si es un socket, nunca otro tipo de archivo
+  struct stat info{};
+  if (path.front() != '@' && lstat(path.c_str(), &info) == 0 &&
+      S_ISSOCK(info.st_mode)) {
+    unlink(path.c_str());
+  }
+}
+
+std::string listen_address::to_string() const {
+  if (family == AF_UNIX) {
+    return "unix:" + path;
+  }
+  in_addr address{};
+  address.s_addr = host;
+  return std::format("{}:{}", inet_ntoa(address), port);
+}
+
+std::expected<listen_address, int> parse_listen_address(std::string_view text) {
+  listen_address result;
+  if (text.starts_with("unix:")) {
+    text.remove_prefix(5);
+    // Cabe en sun_path con su '\0' (o con el '\0' inicial si es abstracto)
+    if (text.empty() || text == "@" ||
+        text.size() >= sizeof(sockaddr_un::sun_path)) {
+      return std::unexpected(EINVAL);
+    }
+    result.family = AF_UNIX;
+    result.path = text;
+    return result;
+  }
+
+  std::string_view port_text = text;
+  if (size_t colon = text.rfind(':'); colon != std::string_view::npos) {
+    std::string host(text.substr(0, colon));
+    port_text = text.substr(colon + 1);
+    if (host != "*" && inet_pton(AF_INET, host.c_str(), &result.host) != 1) {
+      return std::unexpected(EINVAL);
+    }
+  }
+  auto parsed_port = parse_port(port_text);
+  if (!parsed_port) {
+    return std::unexpected(parsed_port.error());
+  }
+  result.port = parsed_port.value();
+  return result;
+}
+
+std::expected<SafeFD, int> open_listener(const listen_address& address,
+                                         int backlog,
+                                         const socket_tuning& tuning) {
+  // CLOEXEC: los programas de /bin no deben heredar los sockets
+  SafeFD fd(socket(address.family, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+                   0));
+  if (!fd.is_valid()) {
+    print_verbose("Error al crear el socket");
+    return std::unexpected(errno);
+  }
+  print_verbose("Make_socket: Socket creado");
+
+  int result = 0;
+  if (address.family == AF_UNIX) {
+    // Un socket que quedó de una ejecución anterior impide el bind
+    remove_stale_socket(address.path);
+    sockaddr_un local_address{};
+    socklen_t length = unix_address(address.path, local_address);
+    result = bind(fd.get(), reinterpret_cast<sockaddr*>(&local_address),
+                  length);
+  } else {
+    int opt = 1;
+    setsockopt(fd.get(), SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    print_verbose("Setsockopt: Socket configurado");
+
+    sockaddr_in local_address{};
+    local_address.sin_family = AF_INET;
+    local_address.sin_addr.s_addr = address.host;
+    local_address.sin_port = htons(address.port);
+    result = bind(fd.get(), reinterpret_cast<sockaddr*>(&local_address),
+                  sizeof(local_address));
+  }
+  if (result < 0) {
+    print_verbose("Error al enlazar el socket");
+    return std::unexpected(errno);
+  }
+  print_verbose("Bind: Socket enlazado");
+  apply_tuning(fd.get(), address, tuning);
+
+  if (listen(fd.get(), backlog) < 0) {
+    print_verbose("Error al escuchar conexiones");
+    return std::unexpected(errno);
+  }
+  print_verbose("Listen: Escuchando conexiones");
+  return fd;
+}
+
+int adopt_listener(const SafeFD& socket, const listen_address& address,
+                   int backlog, const socket_tuning& tuning) {
+  apply_tuning(socket.get(), address, tuning);
+  // Sobre un socket que ya escucha, listen() solo cambia la cola
+  if (listen(socket.get(), backlog) < 0) {
+    return errno;
+  }
+  return 0;
+}
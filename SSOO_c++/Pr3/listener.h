@@ -0,0 +1,99 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: listener.h
+ * Referencias:
+ *     Enunciado de la práctica
+ *     man 7 unix, man 7 ip
+ */
+
+#ifndef LISTENER_H
+#define LISTENER_H
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <string_view>
+
+#include "safe_fd.h"
+
+/**
+ * @brief Dirección en la que escucha el servidor. Se escribe como:
+ *   <puerto>             TCP en todas las interfaces
+ *   <ipv4>:<puerto>      TCP en una interfaz ("*:<puerto>" = todas)
+ *   unix:<ruta>          Socket Unix en el sistema de archivos
+ *   unix:@<nombre>       Socket Unix en el espacio abstracto de Linux
+ */
+struct listen_address {
+  sa_family_t family = AF_INET;
+  in_addr_t host = INADDR_ANY;  // En orden de red
+  uint16_t port = 0;
+  std::string path;  // Con '@' delante si es abstracto
+
+  [[nodiscard]] std::string to_string() const;
+};
+
+/**
+ * @brief Opciones de los sockets TCP (0 / false = la del sistema). Se ponen
+ * en el socket que escucha y Linux las copia a cada socket aceptado, así que
+ * no cuestan llamadas por conexión.
+ */
+struct socket_tuning {
+  int defer_accept_s = 0;  // TCP_DEFER_ACCEPT: no despertar hasta tener datos
+  int fastopen_queue = 0;  // TCP_FASTOPEN: datos en el SYN, con esta cola
+  bool nodelay = false;    // TCP_NODELAY: sin Nagle
+  bool cork = false;       // TCP_CORK alrededor de cabeceras + cuerpo
+  int sndbuf = 0;          // SO_SNDBUF en bytes
+  int notsent_lowat = 0;   // TCP_NOTSENT_LOWAT en bytes
+  int busy_poll_us = 0;    // SO_BUSY_POLL en microsegundos
+};
+
+/**
+ * @brief Interpreta una dirección de --listen.
+ * @return La dirección, o EINVAL si no se entiende.
+ */
+std::expected<listen_address, int> parse_listen_address(std::string_view text);
+
+/**
+ * @brief Crea el socket, lo enlaza a la dirección y se pone a escuchar. Un
+ * socket Unix viejo que quedó en la ruta se borra antes. Las opciones de
+ * tuning que no se pueden poner (SO_BUSY_POLL sin permisos, por ejemplo) se
+ * avisan por la salida de errores y no impiden escuchar.
+ * @return El socket (no bloqueante y con CLOEXEC), o el errno del fallo.
+ */
+std::expected<SafeFD, int> open_listener(const listen_address& address,
+                                         int backlog,
+                                         const socket_tuning& tuning = {});
+
+/**
+ * @brief Usa un socket que ya escucha (recibido de otro proceso en un
+ * reinicio en caliente) con la cola y las opciones de esta ejecución.
+ * @return 0 o el errno del fallo.
+ */
+int adopt_listener(const SafeFD& socket, const listen_address& address,
+                   int backlog, const socket_tuning& tuning = {});
+
+/**
+ * @brief Rellena la sockaddr_un de una ruta ("@nombre" = espacio
+ * abstracto) y devuelve su longitud útil: en el espacio abstracto el nombre
+ * no acaba en '\0' y la longitud cuenta.
+ */
+socklen_t unix_address(const std::string& path, sockaddr_un& address);
+
+/**
+ * @brief Borra el socket Unix que quedó en la ruta de una ejecución
+ * anterior. No toca otros tipos de archivo ni los nombres abstractos.
+ */
+void remove_stale_socket(const std::string& path);
+
+#endif  // LISTENER_H
@@ -0,0 +1,607 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: loadgen.cc
+ * Referencias:
+ *     Gil Tene, "How NOT to measure latency" (omisión coordinada)
+ */
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <expected>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "metrics.h"
+#include "tools_common.h"
+
+/**
+ * Generador de carga para docserver.
+ *
+ * - Lazo cerrado (por defecto): cada conexión lanza la siguiente petición en
+ *   cuanto termina la anterior.
+ * - Lazo abierto (-r <peticiones/s>): las peticiones se programan a ritmo
+ *   constante; la latencia se mide desde el instante en que *debía* salir la
+ *   petición, de modo que si el servidor se atasca las esperas cuentan.
+ *
+ * Ejemplo: ./loadgen -p 8080 -c 64 -d 10 -r 20000 -l rutas.txt
+ */
+
+/**
+ * @brief Opciones del generador de carga.
+ */
+struct loadgen_options {
+  bool flag_h = false;
+  std::string host = "127.0.0.1";
+  uint16_t port = 8080;
+  unsigned connections = 16;
+  double duration = 10.0;  // Segundos
+  uint64_t requests = 0;   // 0: sin límite, manda la duración
+  double rate = 0.0;       // Peticiones por segundo; 0: lazo cerrado
+  std::string path_list;
+  std::string sizes;
+  std::string size_prefix = "/sizes/";
+  uint64_t seed = 1;
+  bool json = false;
+};
+
+/**
+ * @brief Ruta a pedir y su peso acumulado para elegirla al azar.
+ */
+struct weighted_path {
+  std::string path;
+  double cumulative_weight;
+};
+
+/**
+ * @brief Estado de una conexión del generador.
+ */
+struct client_connection {
+  enum class state { idle, connecting, sending, receiving };
+
+  int fd = -1;
+  state current = state::idle;
+  std::string request;
+  size_t sent = 0;
+  std::string head;  // Primeros bytes de la respuesta, para la cabecera
+  uint64_t received = 0;
+  uint64_t expected = 0;  // Bytes totales esperados (0: hasta EOF)
+  uint64_t intended_ns = 0;
+  uint64_t start_ns = 0;
+};
+
+/**
+ * @brief Resultados acumulados de la prueba.
+ */
+struct loadgen_results {
+  uint64_t completed = 0;
+  uint64_t errors = 0;
+  uint64_t bytes = 0;
+  uint64_t max_latency = 0;
+  LogLinearHistogram latency;  // Desde el instante previsto (corregida)
+  LogLinearHistogram service;  // Desde que se abrió la conexión
+};
+
+void Usage(char* argv[]) {
+  std::cout << "Usage: " << argv[0]
+            << " [-H <host>] [-p <port>] [-c <connections>] [-d <seconds>]"
+            << " [-n <requests>] [-r <req/s>] [-l <path list> |"
+            << " -z <size:weight,...>] [--prefix <path>] [--seed <n>]"
+            << " [--json]\n";
+  std::cout << "Options:\n";
+  std::cout << "  -H, --host         Server address (default 127.0.0.1)\n";
+  std::cout << "  -p, --port         Server port (default 8080)\n";
+  std::cout << "  -c, --connections  Concurrent connections (default 16)\n";
+  std::cout << "  -d, --duration     Test length in seconds (default 10)\n";
+  std::cout << "  -n, --requests     Stop after this many requests\n";
+  std::cout << "  -r, --rate         Open loop at this constant rate; latency"
+               " is measured from the scheduled send time\n";
+  std::cout << "  -l, --paths        File with one \"<path> [weight]\" per"
+               " line\n";
+  std::cout << "  -z, --sizes        Size distribution, e.g."
+               " \"1k:50,64k:30,1m:20\"; requests <prefix><bytes>\n";
+  std::cout << "      --prefix       Path prefix for -z (default /sizes/)\n";
+  std::cout << "      --seed         Random seed (default 1)\n";
+  std::cout << "      --json         Print the results as JSON\n";
+}
+
+std::expected<loadgen_options, std::string> parse_args(int argc,
+                                                       char* argv[]) {
+  std::vector<std::string_view> args(argv + 1, argv + argc);
+  loadgen_options options;
+
+  for (auto it = args.begin(), end = args.end(); it != end; ++it) {
+    std::string_view option = *it;
+    auto value = [&]() -> std::expected<std::string, std::string> {
+      if (++it == end) {
+        return std::unexpected(std::format("missing value for {}", option));
+      }
+      return std::string(*it);
+    };
+    try {
+      if (option == "-h" || option == "--help") {
+        options.flag_h = true;
+      } else if (option == "--json") {
+        options.json = true;
+      } else if (option == "-H" || option == "--host") {
+        auto v = value();
+        if (!v) return std::unexpected(v.error());
+        options.host = *v;
+      } else if (option == "-p" || option == "--port") {
+        auto v = value();
+        if (!v) return std::unexpected(v.error());
+        int port_number = std::stoi(*v);
+        if (port_number < 1 || port_number > 65535) {
+          return std::unexpected("port out of bounds");
+        }
+        options.port = static_cast<uint16_t>(port_number);
+      } else if (option == "-c" || option == "--connections") {
+        auto v = value();
+        if (!v) return std::unexpected(v.error());
+        options.connections = static_cast<unsigned>(std::stoul(*v));
+      } else if (option == "-d" || option == "--duration") {
+        auto v = value();
+        if (!v) return std::unexpected(v.error());
+        options.duration = std::stod(*v);
+      } else if (option == "-n" || option == "--requests") {
+        auto v = value();
+        if (!v) return std::unexpected(v.error());
+        options.requests = std::stoull(*v);
+      } else if (option == "-r" || option == "--rate") {
+        auto v = value();
+        if (!v) return std::unexpected(v.error());
+        options.rate = std::stod(*v);
+      } else if (option == "-l" || option == "--paths") {
+        auto v = value();
+        if (!v) return std::unexpected(v.error());
+        options.path_list = *v;
+      } else if (option == "-z" || option == "--sizes") {
+        auto v = value();
+        if (!v) return std::unexpected(v.error());
+        options.sizes = *v;
+      } else if (option == "--prefix") {
+        auto v = value();
+        if (!v) return std::unexpected(v.error());
+        options.size_prefix = *v;
+      } else if (option == "--seed") {
+        auto v = value();
+        if (!v) return std::unexpected(v.error());
+        options.seed = std::stoull(*v);
+      } else {
+        return std::unexpected(std::format("unknown option {}", option));
+      }
+    } catch (const std::exception&) {
+      return std::unexpected(std::format("invalid value for {}", option));
+    }
+  }
+  if (options.connections == 0) {
+    return std::unexpected("at least one connection is needed");
+  }
+  return options;
+}
+
+/**
+ * @brief Construye la lista de rutas a pedir a partir de -l o de -z.
+ */
+std::expected<std::vector<weighted_path>, std::string> load_paths(
+    const loadgen_options& options) {
+  std::vector<weighted_path> paths;
+  double total = 0.0;
+  auto add = [&](std::string path, double weight) {
+    total += weight;
+    paths.push_back({std::move(path), total});
+  };
+
+  if (!options.path_list.empty()) {
+    std::ifstream file(options.path_list);
+    if (!file) {
+      return std::unexpected(
+          std::format("cannot open {}", options.path_list));
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+      if (line.empty() || line.front() == '#') {
+        continue;
+      }
+      std::istringstream iss(line);
+      std::string path;
+      double weight = 1.0;
+      iss >> path >> weight;
+      add(path, weight > 0 ? weight : 1.0);
+    }
+  } else if (!options.sizes.empty()) {
+    std::string_view spec = options.sizes;
+    while (!spec.empty()) {
+      size_t comma = spec.find(',');
+      std::string_view item = spec.substr(0, comma);
+      spec = comma == std::string_view::npos ? std::string_view()
+                                             : spec.substr(comma + 1);
+      size_t colon = item.find(':');
+      auto size = parse_size(item.substr(0, colon));
+      if (!size) {
+        return std::unexpected(std::format("invalid size in {}", item));
+      }
+      double weight = colon == std::string_view::npos
+                          ? 1.0
+                          : std::stod(std::string(item.substr(colon + 1)));
+      add(options.size_prefix + std::to_string(*size), weight);
+    }
+  } else {
+    add("/index.html", 1.0);
+  }
+  if (paths.empty()) {
+    return std::unexpected("the path list is empty");
+  }
+  return paths;
+}
+
+/**
+ * @brief Elige una ruta según los pesos.
+ */
+const std::string& pick_path(const std::vector<weighted_path>& paths,
+                             std::mt19937_64& rng) {
+  std::uniform_real_distribution<double> uniform(
+      0.0, paths.back().cumulative_weight);
+  double x = uniform(rng);
+  auto it = std::upper_bound(
+      paths.begin(), paths.end(), x,
+      [](double v, const weighted_path& p) { return v < p.cumulative_weight; });
+  return it == paths.end() ? paths.back().path : it->path;
+}
+
+/**
+ * @brief Abre una conexión no bloqueante; el connect() termina en epoll.
+ */
+int start_connect(const sockaddr_in& address) {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  if (connect(fd, reinterpret_cast<const sockaddr*>(&address),
+              sizeof(address)) < 0 &&
+      errno != EINPROGRESS) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * @brief Examina la cabecera recibida. Las respuestas correctas empiezan por
+ * "Content-Length:" y las de error por su código ("404 Not Found").
+ * @return false si la respuesta es un error.
+ */
+bool parse_head(client_connection& conn) {
+  if (!conn.head.empty() && conn.head[0] >= '0' && conn.head[0] <= '9') {
+    return false;
+  }
+  size_t end_of_head = conn.head.find("\r\n\r\n");
+  if (end_of_head == std::string::npos) {
+    return true;  // Aún no ha llegado entera
+  }
+  constexpr std::string_view kContentLength = "Content-Length:";
+  size_t pos = conn.head.find(kContentLength);
+  if (pos != std::string::npos && pos < end_of_head) {
+    try {
+      conn.expected = end_of_head + 4 + std::stoull(conn.head.substr(
+                                            pos + kContentLength.size()));
+    } catch (const std::exception&) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  auto parsed = parse_args(argc, argv);
+  if (!parsed) {
+    std::cerr << "Error: " << parsed.error() << "\n";
+    return EXIT_FAILURE;
+  }
+  const loadgen_options& options = *parsed;
+  if (options.flag_h) {
+    Usage(argv);
+    return EXIT_SUCCESS;
+  }
+  auto paths = load_paths(options);
+  if (!paths) {
+    std::cerr << "Error: " << paths.error() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(options.port);
+  if (inet_pton(AF_INET, options.host.c_str(), &address.sin_addr) != 1) {
+    std::cerr << "Error: invalid host address\n";
+    return EXIT_FAILURE;
+  }
+
+  int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (epoll_fd < 0 || timer_fd < 0) {
+    std::cerr << "Error: " << std::strerror(errno) << "\n";
+    return EXIT_FAILURE;
+  }
+  // El timerfd despierta el bucle cuando toca la siguiente petición
+  // programada; se identifica en epoll con el índice -1.
+  epoll_event timer_event{};
+  timer_event.events = EPOLLIN;
+  timer_event.data.u64 = UINT64_MAX;
+  epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &timer_event);
+
+  std::mt19937_64 rng(options.seed);
+  std::vector<client_connection> connections(options.connections);
+  std::vector<size_t> idle;
+  for (size_t i = connections.size(); i > 0; --i) {
+    idle.push_back(i - 1);
+  }
+  std::deque<uint64_t> pending;  // Instantes previstos aún sin conexión libre
+  loadgen_results results;
+
+  const bool open_loop = options.rate > 0.0;
+  const uint64_t interval_ns =
+      open_loop ? static_cast<uint64_t>(1e9 / options.rate) : 0;
+  const uint64_t start = now_ns();
+  const uint64_t deadline =
+      start + static_cast<uint64_t>(options.duration * 1e9);
+  uint64_t next_scheduled = start;
+  uint64_t issued = 0;
+  std::vector<char> buffer(1 << 16);
+
+  auto want_more = [&](uint64_t now) {
+    return now < deadline && (options.requests == 0 || issued < options.requests);
+  };
+
+  auto finish = [&](size_t index, bool ok, uint64_t now) {
+    client_connection& conn = connections[index];
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, conn.fd, nullptr);
+    close(conn.fd);
+    conn.fd = -1;
+    conn.current = client_connection::state::idle;
+    if (ok && conn.expected != 0 && conn.received < conn.expected) {
+      ok = false;  // Conexión cerrada antes de recibir el cuerpo entero
+    }
+    if (ok) {
+      ++results.completed;
+      results.bytes += conn.received;
+      uint64_t latency = now - conn.intended_ns;
+      results.latency.record(latency);
+      results.service.record(now - conn.start_ns);
+      results.max_latency = std::max(results.max_latency, latency);
+    } else {
+      ++results.errors;
+    }
+    idle.push_back(index);
+  };
+
+  auto launch = [&](uint64_t intended, uint64_t now) {
+    size_t index = idle.back();
+    idle.pop_back();
+    client_connection& conn = connections[index];
+    conn = client_connection{};
+    conn.intended_ns = intended;
+    conn.start_ns = now;
+    conn.request = std::format("GET {} HTTP/1.0\r\n\r\n", pick_path(*paths, rng));
+    conn.fd = start_connect(address);
+    ++issued;
+    if (conn.fd < 0) {
+      ++results.errors;
+      idle.push_back(index);
+      return;
+    }
+    conn.current = client_connection::state::connecting;
+    epoll_event event{};
+    event.events = EPOLLOUT;
+    event.data.u64 = index;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, conn.fd, &event);
+  };
+
+  std::vector<epoll_event> events(connections.size() + 1);
+  while (true) {
+    uint64_t now = now_ns();
+
+    // Lazo abierto: encolar todo lo que ya debería haber salido
+    if (open_loop) {
+      while (next_scheduled <= now && want_more(next_scheduled) &&
+             (options.requests == 0 ||
+              issued + pending.size() < options.requests)) {
+        pending.push_back(next_scheduled);
+        next_scheduled += interval_ns;
+      }
+      while (!pending.empty() && !idle.empty()) {
+        uint64_t intended = pending.front();
+        pending.pop_front();
+        launch(intended, now);
+      }
+    } else {
+      while (!idle.empty() && want_more(now)) {
+        launch(now, now);
+      }
+    }
+
+    bool in_flight = idle.size() != connections.size();
+    if (!in_flight && pending.empty() &&
+        (!want_more(now) || (open_loop && !want_more(next_scheduled)))) {
+      break;
+    }
+
+    if (open_loop && want_more(next_scheduled)) {
+      itimerspec when{};
+      when.it_value.tv_sec = static_cast<time_t>(next_scheduled / 1000000000);
+      when.it_value.tv_nsec = static_cast<long>(next_scheduled % 1000000000);
+      timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &when, nullptr);
+    }
+
+    // Las respuestas que no lleguen en kDrainNs tras el final se dan por
+    // perdidas para no esperar indefinidamente a un servidor atascado.
+    constexpr uint64_t kDrainNs = 5000000000ull;
+    if (now > deadline + kDrainNs) {
+      for (size_t index = 0; index < connections.size(); ++index) {
+        if (connections[index].current != client_connection::state::idle) {
+          finish(index, false, now);
+        }
+      }
+      results.errors += pending.size();
+      break;
+    }
+
+    int n = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()),
+                       100);
+    if (n < 0 && errno != EINTR) {
+      std::cerr << "Error: " << std::strerror(errno) << "\n";
+      return EXIT_FAILURE;
+    }
+    now = now_ns();
+    for (int i = 0; i < n; ++i) {
+      uint64_t id = events[static_cast<size_t>(i)].data.u64;
+      if (id == UINT64_MAX) {
+        uint64_t expirations;
+        while (read(timer_fd, &expirations, sizeof(expirations)) > 0) {
+        }
+        continue;
+      }
+      size_t index = id;
+      client_connection& conn = connections[index];
+      uint32_t flags = events[static_cast<size_t>(i)].events;
+
+      if (conn.current == client_connection::state::connecting) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error != 0) {
+          finish(index, false, now);
+          continue;
+        }
+        conn.current = client_connection::state::sending;
+      }
+      if (conn.current == client_connection::state::sending &&
+          (flags & EPOLLOUT)) {
+        ssize_t written = send(conn.fd, conn.request.data() + conn.sent,
+                               conn.request.size() - conn.sent, MSG_NOSIGNAL);
+        if (written < 0 && errno != EAGAIN) {
+          finish(index, false, now);
+          continue;
+        }
+        if (written > 0) {
+          conn.sent += static_cast<size_t>(written);
+        }
+        if (conn.sent == conn.request.size()) {
+          conn.current = client_connection::state::receiving;
+          epoll_event event{};
+          event.events = EPOLLIN | EPOLLRDHUP;
+          event.data.u64 = index;
+          epoll_ctl(epoll_fd, EPOLL_CTL_MOD, conn.fd, &event);
+        }
+        continue;
+      }
+      if (conn.current == client_connection::state::receiving) {
+        while (true) {
+          ssize_t got = recv(conn.fd, buffer.data(), buffer.size(), 0);
+          if (got > 0) {
+            auto bytes = static_cast<size_t>(got);
+            if (conn.expected == 0 && conn.head.size() < 512) {
+              conn.head.append(buffer.data(),
+                               std::min(bytes, 512 - conn.head.size()));
+              if (!parse_head(conn)) {
+                finish(index, false, now);
+                break;
+              }
+            }
+            conn.received += bytes;
+            if (conn.expected != 0 && conn.received >= conn.expected) {
+              finish(index, true, now);
+              break;
+            }
+          } else if (got == 0) {
+            finish(index, !conn.head.empty(), now);
+            break;
+          } else {
+            if (errno != EAGAIN) {
+              finish(index, false, now);
+            }
+            break;
+          }
+        }
+      }
+    }
+  }
+  double elapsed = static_cast<double>(now_ns() - start) / 1e9;
+
+  histogram_snapshot latency, service;
+  results.latency.add_to(latency);
+  results.service.add_to(service);
+  double throughput = static_cast<double>(results.completed) / elapsed;
+  double mib_per_s =
+      static_cast<double>(results.bytes) / elapsed / (1024.0 * 1024.0);
+  auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+
+  if (options.json) {
+    std::cout << std::format(
+        "{{\"mode\":\"{}\",\"connections\":{},\"rate\":{:.1f},"
+        "\"duration_s\":{:.3f},\"completed\":{},\"errors\":{},\"bytes\":{},"
+        "\"throughput_rps\":{:.1f},\"throughput_mib_s\":{:.3f},"
+        "\"latency_us\":{{\"p50\":{:.1f},\"p90\":{:.1f},\"p99\":{:.1f},"
+        "\"p999\":{:.1f},\"max\":{:.1f}}},"
+        "\"service_us\":{{\"p50\":{:.1f},\"p99\":{:.1f},\"p999\":{:.1f}}}}}\n",
+        open_loop ? "open" : "closed", options.connections, options.rate,
+        elapsed, results.completed, results.errors, results.bytes, throughput,
+        mib_per_s, us(latency.percentile(0.50)), us(latency.percentile(0.90)),
+        us(latency.percentile(0.99)), us(latency.percentile(0.999)),
+        us(results.max_latency), us(service.percentile(0.50)),
+        us(service.percentile(0.99)), us(service.percentile(0.999)));
+    return EXIT_SUCCESS;
+  }
+
+  std::cout << std::format("Mode:        {} loop, {} connections",
+                           open_loop ? "open" : "closed", options.connections);
+  if (open_loop) {
+    std::cout << std::format(", {:.0f} req/s target", options.rate);
+  }
+  std::cout << "\n";
+  std::cout << std::format("Requests:    {} ok, {} errors in {:.2f} s\n",
+                           results.completed, results.errors, elapsed);
+  std::cout << std::format("Throughput:  {:.1f} req/s, {:.2f} MiB/s\n",
+                           throughput, mib_per_s);
+  std::cout << std::format(
+      "Latency{}: p50 {:.1f} us, p90 {:.1f} us, p99 {:.1f} us, "
+      "p99.9 {:.1f} us, max {:.1f} us\n",
+      open_loop ? " (from scheduled send)" : "",
+      us(latency.percentile(0.50)), us(latency.percentile(0.90)),
+      us(latency.percentile(0.99)), us(latency.percentile(0.999)),
+      us(results.max_latency));
+  if (open_loop) {
+    std::cout << std::format(
+        "Service time (from connect): p50 {:.1f} us, p99 {:.1f} us, "
+        "p99.9 {:.1f} us\n",
+        us(service.percentile(0.50)), us(service.percentile(0.99)),
+        us(service.percentile(0.999)));
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,331 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: metrics.cc
+ * Referencias:
+ *     Formato de exposición de texto de Prometheus
+ */
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <format>
+#include <mutex>
+#include <string>
+
+namespace {
+
+// Los shards nunca se liberan: si un hilo termina sus cuentas siguen sumando.
+constexpr size_t kMaxShards = 256;
+std::array<std::atomic<metrics_shard*>, kMaxShards> shards{};
+std::atomic<size_t> shard_count{0};
+
+std::mutex caches_mutex;
+std::array<std::string, metrics_shard::kMaxCaches> cache_names;
+std::atomic<size_t> cache_count{0};
+
+struct histogram_info {
+  const char* name;
+  const char* help;
+};
+
+constexpr std::array<histogram_info,
+                     static_cast<size_t>(metric_histogram::count_)>
+    histogram_infos{{
+        {"docserver_accept_to_first_byte_seconds",
+         "Tiempo desde accept() hasta enviar el primer byte."},
+        {"docserver_file_resolution_seconds",
+         "Tiempo de open() y lseek() del archivo pedido."},
+        {"docserver_file_mapping_seconds", "Tiempo de mmap() del archivo."},
+        {"docserver_send_seconds", "Tiempo de envío de la respuesta."},
+        {"docserver_bin_queue_wait_seconds",
+         "Espera en la cola de /bin hasta tener turno."},
+        {"docserver_small_response_seconds",
+         "Tiempo desde accept() hasta enviar entera una respuesta con "
+         "cuerpo de hasta 64 KiB."},
+    }};
+
+std::string seconds(uint64_t nanoseconds) {
+  return std::format("{:.9f}", static_cast<double>(nanoseconds) / 1e9);
+}
+
+}  // namespace
+
+void histogram_snapshot::merge(const histogram_snapshot& other) {
+  if (buckets.size() < other.buckets.size()) {
+    buckets.resize(other.buckets.size(), 0);
+  }
+  for (size_t i = 0; i < other.buckets.size(); ++i) {
+    buckets[i] += other.buckets[i];
+  }
+  count += other.count;
+  sum += other.sum;
+}
+
+/**
+ * @brief Devuelve el valor por debajo del cual queda la fracción q de las
+ * muestras, redondeado al límite superior de su cubeta.
+ */
+uint64_t histogram_snapshot::percentile(double q) const {
+  if (count == 0) {
+    return 0;
+  }
+  auto rank = static_cast<uint64_t>(q * static_cast<double>(count));
+  if (rank == 0) {
+    rank = 1;
+  }
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return LogLinearHistogram::bucket_upper(i) - 1;
+    }
+  }
+  return LogLinearHistogram::bucket_upper(buckets.size() - 1) - 1;
+}
+
+void LogLinearHistogram::add_to(histogram_snapshot& snapshot) const {
+  if (snapshot.buckets.size() < kBuckets) {
+    snapshot.buckets.resize(kBuckets, 0);
+  }
+  for (size_t i = 0; i < kBuckets; ++i) {
+    uint64_t n = buckets_[i].load(std::memory_order_relaxed);
+    snapshot.buckets[i] += n;
+    snapshot.count += n;
+  }
+  snapshot.sum += sum_.load(std::memory_order_relaxed);
+}
+
+metrics_shard* metrics_register_shard() {
+  size_t index = shard_count.fetch_add(1, std::memory_order_acq_rel);
+  // Si se superan los hilos previstos el shard sigue funcionando pero no se
+  // publica; es preferible perder esas cuentas a bloquear el camino rápido.
+  auto* shard = new metrics_shard();
+  if (index < kMaxShards) {
+    shards[index].store(shard, std::memory_order_release);
+  }
+  return shard;
+}
+
+size_t metrics_register_cache(std::string_view name) {
+  std::lock_guard<std::mutex> lock(caches_mutex);
+  size_t count = cache_count.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < count; ++i) {
+    if (cache_names[i] == name) {
+      return i;
+    }
+  }
+  if (count == metrics_shard::kMaxCaches) {
+    return metrics_shard::kMaxCaches;  // metrics_cache_lookup() lo ignora
+  }
+  cache_names[count] = std::string(name);
+  cache_count.store(count + 1, std::memory_order_release);
+  return count;
+}
+
+histogram_snapshot metrics_histogram_snapshot(metric_histogram histogram) {
+  histogram_snapshot snapshot;
+  size_t count = std::min(shard_count.load(std::memory_order_acquire),
+                          kMaxShards);
+  for (size_t i = 0; i < count; ++i) {
+    metrics_shard* shard = shards[i].load(std::memory_order_acquire);
+    if (shard != nullptr) {
+      shard->histograms[static_cast<size_t>(histogram)].add_to(snapshot);
+    }
+  }
+  return snapshot;
+}
+
+std::string metrics_render() {
+  std::string out;
+  size_t count = std::min(shard_count.load(std::memory_order_acquire),
+                          kMaxShards);
+  auto for_each_shard = [&](auto&& fn) {
+    for (size_t i = 0; i < count; ++i) {
+      metrics_shard* shard = shards[i].load(std::memory_order_acquire);
+      if (shard != nullptr) {
+        fn(*shard);
+      }
+    }
+  };
+  auto counter_total = [&](metric_counter counter) {
+    uint64_t total = 0;
+    for_each_shard([&](const metrics_shard& shard) {
+      total += shard.counters[static_cast<size_t>(counter)].load(
+          std::memory_order_relaxed);
+    });
+    return total;
+  };
+  auto counter = [&](const char* name, const char* help, uint64_t value) {
+    out += std::format("# HELP {} {}\n# TYPE {} counter\n{} {}\n", name, help,
+                       name, name, value);
+  };
+
+  counter("docserver_connections_accepted_total", "Conexiones aceptadas.",
+          counter_total(metric_counter::connections_accepted));
+  counter("docserver_requests_total", "Peticiones procesadas.",
+          counter_total(metric_counter::requests));
+  counter("docserver_bytes_served_total", "Bytes de cuerpo enviados.",
+          counter_total(metric_counter::bytes_served));
+  counter("docserver_bin_worker_spawns_total",
+          "Workers de /bin lanzados, incluidos los relanzamientos.",
+          counter_total(metric_counter::bin_worker_spawns));
+  counter("docserver_bin_worker_failures_total",
+          "Workers de /bin descartados por fallo o health check.",
+          counter_total(metric_counter::bin_worker_failures));
+  counter("docserver_bin_rejected_total",
+          "Peticiones de /bin rechazadas con 503 por falta de turno.",
+          counter_total(metric_counter::bin_rejected));
+  counter("docserver_bin_cache_stale_total",
+          "Salidas de /bin servidas viejas mientras se regeneran.",
+          counter_total(metric_counter::bin_cache_stale));
+  counter("docserver_bin_cache_coalesced_total",
+          "Fallos de la caché de /bin que esperan a una ejecución en curso.",
+          counter_total(metric_counter::bin_cache_coalesced));
+  counter("docserver_bin_deadline_kills_total",
+          "Procesos de /bin terminados por pasarse de plazo.",
+          counter_total(metric_counter::bin_deadline_kills));
+  counter("docserver_bin_deadline_sigkills_total",
+          "Procesos de /bin fuera de plazo que hubo que matar con SIGKILL.",
+          counter_total(metric_counter::bin_deadline_sigkills));
+  counter("docserver_bin_killed_user_cpu_microseconds_total",
+          "CPU de usuario de los procesos de /bin fuera de plazo.",
+          counter_total(metric_counter::bin_killed_user_cpu_us));
+  counter("docserver_bin_killed_system_cpu_microseconds_total",
+          "CPU de sistema de los procesos de /bin fuera de plazo.",
+          counter_total(metric_counter::bin_killed_system_cpu_us));
+  counter("docserver_header_timeouts_total",
+          "Conexiones cerradas sin haber recibido la petición a tiempo.",
+          counter_total(metric_counter::header_timeouts));
+  counter("docserver_send_timeouts_total",
+          "Conexiones cerradas porque el cliente dejó de leer la respuesta.",
+          counter_total(metric_counter::send_timeouts));
+  counter("docserver_connections_shed_total",
+          "Conexiones rechazadas con 503 nada más aceptarlas.",
+          counter_total(metric_counter::connections_shed));
+  counter("docserver_requests_shed_total",
+          "Peticiones rechazadas con 503 por sobrecarga.",
+          counter_total(metric_counter::requests_shed));
+  counter("docserver_uploads_total", "Archivos guardados con PUT.",
+          counter_total(metric_counter::uploads));
+  counter("docserver_upload_bytes_total", "Bytes de los archivos guardados.",
+          counter_total(metric_counter::upload_bytes));
+  counter("docserver_digest_bytes_total",
+          "Bytes de los archivos resumidos en segundo plano.",
+          counter_total(metric_counter::digest_bytes));
+  counter("docserver_dedup_files_total",
+          "Rutas que pasan a compartir el mapeo de otra con el mismo "
+          "contenido.",
+          counter_total(metric_counter::dedup_files));
+
+  auto gauge = [&](const char* name, const char* help, metric_gauge which) {
+    int64_t value = 0;
+    for_each_shard([&](const metrics_shard& shard) {
+      value += shard.gauges[static_cast<size_t>(which)].load(
+          std::memory_order_relaxed);
+    });
+    out += std::format("# HELP {} {}\n# TYPE {} gauge\n{} {}\n", name, help,
+                       name, name, value);
+    return value;
+  };
+  gauge("docserver_open_connections", "Conexiones abiertas.",
+        metric_gauge::open_connections);
+  gauge("docserver_bin_running", "Peticiones de /bin en ejecución.",
+        metric_gauge::bin_running);
+  gauge("docserver_bin_queued", "Peticiones de /bin esperando turno.",
+        metric_gauge::bin_queued);
+  int64_t mapped = gauge("docserver_file_cache_bytes",
+                         "Bytes mapeados por la caché de archivos.",
+                         metric_gauge::file_cache_bytes);
+  int64_t logical =
+      gauge("docserver_file_cache_logical_bytes",
+            "Bytes de las rutas de la caché de archivos, sin compartir los "
+            "contenidos repetidos.",
+            metric_gauge::file_cache_logical_bytes);
+  out += std::format(
+      "# HELP docserver_file_cache_dedup_ratio Bytes de las rutas / bytes "
+      "mapeados.\n# TYPE docserver_file_cache_dedup_ratio gauge\n"
+      "docserver_file_cache_dedup_ratio {:.6f}\n",
+      mapped <= 0 ? 1.0
+                  : static_cast<double>(logical) / static_cast<double>(mapped));
+
+  out +=
+      "# HELP docserver_responses_total Respuestas enviadas por código.\n"
+      "# TYPE docserver_responses_total counter\n";
+  for (size_t code = 0; code < metrics_shard::kMaxStatus; ++code) {
+    uint64_t total = 0;
+    for_each_shard([&](const metrics_shard& shard) {
+      total += shard.status[code].load(std::memory_order_relaxed);
+    });
+    if (total != 0) {
+      out += std::format("docserver_responses_total{{code=\"{}\"}} {}\n", code,
+                         total);
+    }
+  }
+
+  size_t caches = cache_count.load(std::memory_order_acquire);
+  if (caches != 0) {
+    std::string hits_out, misses_out, ratio_out;
+    for (size_t cache = 0; cache < caches; ++cache) {
+      uint64_t hits = 0, misses = 0;
+      for_each_shard([&](const metrics_shard& shard) {
+        hits += shard.cache_hits[cache].load(std::memory_order_relaxed);
+        misses += shard.cache_misses[cache].load(std::memory_order_relaxed);
+      });
+      double ratio = hits + misses == 0
+                         ? 0.0
+                         : static_cast<double>(hits) /
+                               static_cast<double>(hits + misses);
+      hits_out += std::format("docserver_cache_hits_total{{cache=\"{}\"}} {}\n",
+                              cache_names[cache], hits);
+      misses_out +=
+          std::format("docserver_cache_misses_total{{cache=\"{}\"}} {}\n",
+                      cache_names[cache], misses);
+      ratio_out +=
+          std::format("docserver_cache_hit_ratio{{cache=\"{}\"}} {:.6f}\n",
+                      cache_names[cache], ratio);
+    }
+    out += "# HELP docserver_cache_hits_total Aciertos de caché.\n"
+           "# TYPE docserver_cache_hits_total counter\n" +
+           hits_out +
+           "# HELP docserver_cache_misses_total Fallos de caché.\n"
+           "# TYPE docserver_cache_misses_total counter\n" +
+           misses_out +
+           "# HELP docserver_cache_hit_ratio Aciertos / búsquedas.\n"
+           "# TYPE docserver_cache_hit_ratio gauge\n" +
+           ratio_out;
+  }
+
+  for (size_t h = 0; h < histogram_infos.size(); ++h) {
+    const auto& info = histogram_infos[h];
+    histogram_snapshot snapshot =
+        metrics_histogram_snapshot(static_cast<metric_histogram>(h));
+    out += std::format("# HELP {} {}\n# TYPE {} histogram\n", info.name,
+                       info.help, info.name);
+    // Se exporta un límite por potencia de dos a partir de 1 µs; las cubetas
+    // internas son más finas pero Prometheus no necesita tanto detalle.
+    constexpr size_t kFirstGroup = 10 - LogLinearHistogram::kSubBucketBits + 1;
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < snapshot.buckets.size(); ++i) {
+      cumulative += snapshot.buckets[i];
+      bool last_of_group = (i + 1) % LogLinearHistogram::kSubBuckets == 0;
+      if (last_of_group && i / LogLinearHistogram::kSubBuckets >= kFirstGroup &&
+          i + 1 < snapshot.buckets.size()) {
+        out += std::format("{}_bucket{{le=\"{}\"}} {}\n", info.name,
+                           seconds(LogLinearHistogram::bucket_upper(i)),
+                           cumulative);
+      }
+    }
+    out += std::format("{}_bucket{{le=\"+Inf\"}} {}\n", info.name,
+                       snapshot.count);
+    out += std::format("{}_sum {}\n{}_count {}\n", info.name,
+                       seconds(snapshot.sum), info.name, snapshot.count);
+  }
+  return out;
+}
@@ -0,0 +1,247 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: metrics.h
+ * Referencias:
+ *     Formato de exposición de texto de Prometheus
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <time.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Devuelve el instante actual del reloj monótono en nanosegundos.
+ */
+inline uint64_t now_ns() noexcept {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull +
+         static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/**
+ * @brief Suma v a un contador atómico que solo escribe un hilo.
+ *
+ * Al haber un único escritor basta con load + store relajados, que no
+ * necesitan instrucción con prefijo lock como fetch_add.
+ */
+template <typename T>
+inline void single_writer_add(std::atomic<T>& counter, T v) noexcept {
+  counter.store(counter.load(std::memory_order_relaxed) + v,
+                std::memory_order_relaxed);
+}
+
+/**
+ * @brief Copia de solo lectura de un histograma, fusionable y consultable.
+ */
+struct histogram_snapshot {
+  std::vector<uint64_t> buckets;
+  uint64_t count = 0;
+  uint64_t sum = 0;
+
+  void merge(const histogram_snapshot& other);
+  uint64_t percentile(double q) const;
+};
+
+/**
+ * @brief Histograma log-lineal al estilo HDR.
+ *
+ * Cada potencia de dos se divide en kSubBuckets cubetas lineales, con lo que
+ * el error relativo es como mucho 1 / kSubBuckets. Registrar un valor son
+ * unas pocas instrucciones y un store relajado, sin bloqueos.
+ */
+class LogLinearHistogram {
+ public:
+  static constexpr unsigned kSubBucketBits = 4;
+  static constexpr uint64_t kSubBuckets = 1ull << kSubBucketBits;
+  // Valores a partir de 2^44 ns (~4.9 horas) se acumulan en la última cubeta
+  static constexpr unsigned kMaxBits = 44;
+  static constexpr size_t kBuckets =
+      (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+  static size_t bucket_index(uint64_t value) noexcept {
+    constexpr uint64_t kMaxValue = (1ull << kMaxBits) - 1;
+    if (value > kMaxValue) {
+      value = kMaxValue;
+    }
+    if (value < kSubBuckets) {
+      return value;
+    }
+    unsigned msb = 63u - static_cast<unsigned>(__builtin_clzll(value));
+    uint64_t group = msb - kSubBucketBits + 1;
+    uint64_t sub = (value >> (msb - kSubBucketBits)) - kSubBuckets;
+    return group * kSubBuckets + sub;
+  }
+
+  // Límite inferior (incluido) de la cubeta
+  static uint64_t bucket_lower(size_t index) noexcept {
+    uint64_t group = index / kSubBuckets;
+    uint64_t sub = index % kSubBuckets;
+    return group == 0 ? sub : (kSubBuckets + sub) << (group - 1);
+  }
+
+  // Límite superior (excluido) de la cubeta
+  static uint64_t bucket_upper(size_t index) noexcept {
+    uint64_t group = index / kSubBuckets;
+    uint64_t sub = index % kSubBuckets;
+    return group == 0 ? sub + 1 : (kSubBuckets + sub + 1) << (group - 1);
+  }
+
+  void record(uint64_t value) noexcept {
+    single_writer_add(buckets_[bucket_index(value)], uint64_t{1});
+    single_writer_add(sum_, value);
+  }
+
+  void add_to(histogram_snapshot& snapshot) const;
+
+ private:
+  std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+  std::atomic<uint64_t> sum_{0};
+};
+
+/**
+ * @brief Contadores monótonos del servidor.
+ */
+enum class metric_counter : size_t {
+  connections_accepted,
+  requests,
+  bytes_served,
+  bin_worker_spawns,    // Workers de /bin lanzados (incluye relanzamientos)
+  bin_worker_failures,  // Workers descartados por fallo o health check
+  bin_rejected,         // Peticiones de /bin rechazadas con 503
+  bin_cache_stale,      // Salidas de /bin servidas viejas mientras se renuevan
+  bin_cache_coalesced,  // Fallos de caché que esperan a una ejecución en curso
+  bin_deadline_kills,        // Hijos terminados por pasarse de plazo
+  bin_deadline_sigkills,     // De ellos, los que no atendieron al SIGTERM
+  bin_killed_user_cpu_us,    // CPU de usuario que consumieron
+  bin_killed_system_cpu_us,  // CPU de sistema que consumieron
+  header_timeouts,  // Conexiones cerradas sin recibir la petición a tiempo
+  send_timeouts,    // Conexiones cerradas porque el cliente no leía
+  connections_shed,  // Conexiones rechazadas al aceptarlas (503)
+  requests_shed,     // Peticiones rechazadas por sobrecarga (503)
+  uploads,       // Archivos guardados con PUT
+  upload_bytes,  // Bytes que ocupan
+  digest_bytes,  // Bytes de los archivos resumidos (ETag, Repr-Digest)
+  dedup_files,   // Rutas que pasan a compartir el mapeo de otra idéntica
+  count_  // Número de contadores, no es un contador
+};
+
+/**
+ * @brief Valores que pueden subir y bajar.
+ */
+enum class metric_gauge : size_t {
+  open_connections,
+  bin_running,  // Peticiones de /bin en ejecución
+  bin_queued,   // Peticiones de /bin esperando turno
+  file_cache_bytes,          // Mapeos de la caché de archivos (una vez cada uno)
+  file_cache_logical_bytes,  // Lo que ocuparían sin compartirlos
+  count_
+};
+
+/**
+ * @brief Histogramas de duración, en nanosegundos.
+ */
+enum class metric_histogram : size_t {
+  accept_to_first_byte,
+  file_resolution,
+  file_mapping,
+  send,
+  bin_queue_wait,
+  small_response,  // De accept() al último byte, con cuerpo de hasta 64 KiB
+  count_
+};
+
+/**
+ * @brief Contadores de un hilo. Solo los escribe su hilo; el resto los lee.
+ */
+struct alignas(64) metrics_shard {
+  static constexpr size_t kMaxCaches = 8;
+  static constexpr size_t kMaxStatus = 600;
+
+  std::array<std::atomic<uint64_t>, static_cast<size_t>(metric_counter::count_)>
+      counters{};
+  std::array<std::atomic<int64_t>, static_cast<size_t>(metric_gauge::count_)>
+      gauges{};
+  std::array<std::atomic<uint64_t>, kMaxStatus> status{};
+  std::array<std::atomic<uint64_t>, kMaxCaches> cache_hits{};
+  std::array<std::atomic<uint64_t>, kMaxCaches> cache_misses{};
+  std::array<LogLinearHistogram,
+             static_cast<size_t>(metric_histogram::count_)>
+      histograms{};
+};
+
+metrics_shard* metrics_register_shard();
+
+/**
+ * @brief Devuelve el shard del hilo actual, creándolo la primera vez.
+ */
+inline metrics_shard& metrics_local_shard() {
+  static thread_local metrics_shard* shard = metrics_register_shard();
+  return *shard;
+}
+
+inline void metrics_count(metric_counter counter, uint64_t value = 1) {
+  single_writer_add(
+      metrics_local_shard().counters[static_cast<size_t>(counter)], value);
+}
+
+inline void metrics_gauge_add(metric_gauge gauge, int64_t delta) {
+  single_writer_add(metrics_local_shard().gauges[static_cast<size_t>(gauge)],
+                    delta);
+}
+
+inline void metrics_observe(metric_histogram histogram, uint64_t nanoseconds) {
+  metrics_local_shard()
+      .histograms[static_cast<size_t>(histogram)]
+      .record(nanoseconds);
+}
+
+inline void metrics_status(int code) {
+  if (code >= 0 && static_cast<size_t>(code) < metrics_shard::kMaxStatus) {
+    single_writer_add(
+        metrics_local_shard().status[static_cast<size_t>(code)], uint64_t{1});
+  }
+}
+
+/**
+ * @brief Registra una caché por nombre y devuelve su índice para
+ * metrics_cache_lookup(). Registrar dos veces el mismo nombre devuelve el
+ * mismo índice.
+ */
+size_t metrics_register_cache(std::string_view name);
+
+inline void metrics_cache_lookup(size_t cache, bool hit) {
+  auto& shard = metrics_local_shard();
+  if (cache < metrics_shard::kMaxCaches) {
+    single_writer_add(hit ? shard.cache_hits[cache] : shard.cache_misses[cache],
+                      uint64_t{1});
+  }
+}
+
+/**
+ * @brief Suma los shards de todos los hilos de un histograma.
+ */
+histogram_snapshot metrics_histogram_snapshot(metric_histogram histogram);
+
+/**
+ * @brief Genera el cuerpo de /metrics en formato de texto de Prometheus.
+ */
+std::string metrics_render();
+
+#endif  // METRICS_H
@@ -0,0 +1,386 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: run_scenario.cc
+ * Referencias:
+ *     man 2 perf_event_open, man 2 getrusage, man 2 wait4
+ */
+
+#include <arpa/inet.h>
+#include <linux/perf_event.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <expected>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * Ejecuta un escenario de carga reproducible y guarda el resultado en JSON.
+ *
+ * 1. Arranca docserver sobre un corpus creado con gen_corpus.
+ * 2. Abre contadores hardware/software para el proceso del servidor (y sus
+ *    hilos) con perf_event_open y los activa solo durante la carga.
+ * 3. Lanza loadgen con el escenario elegido y recoge su salida --json.
+ * 4. Para el servidor, obtiene su rusage con wait4() y escribe todo junto.
+ *
+ * Dos archivos de resultados de commits distintos se comparan con un diff.
+ */
+
+/**
+ * @brief Escenario con nombre: argumentos de loadgen relativos al corpus.
+ */
+struct scenario {
+  const char* name;
+  const char* description;
+  std::vector<std::string> loadgen_args;  // "{corpus}" se sustituye
+};
+
+const std::vector<scenario>& scenarios() {
+  static const std::vector<scenario> all = {
+      {"static-closed", "Zipf-popular static files, closed loop, 32 conns",
+       {"-c", "32", "-l", "{corpus}/paths.txt"}},
+      {"static-open", "Zipf-popular static files, open loop at 2000 req/s",
+       {"-c", "128", "-r", "2000", "-l", "{corpus}/paths.txt"}},
+      {"sizes-mixed", "70% 1K, 25% 64K, 5% 1M, closed loop, 16 conns",
+       {"-c", "16", "-z", "1k:70,64k:25,1m:5", "--prefix", "/sizes/"}},
+      {"small-files", "100 B files only, closed loop, 64 conns",
+       {"-c", "64", "-z", "100:1", "--prefix", "/sizes/"}},
+      {"bin", "/bin programs, closed loop, 8 conns",
+       {"-c", "8", "-l", "{corpus}/bin_paths.txt"}},
+  };
+  return all;
+}
+
+/**
+ * @brief Opciones del ejecutor de escenarios.
+ */
+struct runner_options {
+  bool flag_h = false;
+  std::string server = "./docserver";
+  std::string loadgen = "./loadgen";
+  std::string corpus;
+  std::string scenario_name = "static-closed";
+  std::string out;
+  std::string label;
+  uint16_t port = 18080;
+  double duration = 10.0;
+  std::vector<std::string> server_args;
+};
+
+/**
+ * @brief Contador de perf_event_open y su nombre en el JSON.
+ */
+struct perf_counter {
+  const char* name;
+  uint32_t type;
+  uint64_t config;
+  int fd = -1;
+};
+
+void Usage(char* argv[]) {
+  std::cout << "Usage: " << argv[0]
+            << " -C <corpus> -s <scenario> -o <result.json>"
+            << " [--server <path>] [--loadgen <path>] [-p <port>]"
+            << " [-d <seconds>] [--label <text>] [-- <server args>]\n";
+  std::cout << "Scenarios:\n";
+  for (const auto& s : scenarios()) {
+    std::cout << std::format("  {:<14} {}\n", s.name, s.description);
+  }
+}
+
+std::expected<runner_options, std::string> parse_args(int argc, char* argv[]) {
+  std::vector<std::string_view> args(argv + 1, argv + argc);
+  runner_options options;
+  for (auto it = args.begin(), end = args.end(); it != end; ++it) {
+    std::string_view option = *it;
+    if (option == "--") {
+      options.server_args.assign(it + 1, end);
+      break;
+    }
+    if (option == "-h" || option == "--help") {
+      options.flag_h = true;
+      continue;
+    }
+    if (++it == end) {
+      return std::unexpected(std::format("missing value for {}", option));
+    }
+    std::string value(*it);
+    try {
+      if (option == "-C" || option == "--corpus") {
+        options.corpus = value;
+      } else if (option == "-s" || option == "--scenario") {
+        options.scenario_name = value;
+      } else if (option == "-o" || option == "--out") {
+        options.out = value;
+      } else if (option == "--server") {
+        options.server = value;
+      } else if (option == "--loadgen") {
+        options.loadgen = value;
+      } else if (option == "--label") {
+        options.label = value;
+      } else if (option == "-p" || option == "--port") {
+        options.port = static_cast<uint16_t>(std::stoul(value));
+      } else if (option == "-d" || option == "--duration") {
+        options.duration = std::stod(value);
+      } else {
+        return std::unexpected(std::format("unknown option {}", option));
+      }
+    } catch (const std::exception&) {
+      return std::unexpected(std::format("invalid value for {}", option));
+    }
+  }
+  if (!options.flag_h && (options.corpus.empty() || options.out.empty())) {
+    return std::unexpected("corpus (-C) and output file (-o) are required");
+  }
+  return options;
+}
+
+/**
+ * @brief Espera a que el servidor responda en el puerto. La sonda hace una
+ * petición válida (/metrics) porque docserver termina ante peticiones vacías.
+ */
+bool wait_for_port(uint16_t port, pid_t server, double timeout_s) {
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::duration<double>(timeout_s);
+  while (std::chrono::steady_clock::now() < deadline) {
+    int status;
+    if (waitpid(server, &status, WNOHANG) == server) {
+      return false;  // El servidor terminó al arrancar
+    }
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bool ok = connect(fd, reinterpret_cast<sockaddr*>(&address),
+                      sizeof(address)) == 0;
+    if (ok) {
+      constexpr std::string_view kProbe = "GET /metrics HTTP/1.0\r\n\r\n";
+      char buffer[4096];
+      ok = send(fd, kProbe.data(), kProbe.size(), MSG_NOSIGNAL) ==
+           static_cast<ssize_t>(kProbe.size());
+      while (ok && read(fd, buffer, sizeof(buffer)) > 0) {
+      }
+    }
+    close(fd);
+    if (ok) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  return false;
+}
+
+/**
+ * @brief Abre un contador para pid y sus hilos, desactivado de inicio.
+ */
+int open_counter(pid_t pid, uint32_t type, uint64_t config) {
+  perf_event_attr attr{};
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.inherit = 1;
+  attr.exclude_hv = 1;
+  return static_cast<int>(
+      syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+/**
+ * @brief Ejecuta un programa y devuelve lo que escribe en stdout.
+ */
+std::expected<std::string, std::string> run_capture(
+    const std::vector<std::string>& argv, rusage& usage) {
+  int pipe_fd[2];
+  if (pipe(pipe_fd) < 0) {
+    return std::unexpected(std::strerror(errno));
+  }
+  pid_t pid = fork();
+  if (pid < 0) {
+    return std::unexpected(std::strerror(errno));
+  }
+  if (pid == 0) {
+    dup2(pipe_fd[1], STDOUT_FILENO);
+    close(pipe_fd[0]);
+    close(pipe_fd[1]);
+    std::vector<char*> args;
+    for (const auto& arg : argv) args.push_back(const_cast<char*>(arg.c_str()));
+    args.push_back(nullptr);
+    execv(args[0], args.data());
+    _exit(127);
+  }
+  close(pipe_fd[1]);
+  std::string output;
+  char buffer[4096];
+  ssize_t got;
+  while ((got = read(pipe_fd[0], buffer, sizeof(buffer))) > 0) {
+    output.append(buffer, static_cast<size_t>(got));
+  }
+  close(pipe_fd[0]);
+  int status = 0;
+  wait4(pid, &status, 0, &usage);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    return std::unexpected(std::format("{} failed", argv[0]));
+  }
+  return output;
+}
+
+std::string rusage_json(const rusage& usage) {
+  auto seconds = [](const timeval& tv) {
+    return static_cast<double>(tv.tv_sec) +
+           static_cast<double>(tv.tv_usec) / 1e6;
+  };
+  return std::format(
+      "{{\"utime_s\":{:.6f},\"stime_s\":{:.6f},\"maxrss_kb\":{},"
+      "\"minflt\":{},\"majflt\":{},\"nvcsw\":{},\"nivcsw\":{}}}",
+      seconds(usage.ru_utime), seconds(usage.ru_stime), usage.ru_maxrss,
+      usage.ru_minflt, usage.ru_majflt, usage.ru_nvcsw, usage.ru_nivcsw);
+}
+
+int main(int argc, char* argv[]) {
+  auto parsed = parse_args(argc, argv);
+  if (!parsed) {
+    std::cerr << "Error: " << parsed.error() << "\n";
+    return EXIT_FAILURE;
+  }
+  const runner_options& options = *parsed;
+  if (options.flag_h) {
+    Usage(argv);
+    return EXIT_SUCCESS;
+  }
+  const scenario* chosen = nullptr;
+  for (const auto& s : scenarios()) {
+    if (options.scenario_name == s.name) chosen = &s;
+  }
+  if (chosen == nullptr) {
+    std::cerr << "Error: unknown scenario " << options.scenario_name << "\n";
+    return EXIT_FAILURE;
+  }
+
+  // 1. Servidor, con la salida descartada para no medir la terminal
+  pid_t server = fork();
+  if (server < 0) {
+    std::cerr << "Error: " << std::strerror(errno) << "\n";
+    return EXIT_FAILURE;
+  }
+  if (server == 0) {
+    std::vector<std::string> server_argv = {
+        options.server, "-p", std::to_string(options.port), "-b",
+        options.corpus};
+    server_argv.insert(server_argv.end(), options.server_args.begin(),
+                       options.server_args.end());
+    std::vector<char*> args;
+    for (auto& arg : server_argv) args.push_back(arg.data());
+    args.push_back(nullptr);
+    freopen("/dev/null", "w", stdout);
+    execv(args[0], args.data());
+    _exit(127);
+  }
+  if (!wait_for_port(options.port, server, 5.0)) {
+    std::cerr << "Error: the server did not start on port " << options.port
+              << "\n";
+    kill(server, SIGKILL);
+    waitpid(server, nullptr, 0);
+    return EXIT_FAILURE;
+  }
+
+  // 2. Contadores (pueden no estar disponibles: perf_event_paranoid, VMs)
+  std::vector<perf_counter> counters = {
+      {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+      {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+      {"cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+      {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+      {"context_switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+      {"cpu_migrations", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS},
+      {"page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+  };
+  for (auto& counter : counters) {
+    counter.fd = open_counter(server, counter.type, counter.config);
+    if (counter.fd >= 0) {
+      ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  // 3. Carga
+  std::vector<std::string> loadgen_argv = {
+      options.loadgen, "-p", std::to_string(options.port), "-d",
+      std::format("{}", options.duration), "--json"};
+  for (std::string arg : chosen->loadgen_args) {
+    size_t pos = arg.find("{corpus}");
+    if (pos != std::string::npos) arg.replace(pos, 8, options.corpus);
+    loadgen_argv.push_back(arg);
+  }
+  rusage client_usage{};
+  auto workload = run_capture(loadgen_argv, client_usage);
+
+  std::string perf_json = "{";
+  for (auto& counter : counters) {
+    uint64_t value = 0;
+    bool ok = counter.fd >= 0;
+    if (ok) {
+      ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+      ok = read(counter.fd, &value, sizeof(value)) ==
+           static_cast<ssize_t>(sizeof(value));
+      close(counter.fd);
+    }
+    perf_json += std::format("{}\"{}\":{}", perf_json.size() > 1 ? "," : "",
+                             counter.name, ok ? std::to_string(value) : "null");
+  }
+  perf_json += "}";
+
+  // 4. Parada del servidor y su consumo de recursos
+  kill(server, SIGTERM);
+  int status = 0;
+  rusage server_usage{};
+  wait4(server, &status, 0, &server_usage);
+
+  if (!workload) {
+    std::cerr << "Error: " << workload.error() << "\n";
+    return EXIT_FAILURE;
+  }
+  std::string workload_json = *workload;
+  while (!workload_json.empty() &&
+         (workload_json.back() == '\n' || workload_json.back() == ' ')) {
+    workload_json.pop_back();
+  }
+
+  std::ofstream out(options.out);
+  out << std::format(
+      "{{\n  \"scenario\": \"{}\",\n  \"label\": \"{}\",\n"
+      "  \"timestamp\": {},\n  \"duration_s\": {},\n"
+      "  \"workload\": {},\n  \"server\": {{\n    \"rusage\": {},\n"
+      "    \"perf\": {}\n  }},\n  \"client_rusage\": {}\n}}\n",
+      chosen->name, options.label, static_cast<long long>(std::time(nullptr)),
+      options.duration, workload_json, rusage_json(server_usage), perf_json,
+      rusage_json(client_usage));
+  if (!out) {
+    std::cerr << "Error: cannot write " << options.out << "\n";
+    return EXIT_FAILURE;
+  }
+  std::cout << std::format("{}: {}\n", chosen->name, workload_json);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: safe_map.h
+ * Referencias:
+ *     Enunciado de la práctica
+ */
+
+#ifndef SAFE_MAP_H
+#define SAFE_MAP_H
+
+#include <sys/mman.h>
+
+#include <string_view>
+
+/**
+ * @brief Clase que mapea un archivo en memoria de forma segura.
+ */
+class SafeMap {
+ public:
+  // Constructor por defecto
+  SafeMap() = default;
+  // Constructor que recibe un std::string_view
+  SafeMap(std::string_view sv) : sv_(sv) {}
+  // Destructor llama a munmap con la dirrecion y el tamaño
+  ~SafeMap() {
+    if (sv_.data() != nullptr) {
+      munmap(const_cast<char*>(sv_.data()), sv_.size());
+    }
+  }
+
+  // Método para obtener el std::string_view
+  std::string_view get() const { return sv_; }
+
+  // Prohibir la copia
+  SafeMap(const SafeMap&) = delete;
+  SafeMap& operator=(const SafeMap&) = delete;
+
+  // Permitir el movimiento
+  SafeMap(SafeMap&& other) : sv_(other.sv_) { other.sv_ = std::string_view(); }
+
+  SafeMap& operator=(SafeMap&& other) {
+    if (this != &other) {
+      if (sv_.data() != nullptr) {
+        munmap(const_cast<char*>(sv_.data()), sv_.size());
+      }
+      sv_ = other.sv_;
+      other.sv_ = std::string_view();
+    }
+    return *this;
+  }
+
+ private:
+  std::string_view sv_;  // std::string_view que almacena el archivo mapeado
+};
+
+#endif  // SAFE_MAP_H
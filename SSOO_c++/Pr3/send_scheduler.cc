@@ -0,0 +1,134 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: send_scheduler.cc
+ * Referencias:
+ *     M. Harchol-Balter et al., "Size-based scheduling to improve web
+ *     performance" (SRPT), M. Shreedhar y G. Varghese, "Efficient fair
+ *     queuing using deficit round robin"
+ */
+
+#include "send_scheduler.h"
+
+#include <algorithm>
+
+#include "metrics.h"
+
+namespace {
+
+// Cuantos que se dan en una vuelta antes de volver a epoll_wait()
+constexpr size_t kRoundQuanta = 4;
+// Con SRPT, espera desde el último turno que ya no se deja crecer
+constexpr uint64_t kStarvationNs = 50'000'000;
+
+}  // namespace
+
+std::optional<send_policy> parse_send_policy(std::string_view name) {
+  if (name == "off") {
+    return send_policy::off;
+  }
+  if (name == "rr") {
+    return send_policy::round_robin;
+  }
+  if (name == "srpt") {
+    return send_policy::srpt;
+  }
+  if (name == "wfq") {
+    return send_policy::weighted_fair;
+  }
+  return std::nullopt;
+}
+
+SendScheduler::SendScheduler(EventLoop& loop, send_policy policy,
+                             size_t quantum)
+    : loop_(loop), policy_(policy), quantum_(quantum) {}
+
+uint64_t SendScheduler::key_for(entry& e, uint64_t remaining,
+                                uint32_t weight) {
+  switch (policy_) {
+    case send_policy::round_robin:
+      return sequence_++;
+    case send_policy::weighted_fair: {
+      // Cada turno cuesta un cuanto dividido por el peso; la que vuelve
+      // tras no tener nada que enviar no recupera lo que no gastó
+      uint64_t start = std::max(virtual_time_, e.finish);
+      e.finish = start + quantum_ / std::max<uint32_t>(weight, 1);
+      return e.finish;
+    }
+    default:
+      return remaining;
+  }
+}
+
+void SendScheduler::wait_turn(uint64_t id, uint64_t remaining,
+                              uint32_t weight, turn_callback turn) {
+  entry& e = entries_[id];
+  e.turn = std::move(turn);
+  if (e.waiting) {
+    if (policy_ == send_policy::srpt && e.key != remaining) {
+      order_.erase({e.key, id});
+      e.key = remaining;
+      order_.insert({e.key, id});
+    }
+    return;
+  }
+  e.waiting = true;
+  e.waiting_since = now_ns();
+  e.key = key_for(e, remaining, weight);
+  order_.insert({e.key, id});
+  oldest_.insert({e.waiting_since, id});
+  if (!run_pending_) {
+    run_pending_ = true;
+    loop_.defer([this] { run(); });
+  }
+}
+
+void SendScheduler::forget(uint64_t id) {
+  auto it = entries_.find(id);
+  if (it == entries_.end()) {
+    return;
+  }
+  if (it->second.waiting) {
+    unqueue(id, it->second);
+  }
+  entries_.erase(it);
+}
+
+void SendScheduler::unqueue(uint64_t id, entry& e) {
+  order_.erase({e.key, id});
+  oldest_.erase({e.waiting_since, id});
+  e.waiting = false;
+}
+
+void SendScheduler::run() {
+  run_pending_ = false;
+  uint64_t now = now_ns();
+  for (size_t turns = 0; turns < kRoundQuanta && !order_.empty(); ++turns) {
+    uint64_t id = order_.begin()->second;
+    // Las que vuelven a la cola durante la ronda esperan desde después de
+    // now: sin la primera comparación, la resta daría la vuelta
+    uint64_t since = oldest_.begin()->first;
+    if (policy_ == send_policy::srpt && since <= now &&
+        now - since >= kStarvationNs) {
+      id = oldest_.begin()->second;
+    }
+    entry& e = entries_.at(id);
+    unqueue(id, e);
+    if (policy_ == send_policy::weighted_fair) {
+      virtual_time_ = e.key;
+    }
+    // Copia: en su turno la conexión puede cerrarse y olvidarse
+    turn_callback turn = e.turn;
+    turn(quantum_);
+  }
+  if (!order_.empty() && !run_pending_) {
+    run_pending_ = true;
+    loop_.defer([this] { run(); });
+  }
+}
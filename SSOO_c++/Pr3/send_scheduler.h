@@ -0,0 +1,111 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: send_scheduler.h
+ * Referencias:
+ *     M. Harchol-Balter et al., "Size-based scheduling to improve web
+ *     performance" (SRPT), M. Shreedhar y G. Varghese, "Efficient fair
+ *     queuing using deficit round robin"
+ */
+
+#ifndef SEND_SCHEDULER_H
+#define SEND_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <set>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "event_loop.h"
+
+/**
+ * @brief Orden en el que las conexiones con el socket libre envían.
+ */
+enum class send_policy {
+  off,            // Cada una envía hasta llenar su socket, como antes
+  round_robin,    // Un cuanto a cada una, por orden de llegada
+  srpt,           // Antes la que menos bytes tiene pendientes
+  weighted_fair,  // Menos bytes enviados por unidad de peso primero
+};
+
+/**
+ * @brief "off", "rr", "srpt" o "wfq".
+ */
+std::optional<send_policy> parse_send_policy(std::string_view name);
+
+/**
+ * @brief Reparte el envío entre las conexiones del bucle de eventos.
+ *
+ * Sin él, una conexión con el socket libre envía hasta llenarlo: con un
+ * cliente rápido descargando un archivo de gigas, cada vuelta del bucle se
+ * va en esa descarga y los archivos pequeños esperan detrás. Con él, cada
+ * conexión envía como mucho un cuanto y, si le queda y su socket admite
+ * más, espera turno aquí. Al acabar los eventos de cada vuelta se dan
+ * turnos según la política hasta gastar kRoundQuanta cuantos, y se vuelve
+ * a epoll_wait() (sin esperar) a recoger peticiones nuevas.
+ *
+ * Con SRPT, la que haya esperado más de kStarvationNs desde su último turno
+ * pasa delante de todas, para que las descargas grandes no se queden sin
+ * avanzar mientras lleguen pequeñas.
+ */
+class SendScheduler {
+ public:
+  using turn_callback = std::function<void(size_t quantum)>;
+
+  SendScheduler(EventLoop& loop, send_policy policy, size_t quantum);
+
+  SendScheduler(const SendScheduler&) = delete;
+  SendScheduler& operator=(const SendScheduler&) = delete;
+
+  [[nodiscard]] size_t quantum() const noexcept { return quantum_; }
+
+  /**
+   * @brief id (único, como el de EventLoop::watch()) tiene remaining bytes
+   * pendientes y el socket libre: turn se llamará con el cuanto que puede
+   * enviar. Si ya esperaba, se actualiza lo que le queda.
+   * @param weight Peso con la política weighted_fair (al menos 1).
+   */
+  void wait_turn(uint64_t id, uint64_t remaining, uint32_t weight,
+                 turn_callback turn);
+
+  /**
+   * @brief Olvida id (la conexión se ha cerrado).
+   */
+  void forget(uint64_t id);
+
+ private:
+  struct entry {
+    turn_callback turn;
+    uint64_t key = 0;           // Su lugar en order_ mientras espera
+    uint64_t waiting_since = 0;  // Desde su último turno (o desde que llegó)
+    uint64_t finish = 0;        // Tiempo virtual de weighted_fair
+    bool waiting = false;
+  };
+
+  void run();
+  uint64_t key_for(entry& e, uint64_t remaining, uint32_t weight);
+  void unqueue(uint64_t id, entry& e);
+
+  EventLoop& loop_;
+  send_policy policy_;
+  size_t quantum_;
+  bool run_pending_ = false;
+  uint64_t sequence_ = 0;      // Orden de llegada, para round_robin
+  uint64_t virtual_time_ = 0;  // Último turno dado con weighted_fair
+
+  std::unordered_map<uint64_t, entry> entries_;
+  std::set<std::pair<uint64_t, uint64_t>> order_;  // (key, id)
+  std::set<std::pair<uint64_t, uint64_t>> oldest_;  // (waiting_since, id)
+};
+
+#endif  // SEND_SCHEDULER_H
@@ -0,0 +1,483 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: shared_cache.cc
+ * Referencias:
+ *     man 3 shm_open, man 2 mmap (MAP_SHARED), man 2 kill,
+ *     K. Fraser, "Practical lock-freedom" (reclamación por épocas)
+ */
+
+#include "shared_cache.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#include "hash.h"
+#include "metrics.h"
+#include "safe_fd.h"
+
+namespace {
+
+constexpr uint64_t kMagic = 0x31'68'73'63'73'6f'64'00;
+constexpr uint32_t kVersion = 1;
+// Procesos que pueden usar el segmento a la vez
+constexpr size_t kMaxParticipants = 64;
+// Ranuras del índice que se miran desde la del hash
+constexpr uint64_t kMaxProbe = 8;
+// Una ranura del índice por cada tantos bytes de registros
+constexpr size_t kBytesPerSlot = 4096;
+constexpr size_t kMinBytes = 1u << 20;
+constexpr size_t kMaxContent = 256u << 10;
+constexpr size_t kMaxPath = 4096;
+constexpr size_t kMaxHeader = 4096;
+// Los registros empiezan alineados a una línea de caché
+constexpr uint64_t kAlign = 64;
+// Una palabra del índice: 16 bits del hash y 48 de posición (256 TiB
+// escritos antes de que el segmento deje de aceptar registros)
+constexpr int kPositionBits = 48;
+constexpr uint64_t kPositionMask = (uint64_t{1} << kPositionBits) - 1;
+constexpr uint64_t kNoPin = UINT64_MAX;
+// Lo que se espera a que termine de crearlo otro proceso
+constexpr int kAttachWaitMs = 1000;
+
+struct participant {
+  alignas(64) int64_t pid;  // 0 libre, -1 mientras se limpia
+  uint64_t pin;             // Posición más antigua en uso, o kNoPin
+};
+
+/**
+ * @brief Cabecera de un registro, seguida de la ruta, las cabeceras de la
+ * respuesta y el contenido.
+ */
+struct record {
+  uint64_t position;  // La suya: si no coincide, no es un registro
+  uint64_t length;    // Total, alineado a kAlign
+  uint64_t device;
+  uint64_t inode;
+  int64_t size;
+  int64_t ctime_sec;
+  int64_t ctime_nsec;
+  uint32_t path_length;
+  uint32_t header_length;
+};
+static_assert(sizeof(record) == 64);
+
+template <typename T>
+std::atomic_ref<T> atomic(T& value) {
+  return std::atomic_ref<T>(value);
+}
+static_assert(std::atomic_ref<uint64_t>::is_always_lock_free,
+              "la memoria compartida necesita atómicos sin bloqueo");
+
+uint64_t align_up(uint64_t value) {
+  return (value + kAlign - 1) & ~(kAlign - 1);
+}
+
+bool alive(int64_t pid) {
+  return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+}
+
+void sleep_ms(long milliseconds) {
+  timespec pause{0, milliseconds * 1'000'000};
+  nanosleep(&pause, nullptr);
+}
+
+}  // namespace
+
+/**
+ * @brief Principio del segmento; detrás van las ranuras del índice y los
+ * registros.
+ */
+struct SharedFileCache::segment {
+  uint64_t magic;  // Lo último que escribe quien lo crea
+  uint32_t version;
+  uint32_t slot_count;  // Potencia de dos
+  uint64_t slots_offset;
+  uint64_t data_offset;
+  uint64_t data_bytes;
+  alignas(64) uint64_t head;  // Posición lógica donde empieza el siguiente
+  alignas(64) uint64_t tail;  // Lo que empieza antes ya no vale
+  participant participants[kMaxParticipants];
+};
+
+/**
+ * @brief Mantiene anunciada la posición de un registro hasta que termina la
+ * respuesta que lo envía.
+ */
+class SharedFileCache::pin_guard {
+ public:
+  pin_guard(SharedFileCache& cache, uint64_t position)
+      : cache_(cache), position_(position) {}
+  ~pin_guard() { cache_.unpin(position_); }
+
+  pin_guard(const pin_guard&) = delete;
+  pin_guard& operator=(const pin_guard&) = delete;
+
+ private:
+  SharedFileCache& cache_;
+  uint64_t position_;
+};
+
+std::expected<std::unique_ptr<SharedFileCache>, int> SharedFileCache::attach(
+    const std::string& name, size_t bytes) {
+  if (bytes < kMinBytes) {
+    return std::unexpected(EINVAL);
+  }
+  bool created = true;
+  SafeFD fd(shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC,
+                     0600));
+  if (!fd.is_valid()) {
+    if (errno != EEXIST) {
+      return std::unexpected(errno);
+    }
+    created = false;
+    fd = SafeFD(shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0));
+    if (!fd.is_valid()) {
+      return std::unexpected(errno);
+    }
+  }
+
+  uint64_t slot_count = std::bit_floor(bytes / kBytesPerSlot);
+  uint64_t slots_offset = align_up(sizeof(segment));
+  uint64_t data_offset = align_up(slots_offset + slot_count * sizeof(uint64_t));
+  uint64_t data_bytes = bytes & ~(kAlign - 1);
+  size_t mapped = data_offset + data_bytes;
+  if (created) {
+    if (ftruncate(fd.get(), static_cast<off_t>(mapped)) < 0) {
+      int error = errno;
+      shm_unlink(name.c_str());
+      return std::unexpected(error);
+    }
+  } else {
+    // El que lo crea le da el tamaño de una vez; el de este proceso no
+    // importa, vale el del segmento
+    struct stat info {};
+    for (int waited = 0;; ++waited) {
+      if (fstat(fd.get(), &info) < 0) {
+        return std::unexpected(errno);
+      }
+      if (static_cast<size_t>(info.st_size) >= sizeof(segment)) {
+        break;
+      }
+      if (waited == kAttachWaitMs) {
+        return std::unexpected(EINVAL);
+      }
+      sleep_ms(1);
+    }
+    mapped = static_cast<size_t>(info.st_size);
+  }
+
+  void* address = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_SHARED,
+                       fd.get(), 0);
+  if (address == MAP_FAILED) {
+    return std::unexpected(errno);
+  }
+  char* base = static_cast<char*>(address);
+  auto& seg = *reinterpret_cast<segment*>(base);
+  if (created) {
+    seg.version = kVersion;
+    seg.slot_count = static_cast<uint32_t>(slot_count);
+    seg.slots_offset = slots_offset;
+    seg.data_offset = data_offset;
+    seg.data_bytes = data_bytes;
+    seg.head = kAlign;  // La posición 0 es la ranura vacía
+    seg.tail = 0;
+    atomic(seg.magic).store(kMagic, std::memory_order_release);
+  } else {
+    int waited = 0;
+    while (atomic(seg.magic).load(std::memory_order_acquire) != kMagic &&
+           waited++ < kAttachWaitMs) {
+      sleep_ms(1);
+    }
+    uint64_t slots_end = seg.slots_offset + seg.slot_count * sizeof(uint64_t);
+    bool valid =
+        atomic(seg.magic).load(std::memory_order_acquire) == kMagic &&
+        seg.version == kVersion && std::has_single_bit(seg.slot_count) &&
+        seg.slots_offset >= sizeof(segment) && seg.data_offset >= slots_end &&
+        seg.data_offset + seg.data_bytes <= mapped &&
+        seg.data_bytes >= kMinBytes;
+    if (!valid) {
+      munmap(address, mapped);
+      return std::unexpected(EINVAL);
+    }
+  }
+
+  std::unique_ptr<SharedFileCache> cache(new SharedFileCache(base, mapped));
+  if (!cache->join()) {
+    return std::unexpected(EBUSY);
+  }
+  return cache;
+}
+
+SharedFileCache::SharedFileCache(char* base, size_t mapped)
+    : base_(base),
+      mapped_(mapped),
+      metrics_id_(metrics_register_cache("shared")),
+      announced_(kNoPin) {
+  max_content_ = std::min<size_t>(kMaxContent, layout().data_bytes / 8);
+}
+
+SharedFileCache::~SharedFileCache() {
+  leave();
+  munmap(base_, mapped_);
+}
+
+SharedFileCache::segment& SharedFileCache::layout() const {
+  return *reinterpret_cast<segment*>(base_);
+}
+
+uint64_t* SharedFileCache::slots() const {
+  return reinterpret_cast<uint64_t*>(base_ + layout().slots_offset);
+}
+
+char* SharedFileCache::record_at(uint64_t position) const {
+  return base_ + layout().data_offset + position % layout().data_bytes;
+}
+
+bool SharedFileCache::join() {
+  int64_t self = getpid();
+  for (size_t i = 0; i < kMaxParticipants; ++i) {
+    participant& p = layout().participants[i];
+    int64_t pid = atomic(p.pid).load();
+    // Libre, o de un proceso que murió sin salir
+    if ((pid == 0 || (pid > 0 && !alive(pid))) &&
+        atomic(p.pid).compare_exchange_strong(pid, self)) {
+      atomic(p.pin).store(kNoPin);
+      participant_ = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+void SharedFileCache::leave() {
+  participant& p = layout().participants[participant_];
+  atomic(p.pin).store(kNoPin);
+  atomic(p.pid).store(0);
+}
+
+void SharedFileCache::pin(uint64_t position) {
+  ++pins_[position];
+  if (position < announced_) {
+    announced_ = position;
+    // seq_cst: tiene que verse antes de que se lea tail (ver get())
+    atomic(layout().participants[participant_].pin).store(position);
+  }
+}
+
+void SharedFileCache::unpin(uint64_t position) {
+  auto it = pins_.find(position);
+  if (it == pins_.end()) {
+    return;
+  }
+  if (--it->second == 0) {
+    pins_.erase(it);
+  }
+  uint64_t lowest = pins_.empty() ? kNoPin : pins_.begin()->first;
+  if (lowest != announced_) {
+    announced_ = lowest;
+    atomic(layout().participants[participant_].pin).store(lowest);
+  }
+}
+
+bool SharedFileCache::pinned_below(uint64_t position) {
+  for (size_t i = 0; i < kMaxParticipants; ++i) {
+    participant& p = layout().participants[i];
+    int64_t pid = atomic(p.pid).load();
+    if (pid <= 0 || atomic(p.pin).load() >= position) {
+      continue;
+    }
+    if (i == participant_ || alive(pid)) {
+      return true;
+    }
+    // Murió con un registro anunciado: nadie lo está enviando ya
+    if (atomic(p.pid).compare_exchange_strong(pid, -1)) {
+      atomic(p.pin).store(kNoPin);
+      atomic(p.pid).store(0);
+    }
+  }
+  return false;
+}
+
+std::optional<uint64_t> SharedFileCache::reserve(uint64_t length) {
+  segment& seg = layout();
+  uint64_t data = seg.data_bytes;
+  uint64_t current = atomic(seg.head).load();
+  uint64_t start = 0;
+  uint64_t reclaim = 0;
+  do {
+    // Un registro no da la vuelta al anillo: se salta el final
+    start = current;
+    if (start % data + length > data) {
+      start += data - start % data;
+    }
+    uint64_t end = start + length;
+    if (end > kPositionMask) {
+      return std::nullopt;
+    }
+    reclaim = end > data ? end - data : 0;
+    // Si el hueco está en uso no se toca nada: se volverá a intentar con
+    // otra petición
+    if (atomic(seg.tail).load() < reclaim && pinned_below(reclaim)) {
+      return std::nullopt;
+    }
+  } while (!atomic(seg.head).compare_exchange_weak(current, start + length));
+
+  uint64_t tail = atomic(seg.tail).load();
+  while (tail < reclaim &&
+         !atomic(seg.tail).compare_exchange_weak(tail, reclaim)) {
+  }
+  // Un lector que anunció su posición antes de ver el nuevo tail aparece
+  // aquí; uno que lo anuncie después ya ve el registro caducado
+  if (pinned_below(reclaim)) {
+    return std::nullopt;
+  }
+  return start;
+}
+
+void SharedFileCache::publish(uint64_t hash, uint64_t position) {
+  segment& seg = layout();
+  uint64_t tag = hash >> kPositionBits;
+  uint64_t word = (tag << kPositionBits) | position;
+  uint64_t mask = seg.slot_count - 1;
+  uint64_t tail = atomic(seg.tail).load();
+  uint64_t* victim = nullptr;
+  uint64_t victim_word = 0;
+  for (uint64_t probe = 0; probe < kMaxProbe; ++probe) {
+    uint64_t& slot = slots()[(hash + probe) & mask];
+    uint64_t current = atomic(slot).load(std::memory_order_acquire);
+    // Libre, caducada o de la misma ruta (o de otra con el mismo tag, que
+    // se pierde)
+    if (current == 0 || (current & kPositionMask) < tail ||
+        current >> kPositionBits == tag) {
+      if (atomic(slot).compare_exchange_strong(current, word,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+        return;
+      }
+      continue;  // Otro proceso se la acaba de quedar
+    }
+    if (victim == nullptr ||
+        (current & kPositionMask) < (victim_word & kPositionMask)) {
+      victim = &slot;
+      victim_word = current;
+    }
+  }
+  // Todas ocupadas: se sustituye la más antigua
+  if (victim != nullptr) {
+    atomic(*victim).compare_exchange_strong(victim_word, word,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed);
+  }
+}
+
+std::optional<shared_file> SharedFileCache::get(const std::string& path,
+                                                const struct stat& info) {
+  segment& seg = layout();
+  uint64_t hash = xxh3_64(path);
+  uint64_t tag = hash >> kPositionBits;
+  uint64_t mask = seg.slot_count - 1;
+  for (uint64_t probe = 0; probe < kMaxProbe; ++probe) {
+    uint64_t word =
+        atomic(slots()[(hash + probe) & mask]).load(std::memory_order_acquire);
+    if (word == 0) {
+      break;  // Las ranuras no vuelven a quedar vacías: no hay más
+    }
+    if (word >> kPositionBits != tag) {
+      continue;
+    }
+    uint64_t position = word & kPositionMask;
+    // Primero se anuncia y luego se comprueba que sigue valiendo: quien
+    // reutilice el hueco después verá el anuncio
+    pin(position);
+    if (position < atomic(seg.tail).load()) {
+      unpin(position);
+      continue;
+    }
+    const char* at = record_at(position);
+    record stored{};
+    std::memcpy(&stored, at, sizeof(stored));
+    uint64_t used = sizeof(record) + uint64_t{stored.path_length} +
+                    stored.header_length +
+                    static_cast<uint64_t>(stored.size < 0 ? 0 : stored.size);
+    if (stored.position != position || stored.size < 0 ||
+        stored.length > seg.data_bytes || used > stored.length ||
+        std::string_view(at + sizeof(record), stored.path_length) != path) {
+      unpin(position);
+      continue;
+    }
+    if (stored.device != info.st_dev || stored.inode != info.st_ino ||
+        stored.size != info.st_size ||
+        stored.ctime_sec != info.st_ctim.tv_sec ||
+        stored.ctime_nsec != info.st_ctim.tv_nsec) {
+      unpin(position);
+      break;  // El archivo ha cambiado; el siguiente put() lo sustituye
+    }
+    metrics_cache_lookup(metrics_id_, true);
+    const char* header = at + sizeof(record) + stored.path_length;
+    return shared_file{
+        std::make_shared<pin_guard>(*this, position),
+        std::string_view(header, stored.header_length),
+        std::string_view(header + stored.header_length,
+                         static_cast<size_t>(stored.size))};
+  }
+  metrics_cache_lookup(metrics_id_, false);
+  return std::nullopt;
+}
+
+bool SharedFileCache::put(const std::string& path, const struct stat& info,
+                          std::string_view header, std::string_view content) {
+  if (content.size() > max_content_ || path.size() > kMaxPath ||
+      header.size() > kMaxHeader ||
+      static_cast<off_t>(content.size()) != info.st_size) {
+    return false;
+  }
+  uint64_t length =
+      align_up(sizeof(record) + path.size() + header.size() + content.size());
+  // Lo que se reserve queda detrás de este anuncio, así que nadie lo
+  // reutiliza mientras se escribe
+  uint64_t guard = atomic(layout().head).load();
+  pin(guard);
+  auto start = reserve(length);
+  if (!start) {
+    unpin(guard);
+    return false;
+  }
+  record stored{};
+  stored.position = *start;
+  stored.length = length;
+  stored.device = info.st_dev;
+  stored.inode = info.st_ino;
+  stored.size = info.st_size;
+  stored.ctime_sec = info.st_ctim.tv_sec;
+  stored.ctime_nsec = info.st_ctim.tv_nsec;
+  stored.path_length = static_cast<uint32_t>(path.size());
+  stored.header_length = static_cast<uint32_t>(header.size());
+  char* at = record_at(*start);
+  std::memcpy(at, &stored, sizeof(stored));
+  at += sizeof(stored);
+  std::memcpy(at, path.data(), path.size());
+  at += path.size();
+  std::memcpy(at, header.data(), header.size());
+  at += header.size();
+  std::memcpy(at, content.data(), content.size());
+  // Solo ahora lo puede encontrar otro proceso
+  publish(xxh3_64(path), *start);
+  unpin(guard);
+  return true;
+}
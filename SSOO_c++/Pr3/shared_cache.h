@@ -0,0 +1,124 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: shared_cache.h
+ * Referencias:
+ *     man 3 shm_open, man 2 mmap (MAP_SHARED), man 2 kill,
+ *     K. Fraser, "Practical lock-freedom" (reclamación por épocas)
+ */
+
+#ifndef SHARED_CACHE_H
+#define SHARED_CACHE_H
+
+#include <sys/stat.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Un archivo encontrado en la caché compartida. Mientras viva pin,
+ * header y content apuntan a la memoria compartida y nadie la sobrescribe.
+ */
+struct shared_file {
+  std::shared_ptr<const void> pin;
+  std::string_view header;   // Cabeceras ya formateadas, con sus "\r\n"
+  std::string_view content;
+};
+
+/**
+ * @brief Archivos pequeños y sus cabeceras, en memoria compartida por todos
+ * los docserver que abren el mismo segmento (shm_open()): por ejemplo el
+ * viejo y el nuevo de un reinicio en caliente, o varias instancias sobre el
+ * mismo base_dir. Lo que uno guarda lo sirven los demás sin mapear el
+ * archivo ni esperar a su resumen.
+ *
+ * Los registros se escriben seguidos en un anillo: el espacio se reserva
+ * con un CAS sobre la posición lógica del final (head), que nunca decrece,
+ * y lo que queda más de un anillo por detrás (por debajo de tail) ya no
+ * vale. El índice es una tabla de direccionamiento abierto con una palabra
+ * atómica por ranura (16 bits del hash de la ruta y la posición del
+ * registro); se publica con un CAS cuando el registro ya está escrito, así
+ * que un proceso que muere a mitad solo deja espacio perdido.
+ *
+ * Para no sobrescribir lo que otro proceso está enviando, cada uno anuncia
+ * en su ranura de participante la posición más antigua que usa (su época);
+ * quien va a reutilizar espacio sube tail y, si algún anuncio queda por
+ * debajo, renuncia a ese hueco. El anuncio de un proceso muerto (kill(pid,
+ * 0) da ESRCH) se borra y deja de frenar a los demás.
+ *
+ * No hay bloqueos: ninguna operación espera a otro proceso.
+ */
+class SharedFileCache {
+ public:
+  /**
+   * @brief Abre el segmento name ("/nombre", ver shm_open()), creándolo
+   * con bytes para los registros si no existe.
+   * @return La caché, o el errno del fallo (EINVAL si el segmento no es
+   * de esta versión o quien lo creaba no llegó a terminar).
+   */
+  static std::expected<std::unique_ptr<SharedFileCache>, int> attach(
+      const std::string& name, size_t bytes);
+
+  ~SharedFileCache();
+
+  SharedFileCache(const SharedFileCache&) = delete;
+  SharedFileCache& operator=(const SharedFileCache&) = delete;
+
+  /**
+   * @brief Busca path (relativa a base_dir).
+   * @param info stat() actual del archivo: el registro solo vale si tiene
+   * el mismo dispositivo, inodo, tamaño y ctime.
+   */
+  std::optional<shared_file> get(const std::string& path,
+                                 const struct stat& info);
+
+  /**
+   * @brief Guarda path con sus cabeceras y su contenido, si cabe.
+   * @return false si es demasiado grande o el hueco estaba en uso.
+   */
+  bool put(const std::string& path, const struct stat& info,
+           std::string_view header, std::string_view content);
+
+ private:
+  struct segment;
+  class pin_guard;
+
+  SharedFileCache(char* base, size_t mapped);
+
+  bool join();
+  void leave();
+  void pin(uint64_t position);
+  void unpin(uint64_t position);
+  std::optional<uint64_t> reserve(uint64_t length);
+  bool pinned_below(uint64_t position);
+  void publish(uint64_t hash, uint64_t position);
+
+  segment& layout() const;
+  uint64_t* slots() const;
+  char* record_at(uint64_t position) const;
+
+  char* base_;
+  size_t mapped_;
+  size_t max_content_ = 0;
+  size_t metrics_id_;
+  size_t participant_ = 0;
+
+  // Posiciones que usa este proceso (con cuántas veces cada una); la menor
+  // es la que se anuncia
+  std::map<uint64_t, size_t> pins_;
+  uint64_t announced_;
+};
+
+#endif  // SHARED_CACHE_H
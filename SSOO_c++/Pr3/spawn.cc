@@ -0,0 +1,177 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: spawn.cc
+ * Referencias:
+ *     man 3 posix_spawn, man 2 clone, man 2 vfork
+ */
+
+#include "spawn.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <string_view>
+
+extern char** environ;
+
+namespace {
+
+/**
+ * @brief Punteros a las cadenas, terminados en nullptr, como piden
+ * execve() y posix_spawn(). Se preparan antes de crear el hijo.
+ */
+std::vector<char*> make_pointer_array(const std::vector<std::string>& items) {
+  std::vector<char*> pointers;
+  pointers.reserve(items.size() + 1);
+  for (const auto& item : items) {
+    pointers.push_back(const_cast<char*>(item.c_str()));
+  }
+  pointers.push_back(nullptr);
+  return pointers;
+}
+
+std::expected<pid_t, int> spawn_with_posix_spawn(
+    const std::string& path, const exec_environment& environment,
+    spawn_stdio stdio, char* const argv[], char* const envp[]) {
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  // dup2 quita el CLOEXEC en el destino, así que el resto de descriptores
+  // del servidor (todos CLOEXEC) no llegan al programa
+  if (stdio.in >= 0) {
+    posix_spawn_file_actions_adddup2(&actions, stdio.in, STDIN_FILENO);
+  }
+  if (stdio.out >= 0) {
+    posix_spawn_file_actions_adddup2(&actions, stdio.out, STDOUT_FILENO);
+  }
+  if (!environment.cwd.empty()) {
+    posix_spawn_file_actions_addchdir_np(&actions, environment.cwd.c_str());
+  }
+
+  // El hijo empieza sin señales bloqueadas, con SIGPIPE por defecto y en
+  // su propio grupo de procesos
+  posix_spawnattr_t attributes;
+  posix_spawnattr_init(&attributes);
+  sigset_t empty, defaults;
+  sigemptyset(&empty);
+  sigemptyset(&defaults);
+  sigaddset(&defaults, SIGPIPE);
+  posix_spawnattr_setsigmask(&attributes, &empty);
+  posix_spawnattr_setsigdefault(&attributes, &defaults);
+  posix_spawnattr_setpgroup(&attributes, 0);
+  posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSIGMASK |
+                                            POSIX_SPAWN_SETSIGDEF |
+                                            POSIX_SPAWN_SETPGROUP);
+
+  pid_t pid = -1;
+  int error =
+      posix_spawn(&pid, path.c_str(), &actions, &attributes, argv, envp);
+  posix_spawnattr_destroy(&attributes);
+  posix_spawn_file_actions_destroy(&actions);
+  if (error != 0) {
+    return std::unexpected(error);
+  }
+  return pid;
+}
+
+std::expected<pid_t, int> spawn_with_fork(const std::string& path,
+                                          const exec_environment& environment,
+                                          spawn_stdio stdio, char* const argv[],
+                                          char* const envp[]) {
+  // Si el exec falla, el hijo escribe el errno por esta tubería; si funciona,
+  // el CLOEXEC la cierra y el padre lee EOF
+  int status_pipe[2];
+  if (pipe2(status_pipe, O_CLOEXEC) < 0) {
+    return std::unexpected(errno);
+  }
+  pid_t pid = fork();
+  if (pid < 0) {
+    int error = errno;
+    close(status_pipe[0]);
+    close(status_pipe[1]);
+    return std::unexpected(error);
+  }
+  if (pid == 0) {
+    close(status_pipe[0]);
+    setpgid(0, 0);
+    sigset_t empty;
+    sigemptyset(&empty);
+    sigprocmask(SIG_SETMASK, &empty, nullptr);
+    signal(SIGPIPE, SIG_DFL);
+    if ((stdio.in >= 0 && dup2(stdio.in, STDIN_FILENO) < 0) ||
+        (stdio.out >= 0 && dup2(stdio.out, STDOUT_FILENO) < 0) ||
+        (!environment.cwd.empty() && chdir(environment.cwd.c_str()) < 0)) {
+      int error = errno;
+      (void)!write(status_pipe[1], &error, sizeof(error));
+      _exit(127);
+    }
+    execve(path.c_str(), argv, envp);
+    int error = errno;
+    (void)!write(status_pipe[1], &error, sizeof(error));
+    _exit(127);
+  }
+
+  close(status_pipe[1]);
+  int error = 0;
+  ssize_t got;
+  do {
+    got = read(status_pipe[0], &error, sizeof(error));
+  } while (got < 0 && errno == EINTR);
+  close(status_pipe[0]);
+  if (got == sizeof(error)) {
+    waitpid(pid, nullptr, 0);
+    return std::unexpected(error);
+  }
+  return pid;
+}
+
+}  // namespace
+
+exec_environment inherited_environment(const std::vector<std::string>& variables,
+                                       std::string cwd) {
+  auto name_of = [](std::string_view entry) {
+    return entry.substr(0, entry.find('='));
+  };
+  exec_environment environment;
+  environment.cwd = std::move(cwd);
+  for (char** entry = environ; entry != nullptr && *entry != nullptr; ++entry) {
+    std::string_view name = name_of(*entry);
+    bool overridden = false;
+    for (const auto& variable : variables) {
+      if (name_of(variable) == name) {
+        overridden = true;
+        break;
+      }
+    }
+    if (!overridden) {
+      environment.env.emplace_back(*entry);
+    }
+  }
+  environment.env.insert(environment.env.end(), variables.begin(),
+                         variables.end());
+  return environment;
+}
+
+std::expected<pid_t, int> spawn_program(const std::string& path,
+                                        const exec_environment& environment,
+                                        spawn_stdio stdio,
+                                        spawn_method method) {
+  std::vector<std::string> arguments{path};
+  std::vector<char*> argv = make_pointer_array(arguments);
+  std::vector<char*> envp = make_pointer_array(environment.env);
+  if (method == spawn_method::fork_exec) {
+    return spawn_with_fork(path, environment, stdio, argv.data(), envp.data());
+  }
+  return spawn_with_posix_spawn(path, environment, stdio, argv.data(),
+                                envp.data());
+}
@@ -0,0 +1,72 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: spawn.h
+ * Referencias:
+ *     man 3 posix_spawn, man 2 clone, man 2 vfork
+ */
+
+#ifndef SPAWN_H
+#define SPAWN_H
+
+#include <sys/types.h>
+
+#include <expected>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Entorno con el que se lanza un programa: directorio de trabajo
+ * (vacío = el del servidor) y variables "CLAVE=valor" completas.
+ */
+struct exec_environment {
+  std::string cwd;
+  std::vector<std::string> env;
+};
+
+/**
+ * @brief Descriptores que el programa recibe como stdin y stdout
+ * (-1 = heredar los del servidor).
+ */
+struct spawn_stdio {
+  int in = -1;
+  int out = -1;
+};
+
+/**
+ * @brief Cómo se crea el proceso hijo.
+ *   posix_spawn  glibc usa clone(CLONE_VM | CLONE_VFORK): el hijo comparte
+ *                la memoria del padre hasta el exec y no se copian las tablas
+ *                de páginas, así que no depende de cuánto tenga mapeado el
+ *                servidor.
+ *   fork_exec    fork() + execve(): copia las tablas de páginas del padre.
+ *                Se conserva para comparar en bench_spawn.
+ */
+enum class spawn_method { posix_spawn, fork_exec };
+
+/**
+ * @brief Entorno del servidor más las variables indicadas (que sustituyen
+ * a las del mismo nombre).
+ */
+exec_environment inherited_environment(const std::vector<std::string>& variables,
+                                       std::string cwd = {});
+
+/**
+ * @brief Lanza un programa sin argumentos con el entorno y los descriptores
+ * indicados. El hijo encabeza su propio grupo de procesos (pgid = pid), así
+ * que kill(-pid, ...) alcanza también a los procesos que lance él.
+ * @return El pid del hijo, o el errno si no se pudo ejecutar (ENOENT si no
+ * existe, EACCES si no tiene permiso...). Con ambos métodos el fallo del exec
+ * se devuelve aquí y no como código de salida 127.
+ */
+std::expected<pid_t, int> spawn_program(
+    const std::string& path, const exec_environment& environment,
+    spawn_stdio stdio = {}, spawn_method method = spawn_method::posix_spawn);
+
+#endif  // SPAWN_H
@@ -0,0 +1,212 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: timing_wheel.cc
+ * Referencias:
+ *     Varghese y Lauck, "Hashed and Hierarchical Timing Wheels" (1987)
+ *     kernel/time/timer.c de Linux
+ */
+
+#include "timing_wheel.h"
+
+#include <algorithm>
+#include <climits>
+
+#include "metrics.h"
+
+namespace {
+
+constexpr uint64_t kNsPerTick = 1'000'000;
+
+uint64_t now_tick() { return now_ns() / kNsPerTick; }
+
+}  // namespace
+
+TimingWheel::TimingWheel() : current_(now_tick()) {}
+
+TimingWheel::~TimingWheel() = default;
+
+TimingWheel::node** TimingWheel::slot(int level, uint64_t index) {
+  if (level == 0) {
+    return &first_[index & (kFirstSlots - 1)];
+  }
+  return &upper_[static_cast<size_t>(level - 1)][index & (kLevelSlots - 1)];
+}
+
+void TimingWheel::link(node& n, node** head, int level) {
+  n.head = head;
+  n.level = level;
+  n.prev = nullptr;
+  n.next = *head;
+  if (*head != nullptr) {
+    (*head)->prev = &n;
+  }
+  *head = &n;
+  if (level >= 0) {
+    ++counts_[static_cast<size_t>(level)];
+  }
+}
+
+void TimingWheel::unlink(node& n) {
+  if (n.prev != nullptr) {
+    n.prev->next = n.next;
+  } else {
+    *n.head = n.next;
+  }
+  if (n.next != nullptr) {
+    n.next->prev = n.prev;
+  }
+  if (n.level >= 0) {
+    --counts_[static_cast<size_t>(n.level)];
+  }
+  n.prev = n.next = nullptr;
+  n.head = nullptr;
+}
+
+void TimingWheel::place(node& n, uint64_t earliest) {
+  uint64_t expires = n.expires > earliest ? n.expires : earliest;
+  uint64_t delta = expires - current_;
+  for (int level = 0; level < kLevels; ++level) {
+    // El nivel cubre los vencimientos que caen antes de dar su vuelta
+    uint64_t span = uint64_t{1} << (shift(level) + (level == 0 ? kFirstBits
+                                                                : kLevelBits));
+    if (delta < span) {
+      link(n, slot(level, expires >> shift(level)), level);
+      return;
+    }
+  }
+  // Más allá de la última vuelta: a su última ranura, y al repartirla se
+  // vuelve a colocar con el plazo real
+  uint64_t farthest = current_ + (uint64_t{1} << (shift(kLevels - 1) +
+                                                   kLevelBits)) - 1;
+  link(n, slot(kLevels - 1, farthest >> shift(kLevels - 1)), kLevels - 1);
+}
+
+uint64_t TimingWheel::schedule(uint64_t delay_ns, callback on_expire) {
+  uint64_t id = next_id_++;
+  node& n = nodes_[id];
+  n.id = id;
+  // Redondeo hacia arriba: nunca antes de tiempo
+  n.expires = (now_ns() + delay_ns + kNsPerTick - 1) / kNsPerTick;
+  n.on_expire = std::move(on_expire);
+  place(n, current_ + 1);  // La ranura de current_ ya se procesó
+  return id;
+}
+
+void TimingWheel::cancel(uint64_t id) {
+  auto it = nodes_.find(id);
+  if (it == nodes_.end()) {
+    return;
+  }
+  unlink(it->second);
+  nodes_.erase(it);
+}
+
+void TimingWheel::cascade(int level) {
+  node** head = slot(level, current_ >> shift(level));
+  node* n = *head;
+  while (n != nullptr) {
+    node* next = n->next;
+    unlink(*n);
+    place(*n, current_);  // Se reparte antes de procesar la ranura de current_
+    n = next;
+  }
+}
+
+void TimingWheel::advance(uint64_t target) {
+  while (current_ < target) {
+    // Si los niveles de abajo están vacíos no pasa nada hasta que el primero
+    // que tiene algo haya que repartirlo: se salta hasta ahí
+    int lowest = 0;
+    while (lowest < kLevels && counts_[static_cast<size_t>(lowest)] == 0) {
+      ++lowest;
+    }
+    if (lowest == kLevels) {
+      current_ = target;
+      return;
+    }
+    if (lowest > 0) {
+      uint64_t mask = (uint64_t{1} << shift(lowest)) - 1;
+      uint64_t boundary = (current_ | mask) + 1;
+      if (boundary > target) {
+        current_ = target;
+        return;
+      }
+      current_ = boundary - 1;
+    }
+
+    ++current_;
+    // Al dar la vuelta un nivel se reparte la ranura que toca del siguiente
+    for (int level = 1; level < kLevels; ++level) {
+      if ((current_ & ((uint64_t{1} << shift(level)) - 1)) != 0) {
+        break;
+      }
+      cascade(level);
+    }
+
+    node** head = slot(0, current_);
+    if (*head == nullptr) {
+      continue;
+    }
+    // Se sacan de la ranura antes de llamarlos: un callback puede cancelar
+    // otro de la misma ranura o armar uno nuevo en ella
+    node* pending = nullptr;
+    while (*head != nullptr) {
+      node& n = **head;
+      unlink(n);
+      link(n, &pending, -1);
+    }
+    while (pending != nullptr) {
+      node& n = *pending;
+      unlink(n);
+      callback on_expire = std::move(n.on_expire);
+      nodes_.erase(n.id);
+      on_expire();
+    }
+  }
+}
+
+void TimingWheel::expire() { advance(now_tick()); }
+
+uint64_t TimingWheel::next_event_tick() const {
+  uint64_t next = UINT64_MAX;
+  // Lo de los niveles de arriba no vence antes de repartirse, y el primer
+  // reparto es el del nivel más bajo con algo
+  for (int level = 1; level < kLevels; ++level) {
+    if (counts_[static_cast<size_t>(level)] != 0) {
+      uint64_t mask = (uint64_t{1} << shift(level)) - 1;
+      next = (current_ | mask) + 1;
+      break;
+    }
+  }
+  if (counts_[0] != 0) {
+    uint64_t last = std::min(next - 1, current_ + kFirstSlots);
+    for (uint64_t tick = current_ + 1; tick <= last; ++tick) {
+      if (first_[tick & (kFirstSlots - 1)] != nullptr) {
+        return tick;
+      }
+    }
+  }
+  return next;
+}
+
+int TimingWheel::timeout_ms() const {
+  uint64_t next = next_event_tick();
+  if (next == UINT64_MAX) {
+    return -1;
+  }
+  uint64_t now = now_ns();
+  uint64_t due = next * kNsPerTick;
+  if (due <= now) {
+    return 0;
+  }
+  // Redondeo hacia arriba para no despertar un poco antes y dar otra vuelta
+  uint64_t ms = (due - now + kNsPerTick - 1) / kNsPerTick;
+  return ms > INT_MAX ? INT_MAX : static_cast<int>(ms);
+}
@@ -0,0 +1,110 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: timing_wheel.h
+ * Referencias:
+ *     Varghese y Lauck, "Hashed and Hierarchical Timing Wheels" (1987)
+ *     kernel/time/timer.c de Linux
+ */
+
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+/**
+ * @brief Rueda de temporizadores jerárquica con resolución de 1 ms.
+ *
+ * Cuatro niveles: el primero tiene 256 ranuras de 1 ms y cada uno de los
+ * otros 64 ranuras que cubren una vuelta entera del anterior (hasta unas
+ * 18 horas; lo que vence más tarde espera en la última ranura y se vuelve a
+ * colocar). Cada ranura es una lista doblemente enlazada, así que armar y
+ * cancelar cuestan O(1); al completar una vuelta de un nivel, su ranura
+ * siguiente del nivel de arriba se reparte entre los de abajo.
+ *
+ * Un temporizador nunca vence antes de su plazo; puede hacerlo hasta 1 ms
+ * después.
+ */
+class TimingWheel {
+ public:
+  using callback = std::function<void()>;
+
+  TimingWheel();
+  ~TimingWheel();
+
+  TimingWheel(const TimingWheel&) = delete;
+  TimingWheel& operator=(const TimingWheel&) = delete;
+
+  /**
+   * @brief Arma un temporizador que vence dentro de delay_ns.
+   * @return Identificador para cancel(); nunca se reutiliza ni es 0.
+   */
+  uint64_t schedule(uint64_t delay_ns, callback on_expire);
+
+  /**
+   * @brief Desarma un temporizador (no hace nada si ya venció).
+   */
+  void cancel(uint64_t id);
+
+  /**
+   * @brief Milisegundos hasta que pueda vencer algo (0 si ya hay algo
+   * vencido, -1 si no hay temporizadores); para epoll_wait().
+   */
+  [[nodiscard]] int timeout_ms() const;
+
+  /**
+   * @brief Llama a los temporizadores vencidos hasta ahora. Pueden armar y
+   * cancelar otros, incluso de la misma ranura.
+   */
+  void expire();
+
+  [[nodiscard]] size_t size() const noexcept { return nodes_.size(); }
+
+ private:
+  static constexpr int kLevels = 4;
+  static constexpr int kFirstBits = 8;  // 256 ranuras de 1 ms
+  static constexpr int kLevelBits = 6;  // 64 ranuras en el resto
+  static constexpr size_t kFirstSlots = size_t{1} << kFirstBits;
+  static constexpr size_t kLevelSlots = size_t{1} << kLevelBits;
+
+  struct node {
+    uint64_t id = 0;
+    uint64_t expires = 0;  // En ticks de 1 ms
+    callback on_expire;
+    node* prev = nullptr;
+    node* next = nullptr;
+    node** head = nullptr;  // Lista en la que está
+    int level = 0;
+  };
+
+  static constexpr int shift(int level) {
+    return level == 0 ? 0 : kFirstBits + kLevelBits * (level - 1);
+  }
+
+  node** slot(int level, uint64_t index);
+  void place(node& n, uint64_t earliest);
+  void link(node& n, node** head, int level);
+  void unlink(node& n);
+  void cascade(int level);
+  void advance(uint64_t target);
+  [[nodiscard]] uint64_t next_event_tick() const;
+
+  uint64_t current_;  // Último tick procesado
+  uint64_t next_id_ = 1;
+  std::array<node*, kFirstSlots> first_{};
+  std::array<std::array<node*, kLevelSlots>, kLevels - 1> upper_{};
+  std::array<size_t, kLevels> counts_{};  // Temporizadores en cada nivel
+  std::unordered_map<uint64_t, node> nodes_;
+};
+
+#endif  // TIMING_WHEEL_H
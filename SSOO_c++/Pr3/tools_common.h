@@ -0,0 +1,81 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: tools_common.h
+ * Referencias:
+ *     Utilidades compartidas por las herramientas de medida
+ */
+
+#ifndef TOOLS_COMMON_H
+#define TOOLS_COMMON_H
+
+#include <cstdint>
+#include <format>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Convierte un tamaño con sufijo opcional (k, m, g; base 1024) a
+ * bytes: "100", "4k", "64K", "1g".
+ */
+inline std::optional<uint64_t> parse_size(std::string_view text) {
+  if (text.empty()) {
+    return std::nullopt;
+  }
+  uint64_t multiplier = 1;
+  switch (text.back()) {
+    case 'k':
+    case 'K':
+      multiplier = 1ull << 10;
+      break;
+    case 'm':
+    case 'M':
+      multiplier = 1ull << 20;
+      break;
+    case 'g':
+    case 'G':
+      multiplier = 1ull << 30;
+      break;
+    default:
+      break;
+  }
+  if (multiplier != 1) {
+    text.remove_suffix(1);
+  }
+  if (text.empty()) {
+    return std::nullopt;
+  }
+  uint64_t value = 0;
+  for (char c : text) {
+    if (c < '0' || c > '9') {
+      return std::nullopt;
+    }
+    value = value * 10 + static_cast<uint64_t>(c - '0');
+  }
+  return value * multiplier;
+}
+
+/**
+ * @brief Escribe un tamaño en bytes de forma legible ("4K", "1M", "100B").
+ */
+inline std::string format_size(uint64_t bytes) {
+  if (bytes >= (1ull << 30) && bytes % (1ull << 30) == 0) {
+    return std::format("{}G", bytes >> 30);
+  }
+  if (bytes >= (1ull << 20) && bytes % (1ull << 20) == 0) {
+    return std::format("{}M", bytes >> 20);
+  }
+  if (bytes >= (1ull << 10) && bytes % (1ull << 10) == 0) {
+    return std::format("{}K", bytes >> 10);
+  }
+  return std::format("{}B", bytes);
+}
+
+#endif  // TOOLS_COMMON_H
@@ -0,0 +1,153 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: tracing.cc
+ * Referencias:
+ *     Formato "Trace Event" de Chrome (lo abre Perfetto)
+ */
+
+#include "tracing.h"
+
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <csignal>
+#include <format>
+#include <fstream>
+#include <vector>
+
+std::atomic<uint32_t> trace_sample_every{0};
+thread_local uint64_t trace_current_request = 0;
+
+namespace {
+
+/**
+ * @brief Buffer circular de tramos de un hilo. Solo escribe su hilo; al
+ * volcar se copian los últimos kCapacity tramos publicados.
+ */
+struct alignas(64) trace_buffer {
+  static constexpr size_t kCapacity = 16384;
+
+  std::array<trace_span, kCapacity> spans{};
+  std::atomic<uint64_t> head{0};  // Número de tramos escritos en total
+  int tid = 0;
+};
+
+constexpr size_t kMaxBuffers = 256;
+std::array<std::atomic<trace_buffer*>, kMaxBuffers> buffers{};
+std::atomic<size_t> buffer_count{0};
+
+std::atomic<uint64_t> next_request_id{1};
+volatile std::sig_atomic_t dump_requested = 0;
+int dumps_written = 0;
+
+trace_buffer& local_buffer() {
+  static thread_local trace_buffer* buffer = [] {
+    auto* created = new trace_buffer();
+    created->tid = static_cast<int>(syscall(SYS_gettid));
+    size_t index = buffer_count.fetch_add(1, std::memory_order_acq_rel);
+    if (index < kMaxBuffers) {
+      buffers[index].store(created, std::memory_order_release);
+    }
+    return created;
+  }();
+  return *buffer;
+}
+
+void handle_sigusr1(int) { dump_requested = 1; }
+
+}  // namespace
+
+uint64_t trace_begin_request() {
+  uint32_t every = trace_sample_every.load(std::memory_order_relaxed);
+  if (every == 0) {
+    trace_current_request = 0;
+    return 0;
+  }
+  // El contador de muestreo es por hilo para no compartir una línea de caché
+  static thread_local uint32_t countdown = 0;
+  if (countdown == 0 || countdown > every) {
+    countdown = every;
+  }
+  if (--countdown != 0) {
+    trace_current_request = 0;
+    return 0;
+  }
+  trace_current_request =
+      next_request_id.fetch_add(1, std::memory_order_relaxed);
+  return trace_current_request;
+}
+
+void trace_record_slow(const char* name, uint64_t start_ns, uint64_t end_ns) {
+  trace_buffer& buffer = local_buffer();
+  uint64_t head = buffer.head.load(std::memory_order_relaxed);
+  buffer.spans[head % trace_buffer::kCapacity] =
+      trace_span{name, start_ns, end_ns, trace_current_request};
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+
+std::string trace_dump_json() {
+  std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  pid_t pid = getpid();
+  size_t count =
+      std::min(buffer_count.load(std::memory_order_acquire), kMaxBuffers);
+  for (size_t i = 0; i < count; ++i) {
+    trace_buffer* buffer = buffers[i].load(std::memory_order_acquire);
+    if (buffer == nullptr) {
+      continue;
+    }
+    // Con otros hilos escribiendo a la vez el tramo más antiguo puede quedar
+    // sobrescrito durante la copia; para diagnóstico es aceptable.
+    uint64_t head = buffer->head.load(std::memory_order_acquire);
+    uint64_t begin = head > trace_buffer::kCapacity
+                         ? head - trace_buffer::kCapacity
+                         : 0;
+    for (uint64_t n = begin; n < head; ++n) {
+      const trace_span& span = buffer->spans[n % trace_buffer::kCapacity];
+      if (span.name == nullptr) {
+        continue;
+      }
+      out += std::format(
+          "{}{{\"name\":\"{}\",\"cat\":\"docserver\",\"ph\":\"X\","
+          "\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":{},\"tid\":{},"
+          "\"args\":{{\"request\":{}}}}}",
+          first ? "" : ",", span.name,
+          static_cast<double>(span.start_ns) / 1000.0,
+          static_cast<double>(span.end_ns - span.start_ns) / 1000.0, pid,
+          buffer->tid, span.request_id);
+      first = false;
+    }
+  }
+  out += "]}\n";
+  return out;
+}
+
+void trace_install_signal_handler() {
+  struct sigaction action {};
+  action.sa_handler = handle_sigusr1;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = 0;
+  sigaction(SIGUSR1, &action, nullptr);
+}
+
+std::string trace_dump_if_requested() {
+  if (!dump_requested) {
+    return {};
+  }
+  dump_requested = 0;
+  std::string path =
+      std::format("trace-{}-{}.json", getpid(), dumps_written++);
+  std::ofstream file(path);
+  file << trace_dump_json();
+  return file ? path : std::string();
+}
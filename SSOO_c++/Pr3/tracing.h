@@ -0,0 +1,102 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: tracing.h
+ * Referencias:
+ *     Formato "Trace Event" de Chrome (lo abre Perfetto)
+ */
+
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Tramo de tiempo de una fase de una petición muestreada.
+ */
+struct trace_span {
+  const char* name = nullptr;  // Literal: no se copia ni se libera
+  uint64_t start_ns = 0;
+  uint64_t end_ns = 0;
+  uint64_t request_id = 0;
+};
+
+// Se traza 1 de cada trace_sample_every peticiones; 0 desactiva el trazado.
+extern std::atomic<uint32_t> trace_sample_every;
+
+// Petición que está atendiendo este hilo (0 si no se está trazando).
+extern thread_local uint64_t trace_current_request;
+
+/**
+ * @brief Decide si se traza la siguiente petición del hilo y la marca como
+ * actual. Con el trazado desactivado es una sola lectura relajada.
+ * @return Identificador de la petición, o 0 si no se traza.
+ */
+uint64_t trace_begin_request();
+
+/**
+ * @brief Termina la petición actual del hilo.
+ */
+inline void trace_end_request() { trace_current_request = 0; }
+
+/**
+ * @brief Hace actual la petición indicada mientras dure el objeto. En el
+ * bucle de eventos un hilo atiende muchas conexiones a la vez y cada evento
+ * se anota en la petición de su conexión.
+ */
+class TraceRequestScope {
+ public:
+  explicit TraceRequestScope(uint64_t request_id) noexcept
+      : previous_(trace_current_request) {
+    trace_current_request = request_id;
+  }
+  ~TraceRequestScope() { trace_current_request = previous_; }
+
+  TraceRequestScope(const TraceRequestScope&) = delete;
+  TraceRequestScope& operator=(const TraceRequestScope&) = delete;
+
+ private:
+  uint64_t previous_;
+};
+
+void trace_record_slow(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+/**
+ * @brief Anota una fase de la petición actual si se está trazando.
+ * @param name Nombre de la fase; debe ser un literal.
+ */
+inline void trace_record(const char* name, uint64_t start_ns,
+                         uint64_t end_ns) {
+  if (trace_current_request != 0) {
+    trace_record_slow(name, start_ns, end_ns);
+  }
+}
+
+/**
+ * @brief Vuelca los tramos guardados por todos los hilos en JSON de Chrome
+ * (trace_event), listo para abrir en Perfetto o chrome://tracing.
+ */
+std::string trace_dump_json();
+
+/**
+ * @brief Instala el manejador de SIGUSR1, que pide un volcado a archivo.
+ * La señal interrumpe accept() (sin SA_RESTART) para atenderla enseguida.
+ */
+void trace_install_signal_handler();
+
+/**
+ * @brief Si llegó SIGUSR1, escribe el volcado en trace-<pid>-<n>.json en el
+ * directorio actual.
+ * @return Ruta del archivo escrito, o cadena vacía si no había petición.
+ */
+std::string trace_dump_if_requested();
+
+#endif  // TRACING_H
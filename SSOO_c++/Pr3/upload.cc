@@ -0,0 +1,328 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: upload.cc
+ * Referencias:
+ *     man 2 splice, man 2 fallocate, man 2 fsync, man 2 rename
+ */
+
+#include "upload.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+
+#include "docserver.h"
+#include "metrics.h"
+
+namespace {
+
+// Sin recibir nada en este tiempo se abandona la subida
+constexpr uint64_t kIdleTimeoutNs = 30'000'000'000;
+// Tamaño que se pide para la tubería: lo que mueve cada splice()
+constexpr int kPipeBytes = 1 << 20;
+
+uint64_t temporary_counter = 0;
+
+/**
+ * @brief Código de respuesta de un fallo al escribir el archivo.
+ */
+int status_for(int error) {
+  switch (error) {
+    case EACCES:
+    case EPERM:
+    case EROFS:
+      return 403;
+    case ENOENT:
+    case ENOTDIR:
+      return 404;
+    case EFBIG:
+      return 413;
+    case ENOSPC:
+    case EDQUOT:
+      return 507;
+    default:
+      return 500;
+  }
+}
+
+}  // namespace
+
+bool is_upload_path(std::string_view path) {
+  if (path.empty() || path.front() != '/' || path.back() == '/' ||
+      path.starts_with("/bin/") || path.starts_with("/_") ||
+      path == "/metrics") {
+    return false;
+  }
+  std::string_view rest = path.substr(1);
+  while (!rest.empty()) {
+    size_t slash = rest.find('/');
+    std::string_view part = rest.substr(0, slash);
+    if (part.empty() || part == "." || part == "..") {
+      return false;
+    }
+    rest.remove_prefix(slash == std::string_view::npos ? rest.size()
+                                                       : slash + 1);
+  }
+  return true;
+}
+
+void Upload::start(Connection& connection, std::string path,
+                   std::optional<uint64_t> length,
+                   const upload_limits& limits, stored_callback on_stored) {
+  std::unique_ptr<Upload> upload(new Upload(
+      connection, std::move(path), length, limits, std::move(on_stored)));
+  Upload& self = *upload;
+  connection.set_source(std::move(upload));
+
+  if (length && *length > limits.max_bytes) {
+    self.fail(413, "upload too large");
+    return;
+  }
+  if (int error = self.open_temporary()) {
+    self.fail(status_for(error), "cannot create the uploaded file");
+    return;
+  }
+  std::string received =
+      connection.receive_body([&self] { self.on_readable(); });
+  if (!self.write_received(received)) {
+    return;
+  }
+  self.last_progress_ns_ = now_ns();
+  self.timer_ = connection.loop().add_timer(
+      kIdleTimeoutNs, [&self] { self.on_idle_timer(); });
+  if (self.length_ && self.received_ == *self.length_) {
+    self.complete();
+  }
+}
+
+Upload::Upload(Connection& connection, std::string path,
+               std::optional<uint64_t> length, const upload_limits& limits,
+               stored_callback on_stored)
+    : connection_(connection),
+      path_(std::move(path)),
+      length_(length),
+      limits_(limits),
+      on_stored_(std::move(on_stored)) {}
+
+Upload::~Upload() {
+  discard();
+}
+
+void Upload::abort() {
+  // La conexión se ha cerrado: si no se había terminado, no se terminará
+  discard();
+}
+
+void Upload::discard() {
+  done_ = true;
+  if (timer_ != 0) {
+    connection_.loop().cancel_timer(timer_);
+    timer_ = 0;
+  }
+  if (!temporary_.empty()) {
+    unlinkat(directory_.get(), temporary_.c_str(), 0);
+    temporary_.clear();
+  }
+}
+
+int Upload::open_temporary() {
+  size_t slash = path_.rfind('/');
+  std::string directory = base_dir + path_.substr(0, slash);
+  name_ = path_.substr(slash + 1);
+  directory_ = SafeFD(open(directory.empty() ? "/" : directory.c_str(),
+                           O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+  if (!directory_.is_valid()) {
+    return errno;
+  }
+
+  // Oculto y único en el directorio: un GET no lo encuentra por su nombre
+  temporary_ = "." + name_ + ".put-" + std::to_string(getpid()) + "-" +
+               std::to_string(++temporary_counter);
+  file_ = SafeFD(openat(directory_.get(), temporary_.c_str(),
+                        O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666));
+  if (!file_.is_valid()) {
+    int error = errno;
+    temporary_.clear();
+    return error;
+  }
+  // Reservar de una vez evita fragmentar el archivo y un ENOSPC a mitad
+  if (length_ && *length_ > 0 &&
+      fallocate(file_.get(), 0, 0, static_cast<off_t>(*length_)) < 0 &&
+      errno != EOPNOTSUPP) {
+    return errno;
+  }
+
+  int pipe_fd[2];
+  if (pipe2(pipe_fd, O_CLOEXEC | O_NONBLOCK) < 0) {
+    return errno;
+  }
+  pipe_read_ = SafeFD(pipe_fd[0]);
+  pipe_write_ = SafeFD(pipe_fd[1]);
+  // Sin permiso para agrandarla se queda con su tamaño
+  fcntl(pipe_write_.get(), F_SETPIPE_SZ, kPipeBytes);
+  int size = fcntl(pipe_write_.get(), F_GETPIPE_SZ);
+  if (size > 0) {
+    pipe_size_ = static_cast<size_t>(size);
+  }
+  return 0;
+}
+
+bool Upload::write_received(std::string_view data) {
+  if (length_ && data.size() > *length_) {
+    data = data.substr(0, *length_);  // Lo que sobra no es del cuerpo
+  }
+  while (!data.empty()) {
+    ssize_t written = write(file_.get(), data.data(), data.size());
+    if (written < 0 && errno == EINTR) continue;
+    if (written < 0) {
+      fail(status_for(errno), "cannot write the uploaded file");
+      return false;
+    }
+    data.remove_prefix(static_cast<size_t>(written));
+    received_ += static_cast<uint64_t>(written);
+  }
+  if (received_ > limits_.max_bytes) {
+    fail(413, "upload too large");
+    return false;
+  }
+  return true;
+}
+
+void Upload::on_readable() {
+  while (!done_) {
+    size_t want = pipe_size_;
+    if (length_) {
+      want = static_cast<size_t>(
+          std::min<uint64_t>(want, *length_ - received_));
+    }
+    ssize_t moved = splice(connection_.socket_fd(), nullptr, pipe_write_.get(),
+                           nullptr, want, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (moved < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) return;
+      discard();
+      connection_.close();
+      return;
+    }
+    if (moved == 0) {
+      // El cliente cerró su mitad: sin longitud, es el final del cuerpo
+      if (length_) {
+        fail(400, "upload ended before its length");
+      } else {
+        complete();
+      }
+      return;
+    }
+    if (!drain_pipe(static_cast<size_t>(moved))) {
+      return;
+    }
+    received_ += static_cast<uint64_t>(moved);
+    last_progress_ns_ = now_ns();
+    if (received_ > limits_.max_bytes) {
+      fail(413, "upload too large");
+      return;
+    }
+    if (length_ && received_ == *length_) {
+      complete();
+      return;
+    }
+  }
+}
+
+bool Upload::drain_pipe(size_t bytes) {
+  while (bytes > 0) {
+    ssize_t written = splice(pipe_read_.get(), nullptr, file_.get(), nullptr,
+                             bytes, SPLICE_F_MOVE);
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) {
+      fail(status_for(written < 0 ? errno : EIO),
+           "cannot write the uploaded file");
+      return false;
+    }
+    bytes -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+void Upload::complete() {
+  done_ = true;
+  connection_.stop_receiving();
+  int sync = 0;
+  if (limits_.durability == upload_durability::data) {
+    sync = fdatasync(file_.get());
+  } else if (limits_.durability == upload_durability::full) {
+    sync = fsync(file_.get());
+  }
+  if (sync < 0) {
+    fail(status_for(errno), "cannot sync the uploaded file");
+    return;
+  }
+  // Al reemplazar un archivo se conservan sus permisos y, si se puede, su
+  // dueño; uno nuevo se queda con los de la umask
+  struct stat target {};
+  if (fstatat(directory_.get(), name_.c_str(), &target, 0) == 0) {
+    if (fchmod(file_.get(), target.st_mode & 07777) < 0) {
+      fail(status_for(errno), "cannot copy the permissions of the file");
+      return;
+    }
+    [[maybe_unused]] int owned =
+        fchown(file_.get(), target.st_uid, target.st_gid);
+  }
+  file_ = SafeFD();
+
+  // Sustituye al archivo de una vez, sin que se vea un momento sin él
+  if (renameat2(directory_.get(), temporary_.c_str(), directory_.get(),
+                name_.c_str(), 0) < 0) {
+    fail(status_for(errno), "cannot replace the uploaded file");
+    return;
+  }
+  temporary_.clear();
+  if (limits_.durability == upload_durability::full) {
+    fsync(directory_.get());  // Que también el nombre nuevo sea duradero
+  }
+  discard();
+
+  metrics_count(metric_counter::uploads);
+  metrics_count(metric_counter::upload_bytes, received_);
+  print_verbose("Put: archivo \"" + path_ + "\" guardado correctamente");
+  if (on_stored_) {
+    on_stored_(path_);
+  }
+  connection_.respond("Content-Length: 0\r\n");
+}
+
+void Upload::fail(int status, std::string_view message) {
+  discard();
+  connection_.stop_receiving();
+  connection_.respond(status_line(status));
+  std::cerr << "Error: " << message << "\n";
+}
+
+void Upload::on_idle_timer() {
+  timer_ = 0;
+  if (done_) {
+    return;
+  }
+  uint64_t idle = now_ns() - last_progress_ns_;
+  if (idle < kIdleTimeoutNs) {
+    timer_ = connection_.loop().add_timer(kIdleTimeoutNs - idle,
+                                          [this] { on_idle_timer(); });
+    return;
+  }
+  print_verbose("El cliente no envía el cuerpo");
+  discard();
+  connection_.close();
+}
@@ -0,0 +1,117 @@
+/**
+ * Universidad de La Laguna
+ * Escuela Superior de Ingeniería y Tecnología
+ * Grado en Ingeniería Informática
+ * Asignatura: Sistemas Operativos
+ * Curso: 2º
+ * Autor: Javier Farrona Cabrera
+ * Correo: alu0101541983@ull.edu.es
+ * Fecha: 19 Oct 2026
+ * Archivo: upload.h
+ * Referencias:
+ *     man 2 splice, man 2 fallocate, man 2 fsync, man 2 rename
+ */
+
+#ifndef UPLOAD_H
+#define UPLOAD_H
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "connection.h"
+#include "safe_fd.h"
+
+/**
+ * @brief Cuándo se espera a que un archivo subido llegue al disco.
+ */
+enum class upload_durability {
+  none,  // Nunca: lo decide el núcleo
+  data,  // fdatasync() del archivo antes de renombrarlo
+  full,  // fsync() del archivo y, tras renombrarlo, del directorio
+};
+
+/**
+ * @brief Configuración de PUT (desactivado por defecto).
+ */
+struct upload_limits {
+  bool enabled = false;
+  upload_durability durability = upload_durability::data;
+  uint64_t max_bytes = uint64_t{1} << 30;
+};
+
+/**
+ * @brief true si path se puede escribir con PUT: un archivo de base_dir
+ * sin componentes "." ni "..", que no sea un programa de /bin ni una
+ * página del servidor.
+ */
+bool is_upload_path(std::string_view path);
+
+/**
+ * @brief Recepción del cuerpo de un PUT en base_dir + path.
+ *
+ * El cuerpo pasa del socket a un archivo temporal del mismo directorio con
+ * splice() a través de una tubería, sin copiarse en el proceso; con la
+ * longitud anunciada se reserva antes con fallocate(). Al acabar se
+ * sincroniza según la durabilidad y se renombra sobre el archivo con
+ * renameat2(): un GET concurrente ve el archivo viejo o el nuevo entero,
+ * nunca uno a medias. Si algo falla, o el cliente se va, el temporal se
+ * borra y el archivo queda como estaba.
+ */
+class Upload : public ResponseSource {
+ public:
+  using stored_callback = std::function<void(const std::string& path)>;
+
+  /**
+   * @brief Empieza a recibir. La conexión mantiene viva la subida y recibe
+   * la respuesta ("Content-Length: 0" o la línea de estado del error).
+   * @param length Longitud del cuerpo, o nullopt si llega hasta que el
+   * cliente cierra su mitad de la conexión.
+   * @param on_stored Se llama con path cuando el archivo ya está en su
+   * sitio, antes de responder (para invalidar cachés).
+   */
+  static void start(Connection& connection, std::string path,
+                    std::optional<uint64_t> length,
+                    const upload_limits& limits, stored_callback on_stored);
+
+  ~Upload() override;
+
+  void abort() override;
+
+ private:
+  Upload(Connection& connection, std::string path,
+         std::optional<uint64_t> length, const upload_limits& limits,
+         stored_callback on_stored);
+
+  int open_temporary();
+  bool write_received(std::string_view data);
+  void on_readable();
+  bool drain_pipe(size_t bytes);
+  void complete();
+  void fail(int status, std::string_view message);
+  void on_idle_timer();
+  void discard();
+
+  Connection& connection_;
+  std::string path_;  // Como en la petición
+  std::optional<uint64_t> length_;
+  upload_limits limits_;
+  stored_callback on_stored_;
+
+  SafeFD directory_;
+  std::string name_;       // Nombre final dentro de directory_
+  std::string temporary_;  // Vacío cuando ya no hay temporal que borrar
+  SafeFD file_;
+  SafeFD pipe_read_;
+  SafeFD pipe_write_;
+  size_t pipe_size_ = 65536;
+
+  uint64_t received_ = 0;
+  bool done_ = false;
+  uint64_t timer_ = 0;
+  uint64_t last_progress_ns_ = 0;
+};
+
+#endif  // UPLOAD_H